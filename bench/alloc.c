@@ -0,0 +1,48 @@
+/*
+ * Allocation counting for benchmarks.
+ *
+ * Linked with -Wl,--wrap for every wrapped function, so that calls made by
+ * the library and the benchmark itself (but not by libc internals) go through
+ * these wrappers. Counting is atomic since parallel subroutines allocate from
+ * worker threads.
+ */
+
+#include "bench.h"
+
+void    *__real_malloc(size_t);
+void    *__real_calloc(size_t, size_t);
+void    *__real_realloc(void *, size_t);
+int      __real_posix_memalign(void **, size_t, size_t);
+
+void    *__wrap_malloc(size_t);
+void    *__wrap_calloc(size_t, size_t);
+void    *__wrap_realloc(void *, size_t);
+int      __wrap_posix_memalign(void **, size_t, size_t);
+
+void *
+__wrap_malloc(size_t n)
+{
+        __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+        return __real_malloc(n);
+}
+
+void *
+__wrap_calloc(size_t n, size_t size)
+{
+        __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+        return __real_calloc(n, size);
+}
+
+void *
+__wrap_realloc(void *p, size_t n)
+{
+        __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+        return __real_realloc(p, n);
+}
+
+int
+__wrap_posix_memalign(void **p, size_t align, size_t n)
+{
+        __atomic_fetch_add(&bench_allocs, 1, __ATOMIC_RELAXED);
+        return __real_posix_memalign(p, align, n);
+}
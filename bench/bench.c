@@ -0,0 +1,114 @@
+#include <sys/resource.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+size_t           bench_allocs;
+
+static FILE     *json;          /* JSON output, if any */
+static size_t    json_recs;     /* records written so far */
+static double    start_ns;      /* start of current measurement */
+static size_t    start_allocs;  /* allocations before it */
+
+double
+bench_now(void)
+{
+        struct   timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void
+bench_report(const char *variant, const char *op, size_t n, double ns)
+{
+        printf("%-10s %-10s %12lu %10.2f ns/elem\n", variant, op,
+            (unsigned long)n, n == 0 ? 0.0 : ns / n);
+        fflush(stdout);
+}
+
+size_t
+bench_sizes(int argc, char **argv, size_t *out, size_t max)
+{
+        size_t   n;
+        int      i;
+
+        if (argc < 2) {
+                out[0] = 1000;
+                out[1] = 1000000;
+                out[2] = 100000000;
+                return 3;
+        }
+
+        for (n = 0, i = 1; i < argc && n < max; ++i)
+                out[n++] = strtoul(argv[i], NULL, 10);
+
+        return n;
+}
+
+int
+bench_json_open(const char *path)
+{
+        if (strcmp(path, "-") == 0)
+                json = stdout;
+        else if ((json = fopen(path, "w")) == NULL)
+                return -1;
+
+        fprintf(json, "[");
+        json_recs = 0;
+
+        return 0;
+}
+
+void
+bench_json_close(void)
+{
+        if (json == NULL)
+                return;
+
+        fprintf(json, "\n]\n");
+        if (json != stdout)
+                fclose(json);
+
+        json = NULL;
+}
+
+void
+bench_start(void)
+{
+        start_allocs = bench_allocs;
+        start_ns     = bench_now();
+}
+
+void
+bench_stop(const char *variant, const char *op, size_t n)
+{
+        struct   rusage ru;
+        double   ns, allocs;
+
+        ns     = bench_now() - start_ns;
+        allocs = (double)(bench_allocs - start_allocs);
+
+        /* kilobytes on Linux */
+        getrusage(RUSAGE_SELF, &ru);
+
+        if (n != 0) {
+                ns     /= n;
+                allocs /= n;
+        }
+
+        printf("%-10s %-16s %12lu %10.2f ns/elem %8.4f allocs/elem "
+            "%10ld KiB\n", variant, op, (unsigned long)n, ns, allocs,
+            ru.ru_maxrss);
+        fflush(stdout);
+
+        if (json == NULL)
+                return;
+
+        fprintf(json, "%s\n  {\"variant\": \"%s\", \"op\": \"%s\", "
+            "\"n\": %lu, \"ns_per_elem\": %.3f, \"allocs_per_elem\": %.4f, "
+            "\"peak_rss_kb\": %ld}", json_recs++ > 0 ? "," : "", variant, op,
+            (unsigned long)n, ns, allocs, ru.ru_maxrss);
+}
@@ -0,0 +1,90 @@
+/*
+ * Helpers shared by libfuncc benchmarks.
+ */
+
+#ifndef BENCH_H_INCLUDED
+#define BENCH_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Number of allocations made so far
+ *
+ * Only counted by benchmarks linked with alloc.c (see Makefile), stays zero
+ * otherwise.
+ */
+extern size_t    bench_allocs;
+
+/**
+ * @fn double bench_now(void)
+ * @brief Returns monotonic time in nanoseconds
+ */
+double   bench_now(void);
+
+/**
+ * @fn void bench_report(const char *variant, const char *op, size_t n,
+ *  double ns)
+ * @brief Prints single measurement of @p op performed on @p n elements
+ *
+ * @param[in] variant Name of measured implementation
+ * @param[in] op Name of measured operation
+ * @param[in] n Number of elements processed
+ * @param[in] ns Time it took, in nanoseconds
+ */
+void     bench_report(const char *, const char *, size_t, double);
+
+/**
+ * @fn size_t bench_sizes(int argc, char **argv, size_t *out, size_t max)
+ * @brief Parses list sizes given on the command line
+ *
+ * If none were given, default sizes (1K, 1M and 100M) are used instead.
+ * Returns number of sizes stored in @p out.
+ *
+ * @param[in] argc Argument count as passed to main()
+ * @param[in] argv Argument vector as passed to main()
+ * @param[out] out Parsed sizes
+ * @param[in] max Capacity of @p out
+ */
+size_t   bench_sizes(int, char **, size_t *, size_t);
+
+/**
+ * @fn int bench_json_open(const char *path)
+ * @brief Makes @a bench_stop() also write its records to JSON file @p path
+ *
+ * Records form a single array of objects. Returns zero on success.
+ *
+ * @param[in] path Output file, "-" stands for standard output
+ */
+int      bench_json_open(const char *);
+
+/**
+ * @fn void bench_json_close(void)
+ * @brief Terminates and closes JSON output, if any
+ */
+void     bench_json_close(void);
+
+/**
+ * @fn void bench_start(void)
+ * @brief Starts a measurement
+ */
+void     bench_start(void);
+
+/**
+ * @fn void bench_stop(const char *variant, const char *op, size_t n)
+ * @brief Finishes measurement started by @a bench_start() and reports it
+ *
+ * Reports time and allocations per element as well as peak resident set size
+ * of the process so far, both as text and as a JSON record.
+ *
+ * @param[in] variant Name of measured implementation
+ * @param[in] op Name of measured operation
+ * @param[in] n Number of elements (or calls) processed
+ */
+void     bench_stop(const char *, const char *, size_t);
+
+#endif /* BENCH_H_INCLUDED */
@@ -0,0 +1,108 @@
+/*
+ * Compares flist_sort() and flist_sort_by_key() against exporting the list
+ * with flist_val_at_i(), sorting the array with qsort() and rebuilding it.
+ *
+ * Usage: ./sort [SIZE...]
+ */
+
+#include "bench.h"
+#include "flist.h"
+
+static long     *vals;
+
+static int       cmp(const void *, const void *);
+static int       cmp_ptr(const void *, const void *);
+static long      key(const void *);
+static struct flist *build(size_t);
+static void      run(size_t);
+
+int
+main(int argc, char **argv)
+{
+        size_t   sizes[16], n, i;
+
+        n = bench_sizes(argc, argv, sizes, 16);
+        for (i = 0; i < n; ++i)
+                run(sizes[i]);
+
+        return 0;
+}
+
+int
+cmp(const void *a, const void *b)
+{
+        long     x = *(const long *)a, y = *(const long *)b;
+
+        return (x > y) - (x < y);
+}
+
+int
+cmp_ptr(const void *a, const void *b)
+{
+        return cmp(*(void * const *)a, *(void * const *)b);
+}
+
+long
+key(const void *a)
+{
+        return *(const long *)a;
+}
+
+struct flist *
+build(size_t n)
+{
+        struct   flist *l;
+        size_t   i;
+
+        for (l = NULL, i = 0; i < n; ++i)
+                l = flist_append(l, vals + i, FLIST_DONTCLEAN);
+
+        return l;
+}
+
+void
+run(size_t n)
+{
+        struct   flist *l;
+        void   **arr;
+        unsigned long x;
+        size_t   i;
+        double   t;
+
+        if ((vals = malloc(n * sizeof(long))) == NULL
+            || (arr = malloc(n * sizeof(void *))) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        for (x = 1, i = 0; i < n; ++i) {
+                x = x * 6364136223846793005UL + 1442695040888963407UL;
+                vals[i] = (long)(x >> 16);
+        }
+
+        l = build(n);
+        t = bench_now();
+        for (i = 0; i < n; ++i)
+                arr[i] = flist_val_at_i(l, (int)i);
+        qsort(arr, n, sizeof(void *), cmp_ptr);
+        flist_free(&l, 0);
+        for (i = 0; i < n; ++i)
+                l = flist_append(l, arr[i], FLIST_DONTCLEAN);
+        bench_report("qsort", "sort", n, bench_now() - t);
+        flist_free(&l, 0);
+
+        l = build(n);
+        t = bench_now();
+        flist_sort(l, cmp);
+        bench_report("merge", "sort", n, bench_now() - t);
+        flist_free(&l, 0);
+
+        l = build(n);
+        t = bench_now();
+        flist_sort_by_key(l, key);
+        bench_report("radix", "sort", n, bench_now() - t);
+        flist_free(&l, 0);
+
+        free(arr);
+        free(vals);
+}
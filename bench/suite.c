@@ -0,0 +1,918 @@
+/*
+ * Times every public subroutine of flist.h and ftuple.h, next to baselines
+ * implemented on a plain array and on a hand-rolled intrusive list, and
+ * tuples next to the former layout keeping elements in a separate block.
+ *
+ * Usage: ./suite [-j FILE] [SIZE...]
+ *
+ * Each line reports time and allocations per element (or per call, for
+ * subroutines working on a single element) and peak RSS of the process so
+ * far. With -j the same records are written to FILE as a JSON array. Sizes
+ * default to 10, 10^3, 10^5, 10^7 and 10^8, the last one needing several GiB
+ * of memory.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "flist.h"
+
+#define MEASURE(VARIANT, OP, N, STMT) do {                          \
+        bench_start();                                              \
+        STMT;                                                       \
+        bench_stop((VARIANT), (OP), (N));                           \
+} while (0)
+
+struct node {
+        struct   node *next;
+        struct   node *prev;
+        long     val;
+};
+
+/* tuple with out-of-line elements, as ftuple used to be */
+struct split {
+        void   **arr;
+        size_t   dim;
+};
+
+static long     *vals;          /* elements of all lists */
+static void    **ptrs;          /* pointers to them */
+
+/* keep baselines from being optimized out */
+static volatile long sink;
+static void   *(*volatile map_fn)(void *);
+
+static int       never(void *);
+static int       always(void *);
+static int       every_other(void *);
+static int       never_eq(const void *, const void *);
+static int       cmp_long(const void *, const void *);
+static int       eq_long(const void *, const void *);
+static unsigned long hash_long(const void *);
+static long      key_long(const void *);
+static void     *ident(void *);
+static void     *dup_long(void *);
+static void     *next_long(void *);
+static void     *sum(void *, void *);
+static void     *fst(void *, void *);
+static size_t    enc_long(const void *, void *, size_t);
+static void      add_to(void *, void *);
+static void      add_from(void *, void *);
+static void      count_one(void *, void *);
+static int       count_down(void *, void **);
+static void      no_cleanup(void *);
+static size_t    queries(size_t);
+static struct flist *build(size_t);
+static void      write_lines(const char *, size_t);
+static void      write_records(const char *, size_t);
+static struct flist *slurp_lines(const char *, char **);
+static void      free_pair(struct ftuple *);
+static struct split *split_create(size_t, ...);
+static void      split_free(struct split *);
+static void      run_flist(size_t);
+static void      run_ftuple(size_t);
+static void      run_array(size_t);
+static void      run_intrusive(size_t);
+
+int
+main(int argc, char **argv)
+{
+        size_t   sizes[16], n, i, j;
+        long     x;
+        int      c;
+
+        while ((c = getopt(argc, argv, "j:")) != -1) {
+                if (c != 'j' || bench_json_open(optarg) != 0) {
+                        fprintf(stderr, "usage: %s [-j FILE] [SIZE...]\n",
+                            argv[0]);
+                        return EXIT_FAILURE;
+                }
+        }
+
+        map_fn = ident;
+
+        if (optind < argc) {
+                n = bench_sizes(argc - optind + 1, argv + optind - 1, sizes,
+                    16);
+        } else {
+                sizes[0] = 10;
+                sizes[1] = 1000;
+                sizes[2] = 100000;
+                sizes[3] = 10000000;
+                sizes[4] = 100000000;
+                n = 5;
+        }
+
+        for (i = 0; i < n; ++i) {
+                if ((vals = malloc(sizes[i] * sizeof(long))) == NULL
+                    || (ptrs = malloc(sizes[i] * sizeof(void *))) == NULL) {
+                        perror("malloc");
+                        return EXIT_FAILURE;
+                }
+
+                /* pseudo-random values with plenty of duplicates */
+                for (x = 1, j = 0; j < sizes[i]; ++j) {
+                        x = (x * 1103515245L + 12345L) & 0x7fffffffL;
+                        vals[j] = x % (long)(sizes[i] / 2 + 1);
+                        ptrs[j] = vals + j;
+                }
+
+                run_array(sizes[i]);
+                run_intrusive(sizes[i]);
+                run_flist(sizes[i]);
+                run_ftuple(sizes[i]);
+
+                free(ptrs);
+                free(vals);
+        }
+
+        bench_json_close();
+
+        return 0;
+}
+
+int
+never(void *x)
+{
+        return x == NULL;
+}
+
+int
+always(void *x)
+{
+        return x != NULL;
+}
+
+int
+every_other(void *x)
+{
+        return ((long *)x - vals) % 2 == 0;
+}
+
+int
+never_eq(const void *a, const void *b)
+{
+        (void)a;
+        (void)b;
+        return 1;
+}
+
+int
+cmp_long(const void *a, const void *b)
+{
+        long     x = *(const long *)a, y = *(const long *)b;
+
+        return (x > y) - (x < y);
+}
+
+int
+eq_long(const void *a, const void *b)
+{
+        return *(const long *)a == *(const long *)b;
+}
+
+unsigned long
+hash_long(const void *a)
+{
+        return (unsigned long)*(const long *)a;
+}
+
+long
+key_long(const void *a)
+{
+        return *(const long *)a;
+}
+
+void *
+ident(void *x)
+{
+        return x;
+}
+
+void *
+dup_long(void *x)
+{
+        long    *ret;
+
+        if ((ret = malloc(sizeof(long))) != NULL)
+                *ret = *(long *)x;
+
+        return ret;
+}
+
+void *
+next_long(void *x)
+{
+        long    *ret;
+
+        if ((ret = malloc(sizeof(long))) != NULL)
+                *ret = *(long *)x + 1;
+
+        return ret;
+}
+
+void *
+sum(void *a, void *b)
+{
+        long    *ret;
+
+        if ((ret = malloc(sizeof(long))) != NULL)
+                *ret = *(long *)a + *(long *)b;
+
+        return ret;
+}
+
+void *
+fst(void *a, void *b)
+{
+        (void)b;
+        return a;
+}
+
+size_t
+enc_long(const void *x, void *buf, size_t size)
+{
+        if (size >= sizeof(long))
+                memcpy(buf, x, sizeof(long));
+
+        return sizeof(long);
+}
+
+void
+add_to(void *acc, void *x)
+{
+        *(long *)acc += *(long *)x;
+}
+
+void
+count_one(void *acc, void *x)
+{
+        (void)x;
+        ++*(long *)acc;
+}
+
+void
+add_from(void *x, void *acc)
+{
+        *(long *)acc += *(long *)x;
+}
+
+int
+count_down(void *st, void **out)
+{
+        size_t  *left = st;
+
+        if (*left == 0)
+                return 0;
+
+        *out = vals + --*left;
+        return 1;
+}
+
+void
+no_cleanup(void *x)
+{
+        (void)x;
+}
+
+size_t
+queries(size_t n)
+{
+        size_t   q;
+
+        /* keeps linear-time lookups at roughly 10^8 steps in total */
+        q = 100000000 / n;
+
+        return q == 0 ? 1 : q < n ? q : n;
+}
+
+struct flist *
+build(size_t n)
+{
+        struct   flist *l;
+        size_t   i;
+
+        for (l = NULL, i = 0; i < n; ++i)
+                l = flist_append(l, ptrs[i], FLIST_DONTCLEAN);
+
+        return l;
+}
+
+void
+write_lines(const char *path, size_t n)
+{
+        FILE    *f;
+        size_t   i;
+
+        if ((f = fopen(path, "w")) == NULL) {
+                perror("fopen");
+                exit(EXIT_FAILURE);
+        }
+
+        for (i = 0; i < n; ++i)
+                fprintf(f, "%ld\n", vals[i]);
+
+        fclose(f);
+}
+
+void
+write_records(const char *path, size_t n)
+{
+        FILE    *f;
+
+        if ((f = fopen(path, "wb")) == NULL
+            || fwrite(vals, sizeof(long), n, f) != n) {
+                perror("write_records");
+                exit(EXIT_FAILURE);
+        }
+
+        fclose(f);
+}
+
+struct flist *
+slurp_lines(const char *path, char **buf)
+{
+        struct   flist *l;
+        FILE    *f;
+        char    *cur, *end, *nl;
+        long     len;
+
+        if ((f = fopen(path, "r")) == NULL || fseek(f, 0, SEEK_END) != 0
+            || (len = ftell(f)) < 0 || (*buf = malloc(len + 1)) == NULL) {
+                perror("slurp_lines");
+                exit(EXIT_FAILURE);
+        }
+
+        rewind(f);
+        len = (long)fread(*buf, 1, len, f);
+        fclose(f);
+
+        l = NULL;
+        for (cur = *buf, end = *buf + len; cur < end; cur = nl + 1) {
+                if ((nl = memchr(cur, '\n', end - cur)) == NULL)
+                        nl = end;
+
+                *nl = '\0';
+                l = flist_append(l, cur, FLIST_DONTCLEAN);
+        }
+
+        return l;
+}
+
+void
+free_pair(struct ftuple *t)
+{
+        struct   flist *a, *b;
+
+        a = ftuple_fst(t);
+        b = ftuple_snd(t);
+
+        flist_free(&a, 0);
+        flist_free(&b, 0);
+        ftuple_free(&t);
+}
+
+struct split *
+split_create(size_t dim, ...)
+{
+        va_list  args;
+        struct   split *ret;
+        size_t   i;
+
+        if ((ret = malloc(sizeof(struct split))) == NULL
+            || (ret->arr = calloc(dim, sizeof(void *))) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        ret->dim = dim;
+
+        va_start(args, dim);
+        for (i = 0; i < dim; ++i)
+                ret->arr[i] = va_arg(args, void *);
+        va_end(args);
+
+        return ret;
+}
+
+void
+split_free(struct split *t)
+{
+        free(t->arr);
+        free(t);
+}
+
+void
+run_flist(size_t n)
+{
+        struct   flist *l, *m, *r, *ls[16];
+        struct   flist_cursor c;
+        struct   flist_iter *it;
+        struct   ftuple *t;
+        long     zero = 0, *acc, mut, *scan;
+        size_t   i, q, st, rec;
+        int      ok, fd;
+        void   **out;
+        char    *buf;
+
+        if ((out = malloc(n * sizeof(void *))) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        /* construction and destruction */
+        l = NULL;
+        MEASURE("flist", "append", n,
+            for (i = 0; i < n; ++i)
+                    l = flist_append(l, ptrs[i], FLIST_DONTCLEAN));
+        MEASURE("flist", "free", n, flist_free(&l, 0));
+
+        l = NULL;
+        MEASURE("flist", "prepend", n,
+            for (i = 0; i < n; ++i)
+                    l = flist_prepend(l, ptrs[i], FLIST_DONTCLEAN));
+        flist_free(&l, 0);
+
+        l = flist_append(NULL, ptrs[0], FLIST_DONTCLEAN);
+        MEASURE("flist", "set_arena", n,
+            flist_set_arena(l, 0);
+            for (i = 1; i < n; ++i)
+                    l = flist_append(l, ptrs[i], FLIST_DONTCLEAN));
+        MEASURE("flist", "free_arena", n, flist_free(&l, 0));
+
+        MEASURE("flist", "create", n,
+            l = flist_create(&falloc_cache);
+            for (i = 0; i < n; ++i)
+                    l = flist_append(l, ptrs[i], FLIST_DONTCLEAN));
+        MEASURE("flist", "free_create", n, flist_free(&l, 0));
+
+        MEASURE("flist", "from_array", n,
+            l = flist_from_array(NULL, ptrs, n, FLIST_DONTCLEAN));
+        MEASURE("flist", "to_array", n, flist_to_array(l, out));
+        flist_free(&l, 0);
+
+        l = build(n);
+
+        MEASURE("flist", "copy", n, m = flist_copy(l, NULL));
+        flist_free(&m, 0);
+        MEASURE("flist", "copy_deep", n, m = flist_copy(l, dup_long));
+        flist_free(&m, 0);
+        MEASURE("flist", "copy_par", n, m = flist_copy_par(l, dup_long));
+        flist_free(&m, 0);
+
+        MEASURE("flist", "repeat", n, m = flist_repeat(ptrs[0], (int)n, NULL));
+        flist_free(&m, 0);
+
+        /* lazy lists, forced by taking n elements */
+        MEASURE("flist", "repeat_lazy", n,
+            m = flist_repeat_lazy(ptrs[0], NULL);
+            flist_take(&m, (int)n, 0));
+        flist_free(&m, 0);
+        MEASURE("flist", "iterate", n,
+            m = flist_iterate(&zero, FLIST_DONTCLEAN, next_long);
+            flist_take(&m, (int)n, 0));
+        flist_free(&m, 0);
+        st = n;
+        MEASURE("flist", "unfoldr", n,
+            m = flist_unfoldr(count_down, &st, FLIST_DONTCLEAN);
+            flist_length(m));
+        flist_free(&m, 0);
+        MEASURE("flist", "cycle", n,
+            m = flist_cycle(l);
+            flist_take(&m, (int)n, 0));
+        flist_free(&m, 0);
+
+        /* single element access */
+        MEASURE("flist", "set_cleanup", n,
+            for (i = 0; i < n; ++i)
+                    flist_set_cleanup(l, no_cleanup));
+        MEASURE("flist", "val_head", n,
+            for (i = 0; i < n; ++i)
+                    flist_val_head(l));
+        MEASURE("flist", "val_at_i_seq", n,
+            for (i = 0; i < n; ++i)
+                    flist_val_at_i(l, (int)i));
+
+        q = queries(n);
+        MEASURE("flist", "val_at_i_rand", q,
+            for (i = 0; i < q; ++i)
+                    flist_val_at_i(l, (int)(i * 7919 % n)));
+        flist_set_index(l, 64);
+        MEASURE("flist", "set_index", q,
+            for (i = 0; i < q; ++i)
+                    flist_val_at_i(l, (int)(i * 7919 % n)));
+        flist_set_index(l, 0);
+
+        MEASURE("flist", "elem", q,
+            for (i = 0; i < q; ++i)
+                    flist_elem(l, never_eq, ptrs[0]));
+        MEASURE("flist", "set_hash", n, flist_set_hash(l, hash_long, eq_long));
+        MEASURE("flist", "elem_hashed", n,
+            for (i = 0; i < n; ++i)
+                    flist_elem(l, never_eq, ptrs[i]));
+        flist_set_hash(l, NULL, NULL);
+
+        MEASURE("flist", "get_threads", n,
+            for (i = 0; i < n; ++i)
+                    flist_get_threads());
+        MEASURE("flist", "set_threads", 1, flist_set_threads(0));
+
+        /* traversals */
+        MEASURE("flist", "length", n, flist_length(l));
+        MEASURE("flist", "find", n, flist_find(l, never));
+        MEASURE("flist", "find_foreach", n,
+            FLIST_FOREACH(l, it) {
+                    if (*(long *)it->data == -1)
+                            break;
+            }
+            sink = it != NULL);
+        MEASURE("flist", "find_cursor", n,
+            for (ok = flist_cursor_begin(&c, &l); ok
+                && *(long *)flist_cursor_get(&c) != -1;
+                ok = flist_cursor_next(&c))
+                    ;
+            sink = ok);
+        MEASURE("flist", "find_iter", n,
+            for (it = flist_iter_first(l); it != NULL
+                && *(long *)it->data != -1; it = flist_iter_next(l, it))
+                    ;
+            sink = it != NULL);
+        MEASURE("flist", "iter_first", n,
+            for (i = 0; i < n; ++i)
+                    sink = flist_iter_first(l) != NULL);
+        MEASURE("flist", "iter_last", n,
+            for (i = 0; i < n; ++i)
+                    sink = flist_iter_last(l) != NULL);
+
+        /* backwards from the last element */
+        for (ok = flist_cursor_begin(&c, &l), i = 1; i < n; ++i)
+                ok = flist_cursor_next(&c);
+        MEASURE("flist", "find_cursor_rev", n,
+            for (; ok && *(long *)flist_cursor_get(&c) != -1;
+                ok = flist_cursor_prev(&c))
+                    ;
+            sink = ok);
+        MEASURE("flist", "cursor_set", n,
+            for (ok = flist_cursor_begin(&c, &l); ok;
+                ok = flist_cursor_next(&c))
+                    flist_cursor_set(&c, flist_cursor_get(&c),
+                        FLIST_DONTCLEAN, 0));
+
+        MEASURE("flist", "any", n, flist_any(l, never));
+        MEASURE("flist", "all", n, flist_all(l, always));
+        MEASURE("flist", "find_par", n, flist_find_par(l, never));
+        MEASURE("flist", "find_any_par", n, flist_find_any_par(l, never));
+        MEASURE("flist", "elem_par", n, flist_elem_par(l, never_eq, ptrs[0]));
+        MEASURE("flist", "any_par", n, flist_any_par(l, never));
+        MEASURE("flist", "all_par", n, flist_all_par(l, always));
+        MEASURE("flist", "map", n, flist_map(l, ident, 0));
+        MEASURE("flist", "map_par", n, flist_map_par(l, ident, 0));
+
+        MEASURE("flist", "foldl", n, acc = flist_foldl(l, &zero, sum));
+        free(acc);
+        MEASURE("flist", "foldr", n, acc = flist_foldr(l, &zero, sum));
+        free(acc);
+        MEASURE("flist", "fold_assoc", n,
+            acc = flist_fold_assoc(l, &zero, sum, sum));
+        if (acc != &zero)
+                free(acc);
+
+        mut = 0;
+        MEASURE("flist", "foldl_mut", n, flist_foldl_mut(l, &mut, add_to));
+        MEASURE("flist", "foldr_mut", n, flist_foldr_mut(l, &mut, add_from));
+        if ((scan = malloc((n + 1) * sizeof(long))) != NULL) {
+                MEASURE("flist", "scanl", n,
+                    flist_scanl(l, &mut, add_to, scan, sizeof(long)));
+                free(scan);
+        }
+
+        MEASURE("flist", "reverse", n, flist_reverse(l));
+        MEASURE("flist", "sort", n, flist_sort(l, cmp_long));
+        flist_reverse(l);
+        MEASURE("flist", "sort_by_key", n, flist_sort_by_key(l, key_long));
+
+        /* set operations */
+        MEASURE("flist", "group_by", n, m = flist_group_by(l, hash_long,
+            eq_long));
+        flist_free(&m, 0);
+        r = build(n / 2 + 1);
+        MEASURE("flist", "intersect", n, m = flist_intersect(l, r, hash_long,
+            eq_long));
+        flist_free(&m, 0);
+        MEASURE("flist", "union", n, m = flist_union(l, r, hash_long,
+            eq_long));
+        flist_free(&m, 0);
+        flist_free(&r, 0);
+
+        /* subroutines removing elements, each on a fresh list */
+        flist_free(&l, 0);
+        l = build(n);
+        MEASURE("flist", "nub", n, flist_nub(&l, hash_long, eq_long, 0));
+        flist_free(&l, 0);
+
+        l = build(n);
+        MEASURE("flist", "filter", n, flist_filter(&l, every_other, 0));
+        flist_free(&l, 0);
+
+        l = build(n);
+        MEASURE("flist", "filter_par", n, flist_filter_par(&l, every_other, 0));
+        flist_free(&l, 0);
+
+        l = build(n);
+        MEASURE("flist", "take", n, flist_take(&l, (int)(n / 2), 0));
+        flist_free(&l, 0);
+
+        l = build(n);
+        MEASURE("flist", "drop", n, flist_drop(&l, (int)(n / 2), 0));
+        flist_free(&l, 0);
+
+        l = build(n);
+        MEASURE("flist", "filter_cursor", n,
+            for (ok = flist_cursor_begin(&c, &l); ok;)
+                    ok = every_other(flist_cursor_get(&c))
+                        ? flist_cursor_next(&c) : flist_cursor_remove(&c, 0));
+        flist_free(&l, 0);
+
+        /* splitting, against copying and filtering both copies */
+        l = build(n);
+        MEASURE("flist", "partition_copy", n,
+            m = flist_copy(l, NULL);
+            flist_filter(&l, every_other, 0);
+            flist_filter(&m, every_other, 0));
+        flist_free(&l, 0);
+        flist_free(&m, 0);
+
+        l = build(n);
+        MEASURE("flist", "partition", n, t = flist_partition(&l, every_other));
+        free_pair(t);
+
+        l = build(n);
+        MEASURE("flist", "span", n, t = flist_span(&l, always));
+        free_pair(t);
+
+        l = build(n);
+        MEASURE("flist", "break", n, t = flist_break(&l, never));
+        free_pair(t);
+
+        l = build(n);
+        MEASURE("flist", "split_at", n / 2, t = flist_split_at(&l, n / 2));
+        free_pair(t);
+
+        /* joining, against appending the second list element-wise */
+        l = build(n);
+        m = build(n);
+        MEASURE("flist", "concat_copy", n,
+            for (i = 0; i < n; ++i)
+                    l = flist_append(l, flist_val_at_i(m, i),
+                        FLIST_DONTCLEAN));
+        flist_free(&l, 0);
+        flist_free(&m, 0);
+
+        l = build(n);
+        m = build(n);
+        MEASURE("flist", "concat", n, l = flist_concat(l, &m));
+        flist_free(&l, 0);
+
+        l = build(n);
+        m = build(n);
+        MEASURE("flist", "splice_at", n, l = flist_splice_at(l, n / 2, &m));
+        flist_free(&l, 0);
+
+        for (i = 0; i < 16; ++i)
+                ls[i] = build(n / 16 + 1);
+        MEASURE("flist", "concat_many", n, l = flist_concat_many(ls, 16));
+        flist_free(&l, 0);
+
+        /* loading a saved list, against building it again */
+        l = build(n);
+        MEASURE("flist", "serialize", n,
+            flist_serialize(l, "suite.flist", enc_long));
+        flist_free(&l, 0);
+        MEASURE("flist", "mmap_open", n, l = flist_mmap_open("suite.flist"));
+        mut = 0;
+        MEASURE("flist", "mmap_foldl", n, flist_foldl_mut(l, &mut, add_to));
+        flist_free(&l, 0);
+        remove("suite.flist");
+
+        /* streaming lines, against reading all of them before folding */
+        write_lines("suite.txt", n);
+        mut = 0;
+        MEASURE("flist", "lines_slurp", n,
+            l = slurp_lines("suite.txt", &buf);
+            flist_foldl_mut(l, &mut, count_one);
+            flist_free(&l, 0);
+            free(buf));
+        MEASURE("flist", "lines_from_fd", n,
+            fd = open("suite.txt", O_RDONLY);
+            l = flist_from_fd(fd, flist_split_delim, "\n");
+            flist_foldl_mut(l, &mut, count_one);
+            flist_free(&l, 0);
+            close(fd));
+        remove("suite.txt");
+
+        write_records("suite.bin", n);
+        rec = sizeof(long);
+        mut = 0;
+        MEASURE("flist", "records_from_fd", n,
+            fd = open("suite.bin", O_RDONLY);
+            l = flist_from_fd(fd, flist_split_fixed, &rec);
+            flist_foldl_mut(l, &mut, count_one);
+            flist_free(&l, 0);
+            close(fd));
+        remove("suite.bin");
+
+        l = build(n);
+        m = build(n);
+        MEASURE("flist", "zip", n, r = flist_zip(l, m));
+        MEASURE("flist", "unzip", n, t = flist_unzip(r));
+        free_pair(t);
+        flist_free(&r, 0);
+        MEASURE("flist", "zip_with", n,
+            r = flist_zip_with(l, m, fst, FLIST_DONTCLEAN));
+        flist_free(&r, 0);
+        MEASURE("flist", "zip3", n, r = flist_zip3(l, m, l));
+        flist_free(&r, 0);
+        flist_free(&l, 0);
+        flist_free(&m, 0);
+
+        l = build(n);
+        MEASURE("flist", "head", n, flist_head(l, 0));
+        flist_free(&l, 0);
+
+        l = build(n);
+        MEASURE("flist", "tail", n,
+            while (l != NULL)
+                    flist_tail(&l, 0));
+
+        free(out);
+}
+
+void
+run_ftuple(size_t n)
+{
+        struct   ftuple **t, *st;
+        struct   ftuple_pool *p;
+        struct   split **u;
+        void    *buf[FTUPLE_BUFLEN(3)];
+        size_t   i;
+
+        if ((t = malloc(n * sizeof(struct ftuple *))) == NULL
+            || (u = malloc(n * sizeof(struct split *))) == NULL
+            || (p = ftuple_pool_create(0)) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        MEASURE("ftuple", "create", n,
+            for (i = 0; i < n; ++i)
+                    t[i] = ftuple_create(3, ptrs[i], ptrs[0], ptrs[i]));
+        MEASURE("ftuple", "dim", n,
+            for (i = 0; i < n; ++i)
+                    ftuple_dim(t[i]));
+        MEASURE("ftuple", "fst", n,
+            for (i = 0; i < n; ++i)
+                    ftuple_fst(t[i]));
+        MEASURE("ftuple", "snd", n,
+            for (i = 0; i < n; ++i)
+                    ftuple_snd(t[i]));
+        MEASURE("ftuple", "nth", n,
+            for (i = 0; i < n; ++i)
+                    ftuple_nth(t[i], 2));
+        MEASURE("ftuple", "free", n,
+            for (i = 0; i < n; ++i)
+                    ftuple_free(&t[i]));
+        MEASURE("ftuple", "size", n,
+            for (i = 0; i < n; ++i)
+                    sink = (long)ftuple_size(i % 8 + 2));
+
+        MEASURE("ftuple", "from_array", n,
+            for (i = 0; i + 3 <= n; ++i)
+                    t[i] = ftuple_create_from_array(3, ptrs + i));
+        for (i = 0; i + 3 <= n; ++i)
+                ftuple_free(&t[i]);
+
+        /* twice, so that the second round reuses freed tuples */
+        MEASURE("ftuple", "pool_create", n,
+            for (i = 0; i < n; ++i)
+                    t[i] = ftuple_create_with(ftuple_pool_falloc(p), 2,
+                        ptrs[i], ptrs[0]));
+        MEASURE("ftuple", "pool_free", n,
+            for (i = 0; i < n; ++i)
+                    ftuple_free(&t[i]));
+        MEASURE("ftuple", "pool_reuse", n,
+            for (i = 0; i < n; ++i)
+                    t[i] = ftuple_create_with(ftuple_pool_falloc(p), 2,
+                        ptrs[i], ptrs[0]);
+            for (i = 0; i < n; ++i)
+                    ftuple_free(&t[i]));
+        ftuple_pool_destroy(&p);
+
+        MEASURE("ftuple", "init", n,
+            for (i = 0; i + 3 <= n; ++i) {
+                    st = ftuple_init(buf, sizeof(buf), 3, ptrs + i);
+                    sink = (long)ftuple_nth(st, 2);
+            });
+
+        MEASURE("split", "create", n,
+            for (i = 0; i < n; ++i)
+                    u[i] = split_create(3, ptrs[i], ptrs[0], ptrs[i]));
+        MEASURE("split", "nth", n,
+            for (i = 0; i < n; ++i)
+                    sink = (long)u[i]->arr[2]);
+        MEASURE("split", "free", n,
+            for (i = 0; i < n; ++i)
+                    split_free(u[i]));
+
+        free(u);
+        free(t);
+}
+
+void
+run_array(size_t n)
+{
+        void   **a, **tmp;
+        size_t   i, len, cap;
+        long     s;
+
+        MEASURE("array", "append", n,
+            for (a = NULL, len = cap = 0, i = 0; i < n; ++i) {
+                    if (len == cap) {
+                            cap = cap == 0 ? 16 : 2 * cap;
+                            if ((tmp = realloc(a, cap * sizeof(void *)))
+                                == NULL) {
+                                    perror("realloc");
+                                    exit(EXIT_FAILURE);
+                            }
+                            a = tmp;
+                    }
+                    a[len++] = ptrs[i];
+            });
+        MEASURE("array", "find", n,
+            for (i = 0; i < len && *(long *)a[i] != -1; ++i)
+                    ;
+            sink = i);
+        MEASURE("array", "map", n,
+            for (i = 0; i < len; ++i)
+                    a[i] = map_fn(a[i]));
+        MEASURE("array", "foldl", n,
+            for (s = 0, i = 0; i < len; ++i)
+                    s += *(long *)a[i];
+            sink = s);
+        MEASURE("array", "reverse", n,
+            for (i = 0; i < len / 2; ++i) {
+                    tmp = a[i];
+                    a[i] = a[len - 1 - i];
+                    a[len - 1 - i] = tmp;
+            });
+        MEASURE("array", "sort", n, qsort(a, len, sizeof(void *), cmp_long));
+        MEASURE("array", "free", n, free(a));
+}
+
+void
+run_intrusive(size_t n)
+{
+        struct   node *head, *tail, *cur, *tmp;
+        size_t   i;
+        long     s;
+
+        MEASURE("intrusive", "append", n,
+            for (head = tail = NULL, i = 0; i < n; ++i) {
+                    if ((cur = malloc(sizeof(struct node))) == NULL) {
+                            perror("malloc");
+                            exit(EXIT_FAILURE);
+                    }
+                    cur->val  = vals[i];
+                    cur->next = NULL;
+                    cur->prev = tail;
+                    if (tail == NULL)
+                            head = tail = cur;
+                    else
+                            tail = tail->next = cur;
+            });
+        MEASURE("intrusive", "find", n,
+            for (cur = head; cur != NULL && cur->val != -1; cur = cur->next)
+                    ;
+            sink = cur != NULL);
+        MEASURE("intrusive", "map", n,
+            for (cur = head; cur != NULL; cur = cur->next)
+                    cur->val = *(long *)map_fn(&cur->val));
+        MEASURE("intrusive", "foldl", n,
+            for (s = 0, cur = head; cur != NULL; cur = cur->next)
+                    s += cur->val;
+            sink = s);
+        MEASURE("intrusive", "reverse", n,
+            for (cur = head; cur != NULL; cur = cur->prev) {
+                    tmp = cur->next;
+                    cur->next = cur->prev;
+                    cur->prev = tmp;
+            }
+            tmp = head;
+            head = tail;
+            tail = tmp);
+        MEASURE("intrusive", "free", n,
+            for (cur = head; cur != NULL; cur = tmp) {
+                    tmp = cur->next;
+                    free(cur);
+            });
+}
@@ -0,0 +1,135 @@
+/*
+ * Compares the one-element-per-node flist against the unrolled fulist.
+ *
+ * Usage: ./unrolled [SIZE...]
+ */
+
+#include "bench.h"
+#include "fulist.h"
+
+static int       dummy;
+
+static int       never(void *);
+static int       every_other(void *);
+static void     *ident(void *);
+static void      run_flist(size_t);
+static void      run_fulist(size_t);
+
+int
+main(int argc, char **argv)
+{
+        size_t   sizes[16], n, i;
+
+        n = bench_sizes(argc, argv, sizes, 16);
+        for (i = 0; i < n; ++i) {
+                run_flist(sizes[i]);
+                run_fulist(sizes[i]);
+        }
+
+        return 0;
+}
+
+int
+never(void *x)
+{
+        return x == NULL;
+}
+
+int
+every_other(void *x)
+{
+        static int flip;
+
+        (void)x;
+        return flip ^= 1;
+}
+
+void *
+ident(void *x)
+{
+        return x;
+}
+
+void
+run_flist(size_t n)
+{
+        struct   flist *l;
+        size_t   i;
+        double   t;
+
+        t = bench_now();
+        for (l = NULL, i = 0; i < n; ++i)
+                l = flist_append(l, &dummy, FLIST_DONTCLEAN);
+        bench_report("flist", "append", n, bench_now() - t);
+
+        t = bench_now();
+        flist_find(l, never);
+        bench_report("flist", "find", n, bench_now() - t);
+
+        t = bench_now();
+        flist_map(l, ident, 0);
+        bench_report("flist", "map", n, bench_now() - t);
+
+        t = bench_now();
+        flist_reverse(l);
+        bench_report("flist", "reverse", n, bench_now() - t);
+
+        t = bench_now();
+        flist_filter(&l, every_other, 0);
+        bench_report("flist", "filter", n, bench_now() - t);
+
+        t = bench_now();
+        flist_drop(&l, n / 8, 0);
+        bench_report("flist", "drop", n / 8, bench_now() - t);
+
+        t = bench_now();
+        flist_take(&l, n / 4, 0);
+        bench_report("flist", "take", n / 8, bench_now() - t);
+
+        n = flist_length(l);
+        t = bench_now();
+        flist_free(&l, 0);
+        bench_report("flist", "free", n, bench_now() - t);
+}
+
+void
+run_fulist(size_t n)
+{
+        struct   fulist *l;
+        size_t   i;
+        double   t;
+
+        t = bench_now();
+        for (l = NULL, i = 0; i < n; ++i)
+                l = fulist_append(l, &dummy, FLIST_DONTCLEAN);
+        bench_report("fulist", "append", n, bench_now() - t);
+
+        t = bench_now();
+        fulist_find(l, never);
+        bench_report("fulist", "find", n, bench_now() - t);
+
+        t = bench_now();
+        fulist_map(l, ident, 0);
+        bench_report("fulist", "map", n, bench_now() - t);
+
+        t = bench_now();
+        fulist_reverse(l);
+        bench_report("fulist", "reverse", n, bench_now() - t);
+
+        t = bench_now();
+        fulist_filter(&l, every_other, 0);
+        bench_report("fulist", "filter", n, bench_now() - t);
+
+        t = bench_now();
+        fulist_drop(&l, n / 8, 0);
+        bench_report("fulist", "drop", n / 8, bench_now() - t);
+
+        t = bench_now();
+        fulist_take(&l, n / 4, 0);
+        bench_report("fulist", "take", n / 8, bench_now() - t);
+
+        n = fulist_length(l);
+        t = bench_now();
+        fulist_free(&l, 0);
+        bench_report("fulist", "free", n, bench_now() - t);
+}
@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for @p falloc module
+ */
+
+#include "include/falloc.h"
+
+#include <pthread.h>
+
+#define CACHE_GRAIN    16  /**< @brief Granularity of size classes (bytes) */
+#define CACHE_CLASSES  16  /**< @brief Number of size classes */
+#define CACHE_DEPTH    512 /**< @brief Blocks cached per class and thread */
+
+/**
+ * @brief Free block kept in a cache
+ */
+struct cache_blk {
+        struct       cache_blk *next;   /**< @brief Next free block */
+};
+
+/**
+ * @brief Per-thread cache of free blocks
+ *
+ * Class i holds blocks of (i + 1) * @a CACHE_GRAIN bytes.
+ */
+struct cache {
+        struct       cache_blk *head[CACHE_CLASSES]; /**< @brief Free lists */
+        size_t       cnt[CACHE_CLASSES]; /**< @brief Lengths of free lists */
+};
+
+/**
+ * @fn static void *std_alloc(void *ctx, size_t size)
+ * @brief Allocation function of @a falloc_malloc
+ */
+static void     *std_alloc(void *, size_t);
+
+/**
+ * @fn static void std_free(void *ctx, void *ptr, size_t size)
+ * @brief Release function of @a falloc_malloc
+ */
+static void      std_free(void *, void *, size_t);
+
+/**
+ * @fn static void *cache_alloc(void *ctx, size_t size)
+ * @brief Allocation function of @a falloc_cache
+ *
+ * Falls back to plain malloc() for large blocks and when the cache of calling
+ * thread cannot be created.
+ */
+static void     *cache_alloc(void *, size_t);
+
+/**
+ * @fn static void cache_free(void *ctx, void *ptr, size_t size)
+ * @brief Release function of @a falloc_cache
+ *
+ * Never creates a cache, so blocks freed by exiting threads after their caches
+ * were destroyed go straight to free().
+ */
+static void      cache_free(void *, void *, size_t);
+
+/**
+ * @fn static void cache_make_key(void)
+ * @brief Creates key of per-thread caches
+ */
+static void      cache_make_key(void);
+
+/**
+ * @fn static void cache_destroy(void *c)
+ * @brief Frees cache @p c along with all blocks it holds
+ *
+ * @param[in] c Target cache
+ */
+static void      cache_destroy(void *);
+
+const struct falloc falloc_malloc = { std_alloc, std_free, NULL };
+const struct falloc falloc_cache  = { cache_alloc, cache_free, NULL };
+
+static const struct falloc *dflt = &falloc_malloc;
+
+static pthread_once_t    cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t     cache_key;
+static int               cache_ok;      /* was the key created? */
+
+void
+falloc_set_default(const struct falloc *a)
+{
+        dflt = a == NULL ? &falloc_malloc : a;
+}
+
+const struct falloc *
+falloc_get_default(void)
+{
+        return dflt;
+}
+
+void
+falloc_cache_trim(void)
+{
+        struct   cache *c;
+
+        pthread_once(&cache_once, cache_make_key);
+
+        if (!cache_ok || (c = pthread_getspecific(cache_key)) == NULL)
+                return;
+
+        pthread_setspecific(cache_key, NULL);
+        cache_destroy(c);
+}
+
+void *
+std_alloc(void *ctx, size_t size)
+{
+        (void)ctx;
+
+        return malloc(size);
+}
+
+void
+std_free(void *ctx, void *ptr, size_t size)
+{
+        (void)ctx;
+        (void)size;
+
+        free(ptr);
+}
+
+void *
+cache_alloc(void *ctx, size_t size)
+{
+        struct   cache *c;
+        struct   cache_blk *ret;
+        size_t   cls;
+
+        (void)ctx;
+
+        if (size == 0 || size > CACHE_CLASSES * CACHE_GRAIN)
+                return malloc(size);
+
+        cls = (size - 1) / CACHE_GRAIN;
+
+        pthread_once(&cache_once, cache_make_key);
+        if (!cache_ok)
+                return malloc((cls + 1) * CACHE_GRAIN);
+
+        if ((c = pthread_getspecific(cache_key)) == NULL) {
+                if ((c = calloc(1, sizeof(struct cache))) == NULL
+                    || pthread_setspecific(cache_key, c) != 0) {
+                        free(c);
+                        return malloc((cls + 1) * CACHE_GRAIN);
+                }
+        }
+
+        if ((ret = c->head[cls]) == NULL)
+                return malloc((cls + 1) * CACHE_GRAIN);
+
+        c->head[cls] = ret->next;
+        c->cnt[cls]--;
+
+        return ret;
+}
+
+void
+cache_free(void *ctx, void *ptr, size_t size)
+{
+        struct   cache *c;
+        struct   cache_blk *blk;
+        size_t   cls;
+
+        (void)ctx;
+
+        if (ptr == NULL)
+                return;
+
+        pthread_once(&cache_once, cache_make_key);
+
+        if (size == 0 || size > CACHE_CLASSES * CACHE_GRAIN || !cache_ok
+            || (c = pthread_getspecific(cache_key)) == NULL) {
+                free(ptr);
+                return;
+        }
+
+        cls = (size - 1) / CACHE_GRAIN;
+        if (c->cnt[cls] == CACHE_DEPTH) {
+                free(ptr);
+                return;
+        }
+
+        blk = ptr;
+        blk->next = c->head[cls];
+        c->head[cls] = blk;
+        c->cnt[cls]++;
+}
+
+void
+cache_make_key(void)
+{
+        cache_ok = pthread_key_create(&cache_key, cache_destroy) == 0;
+}
+
+void
+cache_destroy(void *p)
+{
+        struct   cache *c;
+        struct   cache_blk *cur, *tmp;
+        size_t   i;
+
+        c = p;
+
+        for (i = 0; i < CACHE_CLASSES; ++i) {
+                for (cur = c->head[i]; cur != NULL; cur = tmp) {
+                        tmp = cur->next;
+                        free(cur);
+                }
+        }
+
+        free(c);
+}
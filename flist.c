@@ -30,106 +30,686 @@
  * always and then discover some weird bug trying to use it.
  */
 
-#include "include/flist.h"
+#include "flist_impl.h"
+#include "fpool.h"
+#include "fstats_impl.h"
+#include "ftuple_impl.h"
+
+#include <sys/mman.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
- * @brief Error-reporting macro
+ * @brief Description of a parallel job over a list
  *
- * This macro is intended to be used upon detection of unrecoverable error in
- * a standard library subroutine. It informs about location where the error
- * occured, prints error information and exits with a failure code.
+ * The list is split into `nseg` segments, k-th of which starts at node
+ * `first[k]` and covers positions from `off[k]` up to (but excluding)
+ * `off[k + 1]`. Depending on which one of `f` and `p` is set, each task stores
+ * either results of `f` in `res` or results of `p` in `keep`, both indexed by
+ * position in the list. If `fold` is set instead, k-th task folds its segment
+ * starting from `x` and stores the result as `res[k]`.
  *
- * @param[in] X Subroutine that failed
+ * @see par_run()
  */
-#define ERROR(X) do {                                       \
-        fprintf(stderr, "[%s:%d] ", __FILE__, __LINE__);    \
-        perror((X));                                        \
-        exit(EXIT_FAILURE);                                 \
-} while (0);
+struct par_job {
+        struct       flist_iter **first; /**< @brief First node of segments */
+        size_t      *off;               /**< @brief Offsets of segments */
+        size_t       nseg;              /**< @brief Number of segments */
+        size_t       len;               /**< @brief Number of elements */
+
+        void      *(*f)(void *);        /**< @brief Function to apply */
+        int        (*p)(void *);        /**< @brief Predicate to evaluate */
+        void      *(*fold)(void *, void *); /**< @brief Folding function */
+        void        *x;                 /**< @brief Starting element of fold */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler of list */
+        void       **res;               /**< @brief Results of `f` or `fold` */
+        char        *keep;              /**< @brief Results of `p` */
+};
 
 /**
- * @brief Node of `flist`
+ * @brief Description of a single level of tree reduction
  *
- * This structure works both as a node as well as the iterator. The `flist` is
- * implemented to be a doubly linked list storing data in form of void pointers
- * to mimic generics. Moreover, each node contains a two-flag bitfield which
- * stores information used by `flist_free()` upon list deletion.
+ * Task k combines `part[2 * k * step]` with `part[(2 * k + 1) * step]`.
  *
- * @see flist_free()
+ * @see comb_task()
  */
-struct flist_iter {
-        struct       flist_iter *next;  /**< @brief Next node */
-        struct       flist_iter *prev;  /**< @brief Previous node */
-        void        *data;              /**< @brief Pointer to the data */
-
-        unsigned     call_h : 1;        /**< @brief Call cleanup handler? */
-        unsigned     prot_h : 1;        /**< @brief Call cleanup iff forced? */
+struct comb_job {
+        void       **part;              /**< @brief Partial results */
+        size_t       step;              /**< @brief Distance between operands */
+        void      *(*combine)(void *, void *); /**< @brief Combining function */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler of list */
 };
 
 /**
- * @brief A doubly linked list
+ * @brief Description of a parallel search over a list
  *
- * This structure is implemented to serve as an interface to a chain of
- * `flist_iter` nodes.
+ * Segments are laid out as in @a par_job, but there are several of them per
+ * thread so that threads which stop early pick up more work. An element
+ * matches if truth of `p` on it equals truth of `want` or, with `cmp` set,
+ * if it compares equal to `key`. `hit` is the lowest position of a match
+ * found so far, tasks stop as soon as no position they have left can improve
+ * on it or, if `any` is set, as soon as there is one.
  *
- * @see flist_iter
+ * @see find_run()
+ */
+struct find_job {
+        struct       flist_iter **first; /**< @brief First node of segments */
+        size_t      *off;               /**< @brief Offsets of segments */
+        size_t       nseg;              /**< @brief Number of segments */
+
+        int        (*p)(void *);        /**< @brief Predicate to evaluate */
+        int          want;              /**< @brief Truth of `p` searched for */
+        int        (*cmp)(const void *, const void *); /**< @brief Comparison */
+        const void  *key;               /**< @brief Element compared with */
+        int          any;               /**< @brief Accept any match? */
+
+        pthread_mutex_t lock;           /**< @brief Guards `hit` and `node` */
+        size_t       hit;               /**< @brief Position of best match */
+        struct       flist_iter *node;  /**< @brief Node of best match */
+};
+
+/**
+ * @brief Node paired with its key, as sorted by @a flist_sort_by_key()
  */
-struct flist {
-        struct       flist_iter *head;  /**< @brief Head of the list */
-        struct       flist_iter *tail;  /**< @brief Tail of the list */
-        void       (*cl_hand)(void *);  /**< @brief Cleanup handler */
-        size_t       len;               /**< @brief Length of the list */
+struct sort_key {
+        unsigned long key;              /**< @brief Key, sign bit flipped */
+        struct       flist_iter *node;  /**< @brief Keyed node */
 };
 
+static char      hidx_tomb;     /**< @brief Marks slots of removed entries */
+
+#define TOMB ((void *)&hidx_tomb) /**< @brief Value of a removed entry */
+
+#define FIND_SEGS 16 /**< @brief Segments per thread of parallel searches */
+
+#ifdef FLIST_COMPACT
+/** @brief Fails to compile unless node links have three spare bits */
+typedef char compact_check[sizeof(void *) >= 8 ? 1 : -1];
+#endif
+
 /**
- * @fn struct flist new_list(void)
+ * @fn struct flist *new_list(const struct falloc *a)
  * @brief Creates new list
  *
- * @todo Allow for more flexible error handling
+ * Creates and returns a pointer to a new, empty list allocated with @p a, or
+ * with the default allocator if @p a is NULL. Returns NULL and sets errno to
+ * ENOMEM if allocation fails.
  *
- * Creates and returns a pointer to a new, empty list. Treats malloc failure as
- * an unrecoverable error (for now at least).
+ * @param[in] a Allocator of the list and its nodes
  */
-static struct flist         *new_list(void);
+static struct flist         *new_list(const struct falloc *);
 
 /**
- * @fn struct flist_iter new_node(void *dat, struct flist_iter *prev, struct
- *  flist_iter *next, unsigned flags)
+ * @fn struct flist_iter new_node(struct flist *l, void *dat, struct
+ *  flist_iter *prev, struct flist_iter *next, unsigned flags)
  * @brief Creates new node of a linked list
  *
  * Creates and returns a pointer to a new node of @a flist initialized with
- * data passed as arguments. Treats malloc failure as an unrecoverable error
- * (for now at least).
- *
- * @todo Allow for more flexible error handling
+ * data passed as arguments. If @p l is in arena mode, node is taken from its
+ * arena, otherwise it is allocated on its own with the allocator of @p l.
+ * Returns NULL and sets errno to ENOMEM if either the node or room for it in
+ * hash index of @p l cannot be allocated.
  *
+ * @param[in] l List the node will belong to
  * @param[in] dat Data to store in the node
  * @param[in] prev Pointer to previous node
  * @param[in] next Pointer to next node
  * @param[in] flags Flags as defined in @a flist_append()
  * @see flist_append()
  */
-static struct flist_iter    *new_node(void *, struct flist_iter *,
-    struct flist_iter *, unsigned);
+static struct flist_iter    *new_node(struct flist *, void *,
+    struct flist_iter *, struct flist_iter *, unsigned);
+
+/**
+ * @fn void del_node(struct flist *l, struct flist_iter *node, int force)
+ * @brief Cleans up and releases a node
+ *
+ * Calls cleanup handler of @p l on data stored in @p node if its flags (and
+ * @p force) say so and then gives the node back either to the arena or to the
+ * allocator of @p l. Node is expected to be already unlinked from the list.
+ *
+ * @param[in] l List the node belongs to
+ * @param[in] node Node to release
+ * @param[in] force Same as in @a flist_free()
+ */
+static void                  del_node(struct flist *, struct flist_iter *,
+    int);
+
+/**
+ * @fn void del_chain(struct flist *l, struct flist_iter *first,
+ *  struct flist_iter *last, size_t n, int force)
+ * @brief Cleans up and releases a chain of @p n nodes
+ *
+ * Same as @a del_node() called on every node from @p first to @p last,
+ * following `next` links, except that the decisions are taken once for the
+ * whole chain whenever `kinds` of @p l allows. Elements of lists whose nodes
+ * are never cleaned up are then not looked at at all, and if all their nodes
+ * come from slabs, they go back to the arena in one step. Lists with a hash
+ * index go through @a del_node(). The chain is expected to be already
+ * unlinked from the list.
+ *
+ * @param[in] l List the nodes belong to
+ * @param[in] first First node of the chain, may be NULL if @p n is zero
+ * @param[in] last Last node of the chain
+ * @param[in] n Number of nodes
+ * @param[in] force Same as in @a flist_free()
+ */
+static void                  del_chain(struct flist *, struct flist_iter *,
+    struct flist_iter *, size_t, int);
+
+/**
+ * @fn struct flist_iter *arena_alloc(struct flist *l)
+ * @brief Takes a node from the arena of @p l
+ *
+ * Returns NULL if a new slab was needed but could not be allocated.
+ *
+ * @param[in] l Source list, has an arena
+ */
+static struct flist_iter    *arena_alloc(struct flist *);
+
+/**
+ * @fn int par_run(struct flist *l, struct par_job *job)
+ * @brief Splits @p l into balanced segments and runs @p job on the pool
+ *
+ * Allocates `res` or `keep` arrays of @p job (depending on which callback is
+ * set) with the allocator of @p l, the caller is responsible for freeing them
+ * with @a par_free(). Returns 0 on success. If memory runs out, nothing is run
+ * and -1 is returned with errno set to ENOMEM.
+ *
+ * @param[in] l Source list, nonempty
+ * @param[in,out] job Job description with callback set
+ */
+static int                   par_run(struct flist *, struct par_job *);
+
+/**
+ * @fn void par_free(const struct falloc *a, struct par_job *job)
+ * @brief Frees arrays of @p job allocated with @p a by @a par_run()
+ */
+static void                  par_free(const struct falloc *, struct par_job *);
+
+/**
+ * @fn void par_task(void *job, size_t k)
+ * @brief Processes @p k th segment of a @a par_job
+ *
+ * @param[in,out] job Job being executed
+ * @param[in] k Segment to process
+ */
+static void                  par_task(void *, size_t);
+
+/**
+ * @fn struct flist_iter *find_run(struct flist *l, struct find_job *job)
+ * @brief Runs search @p job over @p l on the pool
+ *
+ * Lazy @p l is forced entirely first, NULL is returned if that fails. Returns
+ * node of the match, or NULL if there is none. Searches serially if memory for
+ * the parallel one runs out.
+ *
+ * @param[in] l Source list
+ * @param[in,out] job Job description with `p` or `cmp` set
+ */
+static struct flist_iter    *find_run(struct flist *, struct find_job *);
+
+/**
+ * @fn int find_match(struct find_job *job, void *dat)
+ * @brief Is element @p dat what @p job searches for?
+ */
+static int                   find_match(struct find_job *, void *);
+
+/**
+ * @fn void find_task(void *job, size_t k)
+ * @brief Searches @p k th segment of a @a find_job
+ *
+ * @param[in,out] job Job being executed
+ * @param[in] k Segment to search
+ */
+static void                  find_task(void *, size_t);
+
+/**
+ * @fn void comb_task(void *job, size_t k)
+ * @brief Performs @p k th combination of a @a comb_job
+ *
+ * @param[in,out] job Job being executed
+ * @param[in] k Combination to perform
+ */
+static void                  comb_task(void *, size_t);
+
+/**
+ * @fn void arena_free(struct flist *l)
+ * @brief Releases all slabs of the arena of @p l and the arena itself
+ *
+ * Arenas shared with other lists are only detached from @p l.
+ *
+ * @param[in,out] l Target list, its arena may be NULL
+ */
+static void                  arena_free(struct flist *);
+
+/**
+ * @fn void arena_merge(struct flist *dst, struct flist *src)
+ * @brief Makes arena of @p dst own nodes of arena of @p src
+ *
+ * Used before nodes of @p src move to @p dst. If @p dst has no arena, it takes
+ * over the one of @p src. Otherwise slabs of the arena of @p src move to the
+ * arena of @p dst and the former starts forwarding to the latter, so that
+ * other lists sharing it keep working. Both lists have to use the same
+ * allocator.
+ *
+ * @param[in,out] dst Target list
+ * @param[in,out] src Source list
+ */
+static void                  arena_merge(struct flist *, struct flist *);
+
+/**
+ * @fn struct flist_iter *node_at(struct flist *l, size_t i)
+ * @brief Returns node at position @p i of @p l
+ *
+ * Starts walking from whichever of head, tail, finger or checkpoint is the
+ * closest and moves the finger to the returned node. Extends checkpoints if
+ * @p i lies past the last one, unless memory for them runs out.
+ *
+ * @param[in] l Source list
+ * @param[in] i Position, less than length of already forced part of @p l
+ */
+static struct flist_iter    *node_at(struct flist *, size_t);
+
+/**
+ * @fn void idx_truncate(struct flist *l, size_t n)
+ * @brief Discards positional hints pointing at or past position @p n
+ *
+ * Has to be called whenever nodes are removed from or reordered in @p l,
+ * passing zero discards all hints.
+ *
+ * @param[in] l Target list
+ * @param[in] n First position no longer valid
+ */
+static void                  idx_truncate(struct flist *, size_t);
+
+/**
+ * @fn int force_upto(struct flist *l, size_t n)
+ * @brief Forces elements of a lazy list until there are at least @p n of them
+ *
+ * Stops early if the generator gets exhausted, does nothing if @p l is NULL.
+ * Returns zero, or -1 with errno set if forcing fails.
+ *
+ * @param[in] l Target list
+ * @param[in] n Required number of forced elements
+ */
+static int                   force_upto(struct flist *, size_t);
+
+/**
+ * @fn void gen_free(struct flist *l, int force)
+ * @brief Releases generator of @p l, if any, turning it into an eager list
+ *
+ * Does nothing if @p l is NULL.
+ *
+ * @param[in] l Target list
+ * @param[in] force Same as in @a flist_free()
+ */
+static void                  gen_free(struct flist *, int);
+
+/**
+ * @brief State of generators created by @a flist_iterate()
+ *
+ * The next element is computed as soon as the previous one is forced, since
+ * it may have been freed by the time the following one is needed.
+ */
+struct iterate_st {
+        void      *(*f)(void *);        /**< @brief Iterated function */
+        void        *next;              /**< @brief Next element */
+        unsigned     flags;             /**< @brief Inflags of next element */
+};
+
+/**
+ * @brief State of generators created by @a flist_unfoldr()
+ */
+struct unfoldr_st {
+        int        (*f)(void *, void **); /**< @brief Unfolding function */
+        void        *seed;              /**< @brief Seed passed to `f` */
+        unsigned     flags;             /**< @brief Inflags of elements */
+};
+
+/**
+ * @brief State of generators created by @a flist_cycle()
+ */
+struct cycle_st {
+        struct       flist *src;        /**< @brief Cycled list */
+        struct       flist_iter *pos;   /**< @brief Next node to repeat */
+};
+
+/**
+ * @brief State of generators created by @a flist_repeat_lazy()
+ */
+struct repeat_st {
+        void        *dat;               /**< @brief Repeated element */
+        void      *(*copy_c)(void *);   /**< @brief Copy constructor */
+};
+
+/**
+ * @brief State of @a flist_zip() and relatives
+ *
+ * `pos` holds the nodes of the elements combined last, all NULL before the
+ * first step. Lists are advanced in order given by `ord`, where eager lists
+ * go first, so that lazy ones are not forced past the end of others. Without
+ * `f`, elements are joined into tuples.
+ */
+struct zip_st {
+        struct       flist *src[3];     /**< @brief Zipped lists */
+        struct       flist_iter *pos[3]; /**< @brief Current nodes */
+        size_t       ord[3];            /**< @brief Order of advancing */
+        size_t       k;                 /**< @brief Number of lists */
+        void      *(*f)(void *, void *); /**< @brief Combining function */
+        unsigned     flags;             /**< @brief Inflags of elements */
+};
+
+/** @brief Generating function of @a flist_iterate() */
+static int                   iterate_step(struct flist_gen *, void **,
+    unsigned *);
+/** @brief Releasing function of @a flist_iterate() */
+static void                  iterate_release(struct flist_gen *,
+    struct flist *, int);
+/** @brief Generating function of @a flist_unfoldr() */
+static int                   unfoldr_step(struct flist_gen *, void **,
+    unsigned *);
+/** @brief Generating function of @a flist_cycle() */
+static int                   cycle_step(struct flist_gen *, void **,
+    unsigned *);
+/** @brief Generating function of @a flist_repeat_lazy() */
+static int                   repeat_step(struct flist_gen *, void **,
+    unsigned *);
+/** @brief Generating function of lazy @a flist_zip() and relatives */
+static int                   zip_step(struct flist_gen *, void **,
+    unsigned *);
+/**
+ * @fn struct flist_iter *merge_runs(struct flist_iter *a, struct flist_iter
+ *  *b, int (*cmp)(const void *, const void *))
+ * @brief Merges two sorted, NULL-terminated chains of nodes
+ *
+ * Only `next` links are maintained. On ties nodes of @p a go first, so passing
+ * the chain of earlier elements as @p a keeps the merge stable.
+ *
+ * @param[in] a Chain of earlier elements
+ * @param[in] b Chain of later elements
+ * @param[in] cmp Comparison function
+ */
+static struct flist_iter    *merge_runs(struct flist_iter *,
+    struct flist_iter *, int (*)(const void *, const void *));
+
+/**
+ * @fn void relink(struct flist *l)
+ * @brief Restores `prev` links and tail of @p l after its `next` links changed
+ */
+static void                  relink(struct flist *);
+
+/**
+ * @fn unsigned long hidx_mix(unsigned long h)
+ * @brief Scrambles bits of user-supplied hash @p h
+ *
+ * Tables use low bits of hashes only, which makes weak hashing functions (say,
+ * identity on integers) cluster badly unless high bits are mixed in.
+ */
+static unsigned long         hidx_mix(unsigned long);
+
+/**
+ * @fn struct flist_hent *hidx_find(struct flist_hidx *h, const void *key,
+ *  unsigned long hv)
+ * @brief Returns first entry of @p h with key equal to @p key, or NULL
+ *
+ * @param[in] h Searched table
+ * @param[in] key Key to look for
+ * @param[in] hv Mixed hash of @p key
+ */
+static struct flist_hent    *hidx_find(struct flist_hidx *, const void *,
+    unsigned long);
+
+/**
+ * @fn int hidx_reserve(struct flist_hidx *h, size_t n)
+ * @brief Makes room for @p n more entries of @p h
+ *
+ * Returns 0 on success. If memory runs out, sets errno to ENOMEM and returns
+ * -1, leaving @p h as it was.
+ */
+static int                   hidx_reserve(struct flist_hidx *, size_t);
+
+/**
+ * @fn void hidx_place(struct flist_hidx *h, const void *key, unsigned long
+ *  hv, void *val)
+ * @brief Adds entry to @p h, room for which has been reserved
+ *
+ * Entry is added even if one with equal key is already there.
+ *
+ * @param[in] h Target table
+ * @param[in] key Key of the entry
+ * @param[in] hv Mixed hash of @p key
+ * @param[in] val Nonnull value of the entry
+ */
+static void                  hidx_place(struct flist_hidx *, const void *,
+    unsigned long, void *);
+
+/**
+ * @fn int hidx_insert(struct flist_hidx *h, const void *key, unsigned long
+ *  hv, void *val)
+ * @brief Reserves room for an entry of @p h and adds it
+ *
+ * Returns 0 on success, otherwise -1 with errno set to ENOMEM.
+ *
+ * @see hidx_place()
+ */
+static int                   hidx_insert(struct flist_hidx *, const void *,
+    unsigned long, void *);
+
+/**
+ * @fn void hidx_clear(struct flist_hidx *h)
+ * @brief Frees slots of @p h, leaving it empty
+ */
+static void                  hidx_clear(struct flist_hidx *);
+
+/**
+ * @fn void hidx_remove(struct flist_hidx *h, unsigned long hv, void *val)
+ * @brief Removes entry with value @p val and key hashing to @p hv from @p h
+ */
+static void                  hidx_remove(struct flist_hidx *, unsigned long,
+    void *);
+
+/**
+ * @fn void hidx_fill(struct flist *l)
+ * @brief (Re)builds hash index of @p l from scratch
+ *
+ * The index is only an accelerator, so if memory runs out it is dropped.
+ */
+static void                  hidx_fill(struct flist *);
+
+/**
+ * @fn struct flist *ref_append(struct flist *ret, struct flist *src, struct
+ *  flist_iter *node)
+ * @brief Appends element of @p node, a node of @p src, to @p ret
+ *
+ * Element is added in the same way as @a flist_copy() does for shallow copies.
+ * Returns the possibly newly created list, or NULL with errno set to ENOMEM,
+ * in which case @p ret is left intact.
+ */
+static struct flist         *ref_append(struct flist *, struct flist *,
+    struct flist_iter *);
+
+/**
+ * @fn int merge_check(struct flist **ls, size_t k, void (**hand)(void *))
+ * @brief Checks whether nodes of @p k lists @p ls can be merged into one list
+ *
+ * Lists can be merged if they use the same allocator and at most one cleanup
+ * handler applies to their elements, which is then stored through @p hand.
+ * Returns 0 if they can, otherwise sets errno to EINVAL and returns -1.
+ *
+ * @param[in] ls Lists, NULL ones are skipped
+ * @param[in] k Number of lists
+ * @param[out] hand Cleanup handler of the merged list
+ */
+static int                   merge_check(struct flist **, size_t,
+    void (**)(void *));
+
+/**
+ * @fn int needs_hand(struct flist *l)
+ * @brief Checks whether cleanup handler of @p l may ever be called
+ *
+ * That is, whether @p l holds cleanable elements or is lazy.
+ *
+ * @param[in] l Target list
+ */
+static int                   needs_hand(struct flist *);
+
+/**
+ * @fn void chain_move(struct flist *dst, struct flist *src,
+ *  struct flist_iter *at)
+ * @brief Moves all nodes of @p src before node @p at of @p dst and frees @p src
+ *
+ * If @p at is NULL, nodes are appended and @p dst, which has to be eager,
+ * inherits generator of @p src. Otherwise @p src has to be eager. Lists have to
+ * pass @a merge_check() and hash index of @p dst, if any, must have room for
+ * nodes of @p src reserved.
+ *
+ * @param[in,out] dst Target list
+ * @param[in] src Source list
+ * @param[in] at Node of @p dst to insert before, or NULL
+ */
+static void                  chain_move(struct flist *, struct flist *,
+    struct flist_iter *);
+
+/**
+ * @fn int append_or_drop(struct flist *l, void *dat, unsigned flags)
+ * @brief Appends @p dat to @p l or cleans it up if that is impossible
+ *
+ * Used by subroutines building lists of freshly made elements, which would
+ * otherwise leak if a node could not be allocated for them. On failure, @p dat
+ * is passed to the cleanup handler of @p l if @p flags would make
+ * @a flist_free() do so. Returns 0 on success and -1 on failure.
+ *
+ * @param[in] l Target list
+ * @param[in] dat Data to insert
+ * @param[in] flags Flags to add
+ */
+static int                   append_or_drop(struct flist *, void *, unsigned);
+
+/**
+ * @fn struct ftuple *split_begin(struct flist *l, struct flist **part)
+ * @brief Allocates everything a split of @p l needs
+ *
+ * Allocates the resulting pair and, through @p part, a new empty list with
+ * cleanup handler and positional index settings of @p l. Both use allocator
+ * of @p l. Returns NULL and sets errno to ENOMEM if allocation fails.
+ *
+ * @param[in] l List to be split
+ * @param[out] part New list
+ */
+static struct ftuple        *split_begin(struct flist *, struct flist **);
+
+/**
+ * @fn void split_cut(struct flist *l, struct flist *a, struct flist_iter *cut,
+ *  size_t n)
+ * @brief Moves first @p n nodes of @p l, up to @p cut, to empty list @p a
+ *
+ * @param[in,out] l Source list
+ * @param[in,out] a Target list
+ * @param[in] cut First node to stay in @p l, NULL if all nodes move
+ * @param[in] n Number of nodes preceding @p cut
+ */
+static void                  split_cut(struct flist *, struct flist *,
+    struct flist_iter *, size_t);
+
+/**
+ * @fn struct ftuple *split_end(struct ftuple *t, struct flist *l,
+ *  struct flist *part, int part_first)
+ * @brief Finishes split of @p l into @p l and @p part, storing both in @p t
+ *
+ * Shares arena of @p l with @p part, indexes @p part the same way @p l is
+ * indexed and rebuilds the index of @p l. Lists left empty are freed and
+ * stored as NULL.
+ *
+ * @param[in,out] t Resulting pair
+ * @param[in] l What is left of the original list
+ * @param[in] part List made of nodes moved from @p l
+ * @param[in] part_first Store @p part as the first element of @p t?
+ */
+static struct ftuple        *split_end(struct ftuple *, struct flist *,
+    struct flist *, int);
+
+/**
+ * @fn struct ftuple *span_with(struct flist **lp, int (*p)(void *), int want)
+ * @brief Implements @a flist_span() and @a flist_break()
+ *
+ * Prefix extends as long as truth of @p p matches truth of @p want.
+ */
+static struct ftuple        *span_with(struct flist **, int (*)(void *), int);
+
+/**
+ * @fn void group_free(void *g)
+ * @brief Cleanup handler of lists returned by @a flist_group_by()
+ */
+static void                  group_free(void *);
+
+/**
+ * @fn struct flist *zip_many(struct flist **ls, size_t k,
+ *  void *(*f)(void *, void *), unsigned flags)
+ * @brief Implements @a flist_zip() and relatives
+ *
+ * The result is lazy if all of @p ls are, otherwise it is built at once,
+ * forcing lazy lists only as far as the shortest list reaches.
+ *
+ * @param[in] ls Lists to zip
+ * @param[in] k Number of lists, 2 or 3
+ * @param[in] f Combining function, NULL to build tuples
+ * @param[in] flags Inflags of results of @p f
+ */
+static struct flist         *zip_many(struct flist **, size_t,
+    void *(*)(void *, void *), unsigned);
+
+/**
+ * @fn int zip_next(struct zip_st *st, void **dat)
+ * @brief Combines next elements of zipped lists
+ *
+ * Returns 1 on success, 0 once any of the lists is exhausted and -1 if a
+ * tuple or a node of a lazy list could not be allocated, in which case the
+ * positions are left as they were, so the call may be retried.
+ *
+ * @param[in,out] st Zipping state
+ * @param[out] dat Combined element
+ */
+static int                   zip_next(struct zip_st *, void **);
+
+/**
+ * @fn void tuple_free(void *t)
+ * @brief Cleanup handler of lists returned by @a flist_zip()
+ */
+static void                  tuple_free(void *);
 
 struct flist *
 flist_append(struct flist *l, void *dat, unsigned flags)
 {
         struct   flist_iter *to_add;    /* new node */
-        int      nil;                   /* is passed list pointer NULL? */
+        struct   flist *nl;             /* list created here, if any */
+        STATS_DECL
+
+        if ((nl = l) == NULL && (nl = new_list(NULL)) == NULL)
+                return NULL;
 
-        nil     = l == NULL;
-        to_add  = new_node(dat, nil ? NULL : l->tail, NULL, flags);
+        STATS_BEGIN();
 
-        if (nil) {
-                l       = new_list();
-                l->len  = 1;
+        if (flist_force_all(nl) != 0
+            || (to_add = new_node(nl, dat, nl->tail, NULL, flags)) == NULL) {
+                if (l == NULL)
+                        flist_free(&nl, 0);
+                STATS_END(FLIST_OP_APPEND);
+                return NULL;
+        }
+
+        l = nl;
+
+        if (l->tail == NULL)
                 l->head = l->tail = to_add;
-        } else {
+        else
                 l->tail = l->tail->next = to_add;
-                l->len++;
-        }
+        l->len++;
 
+        STATS_END(FLIST_OP_APPEND);
         return l;
 }
 
@@ -137,392 +717,3366 @@ struct flist *
 flist_prepend(struct flist *l, void *dat, unsigned flags)
 {
         struct   flist_iter *to_add;    /* new node */
-        int      nil;                   /* is passed list pointer NULL? */
+        struct   flist *nl;             /* list created here, if any */
+        STATS_DECL
+
+        if ((nl = l) == NULL && (nl = new_list(NULL)) == NULL)
+                return NULL;
 
-        nil     = l == NULL;
-        to_add  = new_node(dat, NULL, nil ? NULL : l->head, flags);
+        STATS_BEGIN();
 
-        if (nil) {
-                l       = new_list();
-                l->len  = 1;
+        /* lazy lists need not be forced, tail stays unevaluated */
+        if ((to_add = new_node(nl, dat, NULL, nl->head, flags)) == NULL) {
+                if (l == NULL)
+                        flist_free(&nl, 0);
+                STATS_END(FLIST_OP_PREPEND);
+                return NULL;
+        }
+
+        l = nl;
+        idx_truncate(l, 0);
+
+        if (l->head == NULL)
                 l->head = l->tail = to_add;
-        } else {
-                l->head = l->head->prev = to_add;
-                l->len++;
+        else {
+                NODE_SET_PREV(l->head, to_add);
+                l->head = to_add;
         }
+        l->len++;
 
+        STATS_END(FLIST_OP_PREPEND);
         return l;
 }
 
 struct flist *
-flist_copy(struct flist *l, void *(*copy_c)(void *))
+flist_from_array(struct flist *l, void **arr, size_t n, unsigned flags)
 {
-        struct   flist_iter *cur;
-        struct   flist *ret;
+        struct   flist_iter *blk;
+        struct   flist *nl;             /* list created here, if any */
+        size_t   i;
+        STATS_DECL
 
-        for (ret = NULL, cur = l->head; cur != NULL; cur = cur->next) {
-                if (copy_c == NULL) {
-                        ret = flist_append(ret, cur->data,
-                            cur->call_h ? FLIST_CLEANPROT | FLIST_CLEANABLE
-                            : FLIST_DONTCLEAN);
-                } else {
-                        ret = flist_append(ret, copy_c(cur->data), 
-                            FLIST_CLEANABLE);
-                }
+        if ((nl = l) == NULL && (nl = new_list(NULL)) == NULL)
+                return NULL;
+
+        if (n == 0)
+                return nl;
+
+        STATS_BEGIN();
+
+        /* index has room made first, as blocks are not given back */
+        if (flist_force_all(nl) != 0
+            || (nl->hidx != NULL && hidx_reserve(nl->hidx, n) != 0)
+            || (blk = flist_arena_block(nl, n)) == NULL) {
+                if (l == NULL)
+                        flist_free(&nl, 0);
+                STATS_END(FLIST_OP_FROM_ARRAY);
+                return NULL;
         }
 
-        return ret;
+        l = nl;
+        STATS_ADD(node_allocs, n);
+        STATS_ADD(bytes_held, n * sizeof(struct flist_iter));
+
+        for (i = 0; i < n; ++i) {
+                blk[i].data = arr[i];
+                blk[i].next = i + 1 < n ? &blk[i + 1] : NULL;
+                NODE_INIT(&blk[i], i > 0 ? &blk[i - 1] : l->tail,
+                    FLAGS_BITS(flags) | NODE_SLAB);
+        }
+
+        l->kinds |= KIND(FLAGS_BITS(flags) | NODE_SLAB);
+
+        if (l->tail == NULL)
+                l->head = blk;
+        else
+                l->tail->next = blk;
+
+        l->tail = &blk[n - 1];
+        l->len += n;
+
+        for (i = 0; l->hidx != NULL && i < n; ++i) {
+                hidx_place(l->hidx, arr[i], hidx_mix(l->hidx->hash(arr[i])),
+                    &blk[i]);
+        }
+
+        STATS_END(FLIST_OP_FROM_ARRAY);
+        return l;
 }
 
-void
-flist_free(struct flist **lp, int force)
+struct flist *
+flist_create(const struct falloc *a)
 {
-        struct   flist_iter *cur, *tmp;
+        return new_list(a);
+}
 
-        if (*lp == NULL)
-                return;
+size_t
+flist_to_array(struct flist *l, void **out)
+{
+        struct   flist_iter *cur;
+        size_t   i;
 
-        for (cur = (*lp)->head; cur != NULL; cur = tmp) {
-                /* 
-                 * Only call cleanup handler for nonnul, cleanable data when
+        if (l == NULL || flist_force_all(l) != 0)
+                return 0;
+
+        for (i = 0, cur = l->head; cur != NULL; ++i, cur = cur->next)
+                out[i] = cur->data;
+
+        return i;
+}
+
+struct flist *
+flist_copy(struct flist *l, void *(*copy_c)(void *))
+{
+        struct   flist_iter *cur;
+        struct   flist *ret;
+        void    *dat;
+        unsigned flags;
+        STATS_DECL
+
+        if (l == NULL || flist_force_all(l) != 0)
+                return NULL;
+
+        STATS_BEGIN();
+
+        for (ret = NULL, cur = l->head; cur != NULL; cur = cur->next) {
+                STATS_ADD(traversed, 1);
+
+                if (copy_c == NULL) {
+                        dat   = cur->data;
+                        flags = NODE_BITS(cur) & NODE_CALL
+                            ? FLIST_CLEANPROT | FLIST_CLEANABLE
+                            : FLIST_DONTCLEAN;
+                } else {
+                        STATS_ADD(callbacks, 1);
+                        dat   = copy_c(cur->data);
+                        flags = FLIST_CLEANABLE;
+                }
+
+                /* copy shares allocator of the original */
+                if ((ret == NULL && (ret = new_list(l->alloc)) == NULL)
+                    || append_or_drop(ret, dat, flags) != 0) {
+                        flist_free(&ret, 0);
+                        STATS_END(FLIST_OP_COPY);
+                        return NULL;
+                }
+        }
+
+        STATS_END(FLIST_OP_COPY);
+        return ret;
+}
+
+struct flist *
+flist_copy_par(struct flist *l, void *(*copy_c)(void *))
+{
+        struct   par_job job;
+        struct   flist *ret;
+        size_t   i;
+        STATS_DECL
+
+        if (flist_force_all(l) != 0)
+                return NULL;
+
+        if (copy_c == NULL || l == NULL || l->len == 0)
+                return flist_copy(l, copy_c);
+
+        STATS_BEGIN();
+
+        memset(&job, 0x00, sizeof(struct par_job));
+        job.f = copy_c;
+        if (par_run(l, &job) != 0) {
+                ret = flist_copy(l, copy_c);
+                STATS_END(FLIST_OP_COPY);
+                return ret;
+        }
+
+        if ((ret = new_list(l->alloc)) == NULL) {
+                for (i = 0; i < l->len; ++i)
+                        free(job.res[i]);
+        }
+
+        for (i = 0; ret != NULL && i < l->len; ++i) {
+                if (append_or_drop(ret, job.res[i], FLIST_CLEANABLE) != 0) {
+                        /* so are copies that did not make it yet */
+                        while (++i < l->len)
+                                ret->cl_hand(job.res[i]);
+                        flist_free(&ret, 0);
+                }
+        }
+
+        par_free(l->alloc, &job);
+
+        STATS_END(FLIST_OP_COPY);
+        return ret;
+}
+
+void
+flist_free(struct flist **lp, int force)
+{
+        const    struct falloc *a;
+        struct   flist_iter *cur, *tmp;
+        unsigned kinds;
+        int      clean;
+        STATS_DECL
+
+        if (*lp == NULL)
+                return;
+
+        STATS_BEGIN();
+        gen_free(*lp, force);
+        a     = (*lp)->alloc;
+        kinds = (*lp)->kinds;
+
+        STATS_ADD(node_frees, (*lp)->len);
+        STATS_ADD(bytes_held,
+            -(long)((*lp)->len * sizeof(struct flist_iter)));
+
+        /* slab nodes go away together with the arena, maybe all of them */
+        clean = (kinds & KINDS_CLEAN(force)) != 0;
+        cur   = !clean && (kinds & KINDS_NONSLAB) == 0 ? NULL : (*lp)->head;
+
+        for (; cur != NULL; cur = tmp) {
+                /* 
+                 * Only call cleanup handler for nonnul, cleanable data when
                  * either it is not protected or force flag is set.
                  */
-                if (cur->call_h && cur->data && (!cur->prot_h || force))
+                if (clean && NODE_CLEANS(cur, force) && cur->data) {
+                        STATS_ADD(cleanups, 1);
                         (*lp)->cl_hand(cur->data);
+                }
+
+                tmp = cur->next;
+                if (!(NODE_BITS(cur) & NODE_SLAB))
+                        a->free(a->ctx, cur, sizeof(struct flist_iter));
+        }
+
+        arena_free(*lp);
+        flist_set_index(*lp, 0);
+        flist_set_hash(*lp, NULL, NULL);
+        a->free(a->ctx, *lp, sizeof(struct flist));
+        *lp = NULL;
+
+        STATS_END(FLIST_OP_FREE);
+}
+
+void
+flist_set_cleanup(struct flist *l, void (*handler)(void *))
+{
+        if (l == NULL || handler == NULL)
+                return;
+
+        l->cl_hand = handler;
+}
+
+int
+flist_set_arena(struct flist *l, size_t n)
+{
+        if (l == NULL)
+                return 0;
+
+        if (l->arena == NULL && (l->arena = flist_arena_new(l->alloc)) == NULL)
+                return -1;
+
+        flist_arena_of(l)->slab_len = n == 0 ? FLIST_SLAB_DEFAULT : n;
+
+        return 0;
+}
+
+void
+flist_set_index(struct flist *l, size_t n)
+{
+        if (l == NULL)
+                return;
+
+        l->stride = n;
+        l->nckpt  = 0;
+
+        if (n == 0 && l->ckpt != NULL) {
+                l->alloc->free(l->alloc->ctx, l->ckpt,
+                    l->ckpt_cap * sizeof(struct flist_iter *));
+                l->ckpt     = NULL;
+                l->ckpt_cap = 0;
+        }
+}
+
+int
+flist_set_hash(struct flist *l, unsigned long (*hash)(const void *),
+    int (*eq)(const void *, const void *))
+{
+        const    struct falloc *a;
+
+        if (l == NULL)
+                return 0;
+
+        a = l->alloc;
+        if (l->hidx != NULL) {
+                hidx_clear(l->hidx);
+                a->free(a->ctx, l->hidx, sizeof(struct flist_hidx));
+                l->hidx = NULL;
+        }
+
+        if (hash == NULL)
+                return 0;
+
+        if ((l->hidx = a->alloc(a->ctx, sizeof(struct flist_hidx))) == NULL) {
+                errno = ENOMEM;
+                return -1;
+        }
+
+        memset(l->hidx, 0x00, sizeof(struct flist_hidx));
+        l->hidx->hash  = hash;
+        l->hidx->eq    = eq;
+        l->hidx->alloc = a;
+
+        /* nodes forced later are indexed as they come */
+        hidx_fill(l);
+
+        return l->hidx == NULL ? -1 : 0;
+}
+
+void
+flist_head(struct flist *l, int force)
+{
+        if (l == NULL)
+                return;
+
+        flist_take(&l, 1, force);
+}
+
+void
+flist_tail(struct flist **lp, int force)
+{
+        flist_drop(lp, 1, force);
+}
+
+void
+flist_map(struct flist *l, void *(*f)(void *), int force)
+{
+        void    *data;
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        if (flist_force_all(l) != 0)
+                return;
+
+        STATS_BEGIN();
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+                data = f(cur->data);
+
+                if (cur->data != data && data != NULL) {
+                        if (cur->data && NODE_CLEANS(cur, force)) {
+                                STATS_ADD(cleanups, 1);
+                                l->cl_hand(cur->data);
+                        }
+
+                        NODE_SET_BITS(cur,
+                            NODE_CALL | (NODE_BITS(cur) & NODE_SLAB));
+                        l->kinds |= KIND(NODE_BITS(cur));
+                        cur->data = data;
+                }
+        }
+
+        hidx_fill(l);
+        STATS_END(FLIST_OP_MAP);
+}
+
+void
+flist_map_par(struct flist *l, void *(*f)(void *), int force)
+{
+        struct   par_job job;
+        struct   flist_iter *cur;
+        size_t   i;
+        STATS_DECL
+
+        if (l == NULL || flist_force_all(l) != 0 || l->len == 0)
+                return;
+
+        STATS_BEGIN();
+
+        memset(&job, 0x00, sizeof(struct par_job));
+        job.f = f;
+        if (par_run(l, &job) != 0) {
+                flist_map(l, f, force);
+                STATS_END(FLIST_OP_MAP);
+                return;
+        }
+
+        /* cleanup happens here, in list order, just as in flist_map() */
+        for (i = 0, cur = l->head; cur != NULL; ++i, cur = cur->next) {
+                if (cur->data != job.res[i] && job.res[i] != NULL) {
+                        if (cur->data && NODE_CLEANS(cur, force)) {
+                                STATS_ADD(cleanups, 1);
+                                l->cl_hand(cur->data);
+                        }
+
+                        NODE_SET_BITS(cur,
+                            NODE_CALL | (NODE_BITS(cur) & NODE_SLAB));
+                        l->kinds |= KIND(NODE_BITS(cur));
+                        cur->data = job.res[i];
+                }
+        }
+
+        par_free(l->alloc, &job);
+        hidx_fill(l);
+        STATS_END(FLIST_OP_MAP);
+}
+
+size_t
+flist_length(struct flist *l)
+{
+        if (flist_force_all(l) != 0)
+                return 0;
+
+        return l == NULL ? 0 : l->len;
+}
+
+void *
+flist_find(struct flist *l, int (*f)(void *))
+{
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        for (cur = FLIST_FIRST(l); cur != NULL; cur = FLIST_PASS(l, cur)) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+
+                if (f(cur->data))
+                        return cur->data;
+        }
+
+        return NULL;
+}
+
+int
+flist_elem(struct flist *l, int (*cmp)(const void *, const void *),
+    const void *x)
+{
+        struct   flist_iter *cur;
+        STATS_DECL
+        
+        STATS_FETCH();
+
+        /* empty list contains nothing (duh) */
+        if (l == NULL)
+                return 0;
+
+        if (l->hidx != NULL) {
+                if (hidx_find(l->hidx, x, hidx_mix(l->hidx->hash(x))) != NULL)
+                        return 1;
+
+                /* only the forced prefix is indexed */
+                while ((cur = flist_force_next(l)) != NULL) {
+                        STATS_ADD(traversed, 1);
+                        STATS_ADD(callbacks, 1);
+
+                        if (l->hidx->eq(cur->data, x))
+                                return 1;
+                }
+
+                /* generators are gone once exhausted */
+                return 0;
+        }
+
+        for (cur = FLIST_FIRST(l); cur != NULL; cur = FLIST_PASS(l, cur)) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+
+                if (cmp(cur->data, x) == 0)
+                        return 1;
+        }
+
+        return 0;
+}
+
+int
+flist_any(struct flist *l, int (*f)(void *))
+{
+        return flist_find(l, f) != NULL;
+}
+
+int
+flist_all(struct flist *l, int (*f)(void *))
+{
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        for (cur = FLIST_FIRST(l); cur != NULL; cur = FLIST_PASS(l, cur)) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+
+                if (!f(cur->data))
+                        return 0;
+        }
+
+        /* generators are gone once exhausted, one left means forcing failed */
+        return l == NULL || l->gen == NULL;
+}
+
+void *
+flist_find_par(struct flist *l, int (*f)(void *))
+{
+        struct   find_job job;
+        struct   flist_iter *ret;
+
+        memset(&job, 0x00, sizeof(struct find_job));
+        job.p    = f;
+        job.want = 1;
+
+        return (ret = find_run(l, &job)) == NULL ? NULL : ret->data;
+}
+
+void *
+flist_find_any_par(struct flist *l, int (*f)(void *))
+{
+        struct   find_job job;
+        struct   flist_iter *ret;
+
+        memset(&job, 0x00, sizeof(struct find_job));
+        job.p    = f;
+        job.want = 1;
+        job.any  = 1;
+
+        return (ret = find_run(l, &job)) == NULL ? NULL : ret->data;
+}
+
+int
+flist_any_par(struct flist *l, int (*f)(void *))
+{
+        struct   find_job job;
+
+        if (flist_force_all(l) != 0)
+                return 0;
+
+        memset(&job, 0x00, sizeof(struct find_job));
+        job.p    = f;
+        job.want = 1;
+        job.any  = 1;
+
+        return find_run(l, &job) != NULL;
+}
+
+int
+flist_all_par(struct flist *l, int (*f)(void *))
+{
+        struct   find_job job;
+
+        if (flist_force_all(l) != 0)
+                return 0;
+
+        memset(&job, 0x00, sizeof(struct find_job));
+        job.p    = f;
+        job.want = 0;
+        job.any  = 1;
+
+        return find_run(l, &job) == NULL;
+}
+
+int
+flist_elem_par(struct flist *l, int (*cmp)(const void *, const void *),
+    const void *x)
+{
+        struct   find_job job;
+
+        /* hash lookup beats any scan */
+        if (l == NULL || l->hidx != NULL)
+                return flist_elem(l, cmp, x);
+
+        if (flist_force_all(l) != 0)
+                return 0;
+
+        memset(&job, 0x00, sizeof(struct find_job));
+        job.cmp = cmp;
+        job.key = x;
+        job.any = 1;
+
+        return find_run(l, &job) != NULL;
+}
+
+void
+flist_filter(struct flist **lp, int (*f)(void *), int force)
+{
+        struct   flist_iter *cur, *tmp, *at, *dead, *dt; /* tails of both */
+        size_t   n;
+        unsigned live;
+        STATS_DECL
+
+        if (flist_force_all(*lp) != 0)
+                return;
+
+        STATS_BEGIN();
+        idx_truncate(*lp, 0);
+
+        /* relink survivors, chain the rest to release them at once */
+        at   = dead = dt = NULL;
+        live = 0;
+        for (n = 0, cur = (*lp)->head; cur != NULL; cur = tmp) {
+                tmp = cur->next;
+
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+                if (f(cur->data)) {
+                        NODE_SET_PREV(cur, at);
+                        if (at == NULL)
+                                (*lp)->head = cur;
+                        else
+                                at->next = cur;
+                        at    = cur;
+                        live |= KIND(NODE_BITS(cur));
+                        continue;
+                }
+
+                if (dt == NULL)
+                        dead = cur;
+                else
+                        dt->next = cur;
+                dt = cur;
+                n++;
+        }
+
+        if (at == NULL)
+                (*lp)->head = NULL;
+        else
+                at->next = NULL;
+        (*lp)->tail = at;
+        (*lp)->len -= n;
+
+        del_chain(*lp, dead, dt, n, force);
+        (*lp)->kinds = live;
+
+        if ((*lp)->len == 0)
+                flist_free(lp, force);
+
+        STATS_END(FLIST_OP_FILTER);
+}
+
+void
+flist_filter_par(struct flist **lp, int (*f)(void *), int force)
+{
+        struct   par_job job;
+        struct   flist_iter *cur, *tmp, *at, *dead, *dt;
+        size_t   i, n;
+        unsigned live;
+        STATS_DECL
+
+        if (*lp == NULL || flist_force_all(*lp) != 0 || (*lp)->len == 0)
+                return;
+
+        STATS_BEGIN();
+
+        memset(&job, 0x00, sizeof(struct par_job));
+        job.p = f;
+        if (par_run(*lp, &job) != 0) {
+                flist_filter(lp, f, force);
+                STATS_END(FLIST_OP_FILTER);
+                return;
+        }
+        idx_truncate(*lp, 0);
+
+        /* same relinking as in flist_filter() */
+        at   = dead = dt = NULL;
+        live = 0;
+        for (i = n = 0, cur = (*lp)->head; cur != NULL; ++i, cur = tmp) {
+                tmp = cur->next;
+
+                if (job.keep[i]) {
+                        NODE_SET_PREV(cur, at);
+                        if (at == NULL)
+                                (*lp)->head = cur;
+                        else
+                                at->next = cur;
+                        at    = cur;
+                        live |= KIND(NODE_BITS(cur));
+                        continue;
+                }
+
+                if (dt == NULL)
+                        dead = cur;
+                else
+                        dt->next = cur;
+                dt = cur;
+                n++;
+        }
+
+        if (at == NULL)
+                (*lp)->head = NULL;
+        else
+                at->next = NULL;
+        (*lp)->tail = at;
+        (*lp)->len -= n;
+
+        del_chain(*lp, dead, dt, n, force);
+        (*lp)->kinds = live;
+        par_free((*lp)->alloc, &job);
+
+        if ((*lp)->len == 0)
+                flist_free(lp, force);
+
+        STATS_END(FLIST_OP_FILTER);
+}
+
+void
+flist_take(struct flist **lp, int n, int force)
+{
+        struct   flist_iter *cur, *tmp;
+        STATS_DECL
+
+        STATS_BEGIN();
+
+        if (n <= 0) {
+                flist_free(lp, force);
+                STATS_END(FLIST_OP_TAKE);
+                return;
+        }
+
+        if (*lp == NULL) {
+                STATS_END(FLIST_OP_TAKE);
+                return;
+        }
+
+        /* nothing past n-th element will ever be needed */
+        if (force_upto(*lp, n) != 0) {
+                STATS_END(FLIST_OP_TAKE);
+                return;
+        }
+        gen_free(*lp, force);
+
+        if ((size_t)n >= flist_length(*lp)) {
+                STATS_END(FLIST_OP_TAKE);
+                return;
+        }
+
+        cur = node_at(*lp, n);
+        idx_truncate(*lp, n);
+
+        tmp = (*lp)->tail;
+        (*lp)->tail = NODE_PREV(cur);
+        (*lp)->tail->next = NULL;
+
+        del_chain(*lp, cur, tmp, (*lp)->len - n, force);
+        (*lp)->len = n;
+
+        STATS_END(FLIST_OP_TAKE);
+}
+
+void
+flist_drop(struct flist **lp, int n, int force)
+{
+        struct   flist_iter *cur, *tmp;
+        STATS_DECL
+
+        STATS_BEGIN();
+
+        if (n <= 0 || *lp == NULL) {
+                STATS_END(FLIST_OP_DROP);
+                return;
+        }
+
+        /* remainder of a lazy list may stay unevaluated */
+        if (force_upto(*lp, (size_t)n + 1) != 0) {
+                STATS_END(FLIST_OP_DROP);
+                return;
+        }
+
+        if ((size_t)n >= (*lp)->len) {
+                flist_free(lp, force);
+                STATS_END(FLIST_OP_DROP);
+                return;
+        }
+
+        cur = node_at(*lp, n);
+        idx_truncate(*lp, 0);
+
+        tmp = NODE_PREV(cur);
+        tmp->next = NULL;
+        del_chain(*lp, (*lp)->head, tmp, n, force);
+
+        NODE_SET_PREV(cur, NULL);
+        (*lp)->head = cur;
+        (*lp)->len -= n;
+
+        STATS_END(FLIST_OP_DROP);
+}
+
+struct ftuple *
+flist_partition(struct flist **lp, int (*p)(void *))
+{
+        struct   flist_iter *cur, *tmp, *at, *bt; /* tails of both parts */
+        struct   flist *l, *b;
+        struct   ftuple *t;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (*lp == NULL)
+                return ftuple_create(2, NULL, NULL);
+
+        l = *lp;
+        if (flist_force_all(l) != 0 || (t = split_begin(l, &b)) == NULL)
+                return NULL;
+
+        STATS_ADD(traversed, l->len);
+        STATS_ADD(callbacks, l->len);
+        idx_truncate(l, 0);
+
+        for (at = bt = NULL, cur = l->head; cur != NULL; cur = tmp) {
+                tmp = cur->next;
+
+                if (p(cur->data)) {
+                        NODE_SET_PREV(cur, at);
+                        if (at == NULL)
+                                l->head = cur;
+                        else
+                                at->next = cur;
+                        at = cur;
+                } else {
+                        NODE_SET_PREV(cur, bt);
+                        if (bt == NULL)
+                                b->head = cur;
+                        else
+                                bt->next = cur;
+                        bt = cur;
+                        b->len++;
+                }
+        }
+
+        if (at == NULL)
+                l->head = NULL;
+        else
+                at->next = NULL;
+
+        if (bt != NULL)
+                bt->next = NULL;
+
+        l->tail = at;
+        b->tail = bt;
+        l->len -= b->len;
+
+        *lp = NULL;
+
+        return split_end(t, l, b, 0);
+}
+
+struct ftuple *
+flist_span(struct flist **lp, int (*p)(void *))
+{
+        return span_with(lp, p, 1);
+}
+
+struct ftuple *
+flist_break(struct flist **lp, int (*p)(void *))
+{
+        return span_with(lp, p, 0);
+}
+
+struct ftuple *
+flist_split_at(struct flist **lp, size_t n)
+{
+        struct   flist *l, *a;
+        struct   ftuple *t;
+
+        if (*lp == NULL)
+                return ftuple_create(2, NULL, NULL);
+
+        l = *lp;
+        if (force_upto(l, n) != 0 || (t = split_begin(l, &a)) == NULL)
+                return NULL;
+
+        if (n < l->len)
+                split_cut(l, a, node_at(l, n), n);
+        else
+                split_cut(l, a, NULL, l->len);
+
+        *lp = NULL;
+
+        return split_end(t, l, a, 1);
+}
+
+struct flist *
+flist_concat(struct flist *dst, struct flist **srcp)
+{
+        struct   flist *ls[2];
+
+        if (dst != NULL && dst == *srcp) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        ls[0] = dst;
+        ls[1] = *srcp;
+
+        if ((dst = flist_concat_many(ls, 2)) == NULL && ls[0] != NULL)
+                return NULL;
+
+        *srcp = NULL;
+
+        return dst;
+}
+
+struct flist *
+flist_splice_at(struct flist *dst, size_t i, struct flist **srcp)
+{
+        struct   flist_iter *at;
+        struct   flist *ls[2];
+        void   (*hand)(void *);
+
+        if (dst == NULL || *srcp == NULL)
+                return flist_concat(dst, srcp);
+
+        ls[0] = dst;
+        ls[1] = *srcp;
+
+        if (dst == *srcp || merge_check(ls, 2, &hand) != 0) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        /* nodes are only moved once nothing can fail */
+        if (force_upto(dst, i + 1) != 0 || flist_force_all(i < dst->len
+            ? *srcp : dst) != 0 || (dst->hidx != NULL
+            && hidx_reserve(dst->hidx, (*srcp)->len) != 0))
+                return NULL;
+
+        if (i < dst->len) {
+                at = node_at(dst, i);
+                idx_truncate(dst, i);
+        } else
+                at = NULL;
+
+        chain_move(dst, *srcp, at);
+        dst->cl_hand = hand;
+        *srcp = NULL;
+
+        return dst;
+}
+
+struct flist *
+flist_concat_many(struct flist **ls, size_t k)
+{
+        struct   flist *ret;
+        void   (*hand)(void *);
+        size_t   i, last, n;
+
+        if (merge_check(ls, k, &hand) != 0)
+                return NULL;
+
+        /* nodes are only moved once nothing can fail */
+        for (last = k; last > 0 && ls[last - 1] == NULL; --last)
+                ;
+
+        for (ret = NULL, n = 0, i = 0; i < last; ++i) {
+                if (ls[i] == NULL)
+                        continue;
+
+                if (i + 1 < last && flist_force_all(ls[i]) != 0)
+                        return NULL;
+
+                if (ret == NULL)
+                        ret = ls[i];
+                else
+                        n += ls[i]->len;
+        }
+
+        if (ret != NULL && ret->hidx != NULL && hidx_reserve(ret->hidx, n) != 0)
+                return NULL;
+
+        for (ret = NULL, i = 0; i < k; ++i) {
+                if (ls[i] == NULL)
+                        continue;
+
+                if (ret == NULL)
+                        ret = ls[i];
+                else
+                        chain_move(ret, ls[i], NULL);
+
+                ls[i] = NULL;
+        }
+
+        if (ret != NULL)
+                ret->cl_hand = hand;
+
+        return ret;
+}
+
+struct flist *
+flist_zip(struct flist *l1, struct flist *l2)
+{
+        struct   flist *ls[2];
+
+        ls[0] = l1;
+        ls[1] = l2;
+
+        return zip_many(ls, 2, NULL, 0);
+}
+
+struct flist *
+flist_zip3(struct flist *l1, struct flist *l2, struct flist *l3)
+{
+        struct   flist *ls[3];
+
+        ls[0] = l1;
+        ls[1] = l2;
+        ls[2] = l3;
+
+        return zip_many(ls, 3, NULL, 0);
+}
+
+struct flist *
+flist_zip_with(struct flist *l1, struct flist *l2, void *(*f)(void *, void *),
+    unsigned flags)
+{
+        struct   flist *ls[2];
+
+        ls[0] = l1;
+        ls[1] = l2;
+
+        return zip_many(ls, 2, f, flags);
+}
+
+struct ftuple *
+flist_unzip(struct flist *l)
+{
+        struct   flist_iter *cur;
+        struct   flist *part;
+        struct   ftuple *t;
+        size_t   dim, i;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (l == NULL || (cur = FLIST_FIRST(l)) == NULL)
+                return ftuple_create(2, NULL, NULL);
+
+        if ((dim = ftuple_dim(cur->data)) < 2) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        if ((t = ftuple_create_from_array(dim, NULL)) == NULL)
+                return NULL;
+
+        for (i = 0; i < dim; ++i) {
+                if ((t->arr[i] = new_list(l->alloc)) == NULL)
+                        goto fail;
+        }
+
+        for (; cur != NULL; cur = FLIST_NEXT(l, cur)) {
+                STATS_ADD(traversed, 1);
+
+                for (i = 0; i < dim; ++i) {
+                        if (flist_append(t->arr[i], ftuple_nth(cur->data, i),
+                            FLIST_DONTCLEAN) == NULL)
+                                goto fail;
+                }
+        }
+
+        return t;
+
+fail:
+        for (i = 0; i < dim; ++i) {
+                part = t->arr[i];
+                flist_free(&part, 0);
+        }
+        ftuple_free(&t);
+        errno = ENOMEM;
+
+        return NULL;
+}
+
+struct flist_iter *
+flist_iter_first(struct flist *l)
+{
+        return l == NULL ? NULL : FLIST_FIRST(l);
+}
+
+struct flist_iter *
+flist_iter_last(struct flist *l)
+{
+        if (l == NULL || flist_force_all(l) != 0)
+                return NULL;
+
+        return l->tail;
+}
+
+struct flist_iter *
+flist_iter_next(struct flist *l, struct flist_iter *n)
+{
+        return FLIST_NEXT(l, n);
+}
+
+int
+flist_cursor_begin(struct flist_cursor *c, struct flist **lp)
+{
+        c->lp  = lp;
+        c->pos = 0;
+        c->cur = *lp == NULL ? NULL : FLIST_FIRST(*lp);
+
+        return c->cur != NULL;
+}
+
+int
+flist_cursor_next(struct flist_cursor *c)
+{
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (c->cur == NULL)
+                return 0;
+
+        STATS_ADD(traversed, 1);
+        c->cur = FLIST_NEXT(*c->lp, c->cur);
+        c->pos++;
+
+        return c->cur != NULL;
+}
+
+int
+flist_cursor_prev(struct flist_cursor *c)
+{
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (c->cur == NULL)
+                return 0;
+
+        STATS_ADD(traversed, 1);
+        c->cur = NODE_PREV(c->cur);
+        c->pos--;
+
+        return c->cur != NULL;
+}
+
+void *
+flist_cursor_get(struct flist_cursor *c)
+{
+        return c->cur == NULL ? NULL : c->cur->data;
+}
+
+void
+flist_cursor_set(struct flist_cursor *c, void *dat, unsigned flags, int force)
+{
+        struct   flist_iter *cur;
+        struct   flist *l;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if ((cur = c->cur) == NULL)
+                return;
+
+        l = *c->lp;
+
+        /* hash has to be computed before data is cleaned up */
+        if (l->hidx != NULL) {
+                hidx_remove(l->hidx, hidx_mix(l->hidx->hash(cur->data)),
+                    cur);
+        }
+
+        if (cur->data && cur->data != dat && NODE_CLEANS(cur, force)) {
+                STATS_ADD(cleanups, 1);
+                l->cl_hand(cur->data);
+        }
+
+        cur->data = dat;
+        NODE_SET_BITS(cur, FLAGS_BITS(flags) | (NODE_BITS(cur) & NODE_SLAB));
+        l->kinds |= KIND(NODE_BITS(cur));
+
+        if (l->hidx != NULL)
+                hidx_insert(l->hidx, dat, hidx_mix(l->hidx->hash(dat)), cur);
+}
+
+int
+flist_cursor_remove(struct flist_cursor *c, int force)
+{
+        struct   flist_iter *cur, *next;
+        struct   flist *l;
+
+        if ((cur = c->cur) == NULL)
+                return 0;
+
+        l    = *c->lp;
+        next = cur->next;
+        idx_truncate(l, c->pos);
+
+        if (NODE_PREV(cur) == NULL)
+                l->head = cur->next;
+        else
+                NODE_PREV(cur)->next = cur->next;
+
+        if (cur->next == NULL)
+                l->tail = NODE_PREV(cur);
+        else
+                NODE_SET_PREV(cur->next, NODE_PREV(cur));
+
+        del_node(l, cur, force);
+        l->len--;
+
+        if (next == NULL && l->gen != NULL)
+                next = flist_force_next(l);
+        if (l->len == 0 && l->gen == NULL)
+                flist_free(c->lp, force);
+
+        c->cur = next;
+
+        return next != NULL;
+}
+
+void *
+flist_foldr(struct flist *l, void *x, void *(*f)(void *, void *))
+{
+        void    *acc, *tmp;
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        if (flist_force_all(l) != 0)
+                return NULL;
+
+        if (l == NULL || l->tail == NULL)
+                return x;
+
+        STATS_BEGIN();
+        STATS_ADD(traversed, l->len);
+        STATS_ADD(callbacks, l->len);
+        STATS_ADD(cleanups, l->len - 1);
+
+        acc = f(l->tail->data, x);
+        for (cur = NODE_PREV(l->tail); cur != NULL; cur = NODE_PREV(cur)) {
+                tmp = acc;
+                acc = f(cur->data, tmp);
+                l->cl_hand(tmp);
+        }
+
+        STATS_END(FLIST_OP_FOLD);
+        return acc;
+}
+
+void *
+flist_foldl(struct flist *l, void *x, void *(*f)(void *, void *))
+{
+        void    *acc, *tmp;
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        if (l == NULL || FLIST_FIRST(l) == NULL)
+                return x;
+
+        STATS_BEGIN();
+        STATS_ADD(traversed, 1);
+        STATS_ADD(callbacks, 1);
+
+        acc = f(x, l->head->data);
+        for (cur = FLIST_PASS(l, l->head); cur != NULL;
+            cur = FLIST_PASS(l, cur)) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+                STATS_ADD(cleanups, 1);
+
+                tmp = acc;
+                acc = f(tmp, cur->data);
+                l->cl_hand(tmp);
+        }
+
+        STATS_END(FLIST_OP_FOLD);
+        return acc;
+}
+
+void
+flist_foldr_mut(struct flist *l, void *acc, void (*f)(void *, void *))
+{
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        if (l == NULL || flist_force_all(l) != 0)
+                return;
+
+        STATS_BEGIN();
+        STATS_ADD(traversed, l->len);
+        STATS_ADD(callbacks, l->len);
+
+        for (cur = l->tail; cur != NULL; cur = NODE_PREV(cur))
+                f(cur->data, acc);
+
+        STATS_END(FLIST_OP_FOLD);
+}
+
+void
+flist_foldl_mut(struct flist *l, void *acc, void (*f)(void *, void *))
+{
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        if (l == NULL)
+                return;
+
+        STATS_BEGIN();
+
+        for (cur = FLIST_FIRST(l); cur != NULL; cur = FLIST_PASS(l, cur)) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+
+                f(acc, cur->data);
+        }
+
+        STATS_END(FLIST_OP_FOLD);
+}
+
+size_t
+flist_scanl(struct flist *l, void *acc, void (*f)(void *, void *), void *out,
+    size_t size)
+{
+        struct   flist_iter *cur;
+        char    *dst;
+        size_t   n;
+        STATS_DECL
+
+        dst = out;
+        memcpy(dst, acc, size);
+
+        if (l == NULL)
+                return 1;
+
+        STATS_BEGIN();
+
+        for (n = 1, cur = FLIST_FIRST(l); cur != NULL;
+            cur = FLIST_NEXT(l, cur)) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+
+                f(acc, cur->data);
+                memcpy(dst += size, acc, size);
+                ++n;
+        }
+
+        STATS_END(FLIST_OP_FOLD);
+        return n;
+}
+
+void *
+flist_fold_assoc(struct flist *l, void *x, void *(*f)(void *, void *),
+    void *(*combine)(void *, void *))
+{
+        struct   par_job job;
+        struct   comb_job comb;
+        void    *ret;
+        STATS_DECL
+
+        if (flist_force_all(l) != 0)
+                return NULL;
+
+        if (l == NULL || l->len == 0)
+                return x;
+
+        STATS_BEGIN();
+
+        memset(&job, 0x00, sizeof(struct par_job));
+        job.fold    = f;
+        job.x       = x;
+        job.cl_hand = l->cl_hand;
+        if (par_run(l, &job) != 0) {
+                ret = flist_foldl(l, x, f);
+                STATS_END(FLIST_OP_FOLD);
+                return ret;
+        }
+
+        /* fixed shape of the tree keeps the result deterministic */
+        comb.part    = job.res;
+        comb.combine = combine;
+        comb.cl_hand = l->cl_hand;
+        for (comb.step = 1; comb.step < job.nseg; comb.step *= 2) {
+                fpool_run(comb_task, &comb,
+                    (job.nseg - comb.step + 2 * comb.step - 1)
+                    / (2 * comb.step));
+        }
+
+        ret = job.res[0];
+        par_free(l->alloc, &job);
+
+        STATS_END(FLIST_OP_FOLD);
+        return ret;
+}
+
+void *
+flist_val_head(struct flist *l)
+{
+        if (l == NULL)
+                return NULL;
+
+        return FLIST_FIRST(l) != NULL ? l->head->data : NULL;
+}
+
+void *
+flist_val_at_i(struct flist *l, int i)
+{
+        void    *ret;
+        STATS_DECL
+
+        if (l == NULL || i < 0)
+                return NULL;
+
+        STATS_BEGIN();
+
+        ret = force_upto(l, (size_t)i + 1) == 0 && (size_t)i < l->len
+            ? node_at(l, i)->data : NULL;
+
+        STATS_END(FLIST_OP_VAL_AT);
+        return ret;
+}
+
+struct flist *
+flist_repeat(void *dat, int n, void *(*copy_c)(void *))
+{
+        struct   flist *ret;
+        void    *cpy;
+        unsigned flags;
+
+        if (dat == NULL || n <= 0 || (ret = new_list(NULL)) == NULL)
+                return NULL;
+
+        for (; n > 0; --n) {
+                if (copy_c == NULL) {
+                        cpy   = dat;
+                        flags = FLIST_CLEANABLE | FLIST_CLEANPROT;
+                } else {
+                        cpy   = copy_c(dat);
+                        flags = FLIST_CLEANABLE;
+                }
+
+                if (append_or_drop(ret, cpy, flags) != 0) {
+                        flist_free(&ret, 0);
+                        return NULL;
+                }
+        }
+
+        return ret;
+}
+
+struct flist *
+flist_iterate(void *x, unsigned flags, void *(*f)(void *))
+{
+        struct   iterate_st *st;
+        struct   flist *ret;
+
+        if ((ret = flist_new_lazy(iterate_step, iterate_release,
+            sizeof(struct iterate_st))) == NULL)
+                return NULL;
+
+        st        = ret->gen->st;
+        st->f     = f;
+        st->next  = x;
+        st->flags = flags;
+
+        return ret;
+}
+
+struct flist *
+flist_unfoldr(int (*f)(void *, void **), void *seed, unsigned flags)
+{
+        struct   unfoldr_st *st;
+        struct   flist *ret;
+
+        if ((ret = flist_new_lazy(unfoldr_step, NULL,
+            sizeof(struct unfoldr_st))) == NULL)
+                return NULL;
+
+        st        = ret->gen->st;
+        st->f     = f;
+        st->seed  = seed;
+        st->flags = flags;
+
+        return ret;
+}
+
+struct flist *
+flist_cycle(struct flist *l)
+{
+        struct   cycle_st *st;
+        struct   flist *ret;
+
+        if (flist_force_all(l) != 0 || l == NULL || l->len == 0)
+                return NULL;
+
+        if ((ret = flist_new_lazy(cycle_step, NULL,
+            sizeof(struct cycle_st))) == NULL)
+                return NULL;
+
+        st      = ret->gen->st;
+        st->src = l;
+        st->pos = l->head;
+
+        return ret;
+}
+
+struct flist *
+flist_repeat_lazy(void *dat, void *(*copy_c)(void *))
+{
+        struct   repeat_st *st;
+        struct   flist *ret;
+
+        if (dat == NULL)
+                return NULL;
+
+        if ((ret = flist_new_lazy(repeat_step, NULL,
+            sizeof(struct repeat_st))) == NULL)
+                return NULL;
+
+        st         = ret->gen->st;
+        st->dat    = dat;
+        st->copy_c = copy_c;
+
+        return ret;
+}
+
+void
+flist_reverse(struct flist *l)
+{
+        struct   flist_iter *cur, *tmp;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (l == NULL || flist_force_all(l) != 0)
+                return;
+
+        idx_truncate(l, 0);
+
+        STATS_ADD(traversed, l->len);
+
+        for (cur = l->head; cur != NULL; cur = tmp) {
+                tmp = cur->next;
+                cur->next = NODE_PREV(cur);
+                NODE_SET_PREV(cur, tmp);
+        }
+
+        tmp = l->head;
+        l->head = l->tail;
+        l->tail = tmp;
+}
+
+void
+flist_sort(struct flist *l, int (*cmp)(const void *, const void *))
+{
+        struct   flist_iter *bins[8 * sizeof(size_t)], *run, *cur;
+        size_t   i, fill;
+        STATS_DECL
+
+        if (l == NULL || flist_force_all(l) != 0)
+                return;
+
+        STATS_BEGIN();
+        idx_truncate(l, 0);
+
+        /*
+         * Bottom-up merge sort. Bin i holds either nothing or a sorted run of
+         * 2^i elements, each of them older than ones in lower bins. Adding a
+         * single node carries merged runs upwards like incrementing a binary
+         * counter does.
+         */
+        for (fill = 0, cur = l->head; cur != NULL;) {
+                run = cur;
+                cur = cur->next;
+                run->next = NULL;
+
+                for (i = 0; i < fill && bins[i] != NULL; ++i) {
+                        run = merge_runs(bins[i], run, cmp);
+                        bins[i] = NULL;
+                }
+
+                bins[i] = run;
+                if (i == fill)
+                        ++fill;
+        }
+
+        for (run = NULL, i = 0; i < fill; ++i) {
+                if (bins[i] != NULL)
+                        run = run == NULL ? bins[i]
+                            : merge_runs(bins[i], run, cmp);
+        }
+
+        l->head = run;
+        relink(l);
+
+        STATS_END(FLIST_OP_SORT);
+}
+
+int
+flist_sort_by_key(struct flist *l, long (*key)(const void *))
+{
+        struct   sort_key *buf, *a, *b, *tmp;
+        struct   flist_iter *cur;
+        unsigned long sign;
+        size_t   cnt[sizeof(long)][256], sum, c, i, pass;
+        unsigned sh;
+        STATS_DECL
+
+        if (l == NULL)
+                return 0;
+
+        if (flist_force_all(l) != 0)
+                return -1;
+        if (l->len < 2)
+                return 0;
+
+        if ((buf = l->alloc->alloc(l->alloc->ctx,
+            2 * l->len * sizeof(struct sort_key))) == NULL) {
+                errno = ENOMEM;
+                return -1;
+        }
+
+        STATS_BEGIN();
+        STATS_ADD(traversed, l->len);
+        STATS_ADD(callbacks, l->len);
+        idx_truncate(l, 0);
+
+        /* flipping sign bit makes unsigned order match the signed one */
+        sign = ~(~0UL >> 1);
+        memset(cnt, 0x00, sizeof(cnt));
+
+        a = buf;
+        b = buf + l->len;
+
+        /* histograms of all digits are gathered in a single pass */
+        for (i = 0, cur = l->head; cur != NULL; cur = cur->next, ++i) {
+                a[i].key  = (unsigned long)key(cur->data) ^ sign;
+                a[i].node = cur;
+
+                for (pass = 0; pass < sizeof(long); ++pass)
+                        ++cnt[pass][(a[i].key >> 8 * pass) & 0xff];
+        }
+
+        for (pass = 0; pass < sizeof(long); ++pass) {
+                sh = 8 * pass;
+
+                /* all keys share this digit, nothing would move */
+                if (cnt[pass][(a[0].key >> sh) & 0xff] == l->len)
+                        continue;
+
+                for (sum = 0, i = 0; i < 256; ++i) {
+                        c = cnt[pass][i];
+                        cnt[pass][i] = sum;
+                        sum += c;
+                }
+
+                for (i = 0; i < l->len; ++i)
+                        b[cnt[pass][(a[i].key >> sh) & 0xff]++] = a[i];
+
+                tmp = a;
+                a = b;
+                b = tmp;
+        }
+
+        /* relinking from the array avoids another walk in random order */
+        for (i = 0; i < l->len; ++i) {
+                NODE_SET_PREV(a[i].node, i > 0 ? a[i - 1].node : NULL);
+                a[i].node->next = i + 1 < l->len ? a[i + 1].node : NULL;
+        }
+
+        l->head = a[0].node;
+        l->tail = a[l->len - 1].node;
+
+        l->alloc->free(l->alloc->ctx, buf,
+            2 * l->len * sizeof(struct sort_key));
+        STATS_END(FLIST_OP_SORT);
+        return 0;
+}
+
+void
+flist_nub(struct flist **lp, unsigned long (*hash)(const void *),
+    int (*eq)(const void *, const void *), int force)
+{
+        struct   flist_hidx seen;
+        struct   flist_iter *cur, *tmp;
+        unsigned long hv;
+        unsigned live;
+
+        if (*lp == NULL || flist_force_all(*lp) != 0)
+                return;
+
+        memset(&seen, 0x00, sizeof(struct flist_hidx));
+        seen.hash  = hash;
+        seen.eq    = eq;
+        seen.alloc = (*lp)->alloc;
+        live       = 0;
+
+        if (hidx_reserve(&seen, (*lp)->len) != 0)
+                return;
+
+        idx_truncate(*lp, 0);
+
+        for (cur = (*lp)->head; cur != NULL; cur = tmp) {
+                tmp = cur->next;
+                hv  = hidx_mix(hash(cur->data));
+
+                if (hidx_find(&seen, cur->data, hv) == NULL) {
+                        hidx_place(&seen, cur->data, hv, cur);
+                        live |= KIND(NODE_BITS(cur));
+                        continue;
+                }
+
+                /* head is never a duplicate */
+                NODE_PREV(cur)->next = cur->next;
+
+                if (cur->next == NULL)
+                        (*lp)->tail = NODE_PREV(cur);
+                else
+                        NODE_SET_PREV(cur->next, NODE_PREV(cur));
+
+                del_node(*lp, cur, force);
+                (*lp)->len--;
+        }
+
+        (*lp)->kinds = live;
+        hidx_clear(&seen);
+}
+
+struct flist *
+flist_group_by(struct flist *l, unsigned long (*hash)(const void *),
+    int (*eq)(const void *, const void *))
+{
+        struct   flist_hidx groups;
+        struct   flist_hent *ent;
+        struct   flist_iter *cur;
+        struct   flist *ret, *grp, *tmp;
+        unsigned long hv;
+
+        if (l == NULL || flist_force_all(l) != 0)
+                return NULL;
+
+        memset(&groups, 0x00, sizeof(struct flist_hidx));
+        groups.hash  = hash;
+        groups.eq    = eq;
+        groups.alloc = l->alloc;
+
+        if (hidx_reserve(&groups, l->len) != 0)
+                return NULL;
+
+        for (ret = NULL, cur = l->head; cur != NULL; cur = cur->next) {
+                hv = hidx_mix(hash(cur->data));
+
+                if ((ent = hidx_find(&groups, cur->data, hv)) != NULL) {
+                        if (ref_append(ent->val, l, cur) == NULL)
+                                goto fail;
+                        continue;
+                }
+
+                if ((grp = ref_append(NULL, l, cur)) == NULL)
+                        goto fail;
+                if ((tmp = flist_append(ret, grp, FLIST_CLEANABLE)) == NULL) {
+                        flist_free(&grp, 0);
+                        goto fail;
+                }
+
+                ret = tmp;
+                ret->cl_hand = group_free;
+                hidx_place(&groups, cur->data, hv, grp);
+        }
+
+        hidx_clear(&groups);
+
+        return ret;
+
+fail:
+        hidx_clear(&groups);
+        flist_free(&ret, 0);
+        errno = ENOMEM;
+        return NULL;
+}
+
+struct flist *
+flist_intersect(struct flist *l1, struct flist *l2,
+    unsigned long (*hash)(const void *), int (*eq)(const void *, const void *))
+{
+        struct   flist_hidx set;
+        struct   flist_iter *cur;
+        struct   flist *ret, *tmp;
+        unsigned long hv;
+
+        if (l1 == NULL || l2 == NULL || flist_force_all(l1) != 0
+            || flist_force_all(l2) != 0)
+                return NULL;
+
+        memset(&set, 0x00, sizeof(struct flist_hidx));
+        set.hash  = hash;
+        set.eq    = eq;
+        set.alloc = l2->alloc;
+
+        if (hidx_reserve(&set, l2->len) != 0)
+                return NULL;
+
+        for (cur = l2->head; cur != NULL; cur = cur->next) {
+                hv = hidx_mix(hash(cur->data));
+                if (hidx_find(&set, cur->data, hv) == NULL)
+                        hidx_place(&set, cur->data, hv, cur);
+        }
+
+        for (ret = NULL, cur = l1->head; cur != NULL; cur = cur->next) {
+                if (hidx_find(&set, cur->data, hidx_mix(hash(cur->data)))
+                    == NULL)
+                        continue;
+
+                if ((tmp = ref_append(ret, l1, cur)) == NULL) {
+                        flist_free(&ret, 0);
+                        break;
+                }
+                ret = tmp;
+        }
+
+        hidx_clear(&set);
+
+        return ret;
+}
+
+struct flist *
+flist_union(struct flist *l1, struct flist *l2,
+    unsigned long (*hash)(const void *), int (*eq)(const void *, const void *))
+{
+        struct   flist_hidx set;
+        struct   flist_iter *cur;
+        struct   flist *ret, *tmp;
+        unsigned long hv;
+
+        if (flist_force_all(l1) != 0 || flist_force_all(l2) != 0)
+                return NULL;
+
+        memset(&set, 0x00, sizeof(struct flist_hidx));
+        set.hash  = hash;
+        set.eq    = eq;
+        set.alloc = l1 != NULL ? l1->alloc : l2 != NULL ? l2->alloc : NULL;
+
+        if (hidx_reserve(&set, (l1 != NULL ? l1->len : 0)
+            + (l2 != NULL ? l2->len : 0)) != 0)
+                return NULL;
+
+        ret = NULL;
+
+        for (cur = l1 != NULL ? l1->head : NULL; cur != NULL; cur = cur->next) {
+                if ((tmp = ref_append(ret, l1, cur)) == NULL)
+                        goto fail;
+
+                ret = tmp;
+                hv  = hidx_mix(hash(cur->data));
+
+                if (hidx_find(&set, cur->data, hv) == NULL)
+                        hidx_place(&set, cur->data, hv, cur);
+        }
+
+        for (cur = l2 != NULL ? l2->head : NULL; cur != NULL; cur = cur->next) {
+                hv = hidx_mix(hash(cur->data));
+
+                if (hidx_find(&set, cur->data, hv) != NULL)
+                        continue;
+
+                if ((tmp = ref_append(ret, l2, cur)) == NULL)
+                        goto fail;
+
+                ret = tmp;
+                hidx_place(&set, cur->data, hv, cur);
+        }
+
+        hidx_clear(&set);
+
+        return ret;
+
+fail:
+        hidx_clear(&set);
+        flist_free(&ret, 0);
+        return NULL;
+}
+
+void
+flist_set_threads(unsigned n)
+{
+        fpool_set_threads(n);
+}
+
+unsigned
+flist_get_threads(void)
+{
+        return fpool_threads();
+}
+
+struct flist_iter *
+merge_runs(struct flist_iter *a, struct flist_iter *b,
+    int (*cmp)(const void *, const void *))
+{
+        struct   flist_iter head, *tail;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        for (tail = &head; a != NULL && b != NULL; tail = tail->next) {
+                STATS_ADD(callbacks, 1);
+
+                if (cmp(b->data, a->data) < 0) {
+                        tail->next = b;
+                        b = b->next;
+                } else {
+                        tail->next = a;
+                        a = a->next;
+                }
+        }
+
+        tail->next = a != NULL ? a : b;
+
+        return head.next;
+}
+
+void
+relink(struct flist *l)
+{
+        struct   flist_iter *cur, *prev;
+
+        for (prev = NULL, cur = l->head; cur != NULL; cur = cur->next) {
+                NODE_SET_PREV(cur, prev);
+                prev = cur;
+        }
+
+        l->tail = prev;
+}
+
+unsigned long
+hidx_mix(unsigned long h)
+{
+        /* fold high half in (if any), then a couple of multiply-xorshifts */
+        h ^= h >> (4 * sizeof(unsigned long));
+        h  = ((h >> 16) ^ h) * 0x45d9f3bUL;
+        h  = ((h >> 16) ^ h) * 0x45d9f3bUL;
+        h  = (h >> 16) ^ h;
+
+        return h;
+}
+
+struct flist_hent *
+hidx_find(struct flist_hidx *h, const void *key, unsigned long hv)
+{
+        struct   flist_hent *ent;
+        size_t   i, mask;
+
+        if (h->cap == 0)
+                return NULL;
+
+        mask = h->cap - 1;
+        for (i = hv & mask; (ent = &h->tab[i])->val != NULL;
+            i = (i + 1) & mask) {
+                if (ent->val != TOMB && ent->hash == hv && h->eq(ent->key, key))
+                        return ent;
+        }
+
+        return NULL;
+}
+
+int
+hidx_reserve(struct flist_hidx *h, size_t n)
+{
+        struct   flist_hent *old, *tab;
+        size_t   i, cap, old_cap;
+
+        /* keep load (tombstones included) at most one half */
+        if (2 * (h->used + n) <= h->cap)
+                return 0;
+
+        for (cap = 16; cap < 4 * (h->live + n); cap *= 2)
+                ;
+
+        if ((tab = h->alloc->alloc(h->alloc->ctx,
+            cap * sizeof(struct flist_hent))) == NULL) {
+                errno = ENOMEM;
+                return -1;
+        }
+
+        for (i = 0; i < cap; ++i)
+                tab[i].val = NULL;
+
+        old     = h->tab;
+        old_cap = h->cap;
+
+        h->tab  = tab;
+        h->cap  = cap;
+        h->used = h->live = 0;
+        for (i = 0; i < old_cap; ++i) {
+                if (old[i].val != NULL && old[i].val != TOMB)
+                        hidx_place(h, old[i].key, old[i].hash, old[i].val);
+        }
+
+        if (old != NULL)
+                h->alloc->free(h->alloc->ctx, old,
+                    old_cap * sizeof(struct flist_hent));
+
+        return 0;
+}
+
+int
+hidx_insert(struct flist_hidx *h, const void *key, unsigned long hv, void *val)
+{
+        if (hidx_reserve(h, 1) != 0)
+                return -1;
+
+        hidx_place(h, key, hv, val);
+        return 0;
+}
+
+void
+hidx_clear(struct flist_hidx *h)
+{
+        if (h->tab != NULL)
+                h->alloc->free(h->alloc->ctx, h->tab,
+                    h->cap * sizeof(struct flist_hent));
+
+        h->tab = NULL;
+        h->cap = h->used = h->live = 0;
+}
+
+void
+hidx_place(struct flist_hidx *h, const void *key, unsigned long hv, void *val)
+{
+        struct   flist_hent *ent;
+        size_t   i, mask;
+
+        mask = h->cap - 1;
+        for (i = hv & mask; (ent = &h->tab[i])->val != NULL
+            && ent->val != TOMB; i = (i + 1) & mask)
+                ;
+
+        if (ent->val == NULL)
+                h->used++;
+        h->live++;
+
+        ent->hash = hv;
+        ent->key  = key;
+        ent->val  = val;
+}
+
+void
+hidx_remove(struct flist_hidx *h, unsigned long hv, void *val)
+{
+        struct   flist_hent *ent;
+        size_t   i, mask;
+
+        if (h->cap == 0)
+                return;
+
+        mask = h->cap - 1;
+        for (i = hv & mask; (ent = &h->tab[i])->val != NULL;
+            i = (i + 1) & mask) {
+                if (ent->val == val) {
+                        ent->val = TOMB;
+                        h->live--;
+                        return;
+                }
+        }
+}
+
+void
+hidx_fill(struct flist *l)
+{
+        struct   flist_iter *cur;
+        size_t   i;
+
+        if (l == NULL || l->hidx == NULL)
+                return;
+
+        for (i = 0; i < l->hidx->cap; ++i)
+                l->hidx->tab[i].val = NULL;
+        l->hidx->used = l->hidx->live = 0;
+
+        if (hidx_reserve(l->hidx, l->len) != 0) {
+                flist_set_hash(l, NULL, NULL);
+                return;
+        }
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                hidx_place(l->hidx, cur->data,
+                    hidx_mix(l->hidx->hash(cur->data)), cur);
+        }
+}
+
+struct flist *
+ref_append(struct flist *ret, struct flist *src, struct flist_iter *node)
+{
+        struct   flist *nl;             /* list created here, if any */
+
+        if ((nl = ret) == NULL) {
+                if ((nl = new_list(src->alloc)) == NULL)
+                        return NULL;
+                nl->cl_hand = src->cl_hand;
+        }
+
+        if (flist_append(nl, node->data, NODE_BITS(node) & NODE_CALL
+            ? FLIST_CLEANPROT | FLIST_CLEANABLE : FLIST_DONTCLEAN) == NULL) {
+                if (ret == NULL)
+                        flist_free(&nl, 0);
+                return NULL;
+        }
+
+        return nl;
+}
+
+struct ftuple *
+split_begin(struct flist *l, struct flist **part)
+{
+        struct   ftuple *t;
+
+        if ((t = ftuple_create_with(l->alloc, 2, NULL, NULL)) == NULL)
+                return NULL;
+
+        if ((*part = new_list(l->alloc)) == NULL) {
+                ftuple_free(&t);
+                return NULL;
+        }
+
+        (*part)->cl_hand = l->cl_hand;
+        (*part)->stride  = l->stride;
+
+        return t;
+}
+
+void
+split_cut(struct flist *l, struct flist *a, struct flist_iter *cut, size_t n)
+{
+        if (n == 0)
+                return;
+
+        a->head = l->head;
+        a->len  = n;
+
+        if (cut == NULL) {
+                a->tail = l->tail;
+                l->head = l->tail = NULL;
+        } else {
+                a->tail = NODE_PREV(cut);
+                a->tail->next = NULL;
+                NODE_SET_PREV(cut, NULL);
+                l->head = cut;
+        }
+
+        l->len -= n;
+        idx_truncate(l, 0);
+}
+
+struct ftuple *
+split_end(struct ftuple *t, struct flist *l, struct flist *part,
+    int part_first)
+{
+        if ((part->arena = l->arena) != NULL)
+                part->arena->refs++;
+
+        /* lazy lists may have forced more since split_begin() */
+        part->kinds = l->kinds;
+
+        /* the part is left without an index if there is no memory for one */
+        if (l->hidx != NULL) {
+                flist_set_hash(part, l->hidx->hash, l->hidx->eq);
+                hidx_fill(l);
+        }
+
+        if (l->head == NULL && l->gen == NULL)
+                flist_free(&l, 0);
+        if (part->head == NULL)
+                flist_free(&part, 0);
+
+        t->arr[part_first ? 0 : 1] = part;
+        t->arr[part_first ? 1 : 0] = l;
+
+        return t;
+}
+
+struct ftuple *
+span_with(struct flist **lp, int (*p)(void *), int want)
+{
+        struct   flist_iter *cur;
+        struct   flist *l, *a;
+        struct   ftuple *t;
+        size_t   n;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (*lp == NULL)
+                return ftuple_create(2, NULL, NULL);
+
+        l = *lp;
+
+        if ((t = split_begin(l, &a)) == NULL)
+                return NULL;
+
+        for (n = 0, cur = FLIST_FIRST(l); cur != NULL;
+            cur = FLIST_NEXT(l, cur), ++n) {
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
+
+                if (!p(cur->data) != !want)
+                        break;
+        }
+
+        split_cut(l, a, cur, n);
+        *lp = NULL;
+
+        return split_end(t, l, a, 1);
+}
+
+int
+merge_check(struct flist **ls, size_t k, void (**hand)(void *))
+{
+        struct   flist *first;
+        size_t   i;
+        int      same;
+
+        for (first = NULL, same = 1, i = 0; i < k; ++i) {
+                if (ls[i] == NULL)
+                        continue;
+
+                if (first == NULL) {
+                        first = ls[i];
+                        continue;
+                }
+
+                if (ls[i]->alloc != first->alloc)
+                        goto inval;
+
+                same = same && ls[i]->cl_hand == first->cl_hand;
+        }
+
+        *hand = first != NULL ? first->cl_hand : NULL;
+        if (same)
+                return 0;
+
+        /* all lists with elements to clean up have to agree */
+        for (*hand = NULL, i = 0; i < k; ++i) {
+                if (ls[i] == NULL || !needs_hand(ls[i]))
+                        continue;
+
+                if (*hand == NULL)
+                        *hand = ls[i]->cl_hand;
+                else if (*hand != ls[i]->cl_hand)
+                        goto inval;
+        }
+
+        if (*hand == NULL)
+                *hand = first->cl_hand;
+
+        return 0;
+
+inval:
+        errno = EINVAL;
+        return -1;
+}
+
+int
+needs_hand(struct flist *l)
+{
+        struct   flist_iter *cur;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (l->gen != NULL)
+                return 1;
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                STATS_ADD(traversed, 1);
+
+                if (NODE_BITS(cur) & NODE_CALL)
+                        return 1;
+        }
+
+        return 0;
+}
+
+void
+chain_move(struct flist *dst, struct flist *src, struct flist_iter *at)
+{
+        struct   flist_iter *cur;
+
+        for (cur = src->head; dst->hidx != NULL && cur != NULL;
+            cur = cur->next) {
+                hidx_place(dst->hidx, cur->data,
+                    hidx_mix(dst->hidx->hash(cur->data)), cur);
+        }
+
+        arena_merge(dst, src);
+
+        if (src->head != NULL && at == NULL) {
+                NODE_SET_PREV(src->head, dst->tail);
+                if (dst->tail == NULL)
+                        dst->head = src->head;
+                else
+                        dst->tail->next = src->head;
+                dst->tail = src->tail;
+        } else if (src->head != NULL) {
+                NODE_SET_PREV(src->head, NODE_PREV(at));
+                src->tail->next = at;
+                if (NODE_PREV(at) == NULL)
+                        dst->head = src->head;
+                else
+                        NODE_PREV(at)->next = src->head;
+                NODE_SET_PREV(at, src->tail);
+        }
+
+        dst->len   += src->len;
+        dst->kinds |= src->kinds;
+
+        if (at == NULL) {
+                dst->gen = src->gen;
+                src->gen = NULL;
+        }
+
+        /* only the structure of src is left to free */
+        src->head = src->tail = NULL;
+        src->len  = 0;
+        flist_free(&src, 0);
+}
+
+int
+append_or_drop(struct flist *l, void *dat, unsigned flags)
+{
+        if (flist_append(l, dat, flags) != NULL)
+                return 0;
+
+        if ((flags & FLIST_CLEANABLE) && !(flags & FLIST_CLEANPROT) && dat)
+                l->cl_hand(dat);
+
+        return -1;
+}
+
+void
+group_free(void *g)
+{
+        struct   flist *l = g;
+
+        flist_free(&l, 0);
+}
+
+struct flist *
+zip_many(struct flist **ls, size_t k, void *(*f)(void *, void *),
+    unsigned flags)
+{
+        struct   zip_st st;
+        struct   flist *ret;
+        void    *dat;
+        size_t   i, n, lazy;
+        int      rc;
+
+        for (lazy = 0, i = 0; i < k; ++i) {
+                if (ls[i] == NULL)
+                        return NULL;
+                if (ls[i]->gen != NULL)
+                        lazy++;
+
+                st.src[i] = ls[i];
+                st.pos[i] = NULL;
+        }
+
+        for (n = 0, i = 0; i < k; ++i) {
+                if (ls[i]->gen == NULL)
+                        st.ord[n++] = i;
+        }
+        for (i = 0; i < k; ++i) {
+                if (ls[i]->gen != NULL)
+                        st.ord[n++] = i;
+        }
+
+        st.k     = k;
+        st.f     = f;
+        st.flags = f == NULL ? FLIST_CLEANABLE : flags;
+
+        if (lazy == k) {
+                if ((ret = flist_new_lazy(zip_step, NULL,
+                    sizeof(struct zip_st))) == NULL)
+                        return NULL;
+
+                *(struct zip_st *)ret->gen->st = st;
+                if (f == NULL)
+                        ret->cl_hand = tuple_free;
+
+                return ret;
+        }
+
+        if ((ret = new_list(ls[0]->alloc)) == NULL)
+                return NULL;
+        if (f == NULL)
+                ret->cl_hand = tuple_free;
+
+        while ((rc = zip_next(&st, &dat)) > 0) {
+                if (append_or_drop(ret, dat, st.flags) != 0) {
+                        rc = -1;
+                        break;
+                }
+        }
+
+        if (rc < 0) {
+                flist_free(&ret, 0);
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        if (ret->len == 0)
+                flist_free(&ret, 0);
+
+        return ret;
+}
+
+int
+zip_next(struct zip_st *st, void **dat)
+{
+        struct   flist_iter *old[3];
+        size_t   i, j;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        memcpy(old, st->pos, sizeof(old));
+        for (j = 0; j < st->k; ++j) {
+                i = st->ord[j];
+                st->pos[i] = st->pos[i] == NULL ? FLIST_FIRST(st->src[i])
+                    : FLIST_NEXT(st->src[i], st->pos[i]);
+
+                if (st->pos[i] != NULL)
+                        continue;
+
+                /* a lazy list that is not exhausted failed to grow */
+                if (st->src[i]->gen != NULL)
+                        goto fail;
+
+                return 0;
+        }
+
+        STATS_ADD(traversed, st->k);
+
+        if (st->f != NULL) {
+                STATS_ADD(callbacks, 1);
+                *dat = st->f(st->pos[0]->data, st->pos[1]->data);
+                return 1;
+        }
+
+        if (st->k == 2)
+                *dat = ftuple_create_with(st->src[0]->alloc, 2,
+                    st->pos[0]->data, st->pos[1]->data);
+        else
+                *dat = ftuple_create_with(st->src[0]->alloc, 3,
+                    st->pos[0]->data, st->pos[1]->data, st->pos[2]->data);
+
+        if (*dat != NULL)
+                return 1;
+
+fail:
+        memcpy(st->pos, old, sizeof(old));
+        return -1;
+}
+
+void
+tuple_free(void *t)
+{
+        struct   ftuple *tp = t;
+
+        ftuple_free(&tp);
+}
+
+struct flist *
+new_list(const struct falloc *a)
+{
+        struct   flist *ret;
+
+        if (a == NULL)
+                a = falloc_get_default();
+
+        if ((ret = a->alloc(a->ctx, sizeof(struct flist))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        /* set all flags to zero and all pointers to null */
+        memset(ret, 0x00, sizeof(struct flist));
+
+        ret->cl_hand = free;
+        ret->alloc   = a;
+
+        return ret;
+}
+
+struct flist_iter *
+new_node(struct flist *l, void *dat, struct flist_iter *prev,
+    struct flist_iter *next, unsigned flags)
+{
+        struct   flist_iter *ret;
+        struct   flist_arena *a;
+        int      slab;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (l->hidx != NULL && hidx_reserve(l->hidx, 1) != 0)
+                return NULL;
+
+        /* lists outside arena mode may still reuse nodes of bulk blocks */
+        slab = (a = flist_arena_of(l)) != NULL
+            && (a->slab_len != 0 || a->free != NULL);
+
+        if (slab)
+                ret = arena_alloc(l);
+        else
+                ret = l->alloc->alloc(l->alloc->ctx, sizeof(struct flist_iter));
+
+        if (ret == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        STATS_ADD(node_allocs, 1);
+        STATS_ADD(bytes_held, sizeof(struct flist_iter));
+
+        ret->data = dat;
+        ret->next = next;
+        NODE_INIT(ret, prev, FLAGS_BITS(flags) | (slab ? NODE_SLAB : 0));
+        l->kinds |= KIND(NODE_BITS(ret));
+
+        if (l->hidx != NULL)
+                hidx_place(l->hidx, dat, hidx_mix(l->hidx->hash(dat)), ret);
+
+        return ret;
+}
+
+void
+del_node(struct flist *l, struct flist_iter *node, int force)
+{
+        STATS_DECL
+
+        STATS_FETCH();
+
+        /* hash has to be computed before data is cleaned up */
+        if (l->hidx != NULL) {
+                hidx_remove(l->hidx, hidx_mix(l->hidx->hash(node->data)),
+                    node);
+        }
+
+        if (NODE_CLEANS(node, force) && node->data) {
+                STATS_ADD(cleanups, 1);
+                l->cl_hand(node->data);
+        }
+
+        STATS_ADD(node_frees, 1);
+        STATS_ADD(bytes_held, -(long)sizeof(struct flist_iter));
+
+        if (NODE_BITS(node) & NODE_SLAB) {
+                node->next = flist_arena_of(l)->free;
+                l->arena->free = node;
+        } else
+                l->alloc->free(l->alloc->ctx, node, sizeof(struct flist_iter));
+}
+
+void
+del_chain(struct flist *l, struct flist_iter *first, struct flist_iter *last,
+    size_t n, int force)
+{
+        struct   flist_iter *cur, *tmp;
+        struct   flist_arena *a;
+        int      clean;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (n == 0)
+                return;
+
+        if (l->hidx != NULL) {
+                for (cur = first; n-- > 0; cur = tmp) {
+                        tmp = cur->next;
+                        del_node(l, cur, force);
+                }
+                return;
+        }
+
+        STATS_ADD(node_frees, n);
+        STATS_ADD(bytes_held, -(long)(n * sizeof(struct flist_iter)));
+
+        /* nothing to clean up, the arena takes the chain as is */
+        clean = (l->kinds & KINDS_CLEAN(force)) != 0;
+        if (!clean && (l->kinds & KINDS_NONSLAB) == 0) {
+                last->next = flist_arena_of(l)->free;
+                l->arena->free = first;
+                return;
+        }
+
+        /* elements are not looked at unless some of them may be cleaned up */
+        a = flist_arena_of(l);
+        for (cur = first; n-- > 0; cur = tmp) {
+                tmp = cur->next;
+
+                if (clean && NODE_CLEANS(cur, force) && cur->data) {
+                        STATS_ADD(cleanups, 1);
+                        l->cl_hand(cur->data);
+                }
+
+                if (NODE_BITS(cur) & NODE_SLAB) {
+                        cur->next = a->free;
+                        a->free   = cur;
+                } else
+                        l->alloc->free(l->alloc->ctx, cur,
+                            sizeof(struct flist_iter));
+        }
+}
+
+struct flist_iter *
+arena_alloc(struct flist *l)
+{
+        struct   flist_iter *ret;
+        struct   flist_slab *slab;
+        struct   flist_arena *a;
+
+        a = flist_arena_of(l);
+
+        if ((ret = a->free) != NULL) {
+                a->free = ret->next;
+                return ret;
+        }
+
+        if (a->slabs == NULL || a->used == a->used_max) {
+                slab = l->alloc->alloc(l->alloc->ctx, sizeof(struct flist_slab)
+                    + (a->slab_len - 1) * sizeof(struct flist_iter));
+                if (slab == NULL)
+                        return NULL;
+
+                if (a->slabs == NULL)
+                        a->last = slab;
+
+                slab->len   = a->slab_len;
+                slab->next  = a->slabs;
+                a->slabs    = slab;
+                a->used     = 0;
+                a->used_max = a->slab_len;
+        }
+
+        return &a->slabs->nodes[a->used++];
+}
+
+struct flist_arena *
+flist_arena_new(const struct falloc *a)
+{
+        struct   flist_arena *ret;
+
+        if ((ret = a->alloc(a->ctx, sizeof(struct flist_arena))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        memset(ret, 0x00, sizeof(struct flist_arena));
+        ret->refs = 1;
+
+        return ret;
+}
+
+struct flist_iter *
+flist_arena_block(struct flist *l, size_t n)
+{
+        struct   flist_slab *slab;
+        struct   flist_arena *a;
+
+        if (l->arena == NULL && (l->arena = flist_arena_new(l->alloc)) == NULL)
+                return NULL;
+        a = flist_arena_of(l);
+
+        slab = l->alloc->alloc(l->alloc->ctx, sizeof(struct flist_slab)
+            + (n - 1) * sizeof(struct flist_iter));
+        if (slab == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        slab->len = n;
+
+        /* keep carving from the current slab, if there is one */
+        if (a->slabs == NULL) {
+                slab->next  = NULL;
+                a->slabs    = a->last = slab;
+                a->used     = a->used_max = n;
+        } else {
+                slab->next     = a->slabs->next;
+                a->slabs->next = slab;
+                if (a->last == a->slabs)
+                        a->last = slab;
+        }
+
+        return slab->nodes;
+}
+
+void
+arena_free(struct flist *l)
+{
+        struct   flist_slab *cur, *tmp;
+        struct   flist_arena *a, *next;
+        struct   flist_map *m, *mnext;
+        struct   flist_chunk *ch, *chnext;
+
+        /* forwarded arenas hold no slabs, only a reference to their target */
+        for (a = l->arena; a != NULL && --a->refs == 0; a = next) {
+                next = a->fwd;
+
+                for (cur = a->slabs; cur != NULL; cur = tmp) {
+                        tmp = cur->next;
+                        l->alloc->free(l->alloc->ctx, cur,
+                            sizeof(struct flist_slab)
+                            + (cur->len - 1) * sizeof(struct flist_iter));
+                }
+
+                for (m = a->maps; m != NULL; m = mnext) {
+                        mnext = m->next;
+                        munmap(m->addr, m->len);
+                        l->alloc->free(l->alloc->ctx, m,
+                            sizeof(struct flist_map));
+                }
+
+                for (ch = a->chunks; ch != NULL; ch = chnext) {
+                        chnext = ch->next;
+                        free(ch->sl);
+                        free(ch);
+                }
+
+                l->alloc->free(l->alloc->ctx, a, sizeof(struct flist_arena));
+        }
+
+        l->arena = NULL;
+}
+
+struct flist_arena *
+flist_arena_of(struct flist *l)
+{
+        struct   flist_arena *root;
+
+        if (l->arena == NULL || l->arena->fwd == NULL)
+                return l->arena;
+
+        for (root = l->arena->fwd; root->fwd != NULL; root = root->fwd)
+                ;
+
+        /* point straight at the root from now on */
+        root->refs++;
+        arena_free(l);
+
+        return l->arena = root;
+}
+
+void
+arena_merge(struct flist *dst, struct flist *src)
+{
+        struct   flist_arena *a, *c;
+        struct   flist_map *m;
+        struct   flist_chunk *ch;
+
+        if (src->arena == NULL)
+                return;
+
+        if (dst->arena == NULL) {
+                dst->arena = src->arena;
+                src->arena = NULL;
+                return;
+        }
+
+        if ((a = flist_arena_of(src)) == (c = flist_arena_of(dst)))
+                return;
+
+        /* slabs of a join c behind the one c is carving from */
+        if (c->slabs == NULL) {
+                c->slabs    = a->slabs;
+                c->last     = a->last;
+                c->used     = a->used;
+                c->used_max = a->used_max;
+        } else if (a->slabs != NULL) {
+                a->last->next  = c->slabs->next;
+                c->slabs->next = a->slabs;
+                if (c->last == c->slabs)
+                        c->last = a->last;
+        }
+
+        /* spare nodes of a are not worth a walk, they wait for release */
+        if (c->free == NULL)
+                c->free = a->free;
+
+        if (a->maps != NULL) {
+                for (m = a->maps; m->next != NULL; m = m->next)
+                        ;
+                m->next = c->maps;
+                c->maps = a->maps;
+                a->maps = NULL;
+        }
+
+        if (c->err == 0)
+                c->err = a->err;
+
+        if (a->chunks != NULL) {
+                for (ch = a->chunks; ch->next != NULL; ch = ch->next)
+                        ;
+                ch->next  = c->chunks;
+                c->chunks = a->chunks;
+                a->chunks = NULL;
+        }
+
+        a->slabs = a->last = NULL;
+        a->free  = NULL;
+        a->fwd   = c;
+        c->refs++;
+}
+
+struct flist_iter *
+flist_force_next(struct flist *l)
+{
+        struct   flist_iter *to_add;
+        void    *dat;
+        unsigned flags;
+        int      rc;
+
+        if (l->gen == NULL)
+                return NULL;
 
-                tmp = cur->next;
-                free(cur);
+        if (l->gen->pending) {
+                dat   = l->gen->dat;
+                flags = l->gen->flags;
+        } else if ((rc = l->gen->step(l->gen, &dat, &flags)) <= 0) {
+                if (rc == 0)
+                        gen_free(l, 0);
+                return NULL;
         }
 
-        free(*lp);
-        *lp = NULL;
-}
+        /* the element waits for another try instead of getting lost */
+        if ((to_add = new_node(l, dat, l->tail, NULL, flags)) == NULL) {
+                l->gen->dat     = dat;
+                l->gen->flags   = flags;
+                l->gen->pending = 1;
+                return NULL;
+        }
+        l->gen->pending = 0;
 
-void
-flist_set_cleanup(struct flist *l, void (*handler)(void *))
-{
-        if (l == NULL || handler == NULL)
-                return;
+        if (l->tail == NULL)
+                l->head = l->tail = to_add;
+        else
+                l->tail = l->tail->next = to_add;
+        l->len++;
 
-        l->cl_hand = handler;
+        return to_add;
 }
 
-void
-flist_head(struct flist *l, int force)
+struct flist_iter *
+flist_force_pass(struct flist *l)
 {
         struct   flist_iter *cur, *tmp;
 
-        if (l == NULL)
-                return;
-
-        for (cur = l->head->next; cur != NULL; cur = tmp) {
-                if (cur->call_h && cur->data && (!cur->prot_h || force))
-                        l->cl_hand(cur->data);
+        if (l->gen == NULL || l->gen->drop == NULL)
+                return flist_force_next(l);
 
+        idx_truncate(l, 0);
+        for (cur = l->head; cur != NULL; cur = tmp) {
                 tmp = cur->next;
-                free(cur);
+                del_node(l, cur, 0);
         }
+
+        l->head = l->tail = NULL;
+        l->len  = 0;
+
+        /* lists sharing the arena may hold elements of any chunk */
+        if (l->arena == NULL || flist_arena_of(l)->refs == 1)
+                l->gen->drop(l->gen);
+
+        return flist_force_next(l);
 }
 
-void
-flist_tail(struct flist **lp, int force)
+int
+flist_force_all(struct flist *l)
 {
-        flist_drop(lp, 1, force);
+        if (l == NULL)
+                return 0;
+
+        while (l->gen != NULL) {
+                if (flist_force_next(l) == NULL && l->gen != NULL)
+                        return -1;
+        }
+
+        return 0;
 }
 
-void
-flist_map(struct flist *l, void *(*f)(void *), int force)
+struct flist_iter *
+node_at(struct flist *l, size_t i)
 {
-        void    *data;
-        struct   flist_iter *cur;
+        const    struct falloc *a;
+        struct   flist_iter *cur, **tmp;
+        size_t   pos, k;
+
+        /* checkpoints are hints, they are not extended if memory runs out */
+        a = l->alloc;
+        if (l->stride != 0 && (k = i / l->stride) >= l->ckpt_cap
+            && (tmp = a->alloc(a->ctx, (2 * k + 1)
+            * sizeof(struct flist_iter *))) != NULL) {
+                if (l->ckpt != NULL) {
+                        memcpy(tmp, l->ckpt,
+                            l->nckpt * sizeof(struct flist_iter *));
+                        a->free(a->ctx, l->ckpt,
+                            l->ckpt_cap * sizeof(struct flist_iter *));
+                }
 
-        for (cur = l->head; cur != NULL; cur = cur->next) {
-                data = f(cur->data);
+                l->ckpt     = tmp;
+                l->ckpt_cap = 2 * k + 1;
+        }
 
-                if (cur->data != data && data != NULL) {
-                        if (cur->call_h && cur->data && (!cur->prot_h || force))
-                                l->cl_hand(cur->data);
+        /* extend checkpoints so that the one preceding i is known */
+        if (l->stride != 0 && (k = i / l->stride) >= l->nckpt
+            && l->ckpt_cap != 0) {
+                if (k >= l->ckpt_cap)
+                        k = l->ckpt_cap - 1;
 
-                        cur->call_h = 1;
-                        cur->prot_h = 0;
-                        cur->data = data;
+                if (l->nckpt == 0) {
+                        cur = l->head;
+                        l->ckpt[l->nckpt++] = cur;
+                } else
+                        cur = l->ckpt[l->nckpt - 1];
+
+                for (pos = (l->nckpt - 1) * l->stride; l->nckpt <= k;) {
+                        cur = cur->next;
+                        if (++pos % l->stride == 0)
+                                l->ckpt[l->nckpt++] = cur;
                 }
         }
-}
 
-size_t
-flist_length(struct flist *l)
-{
-        return l == NULL ? 0 : l->len;
-}
+        /* pick the closest starting point, walking forward from head */
+        cur = l->head;
+        pos = 0;
 
-void *
-flist_find(struct flist *l, int (*f)(void *))
-{
-        struct   flist_iter *cur;
+        if (l->nckpt != 0) {
+                k   = i / l->stride < l->nckpt ? i / l->stride : l->nckpt - 1;
+                cur = l->ckpt[k];
+                pos = k * l->stride;
+        }
 
-        for (cur = l->head; cur != NULL; cur = cur->next) {
-                if (f(cur->data))
-                        return cur->data;
+        if (l->fing != NULL && (l->fing_i <= i ? i - l->fing_i
+            : l->fing_i - i) < i - pos) {
+                cur = l->fing;
+                pos = l->fing_i;
         }
 
-        return NULL;
+        if (l->len - 1 - i < (pos <= i ? i - pos : pos - i)) {
+                cur = l->tail;
+                pos = l->len - 1;
+        }
+
+        for (; pos < i; ++pos)
+                cur = cur->next;
+        for (; pos > i; --pos)
+                cur = NODE_PREV(cur);
+
+        l->fing   = cur;
+        l->fing_i = i;
+
+        return cur;
+}
+
+void
+idx_truncate(struct flist *l, size_t n)
+{
+        if (l->fing != NULL && l->fing_i >= n)
+                l->fing = NULL;
+
+        if (l->stride != 0 && l->nckpt > (n + l->stride - 1) / l->stride)
+                l->nckpt = (n + l->stride - 1) / l->stride;
 }
 
 int
-flist_elem(struct flist *l, int (*cmp)(const void *, const void *),
-    const void *x)
+force_upto(struct flist *l, size_t n)
 {
-        struct   flist_iter *cur;
-        
-        /* empty list contains nothing (duh) */
         if (l == NULL)
                 return 0;
 
-        for (cur = l->head; cur != NULL; cur = cur->next) {
-                if (cmp(cur->data, x) == 0)
-                        return 1;
+        while (l->gen != NULL && l->len < n) {
+                if (flist_force_next(l) == NULL && l->gen != NULL)
+                        return -1;
         }
 
         return 0;
 }
 
-int
-flist_any(struct flist *l, int (*f)(void *))
+void
+gen_free(struct flist *l, int force)
 {
-        return flist_find(l, f) != NULL;
-}
+        struct   flist_gen *g;
+        STATS_DECL
 
-int
-flist_all(struct flist *l, int (*f)(void *))
-{
-        struct   flist_iter *cur;
+        STATS_FETCH();
 
-        for (cur = l->head; cur != NULL; cur = cur->next) {
-                if (!f(cur->data))
-                        return 0;
+        if (l == NULL || (g = l->gen) == NULL)
+                return;
+
+        if (g->release != NULL)
+                g->release(g, l, force);
+
+        /* element that never made it to the list goes as if it did */
+        if (g->pending && g->dat != NULL
+            && (KINDS_CLEAN(force) & KIND(FLAGS_BITS(g->flags)))) {
+                STATS_ADD(cleanups, 1);
+                l->cl_hand(g->dat);
         }
 
-        return 1;
+        l->alloc->free(l->alloc->ctx, g->st, g->size);
+        l->alloc->free(l->alloc->ctx, g, sizeof(struct flist_gen));
+        l->gen = NULL;
 }
 
-void
-flist_filter(struct flist **lp, int (*f)(void *), int force)
+struct flist *
+flist_new_lazy(int (*step)(struct flist_gen *, void **, unsigned *),
+    void (*release)(struct flist_gen *, struct flist *, int), size_t size)
 {
-        struct   flist_iter *cur, *tmp;
+        struct   flist *ret;
+        struct   flist_gen *g;
+        const    struct falloc *a;
 
-        for (cur = (*lp)->head; cur != NULL; cur = tmp) {
-                tmp = cur->next;
+        if ((ret = new_list(NULL)) == NULL)
+                return NULL;
 
-                if (f(cur->data))
-                        continue;
+        a = ret->alloc;
+        if ((g = a->alloc(a->ctx, sizeof(struct flist_gen))) == NULL
+            || (g->st = a->alloc(a->ctx, size)) == NULL) {
+                if (g != NULL)
+                        a->free(a->ctx, g, sizeof(struct flist_gen));
+                a->free(a->ctx, ret, sizeof(struct flist));
+                errno = ENOMEM;
+                return NULL;
+        }
 
-                if (cur->prev == NULL)
-                        (*lp)->head = cur->next;
-                else
-                        cur->prev->next = cur->next;
+        memset(g->st, 0x00, size);
+        g->step    = step;
+        g->release = release;
+        g->drop    = NULL;
+        g->size    = size;
+        g->dat     = NULL;
+        g->flags   = 0;
+        g->pending = 0;
 
-                if (cur->next == NULL)
-                        (*lp)->tail = cur->prev;
-                else
-                        cur->next->prev = cur->prev;
+        ret->gen = g;
 
-                if (cur->call_h && cur->data && (!cur->prot_h || force))
-                        (*lp)->cl_hand(cur->data);
+        return ret;
+}
 
-                free(cur);
-                (*lp)->len--;
-        }
+int
+iterate_step(struct flist_gen *g, void **dat, unsigned *flags)
+{
+        struct   iterate_st *st;
+        STATS_DECL
 
-        if ((*lp)->len == 0)
-                flist_free(lp, force);
+        STATS_FETCH();
+        st     = g->st;
+        *dat   = st->next;
+        *flags = st->flags;
+
+        STATS_ADD(callbacks, 1);
+        st->next  = st->f(*dat);
+        st->flags = FLIST_CLEANABLE;
+
+        return 1;
 }
 
 void
-flist_take(struct flist **lp, int n, int force)
+iterate_release(struct flist_gen *g, struct flist *l, int force)
 {
-        struct   flist_iter *cur, *tmp;
-        int      i;
-
-        if (n <= 0) {
-                flist_free(lp, force);
-                return;
+        struct   iterate_st *st;
+        STATS_DECL
+
+        STATS_FETCH();
+        st = g->st;
+        if ((st->flags & FLIST_CLEANABLE) && st->next
+            && (!(st->flags & FLIST_CLEANPROT) || force)) {
+                STATS_ADD(cleanups, 1);
+                l->cl_hand(st->next);
         }
+}
 
-        if ((size_t)n >= flist_length(*lp))
-                return;
+int
+unfoldr_step(struct flist_gen *g, void **dat, unsigned *flags)
+{
+        struct   unfoldr_st *st;
+        STATS_DECL
 
-        for (i = 0, cur = (*lp)->head; i < n; ++i, cur = cur->next)
-                ;
+        STATS_FETCH();
+        st     = g->st;
+        *flags = st->flags;
 
-        cur->prev->next = NULL;
-        (*lp)->tail = cur->prev;
+        STATS_ADD(callbacks, 1);
+        return st->f(st->seed, dat) != 0;
+}
 
-        for (; cur != NULL; cur = tmp) {
-                tmp = cur->next;
+int
+cycle_step(struct flist_gen *g, void **dat, unsigned *flags)
+{
+        struct   cycle_st *st;
 
-                if (cur->call_h && cur->data && (!cur->prot_h || force))
-                        (*lp)->cl_hand(cur->data);
+        st     = g->st;
+        *dat   = st->pos->data;
+        *flags = NODE_BITS(st->pos) & NODE_CALL
+            ? FLIST_CLEANABLE | FLIST_CLEANPROT : FLIST_DONTCLEAN;
 
-                free(cur);
-                (*lp)->len--;
-        }
+        st->pos = st->pos->next != NULL ? st->pos->next : st->src->head;
+
+        return 1;
 }
 
-void
-flist_drop(struct flist **lp, int n, int force)
+int
+repeat_step(struct flist_gen *g, void **dat, unsigned *flags)
 {
-        struct   flist_iter *cur, *tmp;
-        int      i;
+        struct   repeat_st *st;
 
-        if ((size_t)n >= flist_length(*lp)) {
-                flist_free(lp, force);
-                return;
+        st = g->st;
+        if (st->copy_c == NULL) {
+                *dat   = st->dat;
+                *flags = FLIST_CLEANABLE | FLIST_CLEANPROT;
+        } else {
+                *dat   = st->copy_c(st->dat);
+                *flags = FLIST_CLEANABLE;
         }
 
-        for (i = 0, cur = (*lp)->head; i < n; ++i, cur = tmp) {
-                tmp = cur->next;
+        return 1;
+}
 
-                if (cur->call_h && cur->data && (!cur->prot_h || force))
-                        (*lp)->cl_hand(cur->data);
+int
+zip_step(struct flist_gen *g, void **dat, unsigned *flags)
+{
+        struct   zip_st *st;
 
-                free(cur);
-                (*lp)->len--;
-        }
+        st     = g->st;
+        *flags = st->flags;
 
-        cur->prev = NULL;
-        (*lp)->head = cur;
+        return zip_next(st, dat);
 }
 
-void *
-flist_foldr(struct flist *l, void *x, void *(*f)(void *, void *))
+int
+par_run(struct flist *l, struct par_job *job)
 {
-        void    *acc, *tmp;
+        const    struct falloc *a;
         struct   flist_iter *cur;
+        size_t   i, k;
+
+        a         = l->alloc;
+        job->len  = l->len;
+        job->nseg = fpool_threads();
+        if (job->nseg > l->len)
+                job->nseg = l->len;
+
+        job->first = a->alloc(a->ctx, job->nseg * sizeof(struct flist_iter *));
+        job->off   = a->alloc(a->ctx, (job->nseg + 1) * sizeof(size_t));
+
+        if (job->f != NULL)
+                job->res = a->alloc(a->ctx, l->len * sizeof(void *));
+        if (job->fold != NULL)
+                job->res = a->alloc(a->ctx, job->nseg * sizeof(void *));
+        if (job->p != NULL)
+                job->keep = a->alloc(a->ctx, l->len);
+
+        if (job->first == NULL || job->off == NULL
+            || (job->p == NULL ? job->res == NULL : job->keep == NULL)) {
+                par_free(a, job);
+                errno = ENOMEM;
+                return -1;
+        }
 
-        if (l == NULL || l->tail == NULL)
-                return x;
+        for (k = 0; k <= job->nseg; ++k)
+                job->off[k] = l->len * k / job->nseg;
 
-        acc = f(l->tail->data, x);
-        for (cur = l->tail->prev; cur != NULL; cur = cur->prev) {
-                tmp = acc;
-                acc = f(cur->data, tmp);
-                l->cl_hand(tmp);
+        for (i = 0, k = 0, cur = l->head; k < job->nseg; ++i, cur = cur->next) {
+                if (i == job->off[k])
+                        job->first[k++] = cur;
         }
 
-        return acc;
+        fpool_run(par_task, job, job->nseg);
+
+        a->free(a->ctx, job->first, job->nseg * sizeof(struct flist_iter *));
+        a->free(a->ctx, job->off, (job->nseg + 1) * sizeof(size_t));
+        job->first = NULL;
+        job->off   = NULL;
+
+        return 0;
 }
 
-void *
-flist_foldl(struct flist *l, void *x, void *(*f)(void *, void *))
+void
+par_free(const struct falloc *a, struct par_job *job)
+{
+        if (job->first != NULL)
+                a->free(a->ctx, job->first,
+                    job->nseg * sizeof(struct flist_iter *));
+        if (job->off != NULL)
+                a->free(a->ctx, job->off, (job->nseg + 1) * sizeof(size_t));
+        if (job->res != NULL)
+                a->free(a->ctx, job->res, (job->f != NULL ? job->len
+                    : job->nseg) * sizeof(void *));
+        if (job->keep != NULL)
+                a->free(a->ctx, job->keep, job->len);
+
+        job->first = NULL;
+        job->off   = NULL;
+        job->res   = NULL;
+        job->keep  = NULL;
+}
+
+void
+par_task(void *arg, size_t k)
 {
         void    *acc, *tmp;
+        struct   par_job *job;
         struct   flist_iter *cur;
+        size_t   i;
+        STATS_DECL
+
+        STATS_FETCH();
+        job = arg;
+        cur = job->first[k];
+
+        STATS_ADD(traversed, job->off[k + 1] - job->off[k]);
+        STATS_ADD(callbacks, job->off[k + 1] - job->off[k]);
+
+        if (job->fold != NULL) {
+                acc = job->fold(job->x, cur->data);
+                for (i = job->off[k] + 1; i < job->off[k + 1]; ++i) {
+                        cur = cur->next;
+                        tmp = acc;
+                        acc = job->fold(tmp, cur->data);
+                        STATS_ADD(cleanups, 1);
+                        job->cl_hand(tmp);
+                }
 
-        if (l == NULL || l->tail == NULL)
-                return x;
-
-        acc = f(x, l->head->data);
-        for (cur = l->head->next; cur != NULL; cur = cur->next) {
-                tmp = acc;
-                acc = f(tmp, cur->data);
-                l->cl_hand(tmp);
+                job->res[k] = acc;
+                return;
         }
 
-        return acc;
-}
-
-void *
-flist_val_head(struct flist *l)
-{
-        if (l == NULL)
-                return NULL;
-
-        return l->head != NULL ? l->head->data : NULL;
+        for (i = job->off[k]; i < job->off[k + 1]; ++i, cur = cur->next) {
+                if (job->f != NULL)
+                        job->res[i] = job->f(cur->data);
+                else
+                        job->keep[i] = job->p(cur->data) != 0;
+        }
 }
 
-void *
-flist_val_at_i(struct flist *l, int i)
+struct flist_iter *
+find_run(struct flist *l, struct find_job *job)
 {
+        const    struct falloc *a;
         struct   flist_iter *cur;
+        size_t   i, k;
+        STATS_DECL
 
-        if (l == NULL)
+        if (l == NULL || flist_force_all(l) != 0 || l->len == 0)
                 return NULL;
 
-        for (cur = l->head; cur != NULL && i > 0; --i, cur = cur->next)
-                ;
+        a         = l->alloc;
+        job->nseg = FIND_SEGS * fpool_threads();
+        if (job->nseg > l->len)
+                job->nseg = l->len;
+
+        job->first = a->alloc(a->ctx, job->nseg * sizeof(struct flist_iter *));
+        job->off   = a->alloc(a->ctx, (job->nseg + 1) * sizeof(size_t));
+
+        if (job->first == NULL || job->off == NULL
+            || pthread_mutex_init(&job->lock, NULL) != 0) {
+                if (job->first != NULL)
+                        a->free(a->ctx, job->first,
+                            job->nseg * sizeof(struct flist_iter *));
+                if (job->off != NULL)
+                        a->free(a->ctx, job->off,
+                            (job->nseg + 1) * sizeof(size_t));
+
+                STATS_FETCH();
+                for (cur = l->head; cur != NULL; cur = cur->next) {
+                        STATS_ADD(traversed, 1);
+                        STATS_ADD(callbacks, 1);
+
+                        if (find_match(job, cur->data))
+                                return cur;
+                }
 
-        return i == 0 ? cur->data : NULL;
-}
+                return NULL;
+        }
 
-struct flist *
-flist_repeat(void *dat, int n, void *(*copy_c)(void *))
-{
-        struct   flist *ret;
+        job->hit  = (size_t)-1;
+        job->node = NULL;
 
-        if (dat == NULL || n == 0)
-                return NULL;
+        for (k = 0; k <= job->nseg; ++k)
+                job->off[k] = l->len * k / job->nseg;
 
-        for (ret = NULL; n > 0; --n) {
-                if (copy_c == NULL) {
-                        ret = flist_append(ret, dat, FLIST_CLEANABLE
-                            | FLIST_CLEANPROT);
-                } else
-                        ret = flist_append(ret, copy_c(dat), FLIST_CLEANABLE);
+        for (i = 0, k = 0, cur = l->head; k < job->nseg; ++i, cur = cur->next) {
+                if (i == job->off[k])
+                        job->first[k++] = cur;
         }
 
-        return ret;
-}
+        fpool_run(find_task, job, job->nseg);
 
-void
-flist_reverse(struct flist *l)
-{
-        struct   flist_iter *cur, *tmp;
+        pthread_mutex_destroy(&job->lock);
+        a->free(a->ctx, job->first, job->nseg * sizeof(struct flist_iter *));
+        a->free(a->ctx, job->off, (job->nseg + 1) * sizeof(size_t));
 
-        if (l == NULL)
-                return;
+        return job->node;
+}
 
-        for (cur = l->head; cur != NULL; cur = cur->prev) {
-                tmp = cur->next;
-                cur->next = cur->prev;
-                cur->prev = tmp;
-        }
+int
+find_match(struct find_job *job, void *dat)
+{
+        if (job->cmp != NULL)
+                return job->cmp(dat, job->key) == 0;
 
-        tmp = l->head;
-        l->head = l->tail;
-        l->tail = tmp;
+        return !job->p(dat) == !job->want;
 }
 
-struct flist *
-new_list(void)
+void
+find_task(void *arg, size_t k)
 {
-        struct   flist *ret;
+        struct   find_job *job;
+        struct   flist_iter *cur;
+        size_t   i;
+        int      stop;
+        STATS_DECL
 
-        if ((ret = malloc(sizeof(struct flist))) == NULL)
-                ERROR("malloc");
+        STATS_FETCH();
+        job = arg;
+        cur = job->first[k];
 
-        /* set all flags to zero and all pointers to null */
-        memset(ret, 0x00, sizeof(struct flist));
+        for (i = job->off[k]; i < job->off[k + 1]; ++i, cur = cur->next) {
+                pthread_mutex_lock(&job->lock);
+                stop = job->any ? job->node != NULL : job->hit <= i;
+                pthread_mutex_unlock(&job->lock);
 
-        ret->cl_hand = free;
+                if (stop)
+                        return;
 
-        return ret;
-}
+                STATS_ADD(traversed, 1);
+                STATS_ADD(callbacks, 1);
 
-struct flist_iter *
-new_node(void *dat, struct flist_iter *prev, struct flist_iter *next,
-    unsigned flags)
-{
-        struct   flist_iter *ret;
+                if (!find_match(job, cur->data))
+                        continue;
 
-        if ((ret = malloc(sizeof(struct flist_iter))) == NULL)
-                ERROR("malloc");
+                pthread_mutex_lock(&job->lock);
+                if (i < job->hit) {
+                        job->hit  = i;
+                        job->node = cur;
+                }
+                pthread_mutex_unlock(&job->lock);
 
-        ret->data     = dat;
-        ret->next     = next;
-        ret->prev     = prev;
-        ret->call_h   = (flags & FLIST_CLEANABLE) != 0 ? 1 : 0;
-        ret->prot_h   = (flags & FLIST_CLEANPROT) != 0 ? 1 : 0;
+                return;
+        }
+}
 
-        return ret;
+void
+comb_task(void *arg, size_t k)
+{
+        struct   comb_job *job;
+        void   **a, **b, *res;
+        STATS_DECL
+
+        STATS_FETCH();
+        job = arg;
+        a   = &job->part[2 * k * job->step];
+        b   = &job->part[(2 * k + 1) * job->step];
+
+        STATS_ADD(callbacks, 1);
+        STATS_ADD(cleanups, 2);
+
+        res = job->combine(*a, *b);
+        job->cl_hand(*a);
+        job->cl_hand(*b);
+        *a  = res;
 }
@@ -0,0 +1,440 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Internal header of the @p flist module
+ *
+ * Definitions shared between @p flist and the modules that need to walk its
+ * nodes directly. Not installed, not a part of the public interface.
+ */
+
+#ifndef FLIST_IMPL_H_INCLUDED
+#define FLIST_IMPL_H_INCLUDED
+
+#include "include/flist.h"
+
+/**
+ * @brief Slab of preallocated nodes
+ *
+ * Slabs are allocated by lists running in arena mode, each one holding a fixed
+ * number of nodes. The array at the end uses the C90 struct hack, actual number
+ * of nodes is stored in `len`, needed to give the slab back to the allocator.
+ *
+ * @see flist_arena
+ */
+struct flist_slab {
+        struct       flist_slab *next;  /**< @brief Previously allocated slab */
+        size_t       len;               /**< @brief Number of nodes */
+        struct       flist_iter nodes[1]; /**< @brief Nodes carved from slab */
+};
+
+/**
+ * @brief Node arena of `flist`
+ *
+ * New nodes are first taken from the free list, then carved from the most
+ * recently allocated slab and only once it is exhausted a new slab is
+ * allocated. Removed nodes are put back on the free list (chained through
+ * their `next` pointers) and slabs themselves are released all at once when
+ * the list is freed.
+ *
+ * Lists split by subroutines like `flist_partition()` may end up holding nodes
+ * of the same slabs. They then share the arena, which counts its users in
+ * `refs` and is released together with the last one of them. When nodes of
+ * one arena move to a list using another one (see `flist_concat()`), slabs of
+ * the former are handed over to the latter and the former forwards to it
+ * through `fwd`, counting as one of its users. Lists look their arena up
+ * through the forwarding chain, which never has cycles.
+ *
+ * Lists opened by `flist_mmap_open()` hold elements pointing into a file
+ * mapping, which is kept in `maps` and unmapped along with the slabs, so that
+ * it lives exactly as long as any node referring to it.
+ *
+ * Elements of lists created by `flist_from_fd()` point into the buffers their
+ * input was read into. The generator holds on to the buffers while it runs
+ * and hands them over to `chunks` once it is released, for the same reason.
+ * Along with them it hands over `err`, the error that ended its input, if
+ * any, so that `flist_stream_error()` can still report it.
+ *
+ * @see flist_set_arena()
+ */
+struct flist_arena {
+        struct       flist_slab *slabs; /**< @brief Chain of allocated slabs */
+        struct       flist_slab *last;  /**< @brief Last slab of the chain */
+        struct       flist_iter *free;  /**< @brief Nodes available for reuse */
+        size_t       slab_len;          /**< @brief Nodes per new slab */
+        size_t       used;              /**< @brief Nodes used in first slab */
+        size_t       used_max;          /**< @brief Capacity of first slab */
+        size_t       refs;              /**< @brief Lists using the arena */
+        struct       flist_arena *fwd;  /**< @brief Arena taking over, or NULL */
+        struct       flist_map *maps;   /**< @brief File mappings in use */
+        struct       flist_chunk *chunks; /**< @brief Input buffers in use */
+        int          err;               /**< @brief Read error of a stream */
+};
+
+/**
+ * @brief File mapping holding elements of a list
+ *
+ * @see flist_arena
+ */
+struct flist_map {
+        struct       flist_map *next;   /**< @brief Next mapping of the arena */
+        void        *addr;              /**< @brief Start of the mapping */
+        size_t       len;               /**< @brief Length of the mapping */
+};
+
+/**
+ * @brief Buffer of input read by `flist_from_fd()`
+ *
+ * Elements split from the buffer are kept in `sl` and point into `buf`, which
+ * is followed by a spare byte so that the last one can always be terminated.
+ *
+ * @see flist_arena
+ */
+struct flist_chunk {
+        struct       flist_chunk *next; /**< @brief Previously read chunk */
+        struct       flist_slice *sl;   /**< @brief Elements split from it */
+        size_t       nsl;               /**< @brief Number of elements */
+        size_t       len;               /**< @brief Bytes read into `buf` */
+        size_t       cap;               /**< @brief Capacity of `buf` */
+        char         buf[1];            /**< @brief Input */
+};
+
+/**
+ * @brief Generator of a lazy list
+ *
+ * Lazy lists store only their already forced prefix as nodes. Further elements
+ * are produced on demand by `step`, which stores the element and its inflags
+ * through its arguments and returns zero once the generator is exhausted, or
+ * a negative value with errno set if it fails and may be retried. `release`
+ * frees whatever the generator state still holds (obeying `force` the same
+ * way as `flist_free()` does), if set, and is called exactly once, either
+ * when the generator is exhausted or when it is discarded. The state itself,
+ * `size` bytes, is allocated along with the generator by the allocator of
+ * the list.
+ *
+ * An element produced by `step` for which no node could be allocated is kept
+ * in `dat` and `flags` until it is forced again, `pending` is set meanwhile.
+ *
+ * Generators of streams set `drop`, which makes traversals passing through
+ * the list with `FLIST_PASS()` release the nodes behind them. It is called
+ * once all nodes are gone and no other list shares the arena, so that the
+ * generator may free whatever backed the released elements.
+ *
+ * @see flist_force_next()
+ */
+struct flist_gen {
+        int        (*step)(struct flist_gen *, void **, unsigned *);
+                                        /**< @brief Produces next element */
+        void       (*release)(struct flist_gen *, struct flist *, int);
+                                        /**< @brief Frees generator state */
+        void       (*drop)(struct flist_gen *);
+                                        /**< @brief Frees passed input */
+        void        *st;                /**< @brief Generator state */
+        size_t       size;              /**< @brief Size of `st` */
+        void        *dat;               /**< @brief Element not linked yet */
+        unsigned     flags;             /**< @brief Inflags of `dat` */
+        int          pending;           /**< @brief Is `dat` set? */
+};
+
+/**
+ * @brief Entry of `flist_hidx`
+ *
+ * Free slots have `val` set to NULL, slots of removed entries keep a tombstone
+ * so that probing sequences passing through them stay intact.
+ */
+struct flist_hent {
+        unsigned long hash;             /**< @brief Hash of `key` */
+        const void  *key;               /**< @brief Element */
+        void        *val;               /**< @brief Associated value */
+};
+
+/**
+ * @brief Open addressing hash table keyed with list elements
+ *
+ * Serves both as the hash index of a list, where keys are elements and values
+ * are their nodes, and as temporary set or map of elements for subroutines
+ * like `flist_nub()`. Several entries may have equal keys. Slots are
+ * allocated with `alloc`, that of the list they serve.
+ *
+ * @see flist_set_hash()
+ */
+struct flist_hidx {
+        unsigned long (*hash)(const void *); /**< @brief Hashing function */
+        int        (*eq)(const void *, const void *); /**< @brief Equality */
+        const struct falloc *alloc;     /**< @brief Allocator of `tab` */
+        struct       flist_hent *tab;   /**< @brief Slots */
+        size_t       cap;               /**< @brief Number of slots */
+        size_t       used;              /**< @brief Entries and tombstones */
+        size_t       live;              /**< @brief Entries */
+};
+
+/**
+ * @brief A doubly linked list
+ *
+ * This structure is implemented to serve as an interface to a chain of
+ * `flist_iter` nodes. Lazy lists have `gen` set and their `len` counts only
+ * the elements forced so far.
+ *
+ * Positional access is sped up by a finger pointing to the most recently
+ * accessed node and, optionally, by an array of checkpoints. Both are only
+ * hints: subroutines that change positions of nodes discard them and they are
+ * rebuilt on demand.
+ *
+ * Unlike them, the optional hash index is exact and has to be kept up to date
+ * by every subroutine adding, removing or replacing elements.
+ *
+ * `kinds` holds a bit for every combination of node flags (see `NODE_BITS()`)
+ * that any node of the list may have. It only grows, except that subroutines
+ * walking all the nodes left anyway, like `flist_filter()`, recompute it, so
+ * it may hold combinations no longer present, but never misses one. That
+ * lets subroutines removing many nodes decide once for all of them whether
+ * elements need cleanup and whether nodes need freeing.
+ *
+ * The structure itself, its nodes and arena are obtained from `alloc`, fixed
+ * when the list is created. Only a pointer is kept, one word per list, as
+ * allocators outlive objects allocated with them.
+ *
+ * @see flist_iter
+ */
+struct flist {
+        struct       flist_iter *head;  /**< @brief Head of the list */
+        struct       flist_iter *tail;  /**< @brief Tail of the list */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler */
+        size_t       len;               /**< @brief Length of the list */
+        struct       flist_arena *arena; /**< @brief Node arena, may be NULL */
+        struct       flist_gen *gen;    /**< @brief Generator, NULL if eager */
+
+        struct       flist_iter *fing;  /**< @brief Last accessed node */
+        size_t       fing_i;            /**< @brief Position of `fing` */
+        struct       flist_iter **ckpt; /**< @brief Every `stride`-th node */
+        size_t       nckpt;             /**< @brief Valid checkpoints */
+        size_t       ckpt_cap;          /**< @brief Capacity of `ckpt` */
+        size_t       stride;            /**< @brief Checkpoint spacing, or 0 */
+
+        struct       flist_hidx *hidx;  /**< @brief Hash index, may be NULL */
+        unsigned     kinds;             /**< @brief Flags nodes may have */
+
+        const struct falloc *alloc;     /**< @brief Allocator of the list */
+};
+
+#define NODE_CALL 0x1 /**< @brief Node flag, call cleanup handler */
+#define NODE_PROT 0x2 /**< @brief Node flag, call cleanup handler iff forced */
+#define NODE_SLAB 0x4 /**< @brief Node flag, carved from an arena slab */
+
+#define KINDS_NONSLAB 0x0f /**< @brief Kinds of nodes not from slabs */
+
+/**
+ * @brief Kinds of nodes whose elements are cleaned up when they are removed
+ *
+ * @param[in] force Removal forced?
+ */
+#define KINDS_CLEAN(force) ((force) ? 0xaa : 0x22)
+
+/**
+ * @brief Node flags of inflags @p flags, `NODE_SLAB` excluded
+ */
+#define FLAGS_BITS(flags)                                               \
+        (((flags) & FLIST_CLEANABLE ? NODE_CALL : 0)                    \
+         | ((flags) & FLIST_CLEANPROT ? NODE_PROT : 0))
+
+/**
+ * @brief Bit of `kinds` standing for node flags @p bits
+ */
+#define KIND(bits) (1u << (bits))
+
+#ifndef FLIST_COMPACT
+/**
+ * @brief Node flags of node @p n
+ */
+# define NODE_BITS(n)                                                   \
+        ((unsigned)((n)->call_h | (n)->prot_h << 1 | (n)->slab_h << 2))
+
+/**
+ * @brief Sets node flags of node @p n to @p bits
+ */
+# define NODE_SET_BITS(n, bits)                                         \
+        ((n)->call_h = ((bits) & NODE_CALL) != 0,                       \
+         (n)->prot_h = ((bits) & NODE_PROT) != 0,                       \
+         (n)->slab_h = ((bits) & NODE_SLAB) != 0)
+
+/**
+ * @brief Sets link to the node preceding @p n to @p p
+ */
+# define NODE_SET_PREV(n, p) ((n)->prev = (p))
+
+/**
+ * @brief Initialises link to the preceding node @p p and node flags @p bits
+ *
+ * Unlike the two above, it does not read anything from @p n.
+ */
+# define NODE_INIT(n, p, bits)                                          \
+        (NODE_SET_PREV((n), (p)), NODE_SET_BITS((n), (bits)))
+#else
+# define NODE_BITS(n) ((unsigned)((n)->prev_f & 0x7))
+# define NODE_SET_BITS(n, bits)                                         \
+        ((n)->prev_f = ((n)->prev_f & ~(uintptr_t)0x7) | (bits))
+# define NODE_SET_PREV(n, p)                                            \
+        ((n)->prev_f = (uintptr_t)(p) | ((n)->prev_f & 0x7))
+# define NODE_INIT(n, p, bits) ((n)->prev_f = (uintptr_t)(p) | (bits))
+#endif
+
+/**
+ * @brief Node preceding node @p n
+ */
+#define NODE_PREV(n) FLIST_ITER_PREV(n)
+
+/**
+ * @brief Does removal of node @p n clean its element up?
+ *
+ * @param[in] n Nonnull node
+ * @param[in] force Removal forced?
+ */
+#define NODE_CLEANS(n, force) ((KINDS_CLEAN(force) & KIND(NODE_BITS(n))) != 0)
+
+/**
+ * @brief First node of list @p l, forcing it if necessary
+ *
+ * @param[in] l Nonnull list
+ */
+#define FLIST_FIRST(l)                                                  \
+        ((l)->head != NULL || (l)->gen == NULL ? (l)->head              \
+         : flist_force_next((l)))
+
+/**
+ * @brief Node following @p n in list @p l, forcing it if necessary
+ *
+ * @param[in] l Nonnull list
+ * @param[in] n Node of @p l
+ */
+#define FLIST_NEXT(l, n)                                                \
+        ((n)->next != NULL || (l)->gen == NULL ? (n)->next              \
+         : flist_force_next((l)))
+
+/**
+ * @brief Node following @p n in list @p l, consuming the list if it streams
+ *
+ * Same as `FLIST_NEXT()`, except that lists whose generator sets `drop` lose
+ * all forced nodes, @p n included, before the next one is forced. Meant for
+ * traversals that never look back.
+ *
+ * @param[in] l Nonnull list
+ * @param[in] n Node of @p l
+ */
+#define FLIST_PASS(l, n)                                                \
+        ((n)->next != NULL || (l)->gen == NULL ? (n)->next              \
+         : flist_force_pass((l)))
+
+/**
+ * @fn struct flist_iter *flist_arena_block(struct flist *l, size_t n)
+ * @brief Allocates a slab of exactly @p n nodes for list @p l
+ *
+ * The slab is owned by the arena of @p l (created if necessary) but is not
+ * used for carving new nodes, all of its nodes are meant to be used by the
+ * caller right away. Returns NULL and sets errno to ENOMEM if allocation
+ * fails.
+ *
+ * @param[in] l Target list
+ * @param[in] n Number of nodes, nonzero
+ */
+struct flist_iter           *flist_arena_block(struct flist *, size_t);
+
+/**
+ * @fn struct flist_arena *flist_arena_new(const struct falloc *a)
+ * @brief Creates new, empty arena using allocator @p a
+ *
+ * Slab size is left zeroed, meaning list is not in arena mode yet. Returns
+ * NULL and sets errno to ENOMEM if allocation fails.
+ *
+ * @param[in] a Allocator
+ */
+struct flist_arena          *flist_arena_new(const struct falloc *);
+
+/**
+ * @fn struct flist_arena *flist_arena_of(struct flist *l)
+ * @brief Returns arena of @p l, following forwarding
+ *
+ * Makes @p l point directly at the arena its arena forwards to, if any, and
+ * returns it. Returns NULL if @p l has no arena.
+ *
+ * @param[in,out] l Target list
+ */
+struct flist_arena          *flist_arena_of(struct flist *);
+
+/**
+ * @fn struct flist *flist_new_lazy(int (*step)(struct flist_gen *, void **,
+ *  unsigned *), void (*release)(struct flist_gen *, struct flist *, int),
+ *  size_t size)
+ * @brief Creates new, empty lazy list with given generator
+ *
+ * The list uses the default allocator, which also allocates the generator
+ * and its zeroed state of @p size bytes, left for the caller to set up.
+ * Returns NULL and sets errno to ENOMEM if allocation fails.
+ *
+ * @param[in] step Generating function
+ * @param[in] release Releasing function, may be NULL
+ * @param[in] size Size of generator state
+ * @see flist_gen
+ */
+struct flist                *flist_new_lazy(int (*)(struct flist_gen *,
+    void **, unsigned *), void (*)(struct flist_gen *, struct flist *, int),
+    size_t);
+
+/**
+ * @fn struct flist_iter *flist_force_next(struct flist *l)
+ * @brief Forces next element of a lazy list
+ *
+ * Appends the element produced by the generator of @p l and returns its node.
+ * If the generator is exhausted, it is released and NULL is returned. If it
+ * fails or no node can be allocated, NULL is returned as well, but the
+ * generator stays, errno is set and forcing may be retried later.
+ *
+ * @param[in] l Target list
+ */
+struct flist_iter           *flist_force_next(struct flist *);
+
+/**
+ * @fn struct flist_iter *flist_force_pass(struct flist *l)
+ * @brief Forces next element of a lazy list, dropping the forced ones first
+ *
+ * Nodes are only dropped if the generator of @p l sets `drop`, otherwise
+ * this is the same as @a flist_force_next().
+ *
+ * @param[in] l Target list
+ * @see FLIST_PASS()
+ */
+struct flist_iter           *flist_force_pass(struct flist *);
+
+/**
+ * @fn int flist_force_all(struct flist *l)
+ * @brief Forces all elements of a lazy list
+ *
+ * Does nothing for eager lists and never returns for infinite ones. Returns
+ * zero, or -1 with errno set if forcing fails, leaving @p l lazy.
+ *
+ * @param[in] l Target list, may be NULL
+ */
+int                          flist_force_all(struct flist *);
+
+#endif /* FLIST_IMPL_H_INCLUDED */
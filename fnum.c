@@ -0,0 +1,976 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for @p fnum module
+ */
+
+#include "include/fnum.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef __AVX2__
+# include <immintrin.h>
+#endif
+
+#define ALIGNMENT 32    /**< @brief Alignment of chunk data (AVX register) */
+
+/**
+ * @brief Expands @p LOOP with the C operator matching comparison @p CMP
+ *
+ * @param[in] CMP Value of type @a fnum_cmp
+ * @param[in] LOOP Name of a macro taking an operator as its only argument
+ */
+#define CMP_SWITCH(CMP, LOOP) do {                          \
+        switch ((CMP)) {                                    \
+        case FNUM_LT: LOOP(<);  break;                      \
+        case FNUM_LE: LOOP(<=); break;                      \
+        case FNUM_EQ: LOOP(==); break;                      \
+        case FNUM_NE: LOOP(!=); break;                      \
+        case FNUM_GE: LOOP(>=); break;                      \
+        case FNUM_GT: LOOP(>);  break;                      \
+        }                                                   \
+} while (0)
+
+/**
+ * @brief Expands @p BODY once per value type, with `T` being the C type and
+ * `F` the matching member of @a fnum_val
+ *
+ * @param[in] TYPE Value of type @a fnum_type
+ * @param[in] BODY Name of a macro taking `T` and `F` as arguments
+ */
+#define TYPE_SWITCH(TYPE, BODY) do {                        \
+        switch ((TYPE)) {                                   \
+        case FNUM_I32: BODY(int32_t, i32); break;           \
+        case FNUM_I64: BODY(int64_t, i64); break;           \
+        case FNUM_F32: BODY(float, f32);   break;           \
+        case FNUM_F64: BODY(double, f64);  break;           \
+        }                                                   \
+} while (0)
+
+/**
+ * @brief Chunk of values
+ *
+ * Values are packed at the beginning of `data`, which is aligned to
+ * `ALIGNMENT` bytes. Chunks reachable from a list are never empty.
+ */
+struct chunk {
+        struct       chunk *next;       /**< @brief Next chunk */
+        size_t       len;               /**< @brief Number of values */
+        void        *data;              /**< @brief Values */
+};
+
+/**
+ * @brief A numeric list
+ */
+struct fnum {
+        struct       chunk *head;       /**< @brief First chunk */
+        struct       chunk *tail;       /**< @brief Last chunk */
+        enum         fnum_type type;    /**< @brief Type of values */
+        size_t       size;              /**< @brief Size of a single value */
+        size_t       cap;               /**< @brief Values per chunk */
+        size_t       len;               /**< @brief Length of the list */
+};
+
+/**
+ * @fn void *slot(struct fnum *n, struct chunk *c, size_t i)
+ * @brief Returns address of @p i th value of chunk @p c
+ */
+static void     *slot(struct fnum *, struct chunk *, size_t);
+
+/**
+ * @fn struct chunk *tail_room(struct fnum *n)
+ * @brief Returns tail chunk of @p n, appending a new one if it is full
+ *
+ * Returns NULL and sets errno to ENOMEM if the new chunk cannot be allocated.
+ */
+static struct chunk *tail_room(struct fnum *);
+
+/**
+ * @fn void k_sum(enum fnum_type t, const void *p, size_t cnt, union fnum_val
+ *  *acc)
+ * @brief Adds @p cnt values at @p p to @p acc (see @a fnum_sum())
+ */
+static void      k_sum(enum fnum_type, const void *, size_t, union fnum_val *);
+
+/**
+ * @fn void k_minmax(enum fnum_type t, const void *p, size_t cnt, int max,
+ *  union fnum_val *acc)
+ * @brief Updates @p acc with minimum (or maximum) of @p cnt values at @p p
+ */
+static void      k_minmax(enum fnum_type, const void *, size_t, int,
+    union fnum_val *);
+
+/**
+ * @fn size_t k_count(enum fnum_type t, const void *p, size_t cnt, enum
+ *  fnum_cmp op, union fnum_val v)
+ * @brief Counts values x among @p cnt values at @p p such that "x op v" holds
+ */
+static size_t    k_count(enum fnum_type, const void *, size_t, enum fnum_cmp,
+    union fnum_val);
+
+/**
+ * @fn size_t k_filter(enum fnum_type t, void *p, size_t cnt, enum fnum_cmp op,
+ *  union fnum_val v)
+ * @brief Packs values x among @p cnt values at @p p such that "x op v" holds
+ * at the beginning of @p p and returns their number
+ */
+static size_t    k_filter(enum fnum_type, void *, size_t, enum fnum_cmp,
+    union fnum_val);
+
+/**
+ * @fn void k_affine(enum fnum_type t, void *p, size_t cnt, union fnum_val a,
+ *  union fnum_val b, int mul, int add)
+ * @brief Replaces values x at @p p with a * x + b
+ *
+ * Multiplication is skipped unless @p mul is set, addition unless @p add is.
+ */
+static void      k_affine(enum fnum_type, void *, size_t, union fnum_val,
+    union fnum_val, int, int);
+
+/**
+ * @fn void map(struct fnum *n, union fnum_val a, union fnum_val b, int mul, int
+ *  add)
+ * @brief Runs @a k_affine() over all chunks of @p n
+ */
+static void      map(struct fnum *, union fnum_val, union fnum_val, int, int);
+
+#ifdef __AVX2__
+/**
+ * @fn int popcnt(unsigned x)
+ * @brief Returns number of bits set in @p x
+ */
+static int       popcnt(unsigned);
+#endif
+
+struct fnum *
+fnum_new(enum fnum_type type)
+{
+        struct   fnum *ret;
+
+        if ((ret = malloc(sizeof(struct fnum))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        memset(ret, 0x00, sizeof(struct fnum));
+
+        ret->type = type;
+        ret->size = type == FNUM_I32 || type == FNUM_F32 ? 4 : 8;
+        ret->cap  = FNUM_CHUNK_BYTES / ret->size;
+
+        return ret;
+}
+
+void
+fnum_free(struct fnum **np)
+{
+        struct   chunk *cur, *tmp;
+
+        if (*np == NULL)
+                return;
+
+        for (cur = (*np)->head; cur != NULL; cur = tmp) {
+                tmp = cur->next;
+                free(cur->data);
+                free(cur);
+        }
+
+        free(*np);
+        *np = NULL;
+}
+
+union fnum_val
+fnum_i32(int32_t x)
+{
+        union    fnum_val ret;
+
+        ret.i64 = 0;
+        ret.i32 = x;
+
+        return ret;
+}
+
+union fnum_val
+fnum_i64(int64_t x)
+{
+        union    fnum_val ret;
+
+        ret.i64 = x;
+
+        return ret;
+}
+
+union fnum_val
+fnum_f32(float x)
+{
+        union    fnum_val ret;
+
+        ret.i64 = 0;
+        ret.f32 = x;
+
+        return ret;
+}
+
+union fnum_val
+fnum_f64(double x)
+{
+        union    fnum_val ret;
+
+        ret.f64 = x;
+
+        return ret;
+}
+
+int
+fnum_append(struct fnum *n, union fnum_val x)
+{
+        struct   chunk *c;
+
+        if ((c = tail_room(n)) == NULL)
+                return -1;
+
+        /* all members of the union start at its very beginning */
+        memcpy(slot(n, c, c->len++), &x, n->size);
+        n->len++;
+
+        return 0;
+}
+
+int
+fnum_append_array(struct fnum *n, const void *arr, size_t cnt)
+{
+        struct   chunk *c;
+        const    char *src;
+        size_t   k;
+
+        for (src = arr; cnt > 0; cnt -= k, src += k * n->size) {
+                if ((c = tail_room(n)) == NULL)
+                        return -1;
+
+                k = n->cap - c->len < cnt ? n->cap - c->len : cnt;
+
+                memcpy(slot(n, c, c->len), src, k * n->size);
+                c->len += k;
+                n->len += k;
+        }
+
+        return 0;
+}
+
+size_t
+fnum_to_array(struct fnum *n, void *out)
+{
+        struct   chunk *c;
+        char    *dst;
+
+        for (dst = out, c = n->head; c != NULL; c = c->next) {
+                memcpy(dst, c->data, c->len * n->size);
+                dst += c->len * n->size;
+        }
+
+        return n->len;
+}
+
+size_t
+fnum_length(struct fnum *n)
+{
+        return n == NULL ? 0 : n->len;
+}
+
+enum fnum_type
+fnum_type(struct fnum *n)
+{
+        return n->type;
+}
+
+union fnum_val
+fnum_at(struct fnum *n, size_t i)
+{
+        union    fnum_val ret;
+        struct   chunk *c;
+
+        ret.i64 = 0;
+
+        for (c = n->head; c != NULL && i >= c->len; c = c->next)
+                i -= c->len;
+
+        if (c != NULL)
+                memcpy(&ret, slot(n, c, i), n->size);
+
+        return ret;
+}
+
+union fnum_val
+fnum_sum(struct fnum *n)
+{
+        union    fnum_val ret;
+        struct   chunk *c;
+
+        if (n->type == FNUM_I32 || n->type == FNUM_I64)
+                ret.i64 = 0;
+        else
+                ret.f64 = 0.0;
+
+        for (c = n->head; c != NULL; c = c->next)
+                k_sum(n->type, c->data, c->len, &ret);
+
+        return ret;
+}
+
+union fnum_val
+fnum_min(struct fnum *n)
+{
+        union    fnum_val ret;
+        struct   chunk *c;
+
+        ret.i64 = 0;
+        if (n->head == NULL)
+                return ret;
+
+        memcpy(&ret, n->head->data, n->size);
+        for (c = n->head; c != NULL; c = c->next)
+                k_minmax(n->type, c->data, c->len, 0, &ret);
+
+        return ret;
+}
+
+union fnum_val
+fnum_max(struct fnum *n)
+{
+        union    fnum_val ret;
+        struct   chunk *c;
+
+        ret.i64 = 0;
+        if (n->head == NULL)
+                return ret;
+
+        memcpy(&ret, n->head->data, n->size);
+        for (c = n->head; c != NULL; c = c->next)
+                k_minmax(n->type, c->data, c->len, 1, &ret);
+
+        return ret;
+}
+
+size_t
+fnum_count(struct fnum *n, enum fnum_cmp op, union fnum_val v)
+{
+        struct   chunk *c;
+        size_t   ret;
+
+        for (ret = 0, c = n->head; c != NULL; c = c->next)
+                ret += k_count(n->type, c->data, c->len, op, v);
+
+        return ret;
+}
+
+int
+fnum_elem(struct fnum *n, union fnum_val v)
+{
+        struct   chunk *c;
+
+        /* chunk granularity is enough to stop early */
+        for (c = n->head; c != NULL; c = c->next) {
+                if (k_count(n->type, c->data, c->len, FNUM_EQ, v) != 0)
+                        return 1;
+        }
+
+        return 0;
+}
+
+void
+fnum_filter(struct fnum *n, enum fnum_cmp op, union fnum_val v)
+{
+        struct   chunk *c, *w, *prev, *tmp;
+        size_t   k;
+
+        for (n->len = 0, c = n->head; c != NULL; c = c->next) {
+                c->len  = k_filter(n->type, c->data, c->len, op, v);
+                n->len += c->len;
+        }
+
+        /* pack values of sparse chunks towards the head */
+        for (w = n->head, c = w != NULL ? w->next : NULL; c != NULL;
+            c = c->next) {
+                while (c->len > 0 && w != c) {
+                        if (w->len == n->cap) {
+                                w = w->next;
+                                continue;
+                        }
+
+                        k = n->cap - w->len < c->len ? n->cap - w->len
+                            : c->len;
+
+                        memcpy(slot(n, w, w->len), c->data, k * n->size);
+                        memmove(c->data, slot(n, c, k), (c->len - k)
+                            * n->size);
+                        w->len += k;
+                        c->len -= k;
+                }
+        }
+
+        /* and get rid of the empty ones */
+        for (prev = NULL, c = n->head; c != NULL; c = tmp) {
+                tmp = c->next;
+
+                if (c->len > 0) {
+                        prev = c;
+                        continue;
+                }
+
+                if (prev == NULL)
+                        n->head = tmp;
+                else
+                        prev->next = tmp;
+
+                free(c->data);
+                free(c);
+        }
+
+        n->tail = prev;
+}
+
+void
+fnum_add(struct fnum *n, union fnum_val v)
+{
+        map(n, v, v, 0, 1);
+}
+
+void
+fnum_mul(struct fnum *n, union fnum_val v)
+{
+        map(n, v, v, 1, 0);
+}
+
+void
+fnum_affine(struct fnum *n, union fnum_val a, union fnum_val b)
+{
+        map(n, a, b, 1, 1);
+}
+
+struct fnum *
+fnum_from_flist(struct flist *l, enum fnum_type type)
+{
+        struct   fnum *ret;
+        void   **arr;
+        size_t   i, len;
+
+        if ((ret = fnum_new(type)) == NULL
+            || (len = flist_length(l)) == 0)
+                return ret;
+
+        if ((arr = malloc(len * sizeof(void *))) == NULL) {
+                fnum_free(&ret);
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        flist_to_array(l, arr);
+        for (i = 0; ret != NULL && i < len; ++i) {
+                if (fnum_append_array(ret, arr[i], 1) != 0)
+                        fnum_free(&ret);
+        }
+
+        free(arr);
+
+        return ret;
+}
+
+struct flist *
+fnum_to_flist(struct fnum *n)
+{
+        struct   flist *ret;
+        struct   chunk *c;
+        void   **arr;
+        size_t   i, j;
+
+        if (n->len == 0)
+                return NULL;
+
+        if ((arr = malloc(n->len * sizeof(void *))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        ret = NULL;
+        for (i = 0, c = n->head; c != NULL; c = c->next) {
+                for (j = 0; j < c->len; ++j, ++i) {
+                        if ((arr[i] = malloc(n->size)) == NULL)
+                                goto out;
+
+                        memcpy(arr[i], slot(n, c, j), n->size);
+                }
+        }
+
+        ret = flist_from_array(NULL, arr, n->len, FLIST_CLEANABLE);
+
+out:
+        /* copies are only owned by the list once it exists */
+        while (ret == NULL && i-- > 0)
+                free(arr[i]);
+
+        free(arr);
+        if (ret == NULL)
+                errno = ENOMEM;
+
+        return ret;
+}
+
+void *
+slot(struct fnum *n, struct chunk *c, size_t i)
+{
+        return (char *)c->data + i * n->size;
+}
+
+struct chunk *
+tail_room(struct fnum *n)
+{
+        struct   chunk *c;
+        int      err;
+
+        if (n->tail != NULL && n->tail->len < n->cap)
+                return n->tail;
+
+        if ((c = malloc(sizeof(struct chunk))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        if ((err = posix_memalign(&c->data, ALIGNMENT, FNUM_CHUNK_BYTES))
+            != 0) {
+                free(c);
+                errno = err;
+                return NULL;
+        }
+
+        c->next = NULL;
+        c->len  = 0;
+
+        if (n->tail == NULL)
+                n->head = n->tail = c;
+        else
+                n->tail = n->tail->next = c;
+
+        return c;
+}
+
+void
+k_sum(enum fnum_type t, const void *p, size_t cnt, union fnum_val *acc)
+{
+        size_t   i;
+
+        i = 0;
+
+#ifdef __AVX2__
+        {
+                __m256i  si;
+                __m256d  sd;
+                int64_t  li[4];
+                double   ld[4];
+
+                si = _mm256_setzero_si256();
+                sd = _mm256_setzero_pd();
+
+                switch (t) {
+                case FNUM_I32:
+                        for (; i + 8 <= cnt; i += 8) {
+                                __m256i v = _mm256_loadu_si256(
+                                    (const __m256i *)((const int32_t *)p + i));
+                                si = _mm256_add_epi64(si, _mm256_cvtepi32_epi64(
+                                    _mm256_castsi256_si128(v)));
+                                si = _mm256_add_epi64(si, _mm256_cvtepi32_epi64(
+                                    _mm256_extracti128_si256(v, 1)));
+                        }
+                        break;
+                case FNUM_I64:
+                        for (; i + 4 <= cnt; i += 4) {
+                                si = _mm256_add_epi64(si, _mm256_loadu_si256(
+                                    (const __m256i *)((const int64_t *)p + i)));
+                        }
+                        break;
+                case FNUM_F32:
+                        for (; i + 4 <= cnt; i += 4) {
+                                sd = _mm256_add_pd(sd, _mm256_cvtps_pd(
+                                    _mm_loadu_ps((const float *)p + i)));
+                        }
+                        break;
+                case FNUM_F64:
+                        for (; i + 4 <= cnt; i += 4) {
+                                sd = _mm256_add_pd(sd, _mm256_loadu_pd(
+                                    (const double *)p + i));
+                        }
+                        break;
+                }
+
+                _mm256_storeu_si256((__m256i *)li, si);
+                _mm256_storeu_pd(ld, sd);
+
+                if (t == FNUM_I32 || t == FNUM_I64) {
+                        acc->i64 = (int64_t)((uint64_t)acc->i64
+                            + (uint64_t)li[0] + (uint64_t)li[1]
+                            + (uint64_t)li[2] + (uint64_t)li[3]);
+                } else
+                        acc->f64 += ld[0] + ld[1] + ld[2] + ld[3];
+        }
+#endif
+
+        /* integers are summed as unsigned, see k_affine() */
+#define SUM_LOOP(T, F) do {                                         \
+        const T *a = p;                                             \
+        uint64_t s;                                                 \
+        if (t == FNUM_I32 || t == FNUM_I64) {                       \
+                for (s = (uint64_t)acc->i64; i < cnt; ++i)          \
+                        s += (uint64_t)a[i];                        \
+                acc->i64 = (int64_t)s;                              \
+        } else {                                                    \
+                for (; i < cnt; ++i)                                \
+                        acc->f64 += a[i];                           \
+        }                                                           \
+} while (0)
+
+        TYPE_SWITCH(t, SUM_LOOP);
+
+#undef SUM_LOOP
+}
+
+void
+k_minmax(enum fnum_type t, const void *p, size_t cnt, int max,
+    union fnum_val *acc)
+{
+        size_t   i;
+
+        i = 0;
+
+#ifdef __AVX2__
+        {
+                __m256i  mi;
+                __m256   mf;
+                __m256d  md;
+                int32_t  li[8];
+                int64_t  ll[4];
+                float    lf[8];
+                double   ld[4];
+                int      j;
+
+#define AVX_MINMAX(W, SET, LOAD, MIN, MAX, STORE, M, L, F, T, CNT) do { \
+        M = SET(acc->F);                                            \
+        for (; i + (CNT) <= cnt; i += (CNT)) {                      \
+                W v = LOAD((const T *)p + i);                       \
+                M = max ? MAX(M, v) : MIN(M, v);                    \
+        }                                                           \
+        STORE(L, M);                                                \
+        for (j = 0; j < (CNT); ++j) {                               \
+                if (max ? L[j] > acc->F : L[j] < acc->F)            \
+                        acc->F = L[j];                              \
+        }                                                           \
+} while (0)
+
+#define LOAD_SI(X)      _mm256_loadu_si256((const __m256i *)(X))
+#define STORE_SI(X, Y)  _mm256_storeu_si256((__m256i *)(X), (Y))
+#define MIN_I64(X, Y)   _mm256_blendv_epi8((X), (Y), _mm256_cmpgt_epi64((X), (Y)))
+#define MAX_I64(X, Y)   _mm256_blendv_epi8((Y), (X), _mm256_cmpgt_epi64((X), (Y)))
+
+                switch (t) {
+                case FNUM_I32:
+                        AVX_MINMAX(__m256i, _mm256_set1_epi32, LOAD_SI,
+                            _mm256_min_epi32, _mm256_max_epi32, STORE_SI, mi,
+                            li, i32, int32_t, 8);
+                        break;
+                case FNUM_I64:
+                        AVX_MINMAX(__m256i, _mm256_set1_epi64x, LOAD_SI,
+                            MIN_I64, MAX_I64, STORE_SI, mi, ll, i64, int64_t,
+                            4);
+                        break;
+                case FNUM_F32:
+                        AVX_MINMAX(__m256, _mm256_set1_ps, _mm256_loadu_ps,
+                            _mm256_min_ps, _mm256_max_ps, _mm256_storeu_ps, mf,
+                            lf, f32, float, 8);
+                        break;
+                case FNUM_F64:
+                        AVX_MINMAX(__m256d, _mm256_set1_pd, _mm256_loadu_pd,
+                            _mm256_min_pd, _mm256_max_pd, _mm256_storeu_pd, md,
+                            ld, f64, double, 4);
+                        break;
+                }
+
+#undef MAX_I64
+#undef MIN_I64
+#undef STORE_SI
+#undef LOAD_SI
+#undef AVX_MINMAX
+        }
+#endif
+
+#define MINMAX_LOOP(T, F) do {                                      \
+        const T *a = p;                                             \
+        for (; i < cnt; ++i) {                                      \
+                if (max ? a[i] > acc->F : a[i] < acc->F)            \
+                        acc->F = a[i];                              \
+        }                                                           \
+} while (0)
+
+        TYPE_SWITCH(t, MINMAX_LOOP);
+
+#undef MINMAX_LOOP
+}
+
+size_t
+k_count(enum fnum_type t, const void *p, size_t cnt, enum fnum_cmp op,
+    union fnum_val v)
+{
+        size_t   i, ret;
+
+        i = ret = 0;
+
+#ifdef __AVX2__
+        /*
+         * Integers only have "equal" and "greater than" comparisons, remaining
+         * ones are derived by swapping operands or negating the lane mask.
+         */
+#define AVX_ICOUNT(SET, EQ, GT, MASK, T, F, CNT) do {               \
+        __m256i  x, y;                                              \
+        unsigned m;                                                 \
+        y = SET(v.F);                                               \
+        for (; i + (CNT) <= cnt; i += (CNT)) {                      \
+                x = _mm256_loadu_si256((const __m256i *)            \
+                    ((const T *)p + i));                            \
+                switch (op) {                                       \
+                case FNUM_LT: m =  MASK(GT(y, x)); break;           \
+                case FNUM_LE: m = ~MASK(GT(x, y)); break;           \
+                case FNUM_EQ: m =  MASK(EQ(x, y)); break;           \
+                case FNUM_NE: m = ~MASK(EQ(x, y)); break;           \
+                case FNUM_GE: m = ~MASK(GT(y, x)); break;           \
+                default:      m =  MASK(GT(x, y)); break;           \
+                }                                                   \
+                ret += popcnt(m & ((1U << (CNT)) - 1));             \
+        }                                                           \
+} while (0)
+
+        /* unordered "not equal" keeps NaN semantics of the scalar loop */
+#define AVX_FCOUNT(W, LOAD, SET, CMP, MASK, T, F, CNT) do {         \
+        W        x, y;                                              \
+        unsigned m;                                                 \
+        y = SET(v.F);                                               \
+        for (; i + (CNT) <= cnt; i += (CNT)) {                      \
+                x = LOAD((const T *)p + i);                         \
+                switch (op) {                                       \
+                case FNUM_LT: m = MASK(CMP(x, y, _CMP_LT_OQ));  break;  \
+                case FNUM_LE: m = MASK(CMP(x, y, _CMP_LE_OQ));  break;  \
+                case FNUM_EQ: m = MASK(CMP(x, y, _CMP_EQ_OQ));  break;  \
+                case FNUM_NE: m = MASK(CMP(x, y, _CMP_NEQ_UQ)); break;  \
+                case FNUM_GE: m = MASK(CMP(x, y, _CMP_GE_OQ));  break;  \
+                default:      m = MASK(CMP(x, y, _CMP_GT_OQ));  break;  \
+                }                                                   \
+                ret += popcnt(m);                                   \
+        }                                                           \
+} while (0)
+
+#define MASK_PS(X)      (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(X))
+#define MASK_PD(X)      (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(X))
+
+        switch (t) {
+        case FNUM_I32:
+                AVX_ICOUNT(_mm256_set1_epi32, _mm256_cmpeq_epi32,
+                    _mm256_cmpgt_epi32, MASK_PS, int32_t, i32, 8);
+                break;
+        case FNUM_I64:
+                AVX_ICOUNT(_mm256_set1_epi64x, _mm256_cmpeq_epi64,
+                    _mm256_cmpgt_epi64, MASK_PD, int64_t, i64, 4);
+                break;
+        case FNUM_F32:
+                AVX_FCOUNT(__m256, _mm256_loadu_ps, _mm256_set1_ps,
+                    _mm256_cmp_ps, (unsigned)_mm256_movemask_ps, float, f32,
+                    8);
+                break;
+        case FNUM_F64:
+                AVX_FCOUNT(__m256d, _mm256_loadu_pd, _mm256_set1_pd,
+                    _mm256_cmp_pd, (unsigned)_mm256_movemask_pd, double, f64,
+                    4);
+                break;
+        }
+
+#undef MASK_PD
+#undef MASK_PS
+#undef AVX_FCOUNT
+#undef AVX_ICOUNT
+#endif
+
+#define COUNT_OP(OP)    for (; i < cnt; ++i) ret += a[i] OP x
+#define COUNT_LOOP(T, F) do {                                       \
+        const T *a = p;                                             \
+        T        x = v.F;                                           \
+        CMP_SWITCH(op, COUNT_OP);                                   \
+} while (0)
+
+        TYPE_SWITCH(t, COUNT_LOOP);
+
+#undef COUNT_LOOP
+#undef COUNT_OP
+
+        return ret;
+}
+
+size_t
+k_filter(enum fnum_type t, void *p, size_t cnt, enum fnum_cmp op,
+    union fnum_val v)
+{
+        size_t   i, ret;
+
+        ret = 0;
+
+        /* branch-free compaction, rejected values get overwritten later */
+#define FILTER_OP(OP) for (i = 0; i < cnt; ++i) {                   \
+        a[ret] = a[i];                                              \
+        ret   += a[i] OP x;                                         \
+}
+#define FILTER_LOOP(T, F) do {                                      \
+        T       *a = p;                                             \
+        T        x = v.F;                                           \
+        CMP_SWITCH(op, FILTER_OP);                                  \
+} while (0)
+
+        TYPE_SWITCH(t, FILTER_LOOP);
+
+#undef FILTER_LOOP
+#undef FILTER_OP
+
+        return ret;
+}
+
+void
+k_affine(enum fnum_type t, void *p, size_t cnt, union fnum_val a,
+    union fnum_val b, int mul, int add)
+{
+        size_t   i;
+
+        i = 0;
+
+#ifdef __AVX2__
+#define AVX_AFFINE(W, LOAD, STORE, SET, MUL, ADD, T, F, CNT) do {   \
+        W        x, va, vb;                                         \
+        va = SET(a.F);                                              \
+        vb = SET(b.F);                                              \
+        for (; i + (CNT) <= cnt; i += (CNT)) {                      \
+                x = LOAD((T *)p + i);                               \
+                if (mul)                                            \
+                        x = MUL(x, va);                             \
+                if (add)                                            \
+                        x = ADD(x, vb);                             \
+                STORE((T *)p + i, x);                               \
+        }                                                           \
+} while (0)
+
+#define LOAD_SI(X)      _mm256_loadu_si256((const __m256i *)(X))
+#define STORE_SI(X, Y)  _mm256_storeu_si256((__m256i *)(X), (Y))
+
+        switch (t) {
+        case FNUM_I32:
+                AVX_AFFINE(__m256i, LOAD_SI, STORE_SI, _mm256_set1_epi32,
+                    _mm256_mullo_epi32, _mm256_add_epi32, int32_t, i32, 8);
+                break;
+        case FNUM_I64:
+                /* there is no 64-bit multiplication in AVX2 */
+                if (!mul) {
+                        AVX_AFFINE(__m256i, LOAD_SI, STORE_SI,
+                            _mm256_set1_epi64x, _mm256_add_epi64,
+                            _mm256_add_epi64, int64_t, i64, 4);
+                }
+                break;
+        case FNUM_F32:
+                AVX_AFFINE(__m256, _mm256_loadu_ps, _mm256_storeu_ps,
+                    _mm256_set1_ps, _mm256_mul_ps, _mm256_add_ps, float, f32,
+                    8);
+                break;
+        case FNUM_F64:
+                AVX_AFFINE(__m256d, _mm256_loadu_pd, _mm256_storeu_pd,
+                    _mm256_set1_pd, _mm256_mul_pd, _mm256_add_pd, double, f64,
+                    4);
+                break;
+        }
+
+#undef STORE_SI
+#undef LOAD_SI
+#undef AVX_AFFINE
+#endif
+
+        /*
+         * Integers are computed on their unsigned counterparts so that
+         * overflow wraps around instead of being undefined.
+         */
+#define AFFINE_LOOP(T, U, F) do {                                   \
+        T       *x = p;                                             \
+        U        ua = (U)a.F, ub = (U)b.F;                          \
+        if (!add) {                                                 \
+                for (; i < cnt; ++i)                                \
+                        x[i] = (T)((U)x[i] * ua);                   \
+        } else if (!mul) {                                          \
+                for (; i < cnt; ++i)                                \
+                        x[i] = (T)((U)x[i] + ub);                   \
+        } else {                                                    \
+                for (; i < cnt; ++i)                                \
+                        x[i] = (T)((U)x[i] * ua + ub);              \
+        }                                                           \
+} while (0)
+
+        switch (t) {
+        case FNUM_I32:
+                AFFINE_LOOP(int32_t, uint32_t, i32);
+                break;
+        case FNUM_I64:
+                AFFINE_LOOP(int64_t, uint64_t, i64);
+                break;
+        case FNUM_F32:
+                AFFINE_LOOP(float, float, f32);
+                break;
+        case FNUM_F64:
+                AFFINE_LOOP(double, double, f64);
+                break;
+        }
+
+#undef AFFINE_LOOP
+}
+
+void
+map(struct fnum *n, union fnum_val a, union fnum_val b, int mul, int add)
+{
+        struct   chunk *c;
+
+        for (c = n->head; c != NULL; c = c->next)
+                k_affine(n->type, c->data, c->len, a, b, mul, add);
+}
+
+#ifdef __AVX2__
+int
+popcnt(unsigned x)
+{
+        int      ret;
+
+        for (ret = 0; x != 0; x &= x - 1)
+                ++ret;
+
+        return ret;
+}
+#endif
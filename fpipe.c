@@ -0,0 +1,411 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for @p fpipe module
+ */
+
+#include <errno.h>
+
+#include "include/fpipe.h"
+#include "flist_impl.h"
+
+/**
+ * @brief Kind of a pipeline stage
+ */
+enum stage_type {
+        STAGE_MAP,                      /**< @brief See fpipe_map() */
+        STAGE_FILTER,                   /**< @brief See fpipe_filter() */
+        STAGE_TAKE,                     /**< @brief See fpipe_take() */
+        STAGE_DROP                      /**< @brief See fpipe_drop() */
+};
+
+/**
+ * @brief Single stage of a pipeline
+ */
+struct stage {
+        enum         stage_type type;   /**< @brief Kind of the stage */
+        void      *(*f)(void *);        /**< @brief Function of a map stage */
+        int        (*p)(void *);        /**< @brief Predicate of a filter */
+        int          n;                 /**< @brief Count of a take or drop */
+};
+
+/**
+ * @brief A pipeline
+ */
+struct fpipe {
+        struct       flist *src;        /**< @brief Source list */
+        const struct falloc *alloc;     /**< @brief Allocator of the pipeline */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler */
+        struct       stage *stages;     /**< @brief Recorded stages */
+        size_t       len;               /**< @brief Number of stages */
+        size_t       cap;               /**< @brief Capacity of `stages` */
+        int          lost;              /**< @brief Was a stage not added? */
+};
+
+/**
+ * @brief State of a fold performed by fpipe_foldl()
+ */
+struct fold_state {
+        void        *acc;               /**< @brief Current accumulator */
+        void      *(*f)(void *, void *); /**< @brief Folding function */
+        int          first;             /**< @brief Nothing folded yet? */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler */
+};
+
+/**
+ * @fn struct stage *add_stage(struct fpipe *p, enum stage_type type)
+ * @brief Appends a new stage of type @p type to @p p and returns it
+ *
+ * Only the type of the new stage is set, the rest is zeroed. If allocation
+ * fails, NULL is returned and @p p is marked as having lost a stage, which
+ * makes it fail whenever run.
+ *
+ * @param[in] p Target pipeline, may be NULL
+ * @param[in] type Type of the stage
+ */
+static struct stage *add_stage(struct fpipe *, enum stage_type);
+
+/**
+ * @fn int run(struct fpipe *p, int (*sink)(void *, void *, unsigned), void
+ *  *ctx)
+ * @brief Pushes elements of the source list through the pipeline
+ *
+ * Every element that makes it through all of the stages is passed to @p sink
+ * along with @p ctx and inflags describing its ownership. Ownership of the
+ * value is passed to @p sink as well, unless it fails by returning nonzero.
+ * Returns 0 on success. If memory runs out, either here, in @p sink or while
+ * forcing the source list, stops and returns -1 with errno set to ENOMEM.
+ *
+ * @param[in] p Pipeline to run
+ * @param[in] sink Consumer of the output
+ * @param[in] ctx Context passed to @p sink
+ */
+static int       run(struct fpipe *, int (*)(void *, void *, unsigned),
+    void *);
+
+/**
+ * @fn int collect_sink(void *lp, void *val, unsigned flags)
+ * @brief Sink appending values to the list pointed to by @p lp
+ */
+static int       collect_sink(void *, void *, unsigned);
+
+/**
+ * @fn int fold_sink(void *st, void *val, unsigned flags)
+ * @brief Sink folding values into @a fold_state pointed to by @p st
+ */
+static int       fold_sink(void *, void *, unsigned);
+
+struct fpipe *
+fpipe_new(struct flist *src)
+{
+        const struct falloc *a;
+        struct   fpipe *ret;
+
+        a = src != NULL ? src->alloc : falloc_get_default();
+        if ((ret = a->alloc(a->ctx, sizeof(struct fpipe))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        memset(ret, 0x00, sizeof(struct fpipe));
+
+        ret->src     = src;
+        ret->alloc   = a;
+        ret->cl_hand = src != NULL ? src->cl_hand : free;
+
+        return ret;
+}
+
+void
+fpipe_free(struct fpipe **pp)
+{
+        const struct falloc *a;
+
+        if (*pp == NULL)
+                return;
+
+        a = (*pp)->alloc;
+        if ((*pp)->stages != NULL) {
+                a->free(a->ctx, (*pp)->stages,
+                    (*pp)->cap * sizeof(struct stage));
+        }
+        a->free(a->ctx, *pp, sizeof(struct fpipe));
+        *pp = NULL;
+}
+
+void
+fpipe_set_cleanup(struct fpipe *p, void (*handler)(void *))
+{
+        if (p == NULL || handler == NULL)
+                return;
+
+        p->cl_hand = handler;
+}
+
+struct fpipe *
+fpipe_map(struct fpipe *p, void *(*f)(void *))
+{
+        struct   stage *st;
+
+        if ((st = add_stage(p, STAGE_MAP)) != NULL)
+                st->f = f;
+
+        return p;
+}
+
+struct fpipe *
+fpipe_filter(struct fpipe *p, int (*f)(void *))
+{
+        struct   stage *st;
+
+        if ((st = add_stage(p, STAGE_FILTER)) != NULL)
+                st->p = f;
+
+        return p;
+}
+
+struct fpipe *
+fpipe_take(struct fpipe *p, int n)
+{
+        struct   stage *st;
+
+        if ((st = add_stage(p, STAGE_TAKE)) != NULL)
+                st->n = n;
+
+        return p;
+}
+
+struct fpipe *
+fpipe_drop(struct fpipe *p, int n)
+{
+        struct   stage *st;
+
+        if ((st = add_stage(p, STAGE_DROP)) != NULL)
+                st->n = n;
+
+        return p;
+}
+
+struct flist *
+fpipe_collect(struct fpipe *p)
+{
+        struct   flist *ret;
+
+        ret = NULL;
+        if (run(p, collect_sink, &ret) != 0) {
+                flist_free(&ret, 0);
+                return NULL;
+        }
+
+        flist_set_cleanup(ret, p->cl_hand);
+
+        return ret;
+}
+
+void *
+fpipe_foldl(struct fpipe *p, void *x, void *(*f)(void *, void *))
+{
+        struct   fold_state st;
+
+        st.acc     = x;
+        st.f       = f;
+        st.first   = 1;
+        st.cl_hand = p != NULL ? p->cl_hand : free;
+
+        if (run(p, fold_sink, &st) == 0)
+                return st.acc;
+
+        /* partial results are of no use to anyone */
+        if (!st.first)
+                st.cl_hand(st.acc);
+
+        return NULL;
+}
+
+struct stage *
+add_stage(struct fpipe *p, enum stage_type type)
+{
+        const struct falloc *a;
+        struct   stage *tmp;
+        size_t   cap;
+
+        if (p == NULL)
+                return NULL;
+
+        a = p->alloc;
+        if (p->len == p->cap) {
+                cap = p->cap == 0 ? 4 : 2 * p->cap;
+                if ((tmp = a->alloc(a->ctx, cap * sizeof(struct stage)))
+                    == NULL) {
+                        p->lost = 1;
+                        return NULL;
+                }
+
+                if (p->stages != NULL) {
+                        memcpy(tmp, p->stages, p->len * sizeof(struct stage));
+                        a->free(a->ctx, p->stages,
+                            p->cap * sizeof(struct stage));
+                }
+
+                p->cap    = cap;
+                p->stages = tmp;
+        }
+
+        memset(&p->stages[p->len], 0x00, sizeof(struct stage));
+        p->stages[p->len].type = type;
+
+        return &p->stages[p->len++];
+}
+
+int
+run(struct fpipe *p, int (*sink)(void *, void *, unsigned), void *ctx)
+{
+        struct   flist_iter *cur;
+        struct   stage *st;
+        void    *val, *tmp;
+        int     *cnt, owned, pass, last;
+        size_t   k;
+
+        if (p == NULL || p->lost) {
+                errno = ENOMEM;
+                return -1;
+        }
+
+        if (p->src == NULL)
+                return 0;
+
+        if ((cnt = p->alloc->alloc(p->alloc->ctx,
+            (p->len + 1) * sizeof(int))) == NULL) {
+                errno = ENOMEM;
+                return -1;
+        }
+        memset(cnt, 0x00, (p->len + 1) * sizeof(int));
+
+        /* take stage that lets nothing through makes the whole run a no-op */
+        for (last = 0, k = 0; k < p->len; ++k) {
+                if (p->stages[k].type == STAGE_TAKE && p->stages[k].n <= 0)
+                        last = 1;
+        }
+
+        /* check for exhaustion before forcing another lazy element */
+        for (cur = last ? NULL : FLIST_FIRST(p->src); cur != NULL;
+            cur = last ? NULL : FLIST_NEXT(p->src, cur)) {
+                val   = cur->data;
+                owned = 0;
+                pass  = 1;
+
+                for (k = 0; k < p->len && pass; ++k) {
+                        st = &p->stages[k];
+
+                        switch (st->type) {
+                        case STAGE_MAP:
+                                tmp = st->f(val);
+                                if (tmp != NULL && tmp != val) {
+                                        if (owned)
+                                                p->cl_hand(val);
+
+                                        val   = tmp;
+                                        owned = 1;
+                                }
+                                break;
+                        case STAGE_FILTER:
+                                pass = st->p(val) != 0;
+                                break;
+                        case STAGE_TAKE:
+                                /* the stage is exhausted after this one */
+                                if (++cnt[k] >= st->n)
+                                        last = 1;
+                                break;
+                        case STAGE_DROP:
+                                if (cnt[k] < st->n) {
+                                        cnt[k]++;
+                                        pass = 0;
+                                }
+                                break;
+                        }
+                }
+
+                if (!pass) {
+                        if (owned)
+                                p->cl_hand(val);
+                        continue;
+                }
+
+                /* sink that fails leaves the value with the pipeline */
+                if (sink(ctx, val, owned ? FLIST_CLEANABLE
+                    : NODE_BITS(cur) & NODE_CALL
+                    ? FLIST_CLEANABLE | FLIST_CLEANPROT
+                    : FLIST_DONTCLEAN) != 0) {
+                        if (owned)
+                                p->cl_hand(val);
+                        break;
+                }
+        }
+
+        p->alloc->free(p->alloc->ctx, cnt, (p->len + 1) * sizeof(int));
+
+        /* generators are gone once exhausted */
+        if (cur != NULL || (!last && p->src->gen != NULL)) {
+                errno = ENOMEM;
+                return -1;
+        }
+
+        return 0;
+}
+
+int
+collect_sink(void *lp, void *val, unsigned flags)
+{
+        struct   flist *l;
+
+        if ((l = flist_append(*(struct flist **)lp, val, flags)) == NULL)
+                return -1;
+
+        *(struct flist **)lp = l;
+
+        return 0;
+}
+
+int
+fold_sink(void *arg, void *val, unsigned flags)
+{
+        struct   fold_state *st;
+        void    *tmp;
+
+        st  = arg;
+        tmp = st->acc;
+        st->acc = st->f(tmp, val);
+
+        /* initial value is not ours to free, see flist_foldl() */
+        if (!st->first)
+                st->cl_hand(tmp);
+        st->first = 0;
+
+        if (flags == FLIST_CLEANABLE)
+                st->cl_hand(val);
+
+        return 0;
+}
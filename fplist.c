@@ -0,0 +1,586 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for @p fplist module
+ */
+
+#include "include/fplist.h"
+
+#include <errno.h>
+
+/**
+ * @brief Node of `fplist`
+ *
+ * Nodes form singly linked chains shared by any number of versions. `refs`
+ * counts handles and nodes pointing at the node. A node either owns its
+ * element, in which case `owner` is NULL and flags have the same meaning as in
+ * `flist_iter`, or it borrows it from `owner`. Owners count their borrowers in
+ * `borrows` and, once no longer reachable, outlive their chain position until
+ * the last borrower is gone, so that borrowing an element does not keep the
+ * whole remainder of the chain alive.
+ */
+struct fplist_node {
+        struct       fplist_node *next; /**< @brief Next node */
+        struct       fplist_node *owner; /**< @brief Owner of `data`, or NULL */
+        void        *data;              /**< @brief Pointer to the data */
+        size_t       refs;              /**< @brief Reference count */
+        size_t       borrows;           /**< @brief Number of borrowers */
+
+        unsigned     call_h : 1;        /**< @brief Call cleanup handler? */
+        unsigned     prot_h : 1;        /**< @brief Call cleanup iff forced? */
+};
+
+/**
+ * @brief A version of a persistent list
+ *
+ * Version consists of first `len` nodes of the chain starting at `head`, the
+ * chain itself may be longer.
+ *
+ * @see fplist_node
+ */
+struct fplist {
+        struct       fplist_node *head; /**< @brief Head of the list */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler */
+        size_t       len;               /**< @brief Length of the list */
+};
+
+/**
+ * @brief Transient builder of `fplist`
+ */
+struct fplist_builder {
+        struct       fplist_node *head; /**< @brief First node */
+        struct       fplist_node *tail; /**< @brief Last node */
+        size_t       len;               /**< @brief Number of nodes */
+};
+
+/**
+ * @fn struct fplist *new_list(struct fplist_node *head, size_t len, void
+ *  (*cl_hand)(void *))
+ * @brief Creates new version made of @p len nodes starting at @p head
+ *
+ * Takes over one reference to @p head held by the caller. Returns NULL if
+ * @p len is zero, in which case that reference is dropped. If allocation
+ * fails, NULL is returned, errno is set to ENOMEM and the reference stays with
+ * the caller.
+ *
+ * @param[in] head First node
+ * @param[in] len Number of nodes
+ * @param[in] cl_hand Cleanup handler
+ */
+static struct fplist        *new_list(struct fplist_node *, size_t,
+    void (*)(void *));
+
+/**
+ * @fn struct fplist_node *new_node(void *dat, struct fplist_node *next,
+ *  unsigned flags)
+ * @brief Creates new node referenced once, taking over a reference to @p next
+ *
+ * Returns NULL and sets errno to ENOMEM if allocation fails, in which case the
+ * reference to @p next stays with the caller.
+ *
+ * @param[in] dat Data to store in the node
+ * @param[in] next Next node
+ * @param[in] flags Flags as defined in @a flist_append()
+ */
+static struct fplist_node   *new_node(void *, struct fplist_node *,
+    unsigned);
+
+/**
+ * @fn struct fplist_node *borrow(struct fplist_node *src)
+ * @brief Creates new, unlinked node sharing element of @p src
+ *
+ * Returns NULL and sets errno to ENOMEM if allocation fails.
+ */
+static struct fplist_node   *borrow(struct fplist_node *);
+
+/**
+ * @fn void release(struct fplist_node *n, void (*cl_hand)(void *), int force)
+ * @brief Drops a reference to @p n, releasing whatever is no longer used
+ *
+ * Works iteratively, so that releasing long chains does not exhaust the stack.
+ * Elements are cleaned up when the nodes owning them are freed.
+ *
+ * @param[in] n Target node, may be NULL
+ * @param[in] cl_hand Cleanup handler to use
+ * @param[in] force Same as in @a flist_free()
+ */
+static void                  release(struct fplist_node *, void (*)(void *),
+    int);
+
+/**
+ * @fn unsigned flags_of(struct fplist_node *n)
+ * @brief Returns inflags a shallow copy of element of @p n should be given
+ * @see flist_copy()
+ */
+static unsigned              flags_of(struct fplist_node *);
+
+struct fplist *
+fplist_prepend(struct fplist *l, void *dat, unsigned flags)
+{
+        struct   fplist_node *n;
+        struct   fplist *ret;
+
+        if ((n = new_node(dat, NULL, flags)) == NULL)
+                return NULL;
+
+        /* the node is linked once nothing can fail */
+        if ((ret = new_list(n, l == NULL ? 1 : l->len + 1,
+            l == NULL ? free : l->cl_hand)) == NULL) {
+                free(n);
+                return NULL;
+        }
+
+        if (l != NULL) {
+                n->next = l->head;
+                n->next->refs++;
+        }
+
+        return ret;
+}
+
+struct fplist *
+fplist_dup(struct fplist *l)
+{
+        struct   fplist *ret;
+
+        if (l == NULL)
+                return NULL;
+
+        if ((ret = new_list(l->head, l->len, l->cl_hand)) != NULL)
+                l->head->refs++;
+
+        return ret;
+}
+
+void
+fplist_free(struct fplist **lp, int force)
+{
+        if (*lp == NULL)
+                return;
+
+        release((*lp)->head, (*lp)->cl_hand, force);
+
+        free(*lp);
+        *lp = NULL;
+}
+
+void
+fplist_set_cleanup(struct fplist *l, void (*handler)(void *))
+{
+        if (l == NULL || handler == NULL)
+                return;
+
+        l->cl_hand = handler;
+}
+
+struct fplist_builder *
+fplist_builder_new(void)
+{
+        struct   fplist_builder *ret;
+
+        if ((ret = malloc(sizeof(struct fplist_builder))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        memset(ret, 0x00, sizeof(struct fplist_builder));
+
+        return ret;
+}
+
+int
+fplist_builder_append(struct fplist_builder *b, void *dat, unsigned flags)
+{
+        struct   fplist_node *to_add;
+
+        /* nodes are not shared yet, so linking them in place is fine */
+        if ((to_add = new_node(dat, NULL, flags)) == NULL)
+                return -1;
+
+        if (b->tail == NULL)
+                b->head = b->tail = to_add;
+        else
+                b->tail = b->tail->next = to_add;
+        b->len++;
+
+        return 0;
+}
+
+struct fplist *
+fplist_builder_finish(struct fplist_builder *b)
+{
+        struct   fplist *ret;
+
+        if ((ret = new_list(b->head, b->len, free)) == NULL && b->len != 0)
+                release(b->head, free, 0);
+        free(b);
+
+        return ret;
+}
+
+struct fplist *
+fplist_from_flist(struct flist *l)
+{
+        struct   fplist_builder *b;
+        void   **arr;
+        size_t   i, len;
+
+        if ((len = flist_length(l)) == 0)
+                return NULL;
+
+        if ((arr = malloc(len * sizeof(void *))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        if ((b = fplist_builder_new()) == NULL) {
+                free(arr);
+                return NULL;
+        }
+
+        /* ownership of elements is not visible here, nothing is owned then */
+        flist_to_array(l, arr);
+        for (i = 0; i < len; ++i) {
+                if (fplist_builder_append(b, arr[i], FLIST_DONTCLEAN) != 0)
+                        break;
+        }
+
+        free(arr);
+
+        if (i < len) {
+                release(b->head, free, 0);
+                free(b);
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        return fplist_builder_finish(b);
+}
+
+struct flist *
+fplist_to_flist(struct fplist *l)
+{
+        struct   fplist_node *cur;
+        struct   flist *ret, *tmp;
+        size_t   i;
+
+        if (l == NULL)
+                return NULL;
+
+        for (ret = NULL, cur = l->head, i = 0; i < l->len; ++i, cur = cur->next) {
+                tmp = flist_append(ret, cur->data, flags_of(cur));
+                if (tmp == NULL) {
+                        flist_free(&ret, 0);
+                        return NULL;
+                }
+                ret = tmp;
+        }
+
+        flist_set_cleanup(ret, l->cl_hand);
+
+        return ret;
+}
+
+void *
+fplist_val_head(struct fplist *l)
+{
+        return l == NULL ? NULL : l->head->data;
+}
+
+void *
+fplist_val_at_i(struct fplist *l, size_t i)
+{
+        struct   fplist_node *cur;
+
+        if (l == NULL || i >= l->len)
+                return NULL;
+
+        for (cur = l->head; i > 0; --i)
+                cur = cur->next;
+
+        return cur->data;
+}
+
+size_t
+fplist_length(struct fplist *l)
+{
+        return l == NULL ? 0 : l->len;
+}
+
+struct fplist *
+fplist_tail(struct fplist *l)
+{
+        return fplist_drop(l, 1);
+}
+
+struct fplist *
+fplist_take(struct fplist *l, size_t n)
+{
+        struct   fplist *ret;
+
+        if (l == NULL || n == 0)
+                return NULL;
+
+        if ((ret = new_list(l->head, n < l->len ? n : l->len, l->cl_hand))
+            != NULL)
+                l->head->refs++;
+
+        return ret;
+}
+
+struct fplist *
+fplist_drop(struct fplist *l, size_t n)
+{
+        struct   fplist_node *cur;
+        struct   fplist *ret;
+        size_t   i;
+
+        if (l == NULL || n >= l->len)
+                return NULL;
+
+        for (cur = l->head, i = 0; i < n; ++i)
+                cur = cur->next;
+
+        if ((ret = new_list(cur, l->len - n, l->cl_hand)) != NULL)
+                cur->refs++;
+
+        return ret;
+}
+
+struct fplist *
+fplist_map(struct fplist *l, void *(*f)(void *))
+{
+        struct   fplist_node *cur, *head, *tail, *to_add;
+        struct   fplist *ret;
+        size_t   i;
+        void    *data;
+
+        if (l == NULL)
+                return NULL;
+
+        head = tail = NULL;
+
+        for (cur = l->head, i = 0; i < l->len; ++i, cur = cur->next) {
+                data = f(cur->data);
+
+                if (data != cur->data && data != NULL) {
+                        if ((to_add = new_node(data, NULL, FLIST_CLEANABLE))
+                            == NULL)
+                                l->cl_hand(data);
+                } else
+                        to_add = borrow(cur);
+
+                if (to_add == NULL)
+                        goto fail;
+
+                if (tail == NULL)
+                        head = tail = to_add;
+                else
+                        tail = tail->next = to_add;
+        }
+
+        if ((ret = new_list(head, l->len, l->cl_hand)) != NULL)
+                return ret;
+
+fail:
+        /* results made so far are owned by nodes nobody else sees */
+        release(head, l->cl_hand, 0);
+        return NULL;
+}
+
+struct fplist *
+fplist_filter(struct fplist *l, int (*f)(void *))
+{
+        struct   fplist_node *cur, *head, *tail, *to_add;
+        struct   fplist *ret;
+        size_t   i, keep, len;
+        char    *sat;
+
+        if (l == NULL)
+                return NULL;
+
+        if ((sat = malloc(l->len)) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        /* suffix starting past the last rejected element can be shared */
+        for (keep = 0, cur = l->head, i = 0; i < l->len; ++i, cur = cur->next) {
+                if (!(sat[i] = f(cur->data) != 0))
+                        keep = i + 1;
+        }
+
+        head = tail = NULL;
+
+        for (len = 0, cur = l->head, i = 0; i < keep; ++i, cur = cur->next) {
+                if (!sat[i])
+                        continue;
+
+                if ((to_add = borrow(cur)) == NULL) {
+                        release(head, l->cl_hand, 0);
+                        free(sat);
+                        return NULL;
+                }
+                len++;
+
+                if (tail == NULL)
+                        head = tail = to_add;
+                else
+                        tail = tail->next = to_add;
+        }
+
+        free(sat);
+
+        if (keep < l->len) {
+                cur->refs++;
+                len += l->len - keep;
+
+                if (tail == NULL)
+                        head = cur;
+                else
+                        tail->next = cur;
+        }
+
+        if ((ret = new_list(head, len, l->cl_hand)) == NULL && len != 0)
+                release(head, l->cl_hand, 0);
+
+        return ret;
+}
+
+void *
+fplist_foldl(struct fplist *l, void *x, void *(*f)(void *, void *))
+{
+        struct   fplist_node *cur;
+        void    *acc, *tmp;
+        size_t   i;
+
+        if (l == NULL)
+                return x;
+
+        acc = f(x, l->head->data);
+        for (cur = l->head->next, i = 1; i < l->len; ++i, cur = cur->next) {
+                tmp = acc;
+                acc = f(tmp, cur->data);
+                l->cl_hand(tmp);
+        }
+
+        return acc;
+}
+
+struct fplist *
+new_list(struct fplist_node *head, size_t len, void (*cl_hand)(void *))
+{
+        struct   fplist *ret;
+
+        if (len == 0) {
+                release(head, cl_hand, 0);
+                return NULL;
+        }
+
+        if ((ret = malloc(sizeof(struct fplist))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        ret->head    = head;
+        ret->len     = len;
+        ret->cl_hand = cl_hand;
+
+        return ret;
+}
+
+struct fplist_node *
+new_node(void *dat, struct fplist_node *next, unsigned flags)
+{
+        struct   fplist_node *ret;
+
+        if ((ret = malloc(sizeof(struct fplist_node))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        ret->next    = next;
+        ret->owner   = NULL;
+        ret->data    = dat;
+        ret->refs    = 1;
+        ret->borrows = 0;
+        ret->call_h  = (flags & FLIST_CLEANABLE) != 0 ? 1 : 0;
+        ret->prot_h  = (flags & FLIST_CLEANPROT) != 0 ? 1 : 0;
+
+        return ret;
+}
+
+struct fplist_node *
+borrow(struct fplist_node *src)
+{
+        struct   fplist_node *ret;
+
+        if ((ret = new_node(src->data, NULL, FLIST_DONTCLEAN)) == NULL)
+                return NULL;
+
+        /* borrowing from a borrower would chain owners needlessly */
+        ret->owner = src->owner != NULL ? src->owner : src;
+        ret->owner->borrows++;
+
+        return ret;
+}
+
+void
+release(struct fplist_node *n, void (*cl_hand)(void *), int force)
+{
+        struct   fplist_node *next, *dead, *owner;
+
+        for (; n != NULL && --n->refs == 0; n = next) {
+                next = n->next;
+                n->next = NULL;
+
+                /* lenders stay until their borrowers are gone */
+                for (dead = n->borrows == 0 ? n : NULL; dead != NULL;
+                    dead = owner) {
+                        owner = dead->owner;
+
+                        if (owner == NULL && dead->call_h && dead->data
+                            && (!dead->prot_h || force))
+                                cl_hand(dead->data);
+
+                        free(dead);
+
+                        /* owners never borrow, so this goes one level deep */
+                        if (owner != NULL && (--owner->borrows > 0
+                            || owner->refs > 0))
+                                owner = NULL;
+                }
+        }
+}
+
+unsigned
+flags_of(struct fplist_node *n)
+{
+        if (n->owner != NULL)
+                n = n->owner;
+
+        return n->call_h ? FLIST_CLEANPROT | FLIST_CLEANABLE : FLIST_DONTCLEAN;
+}
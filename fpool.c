@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for the internal thread pool
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "fpool.h"
+
+/**
+ * @brief State of the pool
+ *
+ * Everything but `run` is protected by `lock`. Current job is described by
+ * `fn`, `arg` and `ntasks`; `next` is the index of first task not yet taken and
+ * `done` counts finished tasks. Workers notice a new job by `gen` changing.
+ */
+static struct {
+        pthread_mutex_t  run;           /**< @brief Held while job runs */
+        pthread_mutex_t  lock;          /**< @brief Protects the rest */
+        pthread_cond_t   work;          /**< @brief Signals new job */
+        pthread_cond_t   idle;          /**< @brief Signals finished job */
+
+        pthread_t       *workers;       /**< @brief Worker threads */
+        unsigned         nworkers;      /**< @brief Number of workers */
+        unsigned         nthreads;      /**< @brief Configured thread count */
+        unsigned         busy;          /**< @brief Workers inside a job */
+        int              quit;          /**< @brief Workers should exit */
+        unsigned long    gen;           /**< @brief Job generation */
+        unsigned long    spawn_gen;     /**< @brief Generation at spawn time */
+
+        void           (*fn)(void *, size_t); /**< @brief Task body */
+        void            *arg;           /**< @brief Task argument */
+        size_t           ntasks;        /**< @brief Number of tasks */
+        size_t           next;          /**< @brief Next task to take */
+        size_t           done;          /**< @brief Finished tasks */
+} pool = {
+        PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_MUTEX_INITIALIZER,
+        PTHREAD_COND_INITIALIZER,
+        PTHREAD_COND_INITIALIZER,
+        NULL, 0, 0, 0, 0, 0, 0, NULL, NULL, 0, 0, 0
+};
+
+/**
+ * @fn void *worker(void *arg)
+ * @brief Body of a worker thread
+ *
+ * @param[in] arg Unused
+ */
+static void     *worker(void *);
+
+/**
+ * @fn void work(void)
+ * @brief Takes and runs tasks of the current job until none are left
+ *
+ * Must be called with `pool.lock` held, returns with it held.
+ */
+static void      work(void);
+
+/**
+ * @fn void stop_workers(void)
+ * @brief Joins and releases all worker threads
+ */
+static void      stop_workers(void);
+
+void
+fpool_run(void (*fn)(void *, size_t), void *arg, size_t ntasks)
+{
+        size_t   i;
+        unsigned n;
+
+        if (ntasks == 0)
+                return;
+
+        /* pool busy or pointless, do everything here */
+        if (ntasks == 1 || fpool_threads() == 1
+            || pthread_mutex_trylock(&pool.run) != 0) {
+                for (i = 0; i < ntasks; ++i)
+                        fn(arg, i);
+                return;
+        }
+
+        if (pool.nworkers + 1 != pool.nthreads) {
+                stop_workers();
+
+                /*
+                 * Fewer workers only make jobs slower, with none at all the
+                 * calling thread does everything. Spawning is retried by the
+                 * next job.
+                 */
+                n = pool.nthreads - 1;
+                pool.spawn_gen = pool.gen;
+                if ((pool.workers = malloc(n * sizeof(pthread_t))) == NULL)
+                        n = 0;
+
+                for (; pool.nworkers < n; ++pool.nworkers) {
+                        if (pthread_create(&pool.workers[pool.nworkers], NULL,
+                            worker, NULL) != 0)
+                                break;
+                }
+        }
+
+        pthread_mutex_lock(&pool.lock);
+
+        pool.fn     = fn;
+        pool.arg    = arg;
+        pool.ntasks = ntasks;
+        pool.next   = 0;
+        pool.done   = 0;
+        pool.gen++;
+        pthread_cond_broadcast(&pool.work);
+
+        work();
+        while (pool.done < pool.ntasks || pool.busy > 0)
+                pthread_cond_wait(&pool.idle, &pool.lock);
+
+        pthread_mutex_unlock(&pool.lock);
+        pthread_mutex_unlock(&pool.run);
+}
+
+void
+fpool_set_threads(unsigned n)
+{
+        long     cpus;
+
+        if (n == 0) {
+                cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                n    = cpus > 0 ? (unsigned)cpus : 1;
+        }
+
+        pthread_mutex_lock(&pool.run);
+        pool.nthreads = n;
+        pthread_mutex_unlock(&pool.run);
+}
+
+unsigned
+fpool_threads(void)
+{
+        if (pool.nthreads == 0)
+                fpool_set_threads(0);
+
+        return pool.nthreads;
+}
+
+void *
+worker(void *arg)
+{
+        unsigned long    gen;
+
+        (void)arg;
+
+        pthread_mutex_lock(&pool.lock);
+        /* a job may have been posted before we got here */
+        for (gen = pool.spawn_gen; ; gen = pool.gen) {
+                while (gen == pool.gen && !pool.quit)
+                        pthread_cond_wait(&pool.work, &pool.lock);
+
+                if (pool.quit)
+                        break;
+
+                pool.busy++;
+                work();
+                pool.busy--;
+
+                if (pool.done == pool.ntasks && pool.busy == 0)
+                        pthread_cond_signal(&pool.idle);
+        }
+        pthread_mutex_unlock(&pool.lock);
+
+        return NULL;
+}
+
+void
+work(void)
+{
+        size_t   i;
+
+        while (pool.next < pool.ntasks) {
+                i = pool.next++;
+
+                pthread_mutex_unlock(&pool.lock);
+                pool.fn(pool.arg, i);
+                pthread_mutex_lock(&pool.lock);
+
+                pool.done++;
+        }
+}
+
+void
+stop_workers(void)
+{
+        unsigned i;
+
+        if (pool.workers == NULL)
+                return;
+
+        pthread_mutex_lock(&pool.lock);
+        pool.quit = 1;
+        pthread_cond_broadcast(&pool.work);
+        pthread_mutex_unlock(&pool.lock);
+
+        for (i = 0; i < pool.nworkers; ++i)
+                pthread_join(pool.workers[i], NULL);
+
+        free(pool.workers);
+        pool.workers  = NULL;
+        pool.nworkers = 0;
+        pool.quit     = 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Internal thread pool shared by parallel subroutines of libfuncc
+ *
+ * The pool is started lazily by the first parallel call and holds one worker
+ * less than the configured number of threads, the calling thread being the
+ * last one. Only one job runs on the pool at a time; a job submitted while
+ * another one is running (from a different thread or from within a task) is
+ * simply executed by the submitting thread.
+ */
+
+#ifndef FPOOL_H_INCLUDED
+#define FPOOL_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+
+/**
+ * @fn void fpool_run(void (*fn)(void *, size_t), void *arg, size_t ntasks)
+ * @brief Runs tasks zero to @p ntasks - 1 on the pool and waits for them
+ *
+ * Tasks are handed out to threads dynamically, so there is no guarantee as to
+ * which thread runs which task or in what order.
+ * If worker threads cannot be started, tasks run on fewer threads, down to the
+ * calling one alone.
+ *
+ * @param[in] fn Task body, receives @p arg and index of the task
+ * @param[in] arg Argument passed to every task
+ * @param[in] ntasks Number of tasks
+ */
+void             fpool_run(void (*)(void *, size_t), void *, size_t);
+
+/**
+ * @fn void fpool_set_threads(unsigned n)
+ * @brief Sets number of threads used by parallel subroutines
+ *
+ * Zero selects number of online processors. Must not be called while a job is
+ * running.
+ *
+ * @param[in] n Number of threads, including the calling one
+ */
+void             fpool_set_threads(unsigned);
+
+/**
+ * @fn unsigned fpool_threads(void)
+ * @brief Returns number of threads used by parallel subroutines
+ */
+unsigned         fpool_threads(void);
+
+#endif /* FPOOL_H_INCLUDED */
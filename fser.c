@@ -0,0 +1,365 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Serialisation of lists of the @p flist module
+ *
+ * Implements @a flist_serialize() and @a flist_mmap_open(). Lists are written
+ * to files in the format described by @a ser_hdr and mapped back into memory
+ * without copying their elements.
+ */
+
+#include "flist_impl.h"
+#include "fstats_impl.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SER_MAGIC   "FLST"      /**< @brief Magic of serialised lists */
+#define SER_VERSION 1           /**< @brief Version of the format */
+#define SER_ORDER   UINT64_C(0x0102030405060708) /**< @brief Byte order mark */
+#define SER_ALIGN   8           /**< @brief Alignment of encoded elements */
+#define SER_CHUNK   65536       /**< @brief Bytes written at once */
+#define SER_SUM_INIT UINT64_C(14695981039346656037) /**< @brief FNV basis */
+#define SER_SUM_MUL  UINT64_C(1099511628211) /**< @brief FNV prime */
+
+/**
+ * @brief Header of a serialised list
+ *
+ * Followed by `count + 1` offsets of encoded elements, each a `uint64_t`
+ * relative to the start of the data area which follows them, and by the data
+ * area of `data_len` bytes. k-th element spans from k-th offset up to the
+ * next one, all of them being multiples of @a SER_ALIGN, with padding set to
+ * zero. Elements of length zero are NULL. `sum` is computed by @a ser_sum()
+ * over the data area, then the offsets. All fields use byte order of the
+ * writer, `order` lets readers detect a foreign one.
+ */
+struct ser_hdr {
+        char         magic[4];          /**< @brief @a SER_MAGIC */
+        uint32_t     version;           /**< @brief @a SER_VERSION */
+        uint64_t     order;             /**< @brief @a SER_ORDER */
+        uint64_t     count;             /**< @brief Number of elements */
+        uint64_t     data_len;          /**< @brief Size of data area */
+        uint64_t     sum;               /**< @brief Checksum */
+};
+
+/**
+ * @fn uint64_t ser_sum(uint64_t h, const void *p, size_t n)
+ * @brief Extends checksum @p h with @p n bytes at @p p
+ *
+ * FNV-1a taken over 64-bit words instead of bytes. Start with
+ * @a SER_SUM_INIT.
+ *
+ * @param[in] h Checksum so far
+ * @param[in] p Data
+ * @param[in] n Size of data, a multiple of @a SER_ALIGN
+ */
+static uint64_t              ser_sum(uint64_t, const void *, size_t);
+
+/**
+ * @fn struct flist *ser_view(char *base, size_t size, int *err)
+ * @brief Validates serialised list at @p base and builds list over it
+ *
+ * Returns NULL and stores error code in @p err if the format is invalid or
+ * memory runs out.
+ *
+ * @param[in] base Mapped file
+ * @param[in] size Size of the file
+ * @param[out] err Error code
+ */
+static struct flist         *ser_view(char *, size_t, int *);
+
+int
+flist_serialize(struct flist *l, const char *path,
+    size_t (*enc)(const void *, void *, size_t))
+{
+        struct   ser_hdr hdr;
+        struct   flist_iter *cur;
+        uint64_t *off;
+        FILE    *f;
+        char    *buf, *tmp;
+        size_t   cap, used, n, len, i;
+        int      err;
+        STATS_DECL
+
+        STATS_FETCH();
+
+        if (flist_force_all(l) != 0)
+                return -1;
+
+        memset(&hdr, 0x00, sizeof(struct ser_hdr));
+        memcpy(hdr.magic, SER_MAGIC, 4);
+        hdr.version = SER_VERSION;
+        hdr.order   = SER_ORDER;
+        hdr.count   = l == NULL ? 0 : l->len;
+        hdr.sum     = SER_SUM_INIT;
+
+        off = malloc((hdr.count + 1) * sizeof(uint64_t));
+        buf = malloc(cap = SER_CHUNK);
+        if (off == NULL || buf == NULL) {
+                free(off);
+                free(buf);
+                return -1;
+        }
+
+        if ((f = fopen(path, "wb")) == NULL) {
+                free(off);
+                free(buf);
+                return -1;
+        }
+
+        /* data goes first, offsets are known once it is written */
+        if (fseek(f, (long)(sizeof(struct ser_hdr)
+            + (hdr.count + 1) * sizeof(uint64_t)), SEEK_SET) != 0)
+                goto fail;
+
+        /* encodings are staged in buf, keeping room for padding */
+        for (i = 0, used = 0, cur = l == NULL ? NULL : l->head; cur != NULL;
+            ++i, cur = cur->next) {
+                off[i] = hdr.data_len;
+                if (cur->data == NULL)
+                        continue;
+
+                /* cap and used are multiples of SER_ALIGN */
+                if (used + SER_ALIGN > cap) {
+                        if (fwrite(buf, 1, used, f) != used)
+                                goto fail;
+                        hdr.sum = ser_sum(hdr.sum, buf, used);
+                        used    = 0;
+                }
+
+                STATS_ADD(callbacks, 1);
+                n = enc(cur->data, buf + used, cap - used - SER_ALIGN);
+                if (n == (size_t)-1)
+                        goto fail;
+
+                if (n > cap - used - SER_ALIGN) {
+                        if (fwrite(buf, 1, used, f) != used)
+                                goto fail;
+                        hdr.sum = ser_sum(hdr.sum, buf, used);
+                        used    = 0;
+
+                        if (n > cap - SER_ALIGN) {
+                                len = (n / SER_ALIGN + 2) * SER_ALIGN;
+                                if ((tmp = realloc(buf, len)) == NULL)
+                                        goto fail;
+                                buf = tmp;
+                                cap = len;
+                        }
+
+                        if ((n = enc(cur->data, buf, cap - SER_ALIGN))
+                            == (size_t)-1)
+                                goto fail;
+                }
+
+                while (n % SER_ALIGN != 0)
+                        buf[used + n++] = 0x00;
+
+                used          += n;
+                hdr.data_len  += n;
+        }
+
+        if (fwrite(buf, 1, used, f) != used)
+                goto fail;
+
+        off[i]  = hdr.data_len;
+        hdr.sum = ser_sum(hdr.sum, buf, used);
+        hdr.sum = ser_sum(hdr.sum, off, (hdr.count + 1) * sizeof(uint64_t));
+
+        if (fseek(f, 0, SEEK_SET) != 0
+            || fwrite(&hdr, sizeof(struct ser_hdr), 1, f) != 1
+            || fwrite(off, sizeof(uint64_t), hdr.count + 1, f)
+            != hdr.count + 1)
+                goto fail;
+
+        free(buf);
+        free(off);
+
+        if (fclose(f) != 0) {
+                err = errno;
+                remove(path);
+                errno = err;
+                return -1;
+        }
+
+        return 0;
+
+fail:
+        err = errno;
+        fclose(f);
+        remove(path);
+        free(buf);
+        free(off);
+        errno = err;
+
+        return -1;
+}
+
+struct flist *
+flist_mmap_open(const char *path)
+{
+        struct   stat st;
+        struct   flist *ret;
+        void    *base;
+        int      fd, err;
+
+        if ((fd = open(path, O_RDONLY)) < 0)
+                return NULL;
+
+        if (fstat(fd, &st) != 0) {
+                err = errno;
+                close(fd);
+                errno = err;
+                return NULL;
+        }
+
+        if ((size_t)st.st_size < sizeof(struct ser_hdr)) {
+                close(fd);
+                errno = EINVAL;
+                return NULL;
+        }
+
+        base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        err  = errno;
+        close(fd);
+
+        if (base == MAP_FAILED) {
+                errno = err;
+                return NULL;
+        }
+
+        if ((ret = ser_view(base, (size_t)st.st_size, &err)) == NULL) {
+                munmap(base, (size_t)st.st_size);
+                errno = err;
+        }
+
+        return ret;
+}
+
+uint64_t
+ser_sum(uint64_t h, const void *p, size_t n)
+{
+        const    char *c;
+        uint64_t w;
+
+        /* memcpy keeps it clear of aliasing rules, it compiles to a load */
+        for (c = p; n >= sizeof(uint64_t); c += sizeof(uint64_t),
+            n -= sizeof(uint64_t)) {
+                memcpy(&w, c, sizeof(uint64_t));
+                h ^= w;
+                h *= SER_SUM_MUL;
+        }
+
+        return h;
+}
+
+struct flist *
+ser_view(char *base, size_t size, int *err)
+{
+        struct   ser_hdr *hdr;
+        struct   flist_iter *blk;
+        struct   flist_map *m;
+        struct   flist *ret;
+        uint64_t *off, sum;
+        char    *data;
+        size_t   i, n;
+        STATS_DECL
+
+        STATS_FETCH();
+        hdr = (struct ser_hdr *)base;
+        off = (uint64_t *)(hdr + 1);
+        *err = EINVAL;
+
+        if (memcmp(hdr->magic, SER_MAGIC, 4) != 0 || hdr->order != SER_ORDER
+            || hdr->version != SER_VERSION)
+                return NULL;
+
+        /* offsets and data have to fill the rest of the file exactly */
+        if (hdr->count >= (size - sizeof(struct ser_hdr)) / sizeof(uint64_t))
+                return NULL;
+
+        n    = (size_t)hdr->count;
+        data = (char *)(off + n + 1);
+        if (hdr->data_len != size - (size_t)(data - base))
+                return NULL;
+
+        for (i = 0; i <= n; ++i) {
+                if (off[i] % SER_ALIGN != 0 || off[i] > hdr->data_len
+                    || (i > 0 && off[i] < off[i - 1]))
+                        return NULL;
+        }
+
+        if (off[0] != 0 || off[n] != hdr->data_len)
+                return NULL;
+
+        sum = ser_sum(SER_SUM_INIT, data, (size_t)hdr->data_len);
+        if (ser_sum(sum, off, (n + 1) * sizeof(uint64_t)) != hdr->sum)
+                return NULL;
+
+        *err = ENOMEM;
+        if ((ret = flist_create(NULL)) == NULL)
+                return NULL;
+
+        /* nothing refers to the mapping, so it may go right away */
+        if (n == 0) {
+                munmap(base, size);
+                return ret;
+        }
+
+        if ((blk = flist_arena_block(ret, n)) == NULL
+            || (m = ret->alloc->alloc(ret->alloc->ctx,
+            sizeof(struct flist_map))) == NULL) {
+                flist_free(&ret, 0);
+                return NULL;
+        }
+
+        m->addr = base;
+        m->len  = size;
+        m->next = NULL;
+        ret->arena->maps = m;
+
+        STATS_ADD(node_allocs, n);
+        STATS_ADD(bytes_held, n * sizeof(struct flist_iter));
+
+        for (i = 0; i < n; ++i) {
+                blk[i].data = off[i] == off[i + 1] ? NULL : data + off[i];
+                blk[i].next = i + 1 < n ? &blk[i + 1] : NULL;
+                NODE_INIT(&blk[i], i > 0 ? &blk[i - 1] : NULL, NODE_SLAB);
+        }
+
+        ret->kinds = KIND(NODE_SLAB);
+
+        ret->head = blk;
+        ret->tail = &blk[n - 1];
+        ret->len  = n;
+
+        return ret;
+}
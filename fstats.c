@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for @p fstats module
+ */
+
+#include "flist_impl.h"
+#include "fstats_impl.h"
+
+#ifdef FUNCC_STATS
+
+#include <pthread.h>
+#include <time.h>
+
+#define STATS_DEPTH 16 /**< @brief Nesting depth of timed operations */
+
+/**
+ * @brief Counters of a single thread
+ *
+ * Besides counters themselves, each block holds start times of the operations
+ * currently being timed by its thread. Operations nested deeper than
+ * @a STATS_DEPTH are not timed. Live blocks form a list so that they can be
+ * summed up by @a flist_stats_get().
+ */
+struct block {
+        struct       flist_stats s;     /**< @brief Counters */
+        struct       timespec start[STATS_DEPTH]; /**< @brief Start times */
+        size_t       depth;             /**< @brief Operations being timed */
+
+        struct       block *next;       /**< @brief Next live block */
+        struct       block *prev;       /**< @brief Previous live block */
+};
+
+static pthread_once_t    once = PTHREAD_ONCE_INIT;
+static pthread_key_t     key;
+static pthread_mutex_t   mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct block     *live;          /* blocks of running threads */
+static struct flist_stats retired;      /* sum of blocks of exited threads */
+static struct block      spare;         /* shared when no block can be had */
+static int               keyed;         /* was the key created? */
+
+/**
+ * @fn static void make_key(void)
+ * @brief Creates key of per-thread blocks
+ */
+static void      make_key(void);
+
+/**
+ * @fn static void retire(void *b)
+ * @brief Folds block of an exiting thread into @a retired and frees it
+ *
+ * @param[in] b Block to retire
+ */
+static void      retire(void *);
+
+/**
+ * @fn static void add(struct flist_stats *dst, const struct flist_stats *src)
+ * @brief Adds counters of @p src to @p dst
+ *
+ * @param[out] dst Sum
+ * @param[in] src Addend
+ */
+static void      add(struct flist_stats *, const struct flist_stats *);
+
+struct flist_stats *
+fstats_self(void)
+{
+        struct   block *b;
+
+        if (pthread_once(&once, make_key) != 0 || !keyed)
+                return &spare.s;
+
+        if ((b = pthread_getspecific(key)) != NULL)
+                return &b->s;
+
+        if ((b = calloc(1, sizeof(struct block))) == NULL)
+                return &spare.s;
+
+        if (pthread_setspecific(key, b) != 0) {
+                free(b);
+                return &spare.s;
+        }
+
+        pthread_mutex_lock(&mtx);
+        if ((b->next = live) != NULL)
+                live->prev = b;
+        live = b;
+        pthread_mutex_unlock(&mtx);
+
+        return &b->s;
+}
+
+struct flist_stats *
+fstats_begin(void)
+{
+        struct   block *b;
+
+        /* s is the first member */
+        b = (struct block *)fstats_self();
+
+        if (b->depth < STATS_DEPTH)
+                clock_gettime(CLOCK_MONOTONIC, &b->start[b->depth]);
+        ++b->depth;
+
+        return &b->s;
+}
+
+void
+fstats_end(struct flist_stats *s, enum flist_stats_op op)
+{
+        struct   block *b;
+        struct   timespec now;
+        unsigned long ns;
+        size_t   i;
+
+        b = (struct block *)s;
+
+        if (b->depth == 0 || --b->depth >= STATS_DEPTH)
+                return;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ns = (unsigned long)(now.tv_sec - b->start[b->depth].tv_sec)
+            * 1000000000UL + now.tv_nsec - b->start[b->depth].tv_nsec;
+
+        for (i = 0; i < FLIST_STATS_BUCKETS - 1 && (ns >>= 1) != 0; ++i)
+                ;
+        ++b->s.latency[op][i];
+}
+
+void
+flist_stats_get(struct flist_stats *out)
+{
+        struct   block *b;
+
+        pthread_once(&once, make_key);
+
+        pthread_mutex_lock(&mtx);
+        *out = retired;
+        add(out, &spare.s);
+        for (b = live; b != NULL; b = b->next)
+                add(out, &b->s);
+        pthread_mutex_unlock(&mtx);
+
+        out->enabled = 1;
+}
+
+void
+flist_stats_reset(void)
+{
+        struct   block *b;
+
+        pthread_mutex_lock(&mtx);
+        memset(&retired, 0, sizeof(struct flist_stats));
+        memset(&spare.s, 0, sizeof(struct flist_stats));
+        for (b = live; b != NULL; b = b->next)
+                memset(&b->s, 0, sizeof(struct flist_stats));
+        pthread_mutex_unlock(&mtx);
+}
+
+void
+make_key(void)
+{
+        keyed = pthread_key_create(&key, retire) == 0;
+}
+
+void
+retire(void *p)
+{
+        struct   block *b;
+
+        b = p;
+
+        pthread_mutex_lock(&mtx);
+        add(&retired, &b->s);
+        if (b->prev != NULL)
+                b->prev->next = b->next;
+        else
+                live = b->next;
+        if (b->next != NULL)
+                b->next->prev = b->prev;
+        pthread_mutex_unlock(&mtx);
+
+        free(b);
+}
+
+void
+add(struct flist_stats *dst, const struct flist_stats *src)
+{
+        size_t   i, j;
+
+        dst->node_allocs  += src->node_allocs;
+        dst->node_frees   += src->node_frees;
+        dst->tuple_allocs += src->tuple_allocs;
+        dst->tuple_frees  += src->tuple_frees;
+        dst->traversed    += src->traversed;
+        dst->callbacks    += src->callbacks;
+        dst->cleanups     += src->cleanups;
+        dst->bytes_held   += src->bytes_held;
+
+        for (i = 0; i < FLIST_OP_COUNT; ++i)
+                for (j = 0; j < FLIST_STATS_BUCKETS; ++j)
+                        dst->latency[i][j] += src->latency[i][j];
+}
+
+#else
+
+void
+flist_stats_get(struct flist_stats *out)
+{
+        memset(out, 0, sizeof(struct flist_stats));
+}
+
+void
+flist_stats_reset(void)
+{
+}
+
+#endif /* FUNCC_STATS */
@@ -0,0 +1,111 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Internal header of the @p fstats module
+ *
+ * Instrumentation points used by other modules. All of them but
+ * @a STATS_DECL are expressions of type void, and all of them compile to
+ * nothing unless @p FUNCC_STATS is defined.
+ *
+ * Counters of the calling thread are looked up once per function, by
+ * @a STATS_BEGIN() or @a STATS_FETCH(), and then added to directly, so that
+ * counting in loops costs no more than an addition.
+ */
+
+#ifndef FSTATS_IMPL_H_INCLUDED
+#define FSTATS_IMPL_H_INCLUDED
+
+#include "include/fstats.h"
+
+#ifdef FUNCC_STATS
+
+/**
+ * @brief Declares counters used by the other instrumentation points
+ *
+ * Goes among declarations of every function using them, without a trailing
+ * semicolon.
+ */
+# define STATS_DECL             struct flist_stats *stats_;
+
+/**
+ * @brief Looks up counters of the calling thread for @a STATS_ADD()
+ */
+# define STATS_FETCH()          ((void)(stats_ = fstats_self()))
+
+/**
+ * @brief Adds @p N to counter @p F fetched earlier in the function
+ */
+# define STATS_ADD(F, N)        ((void)(stats_->F += (N)))
+
+/**
+ * @brief Marks beginning of an operation whose latency is recorded
+ *
+ * Fetches counters as @a STATS_FETCH() does. Has to be paired with
+ * @a STATS_END() on every path leaving the function.
+ */
+# define STATS_BEGIN()          ((void)(stats_ = fstats_begin()))
+
+/**
+ * @brief Marks end of operation @p OP started by the latest @a STATS_BEGIN()
+ */
+# define STATS_END(OP)          fstats_end(stats_, (OP))
+
+/**
+ * @fn struct flist_stats *fstats_self(void)
+ * @brief Returns counters of the calling thread
+ *
+ * Threads that cannot get counters of their own share a spare block, which is
+ * summed up along with the others. It is updated without synchronisation, as
+ * the rest of them.
+ */
+struct flist_stats          *fstats_self(void);
+
+/**
+ * @fn struct flist_stats *fstats_begin(void)
+ * @brief Pushes current time on the stack of the calling thread and returns
+ * its counters
+ */
+struct flist_stats          *fstats_begin(void);
+
+/**
+ * @fn void fstats_end(struct flist_stats *s, enum flist_stats_op op)
+ * @brief Pops time pushed by @a fstats_begin(), which returned @p s, and
+ * records latency of @p op
+ */
+void                         fstats_end(struct flist_stats *,
+    enum flist_stats_op);
+
+#else
+
+# define STATS_DECL
+# define STATS_FETCH()          ((void)0)
+# define STATS_ADD(F, N)        ((void)0)
+# define STATS_BEGIN()          ((void)0)
+# define STATS_END(OP)          ((void)0)
+
+#endif /* FUNCC_STATS */
+
+#endif /* FSTATS_IMPL_H_INCLUDED */
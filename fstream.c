@@ -0,0 +1,317 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Streams of the @p flist module
+ *
+ * Implements @a flist_from_fd() and the splitters shipped with it. Streams are
+ * lazy lists whose elements are split from chunks of input as they are
+ * forced.
+ */
+
+#include "flist_impl.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FD_CHUNK 65536          /**< @brief Bytes read at once by streams */
+
+/**
+ * @brief State of generators created by @a flist_from_fd()
+ *
+ * Chunks are chained newest first. Elements are handed out from the newest
+ * one, bytes of which past `done` are yet to be split.
+ */
+struct fd_st {
+        int          fd;                /**< @brief Input */
+        size_t     (*split)(void *, const char *, size_t, size_t *);
+                                        /**< @brief Splitter */
+        void        *ctx;               /**< @brief Context of `split` */
+        struct       flist_chunk *chunks; /**< @brief Chunks read so far */
+        size_t       next;              /**< @brief Next element to hand out */
+        size_t       done;              /**< @brief Bytes split so far */
+        int          eof;               /**< @brief Nothing more to read? */
+        int          err;               /**< @brief Error that ended input */
+};
+
+/** @brief Generating function of @a flist_from_fd() */
+static int                   fd_step(struct flist_gen *, void **, unsigned *);
+/** @brief Releasing function of @a flist_from_fd() */
+static void                  fd_release(struct flist_gen *, struct flist *,
+    int);
+/** @brief Dropping function of @a flist_from_fd() */
+static void                  fd_drop(struct flist_gen *);
+
+/**
+ * @fn static int fd_fill(struct fd_st *st)
+ * @brief Reads a new chunk of input and splits it
+ *
+ * Bytes of the newest chunk not split yet are moved to the new one, which is
+ * read into until at least one element is complete or the input ends. Returns
+ * 1 once some elements are split, 0 at the end of input and -1 with errno set
+ * to ENOMEM if memory ran out first, in which case no input is lost and the
+ * call may be retried. A failed read ends the input, storing errno in `err`.
+ *
+ * @param[in] st Generator state
+ */
+static int                   fd_fill(struct fd_st *);
+
+struct flist *
+flist_from_fd(int fd, size_t (*split)(void *, const char *, size_t, size_t *),
+    void *ctx)
+{
+        struct   fd_st *st;
+        struct   flist *ret;
+
+        if (split == NULL) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        if ((ret = flist_new_lazy(fd_step, fd_release,
+            sizeof(struct fd_st))) == NULL)
+                return NULL;
+
+        /*
+         * The arena tells whether anyone else may still see the input and
+         * lets consuming traversals recycle nodes they pass.
+         */
+        if (flist_set_arena(ret, 0) != 0) {
+                flist_free(&ret, 0);
+                return NULL;
+        }
+
+        st        = ret->gen->st;
+        st->fd    = fd;
+        st->split = split;
+        st->ctx   = ctx;
+
+        ret->gen->drop = fd_drop;
+
+        return ret;
+}
+
+size_t
+flist_split_delim(void *ctx, const char *buf, size_t len, size_t *elen)
+{
+        const    char *end;
+
+        if ((end = memchr(buf, *(const char *)ctx, len)) == NULL)
+                return 0;
+
+        *elen = (size_t)(end - buf);
+        return *elen + 1;
+}
+
+size_t
+flist_split_fixed(void *ctx, const char *buf, size_t len, size_t *elen)
+{
+        (void)buf;
+
+        if (len < *(const size_t *)ctx)
+                return 0;
+
+        return *elen = *(const size_t *)ctx;
+}
+
+int
+flist_stream_error(struct flist *l)
+{
+        struct   flist_arena *a;
+
+        if (l == NULL)
+                return 0;
+
+        if (l->gen != NULL && l->gen->step == fd_step)
+                return ((struct fd_st *)l->gen->st)->err;
+
+        return (a = flist_arena_of(l)) == NULL ? 0 : a->err;
+}
+
+int
+fd_step(struct flist_gen *g, void **dat, unsigned *flags)
+{
+        struct   fd_st *st;
+        int      rc;
+
+        st = g->st;
+        while (st->chunks == NULL || st->next == st->chunks->nsl) {
+                if ((rc = fd_fill(st)) <= 0)
+                        return rc;
+        }
+
+        *dat   = &st->chunks->sl[st->next++];
+        *flags = FLIST_DONTCLEAN;
+
+        return 1;
+}
+
+void
+fd_release(struct flist_gen *g, struct flist *l, int force)
+{
+        struct   fd_st *st;
+        struct   flist_chunk *c;
+        struct   flist_arena *a;
+
+        (void)force;
+
+        /*
+         * Elements forced so far live as long as the nodes do. Streams get an
+         * arena when created and lists only ever take in ones sharing it.
+         */
+        st = g->st;
+        if (st->chunks != NULL) {
+                a = flist_arena_of(l);
+
+                for (c = st->chunks; c->next != NULL; c = c->next)
+                        ;
+                c->next   = a->chunks;
+                a->chunks = st->chunks;
+
+                /* a failed read still allocated the chunk it read into */
+                if (a->err == 0)
+                        a->err = st->err;
+        }
+}
+
+void
+fd_drop(struct flist_gen *g)
+{
+        struct   fd_st *st;
+        struct   flist_chunk *c, *next;
+
+        /* elements of the newest chunk may still be handed out */
+        st = g->st;
+        if (st->chunks == NULL)
+                return;
+
+        for (c = st->chunks->next; c != NULL; c = next) {
+                next = c->next;
+                free(c->sl);
+                free(c);
+        }
+
+        st->chunks->next = NULL;
+}
+
+int
+fd_fill(struct fd_st *st)
+{
+        struct   flist_chunk *c, *old;
+        struct   flist_slice *sl;
+        size_t   rest, cap, slcap, used, elen;
+        ssize_t  got;
+
+        old  = st->chunks;
+        rest = old == NULL ? 0 : old->len - st->done;
+        if (st->eof && rest == 0)
+                return 0;
+
+        cap = rest + FD_CHUNK;
+        if ((c = malloc(offsetof(struct flist_chunk, buf) + cap + 1)) == NULL)
+                goto nomem;
+
+        if (rest != 0)
+                memcpy(c->buf, old->buf + st->done, rest);
+
+        c->sl   = NULL;
+        c->nsl  = 0;
+        c->len  = rest;
+        c->cap  = cap;
+        c->next = old;
+
+        st->chunks = c;
+        st->next   = 0;
+        st->done   = 0;
+        slcap      = 0;
+
+        /* bytes carried over may only be left by running out of memory */
+        for (;;) {
+                for (;;) {
+                        elen = 0;
+                        used = st->done == c->len ? 0 : st->split(st->ctx,
+                            c->buf + st->done, c->len - st->done, &elen);
+
+                        /* input left at its end makes the last element */
+                        if (used == 0 && st->eof && st->done < c->len)
+                                used = elen = c->len - st->done;
+                        if (used == 0)
+                                break;
+
+                        if (c->nsl == slcap) {
+                                sl = realloc(c->sl, (slcap == 0 ? 64
+                                    : 2 * slcap) * sizeof(struct flist_slice));
+                                if (sl == NULL) {
+                                        /* the rest is split by the next call */
+                                        if (c->nsl != 0)
+                                                return 1;
+                                        goto nomem;
+                                }
+                                slcap = slcap == 0 ? 64 : 2 * slcap;
+                                c->sl = sl;
+                        }
+
+                        if (elen < used || st->done + used == c->len)
+                                c->buf[st->done + elen] = '\0';
+
+                        c->sl[c->nsl].data  = c->buf + st->done;
+                        c->sl[c->nsl++].len = elen;
+                        st->done += used;
+                }
+
+                if (c->nsl != 0 || st->eof)
+                        break;
+
+                /* nothing points into the chunk before it is split */
+                if (c->len == c->cap) {
+                        old = realloc(c, offsetof(struct flist_chunk, buf)
+                            + 2 * c->cap + 1);
+                        if (old == NULL)
+                                goto nomem;
+                        c          = old;
+                        c->cap    *= 2;
+                        st->chunks = c;
+                }
+
+                while ((got = read(st->fd, c->buf + c->len, c->cap - c->len))
+                    < 0 && errno == EINTR)
+                        ;
+
+                if (got < 0)
+                        st->err = errno;
+                if (got <= 0)
+                        st->eof = 1;
+                else
+                        c->len += (size_t)got;
+        }
+
+        return c->nsl != 0;
+
+nomem:
+        errno = ENOMEM;
+        return -1;
+}
@@ -1,27 +1,109 @@
-#include "include/ftuple.h"
+#include "ftuple_impl.h"
+#include "fstats_impl.h"
 
-struct ftuple {
-        void    **arr;
-        size_t   dim;
+#include <errno.h>
+#include <pthread.h>
+#include <stddef.h>
+
+#define POOL_SLAB 256  /**< @brief Default number of tuples per pool slab */
+
+/**
+ * @brief Free tuple kept in a pool
+ */
+struct pool_blk {
+        struct       pool_blk *next;    /**< @brief Next free tuple */
 };
 
+/**
+ * @brief Slab of pool tuples
+ *
+ * The header is followed by the tuples it was carved into.
+ */
+struct pool_slab {
+        struct       pool_slab *next;   /**< @brief Next slab of the pool */
+        size_t       size;              /**< @brief Size of the slab */
+};
+
+/**
+ * @brief Pool of pairs and triples
+ *
+ * `free[0]` holds free pairs and `free[1]` free triples.
+ */
+struct ftuple_pool {
+        struct       falloc self;       /**< @brief Allocator using the pool */
+        const struct falloc *parent;    /**< @brief Source of slabs */
+        pthread_mutex_t lock;           /**< @brief Guards all below */
+        struct       pool_blk *free[2]; /**< @brief Free tuples */
+        struct       pool_slab *slabs;  /**< @brief All slabs */
+        size_t       per_slab;          /**< @brief Tuples per slab */
+};
+
+/**
+ * @fn static struct ftuple *make(const struct falloc *a, size_t dim)
+ * @brief Allocates a tuple of @p dim elements without setting them
+ *
+ * @param[in] a Allocator, NULL selects the default one
+ * @param[in] dim Size of the tuple
+ */
+static struct ftuple    *make(const struct falloc *, size_t);
+
+/**
+ * @fn static void buf_free(void *ctx, void *ptr, size_t size)
+ * @brief Release function of tuples built by @a ftuple_init()
+ */
+static void              buf_free(void *, void *, size_t);
+
+/**
+ * @fn static int pool_class(size_t size)
+ * @brief Returns free list of a pool holding blocks of @p size bytes
+ *
+ * Returns -1 for sizes of neither pairs nor triples.
+ */
+static int               pool_class(size_t);
+
+/**
+ * @fn static void *pool_alloc(void *ctx, size_t size)
+ * @brief Allocation function of @a ftuple_pool_falloc()
+ */
+static void             *pool_alloc(void *, size_t);
+
+/**
+ * @fn static void pool_free(void *ctx, void *ptr, size_t size)
+ * @brief Release function of @a ftuple_pool_falloc()
+ */
+static void              pool_free(void *, void *, size_t);
+
+/** @brief Allocator of tuples built by @a ftuple_init() */
+static const struct falloc buf_falloc = { NULL, buf_free, NULL };
+
 struct ftuple *
 ftuple_create(size_t dim, ...)
 {
-        size_t   i;
         va_list  args;
         struct   ftuple *ret;
+        size_t   i;
 
-        if (dim < 2 || (ret = malloc(sizeof(struct ftuple))) == NULL)
+        if ((ret = make(NULL, dim)) == NULL)
                 return NULL;
 
-        if ((ret->arr = calloc(dim, sizeof(void *))) == NULL) {
-                free(ret);
+        va_start(args, dim);
+        for (i = 0; i < dim; ++i)
+                ret->arr[i] = va_arg(args, void *);
+        va_end(args);
+
+        return ret;
+}
+
+struct ftuple *
+ftuple_create_with(const struct falloc *a, size_t dim, ...)
+{
+        va_list  args;
+        struct   ftuple *ret;
+        size_t   i;
+
+        if ((ret = make(a, dim)) == NULL)
                 return NULL;
-        }
 
-        ret->dim = dim;
-        
         va_start(args, dim);
         for (i = 0; i < dim; ++i)
                 ret->arr[i] = va_arg(args, void *);
@@ -30,13 +112,68 @@ ftuple_create(size_t dim, ...)
         return ret;
 }
 
+struct ftuple *
+ftuple_create_from_array(size_t dim, void **elems)
+{
+        struct   ftuple *ret;
+        size_t   i;
+
+        if ((ret = make(NULL, dim)) == NULL)
+                return NULL;
+
+        for (i = 0; i < dim; ++i)
+                ret->arr[i] = elems == NULL ? NULL : elems[i];
+
+        return ret;
+}
+
+size_t
+ftuple_size(size_t dim)
+{
+        return offsetof(struct ftuple, arr) + dim * sizeof(void *);
+}
+
+struct ftuple *
+ftuple_init(void *buf, size_t size, size_t dim, void **elems)
+{
+        struct   ftuple *ret;
+        size_t   i;
+
+        if (dim < 2 || size < ftuple_size(dim)) {
+                errno = EINVAL;
+                return NULL;
+        }
+
+        ret = buf;
+        ret->dim   = dim;
+        ret->alloc = &buf_falloc;
+
+        for (i = 0; i < dim; ++i)
+                ret->arr[i] = elems == NULL ? NULL : elems[i];
+
+        return ret;
+}
+
 void
 ftuple_free(struct ftuple **tp)
 {
-        free((*tp)->arr);
-        free(*tp);
+        const    struct falloc *a;
+        STATS_DECL
+
+        a = (*tp)->alloc;
+        if (a == &buf_falloc) {
+                *tp = NULL;
+                return;
+        }
+
+        STATS_BEGIN();
+        STATS_ADD(tuple_frees, 1);
+        STATS_ADD(bytes_held, -(long)ftuple_size((*tp)->dim));
+
+        a->free(a->ctx, *tp, ftuple_size((*tp)->dim));
 
         *tp = NULL;
+        STATS_END(FLIST_OP_TUPLE_FREE);
 }
 
 size_t
@@ -62,3 +199,174 @@ ftuple_nth(struct ftuple *t, size_t n)
 {
         return t == NULL || n >= ftuple_dim(t) ? NULL : t->arr[n];
 }
+
+struct ftuple_pool *
+ftuple_pool_create(size_t per_slab)
+{
+        const    struct falloc *a;
+        struct   ftuple_pool *ret;
+        int      err;
+
+        a = falloc_get_default();
+        if ((ret = a->alloc(a->ctx, sizeof(struct ftuple_pool))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        if ((err = pthread_mutex_init(&ret->lock, NULL)) != 0) {
+                a->free(a->ctx, ret, sizeof(struct ftuple_pool));
+                errno = err;
+                return NULL;
+        }
+
+        ret->self.alloc = pool_alloc;
+        ret->self.free  = pool_free;
+        ret->self.ctx   = ret;
+        ret->parent     = a;
+        ret->free[0]    = ret->free[1] = NULL;
+        ret->slabs      = NULL;
+        ret->per_slab   = per_slab == 0 ? POOL_SLAB : per_slab;
+
+        return ret;
+}
+
+const struct falloc *
+ftuple_pool_falloc(struct ftuple_pool *p)
+{
+        return &p->self;
+}
+
+void
+ftuple_pool_destroy(struct ftuple_pool **pp)
+{
+        const    struct falloc *a;
+        struct   pool_slab *s, *next;
+
+        if (*pp == NULL)
+                return;
+
+        a = (*pp)->parent;
+        for (s = (*pp)->slabs; s != NULL; s = next) {
+                next = s->next;
+                a->free(a->ctx, s, s->size);
+        }
+
+        pthread_mutex_destroy(&(*pp)->lock);
+        a->free(a->ctx, *pp, sizeof(struct ftuple_pool));
+        *pp = NULL;
+}
+
+struct ftuple *
+make(const struct falloc *a, size_t dim)
+{
+        struct   ftuple *ret;
+        STATS_DECL
+
+        if (dim < 2)
+                return NULL;
+
+        if (a == NULL)
+                a = falloc_get_default();
+
+        STATS_BEGIN();
+
+        if ((ret = a->alloc(a->ctx, ftuple_size(dim))) == NULL) {
+                errno = ENOMEM;
+                STATS_END(FLIST_OP_TUPLE_CREATE);
+                return NULL;
+        }
+
+        ret->dim   = dim;
+        ret->alloc = a;
+        STATS_ADD(tuple_allocs, 1);
+        STATS_ADD(bytes_held, ftuple_size(dim));
+
+        STATS_END(FLIST_OP_TUPLE_CREATE);
+        return ret;
+}
+
+void
+buf_free(void *ctx, void *ptr, size_t size)
+{
+        (void)ctx;
+        (void)ptr;
+        (void)size;
+}
+
+int
+pool_class(size_t size)
+{
+        if (size == ftuple_size(2))
+                return 0;
+        if (size == ftuple_size(3))
+                return 1;
+
+        return -1;
+}
+
+void *
+pool_alloc(void *ctx, size_t size)
+{
+        struct   ftuple_pool *p;
+        struct   pool_slab *s;
+        struct   pool_blk *b;
+        char    *blk;
+        size_t   i, len;
+        int      c;
+
+        p = ctx;
+        if ((c = pool_class(size)) < 0)
+                return p->parent->alloc(p->parent->ctx, size);
+
+        pthread_mutex_lock(&p->lock);
+
+        if (p->free[c] == NULL) {
+                /* blocks stay aligned, the header is two words */
+                len = sizeof(struct pool_slab) + p->per_slab * size;
+                if ((s = p->parent->alloc(p->parent->ctx, len)) == NULL) {
+                        pthread_mutex_unlock(&p->lock);
+                        return NULL;
+                }
+
+                s->next  = p->slabs;
+                s->size  = len;
+                p->slabs = s;
+
+                blk = (char *)(s + 1);
+                for (i = 0; i < p->per_slab; ++i, blk += size) {
+                        b = (struct pool_blk *)blk;
+                        b->next = p->free[c];
+                        p->free[c] = b;
+                }
+        }
+
+        b = p->free[c];
+        p->free[c] = b->next;
+
+        pthread_mutex_unlock(&p->lock);
+        return b;
+}
+
+void
+pool_free(void *ctx, void *ptr, size_t size)
+{
+        struct   ftuple_pool *p;
+        struct   pool_blk *b;
+        int      c;
+
+        p = ctx;
+        if (ptr == NULL)
+                return;
+
+        if ((c = pool_class(size)) < 0) {
+                p->parent->free(p->parent->ctx, ptr, size);
+                return;
+        }
+
+        b = ptr;
+
+        pthread_mutex_lock(&p->lock);
+        b->next = p->free[c];
+        p->free[c] = b;
+        pthread_mutex_unlock(&p->lock);
+}
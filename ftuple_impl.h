@@ -0,0 +1,54 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Internal header of the @p ftuple module
+ *
+ * Layout of tuples, for modules that build tuples of values they compute only
+ * after the tuple itself has been allocated. Not installed, not a part of the
+ * public interface.
+ */
+
+#ifndef FTUPLE_IMPL_H_INCLUDED
+#define FTUPLE_IMPL_H_INCLUDED
+
+#include "include/ftuple.h"
+
+/**
+ * @brief Tuple of pointers
+ *
+ * Elements are stored inline, `arr` extends past the end of the structure to
+ * hold all `dim` of them, so a tuple is a single block of @a ftuple_size()
+ * bytes coming from `alloc`, of which only a pointer is kept so that the
+ * header of a pair takes two words. Tuples made by @a ftuple_init() live in
+ * memory of the caller, their `alloc` releases nothing.
+ */
+struct ftuple {
+        size_t       dim;               /**< @brief Number of elements */
+        const struct falloc *alloc;     /**< @brief Allocator of the tuple */
+        void        *arr[1];            /**< @brief Elements */
+};
+
+#endif /* FTUPLE_IMPL_H_INCLUDED */
@@ -0,0 +1,626 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief Source file for @p fulist module
+ */
+
+#include <errno.h>
+
+#include "include/fulist.h"
+
+#define BIT(i)  (1U << (i))             /**< @brief Flag bit of i-th slot */
+#define MASK(n) (BIT(n) - 1)            /**< @brief Flag bits of n slots */
+
+/**
+ * @brief Node of `fulist`
+ *
+ * Every node stores up to `FULIST_CHUNK` elements packed at the beginning of
+ * the `data` array. Flags of i-th element are stored as i-th bits of the
+ * `call_h` and `prot_h` bitmasks, their meaning being the same as in the
+ * `flist_iter` structure.
+ */
+struct fulist_node {
+        struct       fulist_node *next; /**< @brief Next node */
+        struct       fulist_node *prev; /**< @brief Previous node */
+        void        *data[FULIST_CHUNK]; /**< @brief Elements of the node */
+
+        unsigned short cnt;             /**< @brief Number of elements */
+        unsigned short call_h;          /**< @brief Call cleanup handler? */
+        unsigned short prot_h;          /**< @brief Call cleanup iff forced? */
+};
+
+/**
+ * @brief An unrolled doubly linked list
+ *
+ * @see fulist_node
+ */
+struct fulist {
+        struct       fulist_node *head; /**< @brief Head of the list */
+        struct       fulist_node *tail; /**< @brief Tail of the list */
+        void       (*cl_hand)(void *);  /**< @brief Cleanup handler */
+        size_t       len;               /**< @brief Length of the list */
+
+        const        struct falloc *alloc; /**< @brief Allocator */
+};
+
+/**
+ * @fn struct fulist *new_list(const struct falloc *a)
+ * @brief Creates new, empty list allocated with @p a
+ *
+ * NULL as @p a selects the default allocator. Returns NULL and sets errno to
+ * ENOMEM if memory runs out.
+ */
+static struct fulist        *new_list(const struct falloc *);
+
+/**
+ * @fn struct fulist_node *new_node(struct fulist *l, struct fulist_node *prev,
+ *  struct fulist_node *next)
+ * @brief Creates new, empty node of @p l linked between @p prev and @p next
+ *
+ * Does not link its neighbours to it. Returns NULL and sets errno to ENOMEM if
+ * memory runs out.
+ *
+ * @param[in] l List the node will belong to
+ * @param[in] prev Pointer to previous node
+ * @param[in] next Pointer to next node
+ */
+static struct fulist_node   *new_node(struct fulist *, struct fulist_node *,
+    struct fulist_node *);
+
+/**
+ * @fn void del_list(struct fulist *l)
+ * @brief Frees structure of @p l, which has no nodes left
+ */
+static void                  del_list(struct fulist *);
+
+/**
+ * @fn void del_node(struct fulist *l, struct fulist_node *n)
+ * @brief Frees node @p n of @p l without looking at its elements
+ */
+static void                  del_node(struct fulist *, struct fulist_node *);
+
+/**
+ * @fn void put(struct fulist_node *n, int i, void *dat, unsigned flags)
+ * @brief Stores @p dat with inflags @p flags in the @p i th slot of @p n
+ *
+ * @param[in] n Target node
+ * @param[in] i Slot to use
+ * @param[in] dat Data to store
+ * @param[in] flags Flags as defined in @a flist_append()
+ */
+static void                  put(struct fulist_node *, int, void *, unsigned);
+
+/**
+ * @fn void clean(struct fulist *l, struct fulist_node *n, int i, int force)
+ * @brief Calls cleanup handler on @p i th element of @p n if its flags say so
+ *
+ * @param[in] l List the node belongs to
+ * @param[in] n Target node
+ * @param[in] i Slot to clean
+ * @param[in] force Same as in @a flist_free()
+ */
+static void                  clean(struct fulist *, struct fulist_node *, int,
+    int);
+
+/**
+ * @fn void free_nodes(struct fulist *l, struct fulist_node *n, int force)
+ * @brief Cleans and frees @p n and all nodes following it
+ *
+ * @param[in] l List the nodes belong to
+ * @param[in] n First node to free
+ * @param[in] force Same as in @a flist_free()
+ */
+static void                  free_nodes(struct fulist *, struct fulist_node *,
+    int);
+
+struct fulist *
+fulist_append(struct fulist *l, void *dat, unsigned flags)
+{
+        struct   fulist *ret;
+        struct   fulist_node *n;
+
+        if ((ret = l) == NULL && (ret = new_list(NULL)) == NULL)
+                return NULL;
+
+        if (ret->tail == NULL || ret->tail->cnt == FULIST_CHUNK) {
+                if ((n = new_node(ret, ret->tail, NULL)) == NULL) {
+                        if (l == NULL)
+                                del_list(ret);
+                        return NULL;
+                }
+
+                if (ret->tail == NULL)
+                        ret->head = n;
+                else
+                        ret->tail->next = n;
+                ret->tail = n;
+        }
+
+        put(ret->tail, ret->tail->cnt++, dat, flags);
+        ret->len++;
+
+        return ret;
+}
+
+struct fulist *
+fulist_prepend(struct fulist *l, void *dat, unsigned flags)
+{
+        struct   fulist *ret;
+        struct   fulist_node *h;
+
+        if ((ret = l) == NULL && (ret = new_list(NULL)) == NULL)
+                return NULL;
+
+        if (ret->head == NULL || ret->head->cnt == FULIST_CHUNK) {
+                if ((h = new_node(ret, NULL, ret->head)) == NULL) {
+                        if (l == NULL)
+                                del_list(ret);
+                        return NULL;
+                }
+
+                if (ret->head == NULL)
+                        ret->tail = h;
+                else
+                        ret->head->prev = h;
+                ret->head = h;
+        }
+
+        /* make room in the first slot */
+        h = ret->head;
+        memmove(h->data + 1, h->data, h->cnt * sizeof(void *));
+        h->call_h = (h->call_h << 1) & MASK(FULIST_CHUNK);
+        h->prot_h = (h->prot_h << 1) & MASK(FULIST_CHUNK);
+
+        put(h, 0, dat, flags);
+        h->cnt++;
+        ret->len++;
+
+        return ret;
+}
+
+void
+fulist_free(struct fulist **lp, int force)
+{
+        if (*lp == NULL)
+                return;
+
+        free_nodes(*lp, (*lp)->head, force);
+
+        del_list(*lp);
+        *lp = NULL;
+}
+
+struct fulist *
+fulist_create(const struct falloc *a)
+{
+        return new_list(a);
+}
+
+void
+fulist_set_cleanup(struct fulist *l, void (*handler)(void *))
+{
+        if (l == NULL || handler == NULL)
+                return;
+
+        l->cl_hand = handler;
+}
+
+void *
+fulist_val_at_i(struct fulist *l, int i)
+{
+        struct   fulist_node *cur;
+
+        if (l == NULL || i < 0)
+                return NULL;
+
+        for (cur = l->head; cur != NULL && i >= cur->cnt; cur = cur->next)
+                i -= cur->cnt;
+
+        return cur != NULL ? cur->data[i] : NULL;
+}
+
+size_t
+fulist_length(struct fulist *l)
+{
+        return l == NULL ? 0 : l->len;
+}
+
+void
+fulist_map(struct fulist *l, void *(*f)(void *), int force)
+{
+        void    *data;
+        struct   fulist_node *cur;
+        int      i;
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                for (i = 0; i < cur->cnt; ++i) {
+                        data = f(cur->data[i]);
+
+                        if (cur->data[i] == data || data == NULL)
+                                continue;
+
+                        clean(l, cur, i, force);
+                        put(cur, i, data, FLIST_CLEANABLE);
+                }
+        }
+}
+
+void *
+fulist_find(struct fulist *l, int (*f)(void *))
+{
+        struct   fulist_node *cur;
+        int      i;
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                for (i = 0; i < cur->cnt; ++i) {
+                        if (f(cur->data[i]))
+                                return cur->data[i];
+                }
+        }
+
+        return NULL;
+}
+
+int
+fulist_elem(struct fulist *l, int (*cmp)(const void *, const void *),
+    const void *x)
+{
+        struct   fulist_node *cur;
+        int      i;
+
+        if (l == NULL)
+                return 0;
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                for (i = 0; i < cur->cnt; ++i) {
+                        if (cmp(cur->data[i], x) == 0)
+                                return 1;
+                }
+        }
+
+        return 0;
+}
+
+int
+fulist_any(struct fulist *l, int (*f)(void *))
+{
+        return fulist_find(l, f) != NULL;
+}
+
+int
+fulist_all(struct fulist *l, int (*f)(void *))
+{
+        struct   fulist_node *cur;
+        int      i;
+
+        for (cur = l->head; cur != NULL; cur = cur->next) {
+                for (i = 0; i < cur->cnt; ++i) {
+                        if (!f(cur->data[i]))
+                                return 0;
+                }
+        }
+
+        return 1;
+}
+
+void
+fulist_filter(struct fulist **lp, int (*f)(void *), int force)
+{
+        struct   fulist_node *cur, *w;
+        unsigned bits;
+        int      i, wi;
+
+        /*
+         * Surviving elements are moved towards the head as we go, with (w, wi)
+         * being the slot to write to. It never gets ahead of the slot being
+         * read, so no element is overwritten before it is examined.
+         */
+        w  = (*lp)->head;
+        wi = 0;
+        for (cur = (*lp)->head; cur != NULL; cur = cur->next) {
+                for (i = 0; i < cur->cnt; ++i) {
+                        if (!f(cur->data[i])) {
+                                clean(*lp, cur, i, force);
+                                (*lp)->len--;
+                                continue;
+                        }
+
+                        if (wi == FULIST_CHUNK) {
+                                w->cnt = FULIST_CHUNK;
+                                w  = w->next;
+                                wi = 0;
+                        }
+
+                        bits = ((cur->call_h & BIT(i)) ? FLIST_CLEANABLE : 0)
+                            | ((cur->prot_h & BIT(i)) ? FLIST_CLEANPROT : 0);
+                        put(w, wi++, cur->data[i], bits);
+                }
+        }
+
+        if ((*lp)->len == 0) {
+                /* everything has already been cleaned */
+                for (cur = (*lp)->head; cur != NULL; cur = cur->next)
+                        cur->cnt = 0;
+
+                fulist_free(lp, force);
+                return;
+        }
+
+        for (cur = w->next; cur != NULL; cur = cur->next)
+                cur->cnt = 0;
+
+        free_nodes(*lp, w->next, force);
+
+        w->cnt     = wi;
+        w->call_h &= MASK(wi);
+        w->prot_h &= MASK(wi);
+        w->next    = NULL;
+        (*lp)->tail = w;
+}
+
+void
+fulist_take(struct fulist **lp, int n, int force)
+{
+        struct   fulist_node *cur;
+        int      i;
+
+        if (n <= 0) {
+                fulist_free(lp, force);
+                return;
+        }
+
+        if ((size_t)n >= fulist_length(*lp))
+                return;
+
+        (*lp)->len = n;
+        for (cur = (*lp)->head; n >= cur->cnt; cur = cur->next)
+                n -= cur->cnt;
+
+        for (i = n; i < cur->cnt; ++i)
+                clean(*lp, cur, i, force);
+
+        cur->cnt     = n;
+        cur->call_h &= MASK(n);
+        cur->prot_h &= MASK(n);
+
+        free_nodes(*lp, cur->next, force);
+        cur->next = NULL;
+        (*lp)->tail = cur;
+
+        /* truncated node may have become empty */
+        if (n == 0) {
+                (*lp)->tail = cur->prev;
+                (*lp)->tail->next = NULL;
+                del_node(*lp, cur);
+        }
+}
+
+void
+fulist_drop(struct fulist **lp, int n, int force)
+{
+        struct   fulist_node *cur, *tmp;
+        int      i;
+
+        if (n <= 0)
+                return;
+
+        if ((size_t)n >= fulist_length(*lp)) {
+                fulist_free(lp, force);
+                return;
+        }
+
+        (*lp)->len -= n;
+        for (cur = (*lp)->head; n >= cur->cnt; cur = tmp) {
+                tmp = cur->next;
+                n  -= cur->cnt;
+
+                cur->next = NULL;
+                free_nodes(*lp, cur, force);
+        }
+
+        for (i = 0; i < n; ++i)
+                clean(*lp, cur, i, force);
+
+        memmove(cur->data, cur->data + n, (cur->cnt - n) * sizeof(void *));
+        cur->call_h >>= n;
+        cur->prot_h >>= n;
+        cur->cnt     -= n;
+
+        cur->prev = NULL;
+        (*lp)->head = cur;
+}
+
+void *
+fulist_foldr(struct fulist *l, void *x, void *(*f)(void *, void *))
+{
+        void    *acc, *tmp;
+        struct   fulist_node *cur;
+        int      i;
+
+        if (l == NULL || l->tail == NULL)
+                return x;
+
+        acc = f(l->tail->data[l->tail->cnt - 1], x);
+        for (cur = l->tail, i = cur->cnt - 2; cur != NULL; cur = cur->prev) {
+                for (i = cur == l->tail ? i : cur->cnt - 1; i >= 0; --i) {
+                        tmp = acc;
+                        acc = f(cur->data[i], tmp);
+                        l->cl_hand(tmp);
+                }
+        }
+
+        return acc;
+}
+
+void *
+fulist_foldl(struct fulist *l, void *x, void *(*f)(void *, void *))
+{
+        void    *acc, *tmp;
+        struct   fulist_node *cur;
+        int      i;
+
+        if (l == NULL || l->head == NULL)
+                return x;
+
+        acc = f(x, l->head->data[0]);
+        for (cur = l->head, i = 1; cur != NULL; cur = cur->next, i = 0) {
+                for (; i < cur->cnt; ++i) {
+                        tmp = acc;
+                        acc = f(tmp, cur->data[i]);
+                        l->cl_hand(tmp);
+                }
+        }
+
+        return acc;
+}
+
+void
+fulist_reverse(struct fulist *l)
+{
+        struct   fulist_node *cur, *tmp;
+        void    *dat;
+        unsigned call, prot;
+        int      i, j;
+
+        if (l == NULL)
+                return;
+
+        for (cur = l->head; cur != NULL; cur = cur->prev) {
+                tmp = cur->next;
+                cur->next = cur->prev;
+                cur->prev = tmp;
+
+                call = prot = 0;
+                for (i = 0, j = cur->cnt - 1; i < cur->cnt; ++i, --j) {
+                        if (cur->call_h & BIT(i))
+                                call |= BIT(j);
+                        if (cur->prot_h & BIT(i))
+                                prot |= BIT(j);
+
+                        if (i < j) {
+                                dat = cur->data[i];
+                                cur->data[i] = cur->data[j];
+                                cur->data[j] = dat;
+                        }
+                }
+
+                cur->call_h = call;
+                cur->prot_h = prot;
+        }
+
+        tmp = l->head;
+        l->head = l->tail;
+        l->tail = tmp;
+}
+
+struct fulist *
+new_list(const struct falloc *a)
+{
+        struct   fulist *ret;
+
+        if (a == NULL)
+                a = falloc_get_default();
+
+        if ((ret = a->alloc(a->ctx, sizeof(struct fulist))) == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        memset(ret, 0x00, sizeof(struct fulist));
+
+        ret->cl_hand = free;
+        ret->alloc   = a;
+
+        return ret;
+}
+
+struct fulist_node *
+new_node(struct fulist *l, struct fulist_node *prev, struct fulist_node *next)
+{
+        struct   fulist_node *ret;
+
+        if ((ret = l->alloc->alloc(l->alloc->ctx, sizeof(struct fulist_node)))
+            == NULL) {
+                errno = ENOMEM;
+                return NULL;
+        }
+
+        ret->next   = next;
+        ret->prev   = prev;
+        ret->cnt    = 0;
+        ret->call_h = 0;
+        ret->prot_h = 0;
+
+        return ret;
+}
+
+void
+put(struct fulist_node *n, int i, void *dat, unsigned flags)
+{
+        n->data[i] = dat;
+
+        n->call_h &= ~BIT(i);
+        n->prot_h &= ~BIT(i);
+        if ((flags & FLIST_CLEANABLE) != 0)
+                n->call_h |= BIT(i);
+        if ((flags & FLIST_CLEANPROT) != 0)
+                n->prot_h |= BIT(i);
+}
+
+void
+clean(struct fulist *l, struct fulist_node *n, int i, int force)
+{
+        if ((n->call_h & BIT(i)) && n->data[i]
+            && (!(n->prot_h & BIT(i)) || force))
+                l->cl_hand(n->data[i]);
+}
+
+void
+free_nodes(struct fulist *l, struct fulist_node *n, int force)
+{
+        struct   fulist_node *tmp;
+        int      i;
+
+        for (; n != NULL; n = tmp) {
+                for (i = 0; i < n->cnt; ++i)
+                        clean(l, n, i, force);
+
+                tmp = n->next;
+                del_node(l, n);
+        }
+}
+
+void
+del_list(struct fulist *l)
+{
+        l->alloc->free(l->alloc->ctx, l, sizeof(struct fulist));
+}
+
+void
+del_node(struct fulist *l, struct fulist_node *n)
+{
+        l->alloc->free(l->alloc->ctx, n, sizeof(struct fulist_node));
+}
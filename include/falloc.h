@@ -0,0 +1,123 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @defgroup falloc falloc
+ * @ingroup falloc.h
+ * @ingroup falloc.c
+ *
+ * Pluggable allocators
+ *
+ * Lists and tuples allocate their nodes and structures through an allocator,
+ * a pair of functions sharing a user context. The allocator is chosen when a
+ * list or tuple is created and kept for its whole lifetime. Unless given
+ * explicitly, the process-wide default is used.
+ */
+
+/**
+ * @file
+ * @brief Header file for the @p falloc module
+ */
+
+#ifndef FALLOC_H_INCLUDED
+#define FALLOC_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _RM_POSIX_DECL
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+
+/**
+ * @brief Allocator
+ *
+ * `alloc` returns @p size bytes aligned as malloc() would align them, or NULL
+ * on failure. `free` releases memory returned by `alloc`, receiving the same
+ * @p size it was requested with, and has to accept NULL. Both may be called
+ * concurrently from multiple threads.
+ *
+ * Lists and tuples keep a pointer to the allocator they were created with,
+ * so it has to outlive them. @a falloc_malloc, @a falloc_cache and allocators
+ * of tuple pools (until the pool is destroyed) do.
+ */
+struct falloc {
+        void      *(*alloc)(void *, size_t);
+                                        /**< @brief Allocates memory */
+        void       (*free)(void *, void *, size_t);
+                                        /**< @brief Releases memory */
+        void        *ctx;               /**< @brief First argument of both */
+};
+
+/**
+ * @brief Allocator backed by plain malloc() and free()
+ *
+ * This is the default allocator unless @a falloc_set_default() is called.
+ */
+extern const struct falloc falloc_malloc;
+
+/**
+ * @brief Thread-local caching allocator
+ *
+ * Small blocks are rounded up to one of a few size classes and, when freed,
+ * kept on a per-thread free list of their class instead of being returned to
+ * malloc, up to a fixed number of blocks per class. Allocating a cached block
+ * involves no locking. Blocks may be freed by threads other than the one that
+ * allocated them, they then join the cache of the freeing thread. Caches are
+ * released when their threads exit, or explicitly by @a falloc_cache_trim().
+ */
+extern const struct falloc falloc_cache;
+
+/**
+ * @fn void falloc_set_default(const struct falloc *a)
+ * @brief Sets process-wide default allocator
+ *
+ * Objects created with the default allocator keep a pointer to it, so @p a
+ * has to outlive all of them. Passing NULL restores @a falloc_malloc.
+ * Objects created earlier keep their allocators.
+ * Changing the default is not synchronised with threads creating lists or
+ * tuples concurrently.
+ *
+ * @param[in] a New default allocator
+ */
+void             falloc_set_default(const struct falloc *);
+
+/**
+ * @fn const struct falloc *falloc_get_default(void)
+ * @brief Returns process-wide default allocator
+ * @see falloc_set_default()
+ */
+const struct falloc *falloc_get_default(void);
+
+/**
+ * @fn void falloc_cache_trim(void)
+ * @brief Returns blocks cached by @a falloc_cache for calling thread to malloc
+ */
+void             falloc_cache_trim(void);
+
+#ifdef _RM_POSIX_DECL
+# undef _POSIX_C_SOURCE
+#endif
+
+#endif /* FALLOC_H_INCLUDED */
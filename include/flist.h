@@ -48,25 +48,96 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef FLIST_COMPACT
+# include <stdint.h>
+#endif
+
 #include "ftuple.h"
 
 #define FLIST_DONTCLEAN 0x0 /**< @brief Inflag, cleanup handler not called */
 #define FLIST_CLEANABLE 0x1 /**< @brief Inflag, cleanup handler called */
 #define FLIST_CLEANPROT 0x2 /**< @brief Inflag, cleanup handler can be called */
 
+#define FLIST_SLAB_DEFAULT 4096 /**< @brief Default arena slab size (nodes) */
+
 struct flist;
 
+/**
+ * @brief Node of `flist`
+ *
+ * This structure works both as a node as well as the iterator. The `flist` is
+ * implemented to be a doubly linked list storing data in form of void pointers
+ * to mimic generics. Moreover, each node contains a two-flag bitfield which
+ * stores information used by `flist_free()` upon list deletion.
+ *
+ * The layout is public only so that @a FLIST_FOREACH() can be expanded
+ * inline. Callers may read `next` and `data` and get the previous node with
+ * @a FLIST_ITER_PREV(), but must not write to any member, the remaining ones
+ * are private.
+ *
+ * When the library is built with @p FLIST_COMPACT defined (for example with
+ * make DEFS=-DFLIST_COMPACT), the flags are kept in the low bits of the link
+ * to the previous node instead, shrinking nodes from four words to three.
+ * This needs nodes aligned to 8 bytes, so custom allocators have to provide
+ * such, and code using the library has to be compiled with the same
+ * definition.
+ *
+ * @see flist_free()
+ */
+#ifndef FLIST_COMPACT
+struct flist_iter {
+        struct       flist_iter *next;  /**< @brief Next node */
+        struct       flist_iter *prev;  /**< @brief Previous node */
+        void        *data;              /**< @brief Pointer to the data */
+
+        unsigned     call_h : 1;        /**< @brief Call cleanup handler? */
+        unsigned     prot_h : 1;        /**< @brief Call cleanup iff forced? */
+        unsigned     slab_h : 1;        /**< @brief Carved from an arena slab? */
+};
+#else
+struct flist_iter {
+        struct       flist_iter *next;  /**< @brief Next node */
+        uintptr_t    prev_f;            /**< @brief Previous node and flags */
+        void        *data;              /**< @brief Pointer to the data */
+};
+#endif
+
+/**
+ * @brief Node preceding node @p n, NULL for the first one
+ *
+ * @param[in] n Nonnull node
+ */
+#ifndef FLIST_COMPACT
+# define FLIST_ITER_PREV(n) ((n)->prev)
+#else
+# define FLIST_ITER_PREV(n)                                             \
+        ((struct flist_iter *)((n)->prev_f & ~(uintptr_t)0x7))
+#endif
+
 /**
  * @fn struct flist *flist_append(struct flist *l, void *dat, unsigned flags)
  * @brief Appends element to a list
  *
  * Creates new list node with data @p dat using flagset @p flags. If @p l is
  * NULL, new list is created and said node is added to it to become its sole
- * element. Otherwise this new node is appended to the end of @p l.
+ * element. Otherwise this new node is appended to the end of @p l, forcing it
+ * first if it is lazy. New lists use the default allocator.
+ *
+ * If allocation fails, NULL is returned, errno is set to ENOMEM and @p l is
+ * left intact (much like realloc() does), so code that needs to survive it
+ * has to keep the original pointer until the call succeeds.
+ *
+ * Other subroutines never treat allocation failure as fatal either. Unless
+ * documented otherwise, they set errno to ENOMEM, return NULL or -1 (those
+ * returning nothing just return) and leave the lists passed as they were,
+ * except for lazy lists keeping elements forced before the failure. Forcing
+ * such a list again goes on from where it stopped.
  *
  * @param[in] l Target list
  * @param[in] dat Data to insert
  * @param[in] flags Flags to add
+ * @see flist_create()
+ * @see falloc_set_default()
  */
 struct flist    *flist_append(struct flist *, void *, unsigned);
 
@@ -77,6 +148,56 @@ struct flist    *flist_append(struct flist *, void *, unsigned);
  */
 struct flist    *flist_prepend(struct flist *, void *, unsigned);
 
+/**
+ * @fn struct flist *flist_from_array(struct flist *l, void **arr, size_t n,
+ *  unsigned flags)
+ * @brief Appends @p n elements of array @p arr to a list
+ *
+ * Behaves as @p n consecutive calls to @a flist_append() with the same
+ * @p flags, except that all the nodes are allocated in a single block and
+ * linked in one pass. The block is released when the list is freed, nodes
+ * removed from the list before that are reused by it. If @p l is NULL, new
+ * list is created (even if @p n is zero). Fails the same way as
+ * @a flist_append() does.
+ *
+ * @param[in] l Target list
+ * @param[in] arr Elements to append
+ * @param[in] n Number of elements
+ * @param[in] flags Flags to add
+ * @see flist_append()
+ */
+struct flist    *flist_from_array(struct flist *, void **, size_t, unsigned);
+
+/**
+ * @fn struct flist *flist_create(const struct falloc *a)
+ * @brief Creates an empty list using allocator @p a
+ *
+ * The list, its nodes and slabs are allocated with @p a for as long as the
+ * list lives, elements can then be added to it by any subroutine accepting a
+ * list. The list keeps a pointer to @p a, which has to outlive it. Passing
+ * NULL as @p a selects the default allocator. Returns NULL and sets errno to
+ * ENOMEM on failure.
+ *
+ * Subroutines that empty a list free it, just as with any other list, and the
+ * allocator is forgotten then.
+ *
+ * @param[in] a Allocator
+ */
+struct flist    *flist_create(const struct falloc *);
+
+/**
+ * @fn size_t flist_to_array(struct flist *l, void **out)
+ * @brief Stores elements of @p l in consecutive cells of @p out
+ *
+ * @p out has to have room for at least @a flist_length() elements. To append
+ * to an already filled array, pass pointer to its first unused cell. Returns
+ * number of elements stored.
+ *
+ * @param[in] l Source list
+ * @param[out] out Target array
+ */
+size_t           flist_to_array(struct flist *, void **);
+
 /**
  * @fn struct flist *flist_copy(struct flist *l, void *(*copy_c)(void *))
  * @brief Creates copy of list @p l
@@ -90,11 +211,29 @@ struct flist    *flist_prepend(struct flist *, void *, unsigned);
  * constructor. All elements of the newly created list will have the
  * @a FLIST_CLEANABLE flag set.
  *
+ * Copy uses the allocator of @p l. If allocation fails, whatever was copied so
+ * far is released, NULL is returned and errno is set to ENOMEM.
+ *
  * @param[in] l Source list
  * @param[in] copy_c Copy constructor, pass NULL if shallow copy suffices
  */
 struct flist    *flist_copy(struct flist *, void *(*)(void *));
 
+/**
+ * @fn struct flist *flist_copy_par(struct flist *l, void *(*copy_c)(void *))
+ * @brief Parallel variant of @a flist_copy()
+ *
+ * Copy constructor @p copy_c is called concurrently from multiple threads (see
+ * @a flist_set_threads()), thus it has to be thread-safe. Resulting list is
+ * the same as the one @a flist_copy() would produce. Shallow copies are not
+ * parallelized.
+ *
+ * @param[in] l Source list
+ * @param[in] copy_c Copy constructor, pass NULL if shallow copy suffices
+ * @see flist_copy()
+ */
+struct flist    *flist_copy_par(struct flist *, void *(*)(void *));
+
 /**
  * @fn void flist_free(struct flist **lp, int force)
  * @brief Frees list pointed to by @p lp
@@ -126,6 +265,62 @@ void             flist_free(struct flist **, int);
  */
 void             flist_set_cleanup(struct flist *, void (*)(void *));
 
+/**
+ * @fn int flist_set_arena(struct flist *l, size_t n)
+ * @brief Switch list @p l to arena mode
+ *
+ * Nodes created from now on are carved from slabs of @p n nodes owned by the
+ * list instead of being allocated one by one. Nodes removed from the list are
+ * kept for reuse and all slabs are released at once by @a flist_free(). Cleanup
+ * handler is still called for every element, as usual. Nodes created before
+ * the call are not affected. Passing zero as @p n selects
+ * @a FLIST_SLAB_DEFAULT, calling this on a list already in arena mode only
+ * changes size of slabs allocated in the future. Returns 0 on success and -1 if
+ * the arena could not be allocated.
+ *
+ * @param[in] l Target list
+ * @param[in] n Number of nodes per slab
+ */
+int              flist_set_arena(struct flist *, size_t);
+
+/**
+ * @fn void flist_set_index(struct flist *l, size_t n)
+ * @brief Maintain positional index with every @p n th node of @p l
+ *
+ * Positional access (@a flist_val_at_i() and @a flist_take()) always starts
+ * from the closest of head, tail and the most recently accessed node, making
+ * sequential access amortised O(1). With an index it additionally starts no
+ * further than @p n nodes from any position, at the cost of one pointer per
+ * @p n nodes. The index is built lazily and rebuilt after subroutines that
+ * move nodes around (everything but appending). Passing zero as @p n removes
+ * the index.
+ *
+ * @param[in] l Target list
+ * @param[in] n Distance between indexed nodes
+ */
+void             flist_set_index(struct flist *, size_t);
+
+/**
+ * @fn int flist_set_hash(struct flist *l, unsigned long (*hash)(const void *),
+ *  int (*eq)(const void *, const void *))
+ * @brief Maintain hash index of elements of @p l
+ *
+ * With the index attached @a flist_elem() runs in O(1) expected time. Equal
+ * elements, as told by @p eq returning nonzero, must have equal hashes. The
+ * index is kept up to date by every subroutine that adds, removes or replaces
+ * elements, which makes them a constant factor slower. Passing NULL as
+ * @p hash removes the index. Returns 0 on success and -1 if the index could
+ * not be allocated, in which case @p l is left without one. Subroutines which
+ * would have to grow the index fail instead, except for those splitting @p l,
+ * parts of which are left without an index if there is no memory for one.
+ *
+ * @param[in] l Target list
+ * @param[in] hash Hashing function
+ * @param[in] eq Equality predicate
+ */
+int              flist_set_hash(struct flist *, unsigned long (*)(const void *),
+    int (*)(const void *, const void *));
+
 /**
  * @fn void *flist_val_head(struct flist *l)
  * @brief Returns data stored in the head of the list
@@ -143,6 +338,7 @@ void            *flist_val_head(struct flist *);
  * If list is shorter than @p i or @p l is NULL, then NULL is returned.
  *
  * @param[in] l Source list
+ * @see flist_set_index()
  */
 void            *flist_val_at_i(struct flist *, int);
 
@@ -154,7 +350,8 @@ void            *flist_val_at_i(struct flist *, int);
  * nodes and the list will behave as if all of them were appended to it with
  * @a FLIST_CLEANABLE and @a FLIST_CLEANPROT inflags. Otherwise @p copy_c is
  * expected to return dynamically allocated copies of its input and constructed
- * list behaves as if only @a FLIST_CLEANABLE was used. Returns NULL on error.
+ * list behaves as if only @a FLIST_CLEANABLE was used. Returns NULL on error,
+ * setting errno to ENOMEM if allocation failed.
  *
  * @param[in] dat Data to repeat
  * @param[in] n Number of repetitions
@@ -162,6 +359,171 @@ void            *flist_val_at_i(struct flist *, int);
  */
 struct flist    *flist_repeat(void *, int, void *(*)(void *));
 
+/**
+ * @fn struct flist *flist_repeat_lazy(void *dat, void *(*copy_c)(void *))
+ * @brief Constructs an infinite lazy list with element @p dat repeated
+ *
+ * Lazy counterpart of @a flist_repeat(), elements are created only once they
+ * are needed. Use @a flist_take() to obtain a finite list.
+ *
+ * @param[in] dat Data to repeat
+ * @param[in] copy_c Copy constructor, set to NULL for shallow copy
+ * @see flist_repeat()
+ */
+struct flist    *flist_repeat_lazy(void *, void *(*)(void *));
+
+/**
+ * @fn struct flist *flist_iterate(void *x, unsigned flags, void *(*f)(void *))
+ * @brief Constructs an infinite lazy list of repeated applications of @p f
+ *
+ * Elements of the list are @p x, f(x), f(f(x)) and so on. The first element
+ * uses inflags @p flags, all of the remaining ones are expected to be
+ * heap-allocated by @p f and use @a FLIST_CLEANABLE. Each element is computed
+ * as soon as the previous one is forced, so that @p f is never called with
+ * already freed data.
+ *
+ * Lists created by this subroutine and the other lazy constructors force their
+ * elements only when they are needed. Subroutines which only look at a prefix
+ * of the list (@a flist_find(), @a flist_any(), @a flist_all(),
+ * @a flist_elem(), @a flist_val_head(), @a flist_val_at_i(), @a flist_take(),
+ * @a flist_drop(), @a flist_span(), @a flist_break() and @a flist_split_at())
+ * force no more than necessary, @a flist_prepend() forces nothing and
+ * @a flist_take() makes the list finite. All others force the entire list
+ * first, which never finishes for infinite lists.
+ *
+ * @param[in] x First element
+ * @param[in] flags Inflags of the first element
+ * @param[in] f Function to iterate
+ */
+struct flist    *flist_iterate(void *, unsigned, void *(*)(void *));
+
+/**
+ * @fn struct flist *flist_unfoldr(int (*f)(void *, void **), void *seed,
+ *  unsigned flags)
+ * @brief Constructs a lazy list from a seed
+ *
+ * Every time an element is needed, @p f is called with @p seed and a location
+ * to store the element in. It should return zero if there are no more
+ * elements, nonzero otherwise. @p f is free to modify data pointed to by
+ * @p seed, which is owned by the caller and has to outlive the list. All
+ * elements use inflags @p flags.
+ *
+ * @param[in] f Unfolding function
+ * @param[in] seed State passed to @p f
+ * @param[in] flags Inflags of the elements
+ * @see flist_iterate()
+ */
+struct flist    *flist_unfoldr(int (*)(void *, void **), void *, unsigned);
+
+/**
+ * @fn struct flist *flist_cycle(struct flist *l)
+ * @brief Constructs an infinite lazy list repeating elements of @p l
+ *
+ * Elements of the new list behave as in a shallow copy made by
+ * @a flist_copy(), thus @p l (which is forced if lazy, but otherwise left
+ * untouched) has to outlive both the new list and anything taken from it.
+ * Returns NULL if @p l is empty.
+ *
+ * @param[in] l Source list
+ * @see flist_iterate()
+ */
+struct flist    *flist_cycle(struct flist *);
+
+/**
+ * @brief Element of a list read by @a flist_from_fd()
+ *
+ * Points straight into the buffer the input was read into. Bytes of the
+ * element are followed by a NUL whenever the splitter dropped a separator
+ * after them and at the end of input, so that lines can be used as strings.
+ */
+struct flist_slice {
+        const char  *data;              /**< @brief First byte */
+        size_t       len;               /**< @brief Number of bytes */
+};
+
+/**
+ * @fn struct flist *flist_from_fd(int fd, size_t (*split)(void *ctx,
+ *  const char *buf, size_t len, size_t *elen), void *ctx)
+ * @brief Constructs a lazy list of elements read from @p fd
+ *
+ * Input is read in large blocks as the list is forced and cut into elements
+ * by @p split. It is called with @p ctx and the @p len bytes of @p buf not
+ * yet split, and returns how many of them the next element takes up, storing
+ * how many of those belong to the element in @p elen. It returns zero if
+ * @p buf holds no complete element, which makes the list read more. Input
+ * left over at the end of @p fd is the last element. Elements are pointers
+ * to @a flist_slice, none of them is ever NULL and none is owned by the list.
+ *
+ * Subroutines walking the list front to back (@a flist_find(),
+ * @a flist_any(), @a flist_all(), @a flist_elem(), @a flist_foldl() and
+ * @a flist_foldl_mut()) consume it: every time they have to read further,
+ * they drop all the elements forced so far and input holding them is
+ * released, so they run in constant memory. They leave the list holding only
+ * the elements from where they stopped. Their callbacks must therefore copy
+ * whatever they want to keep. Other subroutines keep forced elements as in
+ * any lazy list, in particular @a flist_take() reads only as much as it
+ * needs. Input is held by the list and lists split from it until all of them
+ * are freed, as with @a flist_mmap_open().
+ *
+ * @p fd is read from as long as the list is forced and is never closed. A
+ * failed read ends the list early, as if the input ended, and is reported by
+ * @a flist_stream_error(). @p ctx has to outlive the list. Returns NULL with
+ * errno set to EINVAL if @p split is NULL.
+ *
+ * @param[in] fd Input file descriptor
+ * @param[in] split Splitter, like @a flist_split_delim()
+ * @param[in] ctx Context passed to @p split
+ * @see flist_iterate()
+ */
+struct flist    *flist_from_fd(int, size_t (*)(void *, const char *, size_t,
+    size_t *), void *);
+
+/**
+ * @fn size_t flist_split_delim(void *ctx, const char *buf, size_t len,
+ *  size_t *elen)
+ * @brief Splitter of @a flist_from_fd() cutting input at a separator
+ *
+ * @p ctx points to the separating character, which is not a part of any
+ * element, so that "\n" makes a list of lines and "" one of NUL-terminated
+ * records. The separator is found with memchr(), which is vectorised by
+ * common C libraries.
+ *
+ * @param[in] ctx Separator
+ * @param[in] buf Input
+ * @param[in] len Length of input
+ * @param[out] elen Length of the element
+ */
+size_t           flist_split_delim(void *, const char *, size_t, size_t *);
+
+/**
+ * @fn size_t flist_split_fixed(void *ctx, const char *buf, size_t len,
+ *  size_t *elen)
+ * @brief Splitter of @a flist_from_fd() cutting input into equal chunks
+ *
+ * @p ctx points to a nonzero size_t holding the size of a chunk. The last
+ * chunk is shorter if the length of input is not its multiple.
+ *
+ * @param[in] ctx Size of a chunk
+ * @param[in] buf Input
+ * @param[in] len Length of input
+ * @param[out] elen Length of the element
+ */
+size_t           flist_split_fixed(void *, const char *, size_t, size_t *);
+
+/**
+ * @fn int flist_stream_error(struct flist *l)
+ * @brief Returns the error that ended input of @a flist_from_fd()
+ *
+ * Returns errno of the failed read that ended the input of @p l, or of the
+ * list @p l was split from, and zero if the input ended normally, is not over
+ * yet or @p l was not read from a file descriptor at all. Lists taking over
+ * elements of a stream, like the destination of @a flist_concat(), report its
+ * error as well.
+ *
+ * @param[in] l Target list, may be NULL
+ */
+int              flist_stream_error(struct flist *);
+
 /**
  * @fn void flist_head(struct flist *l, int force)
  * @brief Drops all but the first element of the list
@@ -201,12 +563,32 @@ void             flist_tail(struct flist **, int);
  */
 void             flist_map(struct flist *, void *(*)(void *), int);
 
+/**
+ * @fn void flist_map_par(struct flist *l, void *(*f)(void *), int force)
+ * @brief Parallel variant of @a flist_map()
+ *
+ * The list is split into segments of equal length, each of which is mapped by
+ * a separate thread, thus @p f has to be thread-safe. Replacing the elements,
+ * including calls to the cleanup handler, is done afterwards by the calling
+ * thread in list order, so it behaves exactly as in @a flist_map() except for
+ * the fact that all calls to @p f happen before any call to the cleanup
+ * handler.
+ *
+ * @param[in] l Source list
+ * @param[in] f Side effect generator
+ * @param[in] force Set to nonzero should old elements be removed
+ * @see flist_map()
+ * @see flist_set_threads()
+ */
+void             flist_map_par(struct flist *, void *(*)(void *), int);
+
 /**
  * @fn size_t flist_length(struct flist *l);
  * @brief Return length of the list
  *
  * Since length of the list is stored in memory, it does not need to be
- * calculated and therefore this is not a costly operation.
+ * calculated and therefore this is not a costly operation, unless the list is
+ * lazy and needs to be forced first.
  *
  * @param[in] l Target list
  */
@@ -229,7 +611,11 @@ void            *flist_find(struct flist *, int (*)(void *));
  * @brief Verify whether @p x is an element of @p l
  *
  * The @p cmp is expected to be a comparison function defined the same way as
- * comparison function needed for @a qsort() as defined in ANSI C90.
+ * comparison function needed for @a qsort() as defined in ANSI C90. If @p l
+ * has a hash index (see @a flist_set_hash()), equality predicate of the index
+ * is used instead and @p cmp is ignored. Returns 1 if @p x was found and 0
+ * otherwise, which includes failing to force a lazy @p l, in which case errno
+ * is set.
  *
  * @param[in] l Target list
  * @param[in] cmp Comparison function
@@ -243,6 +629,9 @@ int              flist_elem(struct flist *, int (*)(const void *, const void *),
  * @brief Verify whether any element of @p l satisfies predicate @p f
  *
  * This is equivallent to checking if @a flist_find() returned a non-NULL value.
+ * Returns 1 or 0, the latter also if forcing a lazy @p l fails, in which case
+ * errno is set.
+ *
  * @param[in] l Target list
  * @param[in] f Predicate
  * @see flist_find()
@@ -255,6 +644,8 @@ int              flist_any(struct flist *, int (*)(void *));
  *
  * This is equivallent to checking if @a flist_find() returned NULL or @a
  * flist_any() returned true for the logical negation of the predicate.
+ * Returns 1 or 0, the latter also if forcing a lazy @p l fails before a
+ * counterexample is found, in which case errno is set.
  *
  * @param[in] l Target list
  * @param[in] f Predicate
@@ -263,6 +654,81 @@ int              flist_any(struct flist *, int (*)(void *));
  */
 int              flist_all(struct flist *, int (*)(void *));
 
+/**
+ * @fn void *flist_find_par(struct flist *l, int (*f)(void *))
+ * @brief Parallel variant of @a flist_find()
+ *
+ * The list is split into segments, several per thread (see
+ * @a flist_set_threads()), which are searched concurrently, thus @p f has to
+ * be thread-safe. Still the first match in list order is returned: once a
+ * match is found, threads searching past it stop before their next call to
+ * @p f, while those searching before it carry on. Lazy lists are forced
+ * entirely first. Pays off for costly predicates, since threads synchronise
+ * once per element.
+ *
+ * @param[in] l Target list
+ * @param[in] f Predicate
+ * @see flist_find_any_par()
+ */
+void            *flist_find_par(struct flist *, int (*)(void *));
+
+/**
+ * @fn void *flist_find_any_par(struct flist *l, int (*f)(void *))
+ * @brief Variant of @a flist_find_par() returning any element satisfying
+ * @p f
+ *
+ * All threads stop as soon as any of them finds a match, which is returned
+ * even if earlier ones exist. Which match that is may differ between calls.
+ *
+ * @param[in] l Target list
+ * @param[in] f Predicate
+ */
+void            *flist_find_any_par(struct flist *, int (*)(void *));
+
+/**
+ * @fn int flist_any_par(struct flist *l, int (*f)(void *))
+ * @brief Parallel variant of @a flist_any()
+ *
+ * Stops all threads on the first match found, as @a flist_find_any_par().
+ * Returns 1 or 0, the latter also if forcing a lazy @p l fails, in which case
+ * errno is set.
+ *
+ * @param[in] l Target list
+ * @param[in] f Predicate
+ * @see flist_find_par()
+ */
+int              flist_any_par(struct flist *, int (*)(void *));
+
+/**
+ * @fn int flist_all_par(struct flist *l, int (*f)(void *))
+ * @brief Parallel variant of @a flist_all()
+ *
+ * Stops all threads on the first counterexample found. Returns 1 or 0, the
+ * latter also if forcing a lazy @p l fails, in which case errno is set.
+ *
+ * @param[in] l Target list
+ * @param[in] f Predicate
+ * @see flist_find_par()
+ */
+int              flist_all_par(struct flist *, int (*)(void *));
+
+/**
+ * @fn int flist_elem_par(struct flist *l, int (*cmp)(const void *,
+ *  const void *), const void *x)
+ * @brief Parallel variant of @a flist_elem()
+ *
+ * Stops all threads on the first equal element found. Hash-indexed lists are
+ * looked up by @a flist_elem() instead, no threads are involved. Returns 1 or
+ * 0, the latter also if forcing a lazy @p l fails, in which case errno is set.
+ *
+ * @param[in] l Target list
+ * @param[in] cmp Comparison function, has to be thread-safe
+ * @param[in] x Element to look for
+ * @see flist_find_par()
+ */
+int              flist_elem_par(struct flist *, int (*)(const void *,
+    const void *), const void *);
+
 /**
  * @fn void flist_filter(struct flist **l, int (*f)(void *), int force)
  * @brief Filter out elements of @p l that do not satisfy predicate @p f
@@ -279,6 +745,22 @@ int              flist_all(struct flist *, int (*)(void *));
  */
 void             flist_filter(struct flist **, int (*)(void *), int);
 
+/**
+ * @fn void flist_filter_par(struct flist **lp, int (*f)(void *), int force)
+ * @brief Parallel variant of @a flist_filter()
+ *
+ * Predicate @p f is evaluated concurrently by multiple threads and has to be
+ * thread-safe. Nodes are then removed by the calling thread in list order,
+ * just as @a flist_filter() does.
+ *
+ * @param[in] lp Pointer to target list
+ * @param[in] f Predicate
+ * @param[in] force Same as in @a flist_free()
+ * @see flist_filter()
+ * @see flist_set_threads()
+ */
+void             flist_filter_par(struct flist **, int (*)(void *), int);
+
 /**
  * @fn void flist_take(struct flist **lp, int n, int force)
  * @brief Truncate the list to a given size
@@ -297,7 +779,8 @@ void             flist_take(struct flist **, int, int);
  * @brief Remove first @p n elements from @p l
  *
  * Calling this with @p n greater or equal to the length of @p l is equivallent
- * to calling @a flist_free()
+ * to calling @a flist_free(), with @p n of zero or less leaves @p l untouched.
+ * Lazy lists are forced only up to the first element kept.
  *
  * @param[in] lp Pointer to the target list
  * @param[in] n Number of elements to drop
@@ -305,6 +788,409 @@ void             flist_take(struct flist **, int, int);
  */
 void             flist_drop(struct flist **, int, int);
 
+/**
+ * @fn struct ftuple *flist_partition(struct flist **lp, int (*p)(void *))
+ * @brief Splits @p l into elements that satisfy @p p and those that do not
+ *
+ * Returns a pair of lists, the first one holding elements for which @p p
+ * returned nonzero and the second one the remaining elements, both in their
+ * original order. Either of them is NULL if it would be empty.
+ *
+ * Lists are built in a single pass by relinking nodes of the list pointed to
+ * by @p lp, which is consumed and set to NULL. Nothing is copied, elements
+ * keep their inflags and both lists inherit cleanup handler, hash and
+ * positional index settings of the original. Lists holding nodes carved from
+ * the same arena share it, such lists must not be modified concurrently.
+ *
+ * Nothing but the pair and one list structure is allocated. If that fails,
+ * NULL is returned, errno is set to ENOMEM and the list is left intact.
+ *
+ * @param[in,out] lp Pointer to the source list
+ * @param[in] p Predicate
+ */
+struct ftuple   *flist_partition(struct flist **, int (*)(void *));
+
+/**
+ * @fn struct ftuple *flist_span(struct flist **lp, int (*p)(void *))
+ * @brief Splits @p l after the longest prefix satisfying @p p
+ *
+ * Returns a pair of lists, the first one holding the longest prefix of
+ * elements for which @p p returned nonzero and the second one the rest. Lazy
+ * lists are forced only up to the first element not satisfying @p p and the
+ * second list inherits their generator. Otherwise behaves as
+ * @a flist_partition().
+ *
+ * @param[in,out] lp Pointer to the source list
+ * @param[in] p Predicate
+ * @see flist_partition()
+ */
+struct ftuple   *flist_span(struct flist **, int (*)(void *));
+
+/**
+ * @fn struct ftuple *flist_break(struct flist **lp, int (*p)(void *))
+ * @brief Splits @p l before the first element satisfying @p p
+ *
+ * Same as @a flist_span() with negated @p p.
+ *
+ * @param[in,out] lp Pointer to the source list
+ * @param[in] p Predicate
+ * @see flist_span()
+ */
+struct ftuple   *flist_break(struct flist **, int (*)(void *));
+
+/**
+ * @fn struct ftuple *flist_split_at(struct flist **lp, size_t n)
+ * @brief Splits @p l after its @p n th element
+ *
+ * Returns a pair of lists, the first one holding first @p n elements and the
+ * second one the rest. Lazy lists are forced only up to the @p n th element.
+ * Otherwise behaves as @a flist_partition().
+ *
+ * @param[in,out] lp Pointer to the source list
+ * @param[in] n Length of the first list
+ * @see flist_partition()
+ */
+struct ftuple   *flist_split_at(struct flist **, size_t);
+
+/**
+ * @fn struct flist *flist_concat(struct flist *dst, struct flist **srcp)
+ * @brief Moves all nodes of list pointed to by @p srcp to the end of @p dst
+ *
+ * Links the node chain of the source list after the last node of @p dst in
+ * constant time, forcing @p dst first if it is lazy. The source list is
+ * consumed and set to NULL, its elements keep their inflags and, if it was
+ * lazy, @p dst inherits its generator. Returns resulting list, which is
+ * @p dst unless it was NULL.
+ *
+ * Since a list has a single cleanup handler, handlers of both lists are
+ * reconciled: if they differ, the result keeps the handler of the one list
+ * holding cleanable elements (or a generator, which may yield them). If both
+ * hold such elements, nothing happens, NULL is returned and errno is set to
+ * EINVAL. The same happens if the lists use different allocators or are the
+ * same list. Looking for cleanable elements takes a traversal, which only
+ * happens if handlers differ.
+ *
+ * If @p dst is hash-indexed, moved elements are added to its index, which
+ * takes time proportional to their number. Lists using arenas merge them.
+ *
+ * @param[in,out] dst Target list
+ * @param[in,out] srcp Pointer to the source list
+ * @see flist_set_cleanup()
+ */
+struct flist    *flist_concat(struct flist *, struct flist **);
+
+/**
+ * @fn struct flist *flist_splice_at(struct flist *dst, size_t i,
+ *  struct flist **srcp)
+ * @brief Moves all nodes of list pointed to by @p srcp before @p i th node of
+ * @p dst
+ *
+ * Same as @a flist_concat(), except that the node chain is inserted so that
+ * its first node becomes the @p i th node of @p dst. If @p dst has no more
+ * than @p i elements, chain is appended. Lazy @p dst is forced only up to
+ * the insertion point, lazy source list is forced entirely unless appended.
+ *
+ * @param[in,out] dst Target list
+ * @param[in] i Insertion point
+ * @param[in,out] srcp Pointer to the source list
+ * @see flist_concat()
+ */
+struct flist    *flist_splice_at(struct flist *, size_t, struct flist **);
+
+/**
+ * @fn struct flist *flist_concat_many(struct flist **ls, size_t k)
+ * @brief Concatenates @p k lists stored in @p ls, in order
+ *
+ * Behaves as a series of @a flist_concat() calls, all of the lists are
+ * consumed and their cells set to NULL. Takes time proportional to @p k,
+ * except for handler reconciliation and hash index updates as described in
+ * @a flist_concat(). Either all lists are concatenated or, on failure, none.
+ * Lists have to be distinct.
+ *
+ * @param[in,out] ls Lists to concatenate, NULL ones are skipped
+ * @param[in] k Number of lists
+ * @see flist_concat()
+ */
+struct flist    *flist_concat_many(struct flist **, size_t);
+
+/**
+ * @fn struct flist *flist_zip(struct flist *l1, struct flist *l2)
+ * @brief Pairs up elements of @p l1 and @p l2 at equal positions
+ *
+ * Both lists are walked once, in lockstep, and the result is as long as the
+ * shorter of them. Elements of the new list are pairs owned by it, freed
+ * with @a ftuple_free() when removed, while elements inside the pairs are
+ * neither copied nor owned. If both lists are lazy, so is the result: pairs
+ * are built as it is forced and both lists have to outlive it. Otherwise
+ * lazy lists are forced only as far as the other one reaches. Returns NULL
+ * if either list is empty, or on error, setting errno to ENOMEM.
+ *
+ * @param[in] l1 Source of first elements
+ * @param[in] l2 Source of second elements
+ * @see flist_unzip()
+ */
+struct flist    *flist_zip(struct flist *, struct flist *);
+
+/**
+ * @fn struct flist *flist_zip3(struct flist *l1, struct flist *l2,
+ *  struct flist *l3)
+ * @brief Variant of @a flist_zip() building triples
+ *
+ * @param[in] l1 Source of first elements
+ * @param[in] l2 Source of second elements
+ * @param[in] l3 Source of third elements
+ */
+struct flist    *flist_zip3(struct flist *, struct flist *, struct flist *);
+
+/**
+ * @fn struct flist *flist_zip_with(struct flist *l1, struct flist *l2,
+ *  void *(*f)(void *, void *), unsigned flags)
+ * @brief Combines elements of @p l1 and @p l2 at equal positions with @p f
+ *
+ * Same as @a flist_zip(), except that elements of the new list are results
+ * of @p f, called with an element of @p l1 and one of @p l2, and use inflags
+ * @p flags. No tuples are built.
+ *
+ * @param[in] l1 Source of first arguments
+ * @param[in] l2 Source of second arguments
+ * @param[in] f Combining function
+ * @param[in] flags Inflags of the elements
+ */
+struct flist    *flist_zip_with(struct flist *, struct flist *,
+    void *(*)(void *, void *), unsigned);
+
+/**
+ * @fn struct ftuple *flist_unzip(struct flist *l)
+ * @brief Splits list of tuples into a tuple of lists
+ *
+ * The number of lists is the dimension of the first tuple, k-th list holds
+ * k-th elements of all tuples, or NULL for tuples too short to have one.
+ * Elements are neither copied nor owned by the new lists, @p l is left
+ * untouched and forced if lazy. An empty @p l gives a pair of empty lists.
+ * Returns NULL on error, setting errno to EINVAL if the first element is
+ * NULL or has fewer than two elements, or to ENOMEM.
+ *
+ * @param[in] l List of tuples
+ * @see flist_zip()
+ */
+struct ftuple   *flist_unzip(struct flist *);
+
+/**
+ * @brief Hints that node @p n will soon be read
+ *
+ * Expands to a prefetch on compilers supporting one and to nothing otherwise.
+ *
+ * @param[in] n Node, may be NULL
+ */
+#ifdef __GNUC__
+# define FLIST_PREFETCH(n)      __builtin_prefetch((n))
+#else
+# define FLIST_PREFETCH(n)      ((void)(n))
+#endif
+
+/**
+ * @brief Loops over nodes of list @p l, binding each one to @p it
+ *
+ * Expands to a `for` statement header whose body runs once per node, with
+ * the element available as `it->data`. Apart from forcing lazy lists, which
+ * happens one element at a time when the end of forced ones is reached, the
+ * loop is plain pointer chasing with the next node prefetched while the body
+ * runs, so conditions in the body can be inlined by the compiler. The list
+ * must not be modified during the loop, except through a cursor. Both
+ * arguments are evaluated multiple times.
+ *
+ * @param[in] l Source list, may be NULL
+ * @param[out] it Variable of type `struct flist_iter *`
+ * @see flist_cursor_begin()
+ */
+#define FLIST_FOREACH(l, it)                                            \
+        for ((it) = flist_iter_first((l));                              \
+            (it) != NULL && (FLIST_PREFETCH((it)->next), 1);            \
+            (it) = (it)->next != NULL ? (it)->next                      \
+            : flist_iter_next((l), (it)))
+
+/**
+ * @brief Variant of @a FLIST_FOREACH() going from the last node back
+ *
+ * Lazy lists are forced entirely before the loop starts.
+ *
+ * @param[in] l Source list, may be NULL
+ * @param[out] it Variable of type `struct flist_iter *`
+ */
+#define FLIST_FOREACH_REV(l, it)                                        \
+        for ((it) = flist_iter_last((l));                               \
+            (it) != NULL && (FLIST_PREFETCH(FLIST_ITER_PREV((it))), 1); \
+            (it) = FLIST_ITER_PREV((it)))
+
+/**
+ * @fn struct flist_iter *flist_iter_first(struct flist *l)
+ * @brief Returns first node of @p l, forcing it if necessary
+ *
+ * Returns NULL for empty lists.
+ *
+ * @param[in] l Source list
+ * @see FLIST_FOREACH
+ */
+struct flist_iter *flist_iter_first(struct flist *);
+
+/**
+ * @fn struct flist_iter *flist_iter_last(struct flist *l)
+ * @brief Returns last node of @p l, forcing the whole list if necessary
+ *
+ * Returns NULL for empty lists.
+ *
+ * @param[in] l Source list
+ * @see FLIST_FOREACH_REV
+ */
+struct flist_iter *flist_iter_last(struct flist *);
+
+/**
+ * @fn struct flist_iter *flist_iter_next(struct flist *l, struct flist_iter *n)
+ * @brief Returns node following @p n in @p l, forcing it if necessary
+ *
+ * @param[in] l Source list
+ * @param[in] n Node of @p l
+ */
+struct flist_iter *flist_iter_next(struct flist *, struct flist_iter *);
+
+/**
+ * @brief Cursor over elements of a list
+ *
+ * A cursor stands either on a node of the list or past one of its ends, in
+ * which case it cannot be moved back. Unlike @a FLIST_FOREACH() it allows
+ * the list to be modified in place. The list must not be modified other than
+ * through the cursor while it is in use. Members are private.
+ *
+ * @see flist_cursor_begin()
+ */
+struct flist_cursor {
+        struct       flist **lp;        /**< @brief Traversed list */
+        struct       flist_iter *cur;   /**< @brief Current node, or NULL */
+        size_t       pos;               /**< @brief Position of `cur` */
+};
+
+/**
+ * @fn int flist_cursor_begin(struct flist_cursor *c, struct flist **lp)
+ * @brief Places cursor @p c on the first element of list pointed to by @p lp
+ *
+ * The list is forced one element at a time, as the cursor moves. Returns
+ * nonzero if the cursor stands on an element, zero if the list is empty.
+ *
+ * @param[out] c Target cursor
+ * @param[in,out] lp Pointer to the traversed list
+ */
+int              flist_cursor_begin(struct flist_cursor *, struct flist **);
+
+/**
+ * @fn int flist_cursor_next(struct flist_cursor *c)
+ * @brief Moves cursor @p c to the next element
+ *
+ * Returns nonzero if the cursor stands on an element, zero once it has moved
+ * past the last one.
+ *
+ * @param[in,out] c Target cursor
+ */
+int              flist_cursor_next(struct flist_cursor *);
+
+/**
+ * @fn int flist_cursor_prev(struct flist_cursor *c)
+ * @brief Moves cursor @p c to the previous element
+ *
+ * Returns nonzero if the cursor stands on an element, zero once it has moved
+ * past the first one.
+ *
+ * @param[in,out] c Target cursor
+ */
+int              flist_cursor_prev(struct flist_cursor *);
+
+/**
+ * @fn void *flist_cursor_get(struct flist_cursor *c)
+ * @brief Returns element under cursor @p c, or NULL past either end
+ *
+ * @param[in] c Source cursor
+ */
+void            *flist_cursor_get(struct flist_cursor *);
+
+/**
+ * @fn void flist_cursor_set(struct flist_cursor *c, void *dat,
+ *  unsigned flags, int force)
+ * @brief Replaces element under cursor @p c
+ *
+ * The old element is cleaned up as it would be by @a flist_free() called
+ * with @p force, the new one uses inflags @p flags. Hash index of the list
+ * is updated. Does nothing past either end.
+ *
+ * @param[in,out] c Target cursor
+ * @param[in] dat New element
+ * @param[in] flags Inflags of the new element
+ * @param[in] force Should protected old element be cleaned up?
+ */
+void             flist_cursor_set(struct flist_cursor *, void *, unsigned,
+    int);
+
+/**
+ * @fn int flist_cursor_remove(struct flist_cursor *c, int force)
+ * @brief Removes element under cursor @p c and moves it to the next one
+ *
+ * The element is cleaned up as it would be by @a flist_free() called with
+ * @p force. Removing the last element of a list that has no more to force
+ * frees the list and sets the traversed pointer to NULL. Returns nonzero if
+ * the cursor stands on an element afterwards, zero otherwise.
+ *
+ * @param[in,out] c Target cursor
+ * @param[in] force Should protected element be cleaned up?
+ */
+int              flist_cursor_remove(struct flist_cursor *, int);
+
+/**
+ * @fn int flist_serialize(struct flist *l, const char *path,
+ *  size_t (*enc)(const void *x, void *buf, size_t size))
+ * @brief Writes elements of @p l to file @p path
+ *
+ * Every element is encoded by @p enc into a buffer @p buf of @p size bytes.
+ * It returns the length of the encoding, writing it only if it fits,
+ * otherwise it is called again with a larger buffer. Returning (size_t)-1
+ * aborts with errno as set by @p enc. NULL elements are stored without
+ * calling @p enc, encodings of length zero load as NULL as well. Lazy @p l is
+ * forced first.
+ *
+ * The file records a format version and a checksum, encodings are padded to
+ * 8 bytes so that loaded elements are aligned for any scalar type. Multibyte
+ * values are kept in native byte order, files are not portable across byte
+ * orders. Returns 0 on success, otherwise -1 with errno set and no file left
+ * behind.
+ *
+ * @param[in] l Source list
+ * @param[in] path Output file, replaced if it exists
+ * @param[in] enc Element encoder
+ * @see flist_mmap_open()
+ */
+int              flist_serialize(struct flist *, const char *,
+    size_t (*)(const void *, void *, size_t));
+
+/**
+ * @fn struct flist *flist_mmap_open(const char *path)
+ * @brief Maps list written by @a flist_serialize() to memory
+ *
+ * Elements of the new list point straight into read-only pages of the file,
+ * in the form given them by the encoder, and are neither copied nor owned by
+ * the list. Nodes are laid out in a single block, so opening takes one pass
+ * to verify the checksum and one to link the nodes, with no allocation per
+ * element. Apart from elements being read-only, the result is an ordinary
+ * list: it may be traversed, searched, folded and even modified.
+ *
+ * The mapping lives as long as any list holding its nodes, including lists
+ * split from this one or joined with it, and is released with the last of
+ * them. Elements referenced by other lists (copies, for instance) must not
+ * outlive it. Returns NULL on error, setting errno to EINVAL if the file is
+ * not a valid serialised list, its version is not supported or its checksum
+ * does not match, otherwise to the errno of the failed call.
+ *
+ * @param[in] path Input file
+ * @see flist_serialize()
+ */
+struct flist    *flist_mmap_open(const char *);
+
 /**
  * @fn void *flist_foldr(struct flist *l, void *x, void *(*f)(void *, void *))
  * @brief Folds the list from the right
@@ -332,6 +1218,87 @@ void            *flist_foldr(struct flist *, void *, void *(*)(void *, void *));
  */
 void            *flist_foldl(struct flist *, void *, void *(*)(void *, void *));
 
+/**
+ * @fn void flist_foldr_mut(struct flist *l, void *acc, void (*f)(void *,
+ *  void *))
+ * @brief Folds the list from the right into a caller-owned accumulator
+ *
+ * Calls @p f with each element of @p l, from the last one to the first, and
+ * @p acc. @p f is expected to update the accumulator in place, nothing is
+ * allocated or freed, neither by this subroutine nor on behalf of it, and
+ * @p acc stays owned by the caller. @p l is unmodified.
+ *
+ * @param[in] l Source list
+ * @param[in,out] acc Accumulator
+ * @param[in] f Folding function, takes element and accumulator
+ * @see flist_foldr()
+ */
+void             flist_foldr_mut(struct flist *, void *,
+    void (*)(void *, void *));
+
+/**
+ * @fn void flist_foldl_mut(struct flist *l, void *acc, void (*f)(void *,
+ *  void *))
+ * @brief Folds the list from the left into a caller-owned accumulator
+ *
+ * Analogous to @a flist_foldr_mut(), except that elements are visited from
+ * the first one and @p f takes the accumulator as its first argument. Lazy
+ * lists are forced one element at a time, as in @a flist_foldl().
+ *
+ * @param[in] l Source list
+ * @param[in,out] acc Accumulator
+ * @param[in] f Folding function, takes accumulator and element
+ */
+void             flist_foldl_mut(struct flist *, void *,
+    void (*)(void *, void *));
+
+/**
+ * @fn size_t flist_scanl(struct flist *l, void *acc, void (*f)(void *,
+ *  void *), void *out, size_t size)
+ * @brief Stores every intermediate state of a left fold in @p out
+ *
+ * Folds @p l as @a flist_foldl_mut() does, with @p acc pointing to an object
+ * of @p size bytes. Its initial value and its value after each step are copied
+ * to consecutive @p size byte cells of @p out, which has to have room for
+ * @a flist_length() + 1 of them. Returns the number of cells written.
+ *
+ * @param[in] l Source list
+ * @param[in,out] acc Accumulator
+ * @param[in] f Folding function, takes accumulator and element
+ * @param[out] out Target buffer
+ * @param[in] size Size of the accumulator
+ */
+size_t           flist_scanl(struct flist *, void *, void (*)(void *, void *),
+    void *, size_t);
+
+/**
+ * @fn void *flist_fold_assoc(struct flist *l, void *x, void *(*f)(void *,
+ *  void *), void *(*combine)(void *, void *))
+ * @brief Folds the list in parallel, assuming associativity
+ *
+ * The list is split into one segment per thread (see @a flist_set_threads()),
+ * each of which is folded from the left as in @a flist_foldl(), starting with
+ * @p x. Partial results are then merged pairwise with @p combine in a balanced
+ * tree. This gives the same result as @a flist_foldl() as long as @p f and
+ * @p combine are associative and @p x is their identity element. For a fixed
+ * number of threads the result is deterministic even if they are not.
+ *
+ * As in @a flist_foldl(), @p f and @p combine are expected to return
+ * heap-allocated data and intermediate results are freed with the cleanup
+ * handler of @p l. Both, as well as the cleanup handler, are called from
+ * multiple threads concurrently and have to be thread-safe. Returns @p x if
+ * the list is empty. If memory for the segments runs out, the list is folded by
+ * @a flist_foldl() alone.
+ *
+ * @param[in] l Source list
+ * @param[in] x Identity element
+ * @param[in] f Folding function
+ * @param[in] combine Function merging two partial results
+ * @see flist_foldl()
+ */
+void            *flist_fold_assoc(struct flist *, void *,
+    void *(*)(void *, void *), void *(*)(void *, void *));
+
 /**
  * @fn void flist_reverse(struct flist *l)
  * @brief Inverts order of elements in @p l
@@ -340,6 +1307,127 @@ void            *flist_foldl(struct flist *, void *, void *(*)(void *, void *));
  */
 void             flist_reverse(struct flist *);
 
+/**
+ * @fn void flist_sort(struct flist *l, int (*cmp)(const void *, const void *))
+ * @brief Sorts @p l in ascending order according to @p cmp
+ *
+ * The @p cmp is defined the same way as in @a flist_elem(), that is it is
+ * called with elements themselves rather than with pointers to them. Sort is
+ * stable and runs in O(n log n) time. It relinks existing nodes instead of
+ * moving elements around, so nothing gets allocated.
+ *
+ * @param[in] l Target list
+ * @param[in] cmp Comparison function
+ */
+void             flist_sort(struct flist *, int (*)(const void *, const void *));
+
+/**
+ * @fn int flist_sort_by_key(struct flist *l, long (*key)(const void *))
+ * @brief Sorts @p l in ascending order of integer keys assigned by @p key
+ *
+ * Uses LSD radix sort, which is stable and runs in linear time, calling @p key
+ * exactly once for every element. Unlike @a flist_sort() it needs a temporary
+ * buffer of four pointers per element, allocated with the allocator of @p l.
+ * Returns 0 on success and -1 if the buffer could not be allocated, in which
+ * case @p l is left unsorted.
+ *
+ * @param[in] l Target list
+ * @param[in] key Key extraction function
+ */
+int              flist_sort_by_key(struct flist *, long (*)(const void *));
+
+/**
+ * @fn void flist_nub(struct flist **lp, unsigned long (*hash)(const void *),
+ *  int (*eq)(const void *, const void *), int force)
+ * @brief Removes all but the first occurrence of every element of @p *lp
+ *
+ * Runs in O(n) expected time. Hashing and equality are defined as in
+ * @a flist_set_hash(). Removed elements are cleaned up just like in
+ * @a flist_filter().
+ *
+ * @param[in] lp Pointer to the target list
+ * @param[in] hash Hashing function
+ * @param[in] eq Equality predicate
+ * @param[in] force Same as in @a flist_free()
+ */
+void             flist_nub(struct flist **, unsigned long (*)(const void *),
+    int (*)(const void *, const void *), int);
+
+/**
+ * @fn struct flist *flist_group_by(struct flist *l, unsigned long
+ *  (*hash)(const void *), int (*eq)(const void *, const void *))
+ * @brief Groups equal elements of @p l together
+ *
+ * Returns a list of lists, one per distinct element, ordered by first
+ * occurrence. Each group keeps elements in their original order. Unlike
+ * Haskell's groupBy, equal elements end up in a single group even if they are
+ * not adjacent. Groups are shallow copies (see @a flist_copy()), so
+ * freeing the result with @a flist_free() releases the groups but never the
+ * elements. Runs in O(n) expected time.
+ *
+ * @param[in] l Source list
+ * @param[in] hash Hashing function
+ * @param[in] eq Equality predicate
+ */
+struct flist    *flist_group_by(struct flist *, unsigned long (*)(const void *),
+    int (*)(const void *, const void *));
+
+/**
+ * @fn struct flist *flist_intersect(struct flist *l1, struct flist *l2,
+ *  unsigned long (*hash)(const void *), int (*eq)(const void *, const void *))
+ * @brief Returns elements of @p l1 that also occur in @p l2
+ *
+ * Duplicates in @p l1 are preserved, just like in Haskell's intersect. The
+ * result is a shallow copy (see @a flist_copy()). Runs in O(n + m) expected
+ * time.
+ *
+ * @param[in] l1 First list
+ * @param[in] l2 Second list
+ * @param[in] hash Hashing function
+ * @param[in] eq Equality predicate
+ */
+struct flist    *flist_intersect(struct flist *, struct flist *,
+    unsigned long (*)(const void *), int (*)(const void *, const void *));
+
+/**
+ * @fn struct flist *flist_union(struct flist *l1, struct flist *l2, unsigned
+ *  long (*hash)(const void *), int (*eq)(const void *, const void *))
+ * @brief Returns @p l1 followed by distinct elements of @p l2 missing in @p l1
+ *
+ * Duplicates in @p l1 are preserved, just like in Haskell's union. The result
+ * is a shallow copy (see @a flist_copy()). Runs in O(n + m) expected time.
+ *
+ * @param[in] l1 First list
+ * @param[in] l2 Second list
+ * @param[in] hash Hashing function
+ * @param[in] eq Equality predicate
+ */
+struct flist    *flist_union(struct flist *, struct flist *,
+    unsigned long (*)(const void *), int (*)(const void *, const void *));
+
+/**
+ * @fn void flist_set_threads(unsigned n)
+ * @brief Set number of threads used by parallel subroutines
+ *
+ * Parallel subroutines (the ones with @a _par suffix) share a pool of worker
+ * threads started on first use. Passing zero selects number of online
+ * processors, which is also the default. Must not be called while a parallel
+ * subroutine is running. A parallel subroutine called while another one is
+ * already running (for example from within a callback) runs serially. So does
+ * one that runs out of memory for its bookkeeping, and if worker threads cannot
+ * be started the pool makes do with fewer of them.
+ *
+ * @param[in] n Number of threads, including the calling one
+ */
+void             flist_set_threads(unsigned);
+
+/**
+ * @fn unsigned flist_get_threads(void)
+ * @brief Return number of threads used by parallel subroutines
+ * @see flist_set_threads()
+ */
+unsigned         flist_get_threads(void);
+
 #ifdef _RM_POSIX_DECL
 # undef _POSIX_C_SOURCE
 #endif
@@ -0,0 +1,312 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @defgroup fnum fnum
+ * @ingroup fnum.h
+ * @ingroup fnum.c
+ *
+ * Unboxed numeric lists. Unlike @p flist, which stores pointers, @p fnum
+ * stores values of a single numeric type directly in contiguous, aligned
+ * chunks, which lets reductions, maps and filters run over them with vector
+ * instructions. AVX2 kernels are used when the library is built with AVX2
+ * enabled (e.g. by passing SIMD_FLAGS=-mavx2 to make), otherwise plain loops
+ * are used, leaving vectorization up to the compiler.
+ */
+
+/**
+ * @file
+ * @brief Header file for the @p fnum module
+ */
+
+#ifndef FNUM_H_INCLUDED
+#define FNUM_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _RM_POSIX_DECL
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "flist.h"
+
+#define FNUM_CHUNK_BYTES 16384 /**< @brief Size of a single chunk of values */
+
+/**
+ * @brief Type of values stored in a numeric list
+ */
+enum fnum_type {
+        FNUM_I32,                       /**< @brief int32_t */
+        FNUM_I64,                       /**< @brief int64_t */
+        FNUM_F32,                       /**< @brief float */
+        FNUM_F64                        /**< @brief double */
+};
+
+/**
+ * @brief Comparison used by @a fnum_count() and @a fnum_filter()
+ */
+enum fnum_cmp {
+        FNUM_LT,                        /**< @brief x < v */
+        FNUM_LE,                        /**< @brief x <= v */
+        FNUM_EQ,                        /**< @brief x == v */
+        FNUM_NE,                        /**< @brief x != v */
+        FNUM_GE,                        /**< @brief x >= v */
+        FNUM_GT                         /**< @brief x > v */
+};
+
+/**
+ * @brief A single numeric value
+ *
+ * Subroutines taking or returning values use the member matching type of the
+ * list, unless stated otherwise.
+ */
+union fnum_val {
+        int32_t      i32;               /**< @brief FNUM_I32 value */
+        int64_t      i64;               /**< @brief FNUM_I64 value */
+        float        f32;               /**< @brief FNUM_F32 value */
+        double       f64;               /**< @brief FNUM_F64 value */
+};
+
+struct fnum;
+
+/**
+ * @fn struct fnum *fnum_new(enum fnum_type type)
+ * @brief Creates new, empty numeric list of values of type @p type
+ *
+ * Returns NULL and sets errno to ENOMEM if allocation fails. So do other
+ * subroutines returning a list, while those returning an int return -1.
+ *
+ * @param[in] type Type of values
+ */
+struct fnum     *fnum_new(enum fnum_type);
+
+/**
+ * @fn void fnum_free(struct fnum **np)
+ * @brief Frees numeric list pointed to by @p np and sets it to NULL
+ *
+ * @param[in,out] np Pointer to the target list
+ */
+void             fnum_free(struct fnum **);
+
+/**
+ * @fn union fnum_val fnum_i32(int32_t x)
+ * @brief Wraps @p x in a @a fnum_val
+ */
+union fnum_val   fnum_i32(int32_t);
+
+/**
+ * @fn union fnum_val fnum_i64(int64_t x)
+ * @brief Wraps @p x in a @a fnum_val
+ */
+union fnum_val   fnum_i64(int64_t);
+
+/**
+ * @fn union fnum_val fnum_f32(float x)
+ * @brief Wraps @p x in a @a fnum_val
+ */
+union fnum_val   fnum_f32(float);
+
+/**
+ * @fn union fnum_val fnum_f64(double x)
+ * @brief Wraps @p x in a @a fnum_val
+ */
+union fnum_val   fnum_f64(double);
+
+/**
+ * @fn int fnum_append(struct fnum *n, union fnum_val x)
+ * @brief Appends value @p x to the list
+ *
+ * Returns 0 on success and -1 if memory runs out.
+ *
+ * @param[in] n Target list
+ * @param[in] x Value to append
+ */
+int              fnum_append(struct fnum *, union fnum_val);
+
+/**
+ * @fn int fnum_append_array(struct fnum *n, const void *arr, size_t cnt)
+ * @brief Appends @p cnt values stored in array @p arr to the list
+ *
+ * @p arr has to be an array of the type of the list. Returns 0 on success and
+ * -1 if memory runs out, in which case only some of the values may have been
+ * appended.
+ *
+ * @param[in] n Target list
+ * @param[in] arr Values to append
+ * @param[in] cnt Number of values
+ */
+int              fnum_append_array(struct fnum *, const void *, size_t);
+
+/**
+ * @fn size_t fnum_to_array(struct fnum *n, void *out)
+ * @brief Copies values of the list into array @p out
+ *
+ * Returns number of values copied.
+ *
+ * @param[in] n Source list
+ * @param[out] out Array of the type of the list, large enough
+ */
+size_t           fnum_to_array(struct fnum *, void *);
+
+/**
+ * @fn size_t fnum_length(struct fnum *n)
+ * @brief Return length of the list
+ *
+ * @param[in] n Target list
+ */
+size_t           fnum_length(struct fnum *);
+
+/**
+ * @fn enum fnum_type fnum_type(struct fnum *n)
+ * @brief Return type of values stored in the list
+ *
+ * @param[in] n Target list
+ */
+enum fnum_type   fnum_type(struct fnum *);
+
+/**
+ * @fn union fnum_val fnum_at(struct fnum *n, size_t i)
+ * @brief Returns @p i th value of the list
+ *
+ * Returns zero if the list is shorter than @p i.
+ *
+ * @param[in] n Source list
+ * @param[in] i Position
+ */
+union fnum_val   fnum_at(struct fnum *, size_t);
+
+/**
+ * @fn union fnum_val fnum_sum(struct fnum *n)
+ * @brief Returns sum of all values of the list
+ *
+ * To avoid overflow and loss of precision, sums are accumulated and returned
+ * as @a i64 for integer lists and as @a f64 for floating-point ones. Integer
+ * sums wrap around on overflow.
+ *
+ * @param[in] n Source list
+ */
+union fnum_val   fnum_sum(struct fnum *);
+
+/**
+ * @fn union fnum_val fnum_min(struct fnum *n)
+ * @brief Returns the smallest value of the list
+ *
+ * Returns zero for an empty list. Result is unspecified if the list contains
+ * NaNs.
+ *
+ * @param[in] n Source list
+ */
+union fnum_val   fnum_min(struct fnum *);
+
+/**
+ * @fn union fnum_val fnum_max(struct fnum *n)
+ * @brief Returns the greatest value of the list
+ * @see fnum_min()
+ */
+union fnum_val   fnum_max(struct fnum *);
+
+/**
+ * @fn size_t fnum_count(struct fnum *n, enum fnum_cmp cmp, union fnum_val v)
+ * @brief Counts values x of the list for which "x cmp v" holds
+ *
+ * @param[in] n Source list
+ * @param[in] cmp Comparison
+ * @param[in] v Value to compare with
+ */
+size_t           fnum_count(struct fnum *, enum fnum_cmp, union fnum_val);
+
+/**
+ * @fn int fnum_elem(struct fnum *n, union fnum_val v)
+ * @brief Verify whether @p v is an element of @p n
+ *
+ * @param[in] n Source list
+ * @param[in] v Value we are looking for
+ */
+int              fnum_elem(struct fnum *, union fnum_val);
+
+/**
+ * @fn void fnum_filter(struct fnum *n, enum fnum_cmp cmp, union fnum_val v)
+ * @brief Keeps only values x of the list for which "x cmp v" holds
+ *
+ * @param[in] n Target list
+ * @param[in] cmp Comparison
+ * @param[in] v Value to compare with
+ */
+void             fnum_filter(struct fnum *, enum fnum_cmp, union fnum_val);
+
+/**
+ * @fn void fnum_add(struct fnum *n, union fnum_val v)
+ * @brief Adds @p v to every value of the list
+ *
+ * Integer arithmetic wraps around on overflow.
+ *
+ * @param[in] n Target list
+ * @param[in] v Value to add
+ */
+void             fnum_add(struct fnum *, union fnum_val);
+
+/**
+ * @fn void fnum_mul(struct fnum *n, union fnum_val v)
+ * @brief Multiplies every value of the list by @p v
+ * @see fnum_add()
+ */
+void             fnum_mul(struct fnum *, union fnum_val);
+
+/**
+ * @fn void fnum_affine(struct fnum *n, union fnum_val a, union fnum_val b)
+ * @brief Replaces every value x of the list with a * x + b
+ * @see fnum_add()
+ */
+void             fnum_affine(struct fnum *, union fnum_val, union fnum_val);
+
+/**
+ * @fn struct fnum *fnum_from_flist(struct flist *l, enum fnum_type type)
+ * @brief Creates numeric list out of values pointed to by elements of @p l
+ *
+ * Every element of @p l has to point to a value of type @p type. @p l is left
+ * unmodified.
+ *
+ * @param[in] l Source list
+ * @param[in] type Type of values
+ */
+struct fnum     *fnum_from_flist(struct flist *, enum fnum_type);
+
+/**
+ * @fn struct flist *fnum_to_flist(struct fnum *n)
+ * @brief Creates @p flist of heap-allocated copies of values of @p n
+ *
+ * All elements of the new list have @a FLIST_CLEANABLE flag set. Returns NULL
+ * if @p n is empty, or if memory runs out.
+ *
+ * @param[in] n Source list
+ */
+struct flist    *fnum_to_flist(struct fnum *);
+
+#ifdef _RM_POSIX_DECL
+# undef _POSIX_C_SOURCE
+#endif
+
+#endif /* FNUM_H_INCLUDED */
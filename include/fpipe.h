@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @defgroup fpipe fpipe
+ * @ingroup fpipe.h
+ * @ingroup fpipe.c
+ *
+ * Lazy pipelines over @p flist. A pipeline records a chain of map, filter,
+ * take and drop stages and executes all of them in a single traversal of the
+ * source list, stopping as soon as no more elements can make it through.
+ */
+
+/**
+ * @file
+ * @brief Header file for the @p fpipe module
+ */
+
+#ifndef FPIPE_H_INCLUDED
+#define FPIPE_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _RM_POSIX_DECL
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+
+#include "flist.h"
+
+struct fpipe;
+
+/**
+ * @fn struct fpipe *fpipe_new(struct flist *src)
+ * @brief Creates an empty pipeline reading from @p src
+ *
+ * Source list is never modified by the pipeline, but it has to outlive it.
+ * Cleanup handler of the pipeline is initially that of @p src. The pipeline
+ * and its stages are allocated with the allocator of @p src, or the default
+ * one if @p src is NULL. Returns NULL and sets errno to ENOMEM if allocation
+ * fails.
+ *
+ * @param[in] src Source list, may be NULL (empty)
+ */
+struct fpipe    *fpipe_new(struct flist *);
+
+/**
+ * @fn void fpipe_free(struct fpipe **pp)
+ * @brief Frees pipeline pointed to by @p pp
+ *
+ * Neither the source list nor results of the pipeline are affected. Pipeline
+ * is then set to NULL.
+ *
+ * @param[in,out] pp Pointer to the target pipeline
+ */
+void             fpipe_free(struct fpipe **);
+
+/**
+ * @fn void fpipe_set_cleanup(struct fpipe *p, void (*handler)(void *))
+ * @brief Change cleanup handler of pipeline @p p
+ *
+ * The handler is used to free values produced by map stages that did not make
+ * it to the end of the pipeline as well as intermediate accumulators of
+ * @a fpipe_foldl(). It also becomes the cleanup handler of lists returned by
+ * @a fpipe_collect().
+ *
+ * @param[in] p Target pipeline
+ * @param[in] handler New cleanup handler
+ */
+void             fpipe_set_cleanup(struct fpipe *, void (*)(void *));
+
+/**
+ * @fn struct fpipe *fpipe_map(struct fpipe *p, void *(*f)(void *))
+ * @brief Appends a map stage to the pipeline
+ *
+ * As in @a flist_map(), if @p f returns NULL or its argument, element is passed
+ * on unchanged. Otherwise @p f is expected to return heap-allocated data, which
+ * is owned by the pipeline until it reaches its end. Returns @p p.
+ *
+ * Stages are added by the subroutines below in the same way. Any of them may
+ * be passed NULL, which is then returned. If a stage cannot be allocated, the
+ * pipeline fails whenever run.
+ *
+ * @param[in] p Target pipeline
+ * @param[in] f Function to apply
+ * @see flist_map()
+ */
+struct fpipe    *fpipe_map(struct fpipe *, void *(*)(void *));
+
+/**
+ * @fn struct fpipe *fpipe_filter(struct fpipe *p, int (*f)(void *))
+ * @brief Appends a filter stage to the pipeline
+ *
+ * Only elements satisfying @p f are passed on. Returns @p p.
+ *
+ * @param[in] p Target pipeline
+ * @param[in] f Predicate
+ * @see flist_filter()
+ */
+struct fpipe    *fpipe_filter(struct fpipe *, int (*)(void *));
+
+/**
+ * @fn struct fpipe *fpipe_take(struct fpipe *p, int n)
+ * @brief Appends a take stage to the pipeline
+ *
+ * Only first @p n elements reaching the stage are passed on. Once all of them
+ * went through, traversal of the source list stops, so pipelines reading from
+ * infinite lazy lists terminate as long as they contain a take stage. Returns
+ * @p p.
+ *
+ * @param[in] p Target pipeline
+ * @param[in] n Number of elements to take
+ * @see flist_take()
+ */
+struct fpipe    *fpipe_take(struct fpipe *, int);
+
+/**
+ * @fn struct fpipe *fpipe_drop(struct fpipe *p, int n)
+ * @brief Appends a drop stage to the pipeline
+ *
+ * First @p n elements reaching the stage are discarded. Returns @p p.
+ *
+ * @param[in] p Target pipeline
+ * @param[in] n Number of elements to drop
+ * @see flist_drop()
+ */
+struct fpipe    *fpipe_drop(struct fpipe *, int);
+
+/**
+ * @fn struct flist *fpipe_collect(struct fpipe *p)
+ * @brief Runs the pipeline and gathers its output in a new list
+ *
+ * Elements produced by map stages are stored with @a FLIST_CLEANABLE flag,
+ * elements coming straight from the source list are stored as in a shallow
+ * copy made by @a flist_copy(). Returns NULL if nothing made it through. The
+ * pipeline itself may be run again afterwards. If memory runs out, values
+ * produced so far are released, NULL is returned and errno is set to ENOMEM.
+ *
+ * @param[in] p Pipeline to run
+ * @see flist_copy()
+ */
+struct flist    *fpipe_collect(struct fpipe *);
+
+/**
+ * @fn void *fpipe_foldl(struct fpipe *p, void *x, void *(*f)(void *, void *))
+ * @brief Runs the pipeline and folds its output from the left
+ *
+ * Behaves as @a flist_foldl() called on the list @a fpipe_collect() would
+ * return, without ever building it. Values produced by map stages are freed
+ * right after being folded. If memory runs out, the partial result is freed,
+ * NULL is returned and errno is set to ENOMEM.
+ *
+ * @param[in] p Pipeline to run
+ * @param[in] x Starting element
+ * @param[in] f Folding function
+ * @see flist_foldl()
+ */
+void            *fpipe_foldl(struct fpipe *, void *,
+    void *(*)(void *, void *));
+
+#ifdef _RM_POSIX_DECL
+# undef _POSIX_C_SOURCE
+#endif
+
+#endif /* FPIPE_H_INCLUDED */
@@ -0,0 +1,257 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @defgroup fplist fplist
+ * @ingroup fplist.h
+ * @ingroup fplist.c
+ *
+ * Persistent variant of the @p flist module. Lists are never modified in
+ * place: every subroutine returns a new version and leaves its arguments
+ * intact, so there is no need to copy a list before deriving another one from
+ * it. Versions share their nodes the same way Haskell lists do. Nodes are
+ * reference counted and released (together with elements they own) once the
+ * last version using them is freed.
+ *
+ * Every version is a separate handle that has to be freed with
+ * @a fplist_free(), just like any @p flist. NULL stands for the empty list.
+ * Inflags keep their @p flist meaning: element is owned by the node it was
+ * added with and is cleaned up (or not) according to its flags when that node
+ * is released. Versions derived from a list inherit its cleanup handler, the
+ * handler of the version dropping the last reference is used.
+ *
+ * Reference counts are not atomic, versions sharing nodes must not be used
+ * from multiple threads at once.
+ */
+
+/**
+ * @file
+ * @brief Header file for the @p fplist module
+ */
+
+#ifndef FPLIST_H_INCLUDED
+#define FPLIST_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _RM_POSIX_DECL
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flist.h"
+
+struct fplist;
+struct fplist_builder;
+
+/**
+ * @fn struct fplist *fplist_prepend(struct fplist *l, void *dat, unsigned
+ *  flags)
+ * @brief Returns @p l with @p dat prepended, sharing all nodes of @p l
+ *
+ * Runs in O(1) time. If allocation fails, NULL is returned and errno is set
+ * to ENOMEM, which holds for all subroutines returning a list. Since the empty
+ * list is NULL as well, errno tells the two apart.
+ *
+ * @param[in] l Source list
+ * @param[in] dat Data to insert
+ * @param[in] flags Flags as defined in @a flist_append()
+ */
+struct fplist   *fplist_prepend(struct fplist *, void *, unsigned);
+
+/**
+ * @fn struct fplist *fplist_dup(struct fplist *l)
+ * @brief Returns new handle to the very same version as @p l
+ *
+ * Runs in O(1) time. Useful when two owners need to free the list
+ * independently.
+ *
+ * @param[in] l Source list
+ */
+struct fplist   *fplist_dup(struct fplist *);
+
+/**
+ * @fn void fplist_free(struct fplist **lp, int force)
+ * @brief Frees version pointed to by @p lp
+ *
+ * Nodes no longer used by any other version are released, elements they own
+ * are cleaned up as described in @a flist_free().
+ *
+ * @param[in,out] lp Pointer to the target list
+ * @param[in] force Same as in @a flist_free()
+ */
+void             fplist_free(struct fplist **, int);
+
+/**
+ * @fn void fplist_set_cleanup(struct fplist *l, void (*handler)(void *))
+ * @brief Change cleanup handler of version @p l
+ * @see flist_set_cleanup()
+ */
+void             fplist_set_cleanup(struct fplist *, void (*)(void *));
+
+/**
+ * @fn struct fplist_builder *fplist_builder_new(void)
+ * @brief Creates a transient builder of a list
+ *
+ * Builder appends elements in O(1) time by mutating its nodes, which is safe
+ * as long as they are not shared. Once finished it turns into an ordinary,
+ * persistent list. Returns NULL if allocation fails.
+ */
+struct fplist_builder *fplist_builder_new(void);
+
+/**
+ * @fn int fplist_builder_append(struct fplist_builder *b, void *dat, unsigned
+ *  flags)
+ * @brief Appends @p dat to list being built by @p b
+ *
+ * Returns 0 on success and -1 if allocation fails, leaving @p b intact.
+ *
+ * @see flist_append()
+ */
+int              fplist_builder_append(struct fplist_builder *, void *,
+    unsigned);
+
+/**
+ * @fn struct fplist *fplist_builder_finish(struct fplist_builder *b)
+ * @brief Frees builder @p b and returns the list it has built
+ *
+ * If allocation fails, elements appended to @p b are released as
+ * @a fplist_free() would release them without force.
+ */
+struct fplist   *fplist_builder_finish(struct fplist_builder *);
+
+/**
+ * @fn struct fplist *fplist_from_flist(struct flist *l)
+ * @brief Builds persistent list with elements of @p l
+ *
+ * Elements are shared with @p l the same way a shallow @a flist_copy() shares
+ * them, so @p l has to outlive elements it owns.
+ *
+ * @param[in] l Source list
+ */
+struct fplist   *fplist_from_flist(struct flist *);
+
+/**
+ * @fn struct flist *fplist_to_flist(struct fplist *l)
+ * @brief Builds @p flist with elements of @p l
+ *
+ * Elements are shared with @p l the same way a shallow @a flist_copy() shares
+ * them, so @p l has to outlive the result.
+ *
+ * @param[in] l Source list
+ */
+struct flist    *fplist_to_flist(struct fplist *);
+
+/**
+ * @fn void *fplist_val_head(struct fplist *l)
+ * @brief Returns data stored in the head of @p l
+ * @see flist_val_head()
+ */
+void            *fplist_val_head(struct fplist *);
+
+/**
+ * @fn void *fplist_val_at_i(struct fplist *l, size_t i)
+ * @brief Returns data stored in the @p i th node of @p l, or NULL
+ */
+void            *fplist_val_at_i(struct fplist *, size_t);
+
+/**
+ * @fn size_t fplist_length(struct fplist *l)
+ * @brief Returns length of @p l in O(1) time
+ */
+size_t           fplist_length(struct fplist *);
+
+/**
+ * @fn struct fplist *fplist_tail(struct fplist *l)
+ * @brief Returns @p l without its head, sharing all remaining nodes
+ *
+ * Runs in O(1) time.
+ *
+ * @param[in] l Source list
+ */
+struct fplist   *fplist_tail(struct fplist *);
+
+/**
+ * @fn struct fplist *fplist_take(struct fplist *l, size_t n)
+ * @brief Returns first @p n elements of @p l, sharing all their nodes
+ *
+ * Runs in O(1) time. Nodes past the @p n th one stay alive for as long as the
+ * result does.
+ *
+ * @param[in] l Source list
+ * @param[in] n Number of elements to keep
+ */
+struct fplist   *fplist_take(struct fplist *, size_t);
+
+/**
+ * @fn struct fplist *fplist_drop(struct fplist *l, size_t n)
+ * @brief Returns @p l without its first @p n elements, sharing the rest
+ *
+ * Runs in O(n) time and allocates nothing but the handle.
+ *
+ * @param[in] l Source list
+ * @param[in] n Number of elements to drop
+ */
+struct fplist   *fplist_drop(struct fplist *, size_t);
+
+/**
+ * @fn struct fplist *fplist_map(struct fplist *l, void *(*f)(void *))
+ * @brief Returns list of results of applying @p f to elements of @p l
+ *
+ * Results different from their arguments are owned by the new list, just
+ * like after @a flist_map(). Results equal to their arguments are shared with
+ * @p l.
+ *
+ * @param[in] l Source list
+ * @param[in] f Function to apply
+ */
+struct fplist   *fplist_map(struct fplist *, void *(*)(void *));
+
+/**
+ * @fn struct fplist *fplist_filter(struct fplist *l, int (*f)(void *))
+ * @brief Returns list of elements of @p l satisfying @p f
+ *
+ * Longest suffix of @p l whose elements all satisfy @p f is shared, only the
+ * nodes preceding it are allocated anew.
+ *
+ * @param[in] l Source list
+ * @param[in] f Predicate
+ */
+struct fplist   *fplist_filter(struct fplist *, int (*)(void *));
+
+/**
+ * @fn void *fplist_foldl(struct fplist *l, void *x, void *(*f)(void *, void *))
+ * @brief Left-associative fold of @p l
+ * @see flist_foldl()
+ */
+void            *fplist_foldl(struct fplist *, void *,
+    void *(*)(void *, void *));
+
+#ifdef _RM_POSIX_DECL
+# undef _POSIX_C_SOURCE
+#endif
+
+#endif /* FPLIST_H_INCLUDED */
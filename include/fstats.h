@@ -0,0 +1,126 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @defgroup fstats fstats
+ * @ingroup fstats.h
+ * @ingroup fstats.c
+ *
+ * Optional instrumentation of the @p flist and @p ftuple modules. Counting is
+ * compiled in only when the library is built with @p FUNCC_STATS defined (for
+ * example with make DEFS=-DFUNCC_STATS), otherwise instrumentation points
+ * compile to nothing and @a flist_stats_get() reports all zeros.
+ *
+ * Every thread counts into its own block, so counters are not contended.
+ * Blocks are summed up on query, blocks of threads that have exited are kept
+ * folded into a common total. Counting takes no locks, so under concurrency
+ * counts are approximate: threads that could not allocate a block of their own
+ * share a spare one, and @a flist_stats_reset() may lose increments made
+ * while it runs.
+ */
+
+/**
+ * @file
+ * @brief Header file for the @p fstats module
+ */
+
+#ifndef FSTATS_H_INCLUDED
+#define FSTATS_H_INCLUDED
+
+#include <stdlib.h>
+
+#define FLIST_STATS_BUCKETS 32 /**< @brief Buckets of latency histograms */
+
+/**
+ * @brief Operations with latency histograms
+ *
+ * Parallel variants are recorded together with sequential ones, folds include
+ * @a flist_foldl(), @a flist_foldr(), their in-place variants,
+ * @a flist_fold_assoc() and @a flist_scanl(), sorts include both
+ * @a flist_sort() and @a flist_sort_by_key().
+ */
+enum flist_stats_op {
+        FLIST_OP_APPEND,                /**< @brief flist_append() */
+        FLIST_OP_PREPEND,               /**< @brief flist_prepend() */
+        FLIST_OP_FROM_ARRAY,            /**< @brief flist_from_array() */
+        FLIST_OP_COPY,                  /**< @brief flist_copy() */
+        FLIST_OP_FREE,                  /**< @brief flist_free() */
+        FLIST_OP_MAP,                   /**< @brief flist_map() */
+        FLIST_OP_FILTER,                /**< @brief flist_filter() */
+        FLIST_OP_TAKE,                  /**< @brief flist_take() */
+        FLIST_OP_DROP,                  /**< @brief flist_drop() */
+        FLIST_OP_FOLD,                  /**< @brief Folds */
+        FLIST_OP_SORT,                  /**< @brief Sorts */
+        FLIST_OP_VAL_AT,                /**< @brief flist_val_at_i() */
+        FLIST_OP_TUPLE_CREATE,          /**< @brief ftuple_create() */
+        FLIST_OP_TUPLE_FREE,            /**< @brief ftuple_free() */
+        FLIST_OP_COUNT                  /**< @brief Number of operations */
+};
+
+/**
+ * @brief Snapshot of instrumentation counters
+ *
+ * Bucket i of a latency histogram counts calls that took from 2^i up to (but
+ * excluding) 2^(i + 1) nanoseconds, the first and the last buckets also count
+ * everything below and above, respectively. Calls made from within other
+ * instrumented calls are recorded as well.
+ */
+struct flist_stats {
+        int          enabled;           /**< @brief Built with FUNCC_STATS? */
+
+        unsigned long node_allocs;      /**< @brief List nodes created */
+        unsigned long node_frees;       /**< @brief List nodes released */
+        unsigned long tuple_allocs;     /**< @brief Tuples created */
+        unsigned long tuple_frees;      /**< @brief Tuples released */
+        unsigned long traversed;        /**< @brief Nodes visited */
+        unsigned long callbacks;        /**< @brief Callbacks invoked */
+        unsigned long cleanups;         /**< @brief Cleanup handler calls */
+        long         bytes_held;        /**< @brief Bytes of nodes and tuples */
+
+        unsigned long latency[FLIST_OP_COUNT][FLIST_STATS_BUCKETS];
+                                        /**< @brief Latency histograms */
+};
+
+/**
+ * @fn void flist_stats_get(struct flist_stats *out)
+ * @brief Stores sum of counters of all threads in @p out
+ *
+ * Counters of threads running concurrently with the call may be slightly out
+ * of date.
+ *
+ * @param[out] out Target snapshot
+ */
+void             flist_stats_get(struct flist_stats *);
+
+/**
+ * @fn void flist_stats_reset(void)
+ * @brief Zeroes counters of all threads
+ *
+ * Since @a bytes_held is reset too, it may go negative afterwards. Blocks of
+ * other threads are zeroed while they may be counting into them, so some of
+ * their increments may survive the reset and others may get lost.
+ */
+void             flist_stats_reset(void);
+
+#endif /* FSTATS_H_INCLUDED */
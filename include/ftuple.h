@@ -46,19 +46,91 @@
 #include <stdlib.h>
 #include <stdarg.h>
 
+#include "falloc.h"
+
 struct ftuple;
+struct ftuple_pool;
 
 /**
  * @fn struct ftuple *ftuple_create(size_t dim, ...)
  * @brief Join @p dim elements into a tuple
  *
- * Returns NULL on error.
+ * Tuple is allocated with the default allocator. Returns NULL on error, setting
+ * errno to ENOMEM if allocation failed.
  *
  * @param[in] dim Size of the tuple
  * @param[in] ... Conseccutive elements of the tuple
+ * @see falloc_set_default()
  */
 struct ftuple   *ftuple_create(size_t, ...);
 
+/**
+ * @fn struct ftuple *ftuple_create_with(const struct falloc *a, size_t dim,
+ *  ...)
+ * @brief Variant of @a ftuple_create() using allocator @p a
+ *
+ * The tuple keeps a pointer to the allocator and later uses it to free the
+ * tuple, so @p a has to outlive it. Passing NULL as @p a selects the default
+ * allocator.
+ *
+ * @param[in] a Allocator
+ * @param[in] dim Size of the tuple
+ * @param[in] ... Conseccutive elements of the tuple
+ */
+struct ftuple   *ftuple_create_with(const struct falloc *, size_t, ...);
+
+/**
+ * @fn struct ftuple *ftuple_create_from_array(size_t dim, void **elems)
+ * @brief Variant of @a ftuple_create() taking elements from an array
+ *
+ * Copies @p dim pointers from @p elems, or sets all elements to NULL if
+ * @p elems is NULL. Returns NULL on error, setting errno to ENOMEM if the
+ * allocation failed.
+ *
+ * @param[in] dim Size of the tuple
+ * @param[in] elems Elements of the tuple
+ */
+struct ftuple   *ftuple_create_from_array(size_t, void **);
+
+/**
+ * @brief Number of pointers in a buffer large enough for @a ftuple_init()
+ *
+ * Usable in constant expressions, e.g. to declare a buffer on the stack:
+ * `void *buf[FTUPLE_BUFLEN(2)];`.
+ *
+ * @param[in] dim Size of the tuple
+ */
+#define FTUPLE_BUFLEN(dim)                                          \
+        ((sizeof(size_t) + sizeof(struct falloc *) + sizeof(void *) - 1) \
+        / sizeof(void *) + (dim))
+
+/**
+ * @fn size_t ftuple_size(size_t dim)
+ * @brief Number of bytes taken by a tuple of @p dim elements
+ *
+ * @param[in] dim Size of the tuple
+ */
+size_t           ftuple_size(size_t);
+
+/**
+ * @fn struct ftuple *ftuple_init(void *buf, size_t size, size_t dim,
+ *  void **elems)
+ * @brief Builds a tuple in memory provided by the caller
+ *
+ * Nothing is allocated, the tuple is valid for as long as @p buf is. Passing
+ * it to @a ftuple_free() only clears the pointer. @p buf has to be aligned
+ * for pointers. Elements are taken as in @a ftuple_create_from_array().
+ * Returns NULL and sets errno to EINVAL if @p dim is less than 2 or @p size
+ * is less than @a ftuple_size() of @p dim.
+ *
+ * @param[out] buf Memory to hold the tuple
+ * @param[in] size Size of @p buf in bytes
+ * @param[in] dim Size of the tuple
+ * @param[in] elems Elements of the tuple
+ * @see FTUPLE_BUFLEN
+ */
+struct ftuple   *ftuple_init(void *, size_t, size_t, void **);
+
 /**
  * @fn void ftuple_free(struct ftuple **tp)
  * @brief Free tuple structure
@@ -106,6 +178,39 @@ void            *ftuple_snd(struct ftuple *);
  */
 void            *ftuple_nth(struct ftuple *, size_t);
 
+/**
+ * @fn struct ftuple_pool *ftuple_pool_create(size_t per_slab)
+ * @brief Creates a pool of pairs and triples
+ *
+ * The pool carves tuples of dimension 2 and 3 from slabs of @p per_slab
+ * tuples and keeps freed ones for reuse, it never returns memory until
+ * destroyed. Tuples are drawn from it by passing @a ftuple_pool_falloc() to
+ * @a ftuple_create_with(), larger tuples then fall back to the default
+ * allocator. The pool may be used from multiple threads. Returns NULL on
+ * error, setting errno.
+ *
+ * @param[in] per_slab Number of tuples allocated at once, 0 picks a default
+ */
+struct ftuple_pool *ftuple_pool_create(size_t);
+
+/**
+ * @fn const struct falloc *ftuple_pool_falloc(struct ftuple_pool *p)
+ * @brief Returns allocator drawing tuples from @p p
+ *
+ * @param[in] p Source pool
+ */
+const struct falloc *ftuple_pool_falloc(struct ftuple_pool *);
+
+/**
+ * @fn void ftuple_pool_destroy(struct ftuple_pool **pp)
+ * @brief Frees the pool along with all of its slabs
+ *
+ * Tuples drawn from the pool and not yet freed become invalid.
+ *
+ * @param[in,out] pp Pointer to the target pool
+ */
+void             ftuple_pool_destroy(struct ftuple_pool **);
+
 #ifdef _RM_POSIX_DECL
 # undef _POSIX_C_SOURCE
 #endif
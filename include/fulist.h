@@ -0,0 +1,213 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 https://github.com/duszku
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @defgroup fulist fulist
+ * @ingroup fulist.h
+ * @ingroup fulist.c
+ *
+ * Unrolled variant of the @p flist module. Every node stores a small array of
+ * elements instead of a single one, which makes traversals considerably more
+ * cache-friendly. Interface and semantics (including inflags and cleanup
+ * handlers) mirror those of @p flist, refer to its documentation for details.
+ *
+ * It is a separate type rather than a layout of `struct flist`: lists only
+ * get the unrolled layout once callers switch to it, while @p flist keeps one
+ * element per node and none of its subroutines get faster. Only the subset of
+ * @p flist below is provided.
+ *
+ * Lists are allocated with the default allocator unless created with
+ * @a fulist_create(). Running out of memory is reported the way @p flist
+ * does.
+ */
+
+/**
+ * @file
+ * @brief Header file for the @p fulist module
+ */
+
+#ifndef FULIST_H_INCLUDED
+#define FULIST_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _RM_POSIX_DECL
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flist.h"
+
+#define FULIST_CHUNK 13 /**< @brief Number of elements stored per node */
+
+struct fulist;
+
+/**
+ * @fn struct fulist *fulist_append(struct fulist *l, void *dat, unsigned flags)
+ * @brief Appends element to a list
+ * @see flist_append()
+ */
+struct fulist   *fulist_append(struct fulist *, void *, unsigned);
+
+/**
+ * @fn struct fulist *fulist_create(const struct falloc *a)
+ * @brief Creates an empty list whose structure and nodes are allocated with
+ * @p a
+ * @see flist_create()
+ */
+struct fulist   *fulist_create(const struct falloc *);
+
+/**
+ * @fn struct fulist *fulist_prepend(struct fulist *l, void *dat, unsigned
+ *  flags)
+ * @brief Prepends element to a list
+ * @see flist_prepend()
+ */
+struct fulist   *fulist_prepend(struct fulist *, void *, unsigned);
+
+/**
+ * @fn void fulist_free(struct fulist **lp, int force)
+ * @brief Frees list pointed to by @p lp
+ * @see flist_free()
+ */
+void             fulist_free(struct fulist **, int);
+
+/**
+ * @fn void fulist_set_cleanup(struct fulist *l, void (*handler)(void *))
+ * @brief Change cleanup handler for list @p l
+ * @see flist_set_cleanup()
+ */
+void             fulist_set_cleanup(struct fulist *, void (*)(void *));
+
+/**
+ * @fn void *fulist_val_at_i(struct fulist *l, int i)
+ * @brief Returns data stored at position @p i of the list
+ *
+ * Skips whole nodes at a time, so it is roughly @a FULIST_CHUNK times faster
+ * than @a flist_val_at_i().
+ *
+ * @see flist_val_at_i()
+ */
+void            *fulist_val_at_i(struct fulist *, int);
+
+/**
+ * @fn size_t fulist_length(struct fulist *l)
+ * @brief Return length of the list
+ * @see flist_length()
+ */
+size_t           fulist_length(struct fulist *);
+
+/**
+ * @fn void fulist_map(struct fulist *l, void *(*f)(void *), int force)
+ * @brief Apply @p f with all elements of @p l and put the result in place of
+ * the arguments.
+ * @see flist_map()
+ */
+void             fulist_map(struct fulist *, void *(*)(void *), int);
+
+/**
+ * @fn void *fulist_find(struct fulist *l, int (*f)(void *))
+ * @brief Find first element satisfying predicate @p f
+ * @see flist_find()
+ */
+void            *fulist_find(struct fulist *, int (*)(void *));
+
+/**
+ * @fn int fulist_elem(struct fulist *l, int (*cmp)(const void *, const void *),
+ *  const void *x)
+ * @brief Verify whether @p x is an element of @p l
+ * @see flist_elem()
+ */
+int              fulist_elem(struct fulist *,
+    int (*)(const void *, const void *), const void *);
+
+/**
+ * @fn int fulist_any(struct fulist *l, int (*f)(void *))
+ * @brief Verify whether any element of @p l satisfies predicate @p f
+ * @see flist_any()
+ */
+int              fulist_any(struct fulist *, int (*)(void *));
+
+/**
+ * @fn int fulist_all(struct fulist *l, int (*f)(void *))
+ * @brief Verify whether all elements of @p l satisfy predicate @p f
+ * @see flist_all()
+ */
+int              fulist_all(struct fulist *, int (*)(void *));
+
+/**
+ * @fn void fulist_filter(struct fulist **lp, int (*f)(void *), int force)
+ * @brief Filter out elements of @p l that do not satisfy predicate @p f
+ *
+ * Surviving elements are packed into as few nodes as possible, so the list
+ * does not degrade into sparsely populated nodes after repeated filtering.
+ *
+ * @see flist_filter()
+ */
+void             fulist_filter(struct fulist **, int (*)(void *), int);
+
+/**
+ * @fn void fulist_take(struct fulist **lp, int n, int force)
+ * @brief Truncate the list to a given size
+ * @see flist_take()
+ */
+void             fulist_take(struct fulist **, int, int);
+
+/**
+ * @fn void fulist_drop(struct fulist **lp, int n, int force)
+ * @brief Remove first @p n elements from @p l
+ * @see flist_drop()
+ */
+void             fulist_drop(struct fulist **, int, int);
+
+/**
+ * @fn void *fulist_foldr(struct fulist *l, void *x, void *(*f)(void *, void *))
+ * @brief Folds the list from the right
+ * @see flist_foldr()
+ */
+void            *fulist_foldr(struct fulist *, void *,
+    void *(*)(void *, void *));
+
+/**
+ * @fn void *fulist_foldl(struct fulist *l, void *x, void *(*f)(void *, void *))
+ * @brief Folds the list from the left
+ * @see flist_foldl()
+ */
+void            *fulist_foldl(struct fulist *, void *,
+    void *(*)(void *, void *));
+
+/**
+ * @fn void fulist_reverse(struct fulist *l)
+ * @brief Inverts order of elements in @p l
+ * @see flist_reverse()
+ */
+void             fulist_reverse(struct fulist *);
+
+#ifdef _RM_POSIX_DECL
+# undef _POSIX_C_SOURCE
+#endif
+
+#endif /* FULIST_H_INCLUDED */
@@ -0,0 +1,168 @@
+/*
+ * Node arenas: reuse of removed nodes, cleanup and release of slabs, sharing
+ * between split lists and merging on concatenation.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+
+#define N 64
+
+static int       vals[2 * N];
+
+/**
+ * @fn static struct flist *make(size_t slab, size_t n)
+ * @brief Builds an arena list of first @p n elements of @a vals
+ */
+static struct flist     *make(size_t, size_t);
+
+/**
+ * @fn static void reuse(void)
+ * @brief Removed nodes are reused before new slabs are allocated
+ */
+static void              reuse(void);
+
+/**
+ * @fn static void cleanup(void)
+ * @brief Elements are cleaned up according to their inflags
+ */
+static void              cleanup(void);
+
+/**
+ * @fn static void shared(void)
+ * @brief Lists split from an arena list keep it alive until the last is freed
+ */
+static void              shared(void);
+
+int
+main(void)
+{
+        size_t   i;
+
+        for (i = 0; i < 2 * N; ++i)
+                vals[i] = (int)i;
+
+        reuse();
+        cleanup();
+        shared();
+
+        CHECK(test_count.bytes == 0);
+        CHECK(test_count.allocs == test_count.frees);
+
+        return test_done("arena");
+}
+
+struct flist *
+make(size_t slab, size_t n)
+{
+        struct   flist *ret;
+        size_t   i;
+
+        if ((ret = flist_create(&test_falloc)) == NULL)
+                return NULL;
+
+        flist_set_arena(ret, slab);
+        for (i = 0; i < n; ++i)
+                ret = flist_append(ret, &vals[i], FLIST_DONTCLEAN);
+
+        return ret;
+}
+
+void
+reuse(void)
+{
+        struct   flist *l;
+        size_t   allocs, i;
+
+        l      = make(16, N);
+        allocs = test_count.allocs;
+
+        flist_take(&l, N / 4, 0);
+        CHECK(flist_length(l) == N / 4);
+
+        for (i = N / 4; i < N; ++i)
+                l = flist_append(l, &vals[i], FLIST_DONTCLEAN);
+        CHECK(test_count.allocs == allocs);
+
+        flist_drop(&l, N / 2, 0);
+        flist_filter(&l, test_odd, 0);
+        CHECK(flist_length(l) == N / 4);
+        CHECK(*(int *)flist_val_head(l) == N / 2 + 1);
+
+        for (i = 0; i < N / 4 * 3; ++i)
+                l = flist_prepend(l, &vals[i], FLIST_DONTCLEAN);
+        CHECK(test_count.allocs == allocs);
+        CHECK(flist_length(l) == N);
+        CHECK(*(int *)flist_val_at_i(l, N / 4 * 3 - 1) == 0);
+        CHECK(*(int *)flist_val_at_i(l, N - 1) == N - 1);
+
+        /* no more room, only now a slab is added */
+        l = flist_append(l, &vals[N], FLIST_DONTCLEAN);
+        CHECK(test_count.allocs == allocs + 1);
+
+        flist_free(&l, 0);
+        CHECK(l == NULL);
+}
+
+void
+cleanup(void)
+{
+        struct   flist *l;
+        int     *p[N];
+        size_t   i;
+
+        l = make(8, 0);
+        flist_set_cleanup(l, test_cleanup);
+
+        for (i = 0; i < N; ++i) {
+                if ((p[i] = malloc(sizeof(int))) == NULL)
+                        return;
+                *p[i] = (int)i;
+                l = flist_append(l, p[i], i % 2 == 0 ? FLIST_CLEANABLE
+                    : FLIST_CLEANABLE | FLIST_CLEANPROT);
+        }
+        l = flist_append(l, &vals[0], FLIST_DONTCLEAN);
+
+        test_cleaned = 0;
+        flist_take(&l, N / 2, 0);
+        CHECK(test_cleaned == N / 4);
+
+        /* protected elements removed without force are left to the caller */
+        for (i = N / 2 + 1; i < N; i += 2)
+                test_cleanup(p[i]);
+
+        flist_free(&l, 1);
+        CHECK(test_cleaned == N);
+}
+
+void
+shared(void)
+{
+        struct   ftuple *t;
+        struct   flist *l, *a, *b;
+
+        l = make(16, N);
+        if ((t = flist_partition(&l, test_odd)) == NULL) {
+                CHECK(t != NULL);
+                return;
+        }
+
+        a = ftuple_fst(t);
+        b = ftuple_snd(t);
+        ftuple_free(&t);
+        CHECK(flist_length(a) == N / 2 && flist_length(b) == N / 2);
+
+        flist_free(&a, 0);
+        CHECK(flist_length(b) == N / 2);
+        CHECK(*(int *)flist_val_at_i(b, N / 2 - 1) == N - 2);
+
+        a = make(4, N / 2);
+        b = flist_concat(b, &a);
+        CHECK(a == NULL);
+        CHECK(flist_length(b) == N);
+        CHECK(*(int *)flist_val_at_i(b, N / 2 - 1) == N - 2);
+        CHECK(*(int *)flist_val_at_i(b, N - 1) == N / 2 - 1);
+
+        flist_free(&b, 0);
+}
@@ -0,0 +1,256 @@
+/*
+ * Arrays: flist_from_array() builds what as many flist_append() calls would,
+ * inflags and ownership of elements included, and flist_to_array() gives the
+ * elements back, forcing lazy lists. Zero counts and failures change nothing.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "flist.h"
+
+#define N 100
+
+static int       vals[N];       /* element i is i */
+static void     *arr[N];
+static void     *out[2 * N + 2];
+static size_t    calls;         /* elements generated so far */
+
+/**
+ * @fn static unsigned long hash(const void *p)
+ * @brief Hashing function of integers
+ */
+static unsigned long     hash(const void *);
+
+/**
+ * @fn static int eq(const void *a, const void *b)
+ * @brief Are integers pointed to by @p a and @p b equal?
+ */
+static int               eq(const void *, const void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding elements of @a vals from @p seed on
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static void dup_all(size_t n)
+ * @brief Fills @a arr with copies of first @p n elements of @a vals
+ */
+static void              dup_all(size_t);
+
+/**
+ * @fn static void round_trip(size_t n)
+ * @brief Elements of @p n element arrays come back out as they went in
+ */
+static void              round_trip(size_t);
+
+/**
+ * @fn static void owned(void)
+ * @brief Elements are cleaned up as their inflags say
+ */
+static void              owned(void);
+
+/**
+ * @fn static void lazy(void)
+ * @brief Lazy lists are forced by both
+ */
+static void              lazy(void);
+
+/**
+ * @fn static void failing(void)
+ * @brief Lists are left alone when memory runs out
+ */
+static void              failing(void);
+
+int
+main(void)
+{
+        static const size_t lens[] = { 0, 1, 2, 17, N };
+        size_t   i;
+
+        for (i = 0; i < N; ++i)
+                vals[i] = (int)i;
+
+        for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+                round_trip(lens[i]);
+
+        owned();
+        lazy();
+        failing();
+
+        return test_done("array");
+}
+
+unsigned long
+hash(const void *p)
+{
+        return (unsigned long)*(const int *)p;
+}
+
+int
+eq(const void *a, const void *b)
+{
+        return *(const int *)a == *(const int *)b;
+}
+
+int
+gen(void *seed, void **out)
+{
+        if (*(int *)seed >= N)
+                return 0;
+
+        ++calls;
+        *out = &vals[(*(int *)seed)++];
+
+        return 1;
+}
+
+void
+dup_all(size_t n)
+{
+        size_t   i;
+
+        for (i = 0; i < n; ++i)
+                arr[i] = test_dup(&vals[i]);
+}
+
+void
+round_trip(size_t n)
+{
+        struct   flist *l;
+        size_t   i;
+        int      v;
+
+        /* a new list, even for nothing */
+        l = flist_from_array(NULL, arr, 0, 0);
+        CHECK(l != NULL && flist_length(l) == 0);
+
+        for (i = 0; i < n; ++i)
+                arr[i] = &vals[i];
+        CHECK(flist_set_hash(l, hash, eq) == 0);
+        CHECK(flist_from_array(l, arr, n, FLIST_DONTCLEAN) == l);
+        CHECK(flist_from_array(l, arr, 0, FLIST_DONTCLEAN) == l);
+        CHECK(flist_length(l) == n);
+
+        out[n] = out;
+        CHECK(flist_to_array(l, out) == n && out[n] == out);
+        CHECK(memcmp(out, arr, n * sizeof(void *)) == 0);
+
+        /* added to a filled list, taken out into a filled array */
+        CHECK(flist_from_array(l, arr, n, FLIST_DONTCLEAN) == l);
+        CHECK(flist_append(l, &vals[0], FLIST_DONTCLEAN) == l);
+        out[0] = out;
+        CHECK(flist_to_array(l, out + 1) == 2 * n + 1 && out[0] == out);
+        for (i = 0; i < 2 * n; ++i) {
+                CHECK(out[i + 1] == arr[i % n]);
+                CHECK(flist_val_at_i(l, (int)i) == arr[i % n]);
+        }
+        CHECK(out[2 * n + 1] == &vals[0]);
+
+        for (v = -1; v <= (int)n; ++v) {
+                CHECK(flist_elem(l, test_cmp_int, &v)
+                    == ((v >= 0 && v < (int)n) || v == 0));
+        }
+
+        flist_free(&l, 0);
+        CHECK(flist_to_array(l, out) == 0);
+}
+
+void
+owned(void)
+{
+        struct   flist *l;
+        size_t   i;
+
+        /* the list owns and frees them */
+        dup_all(N);
+        l = flist_from_array(NULL, arr, N, FLIST_CLEANABLE);
+        flist_set_cleanup(l, test_cleanup);
+        test_cleaned = 0;
+        flist_take(&l, N / 2, 0);
+        CHECK(test_cleaned == N - N / 2);
+        flist_free(&l, 0);
+        CHECK(test_cleaned == N);
+
+        /* protected ones only when forced */
+        dup_all(N);
+        l = flist_from_array(NULL, arr, N, FLIST_CLEANABLE | FLIST_CLEANPROT);
+        flist_set_cleanup(l, test_cleanup);
+        test_cleaned = 0;
+        flist_take(&l, N / 2, 0);
+        CHECK(test_cleaned == 0);
+        for (i = N / 2; i < N; ++i)
+                free(arr[i]);
+        flist_free(&l, 1);
+        CHECK(test_cleaned == N / 2);
+
+        /* never anything the list is not to clean up */
+        for (i = 0; i < N; ++i)
+                arr[i] = &vals[i];
+        l = flist_from_array(NULL, arr, N, FLIST_DONTCLEAN);
+        flist_set_cleanup(l, test_cleanup);
+        test_cleaned = 0;
+        flist_free(&l, 1);
+        CHECK(test_cleaned == 0);
+}
+
+void
+lazy(void)
+{
+        struct   flist *l;
+        size_t   i;
+        int      seed;
+
+        seed  = 0;
+        calls = 0;
+        l     = flist_unfoldr(gen, &seed, FLIST_DONTCLEAN);
+        CHECK(flist_to_array(l, out) == N && calls == N);
+        for (i = 0; i < N; ++i)
+                CHECK(out[i] == &vals[i]);
+        flist_free(&l, 0);
+
+        /* elements come after what is generated */
+        seed  = N / 2;
+        calls = 0;
+        l     = flist_unfoldr(gen, &seed, FLIST_DONTCLEAN);
+        for (i = 0; i < N / 2; ++i)
+                arr[i] = &vals[i];
+        CHECK(flist_from_array(l, arr, N / 2, FLIST_DONTCLEAN) == l);
+        CHECK(calls == N / 2 && flist_length(l) == N);
+        CHECK(flist_to_array(l, out) == N);
+        for (i = 0; i < N; ++i)
+                CHECK(out[i] == &vals[(i + N / 2) % N]);
+        flist_free(&l, 0);
+}
+
+void
+failing(void)
+{
+        struct   flist *l;
+        size_t   i;
+
+        for (i = 0; i < N; ++i)
+                arr[i] = &vals[i];
+
+        if ((l = flist_create(&test_brk_falloc)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        CHECK(flist_append(l, &vals[0], FLIST_DONTCLEAN) == l);
+
+        test_broke = 1;
+        errno = 0;
+        CHECK(flist_from_array(l, arr, N, FLIST_DONTCLEAN) == NULL);
+        CHECK(errno == ENOMEM);
+        test_broke = 0;
+        CHECK(flist_length(l) == 1 && flist_to_array(l, out) == 1);
+        CHECK(out[0] == &vals[0]);
+
+        CHECK(flist_from_array(l, arr, N, FLIST_DONTCLEAN) == l);
+        CHECK(flist_length(l) == N + 1);
+        flist_free(&l, 0);
+}
@@ -0,0 +1,319 @@
+/*
+ * Concatenation: flist_concat_many() joins lists in order, skipping NULL
+ * cells and setting all cells to NULL, adds moved elements to the hash index
+ * of the result and either joins all lists or, when it fails, none of them.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+
+#include "flist.h"
+
+#define K    6                  /* lists joined at once */
+#define POOL 3000
+
+static int       pool[POOL];    /* element i of the pool is i */
+static size_t    calls;         /* elements generated so far */
+
+/**
+ * @fn static unsigned long hash(const void *p)
+ * @brief Hashing function of integers
+ */
+static unsigned long     hash(const void *);
+
+/**
+ * @fn static int eq(const void *a, const void *b)
+ * @brief Are integers pointed to by @p a and @p b equal?
+ */
+static int               eq(const void *, const void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding copies of elements of @a pool from
+ *  @p seed on, up to the integer following @p seed
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static struct flist *build(const struct falloc *a, size_t from,
+ *  size_t to)
+ * @brief Returns list of copies of elements of @a pool from @p from to @p to,
+ *  owned by the list and allocated with @p a, NULL if there are none
+ */
+static struct flist     *build(const struct falloc *, size_t, size_t);
+
+/**
+ * @fn static int holds(struct flist *l, size_t from, size_t to)
+ * @brief Does @p l hold integers from @p from to @p to, walking it and by
+ *  position, and know about each of them through @a flist_elem()?
+ */
+static int               holds(struct flist *, size_t, size_t);
+
+/**
+ * @fn static void joined(void)
+ * @brief Lists are joined in order, NULL cells skipped, all cells cleared
+ */
+static void              joined(void);
+
+/**
+ * @fn static void indexed(void)
+ * @brief Moved elements are found through the hash index of the result
+ */
+static void              indexed(void);
+
+/**
+ * @fn static void failing(void)
+ * @brief Lists are left as they were if anything fails
+ */
+static void              failing(void);
+
+int
+main(void)
+{
+        size_t   i;
+
+        for (i = 0; i < POOL; ++i)
+                pool[i] = (int)i;
+
+        joined();
+        indexed();
+        failing();
+
+        return test_done("concat");
+}
+
+unsigned long
+hash(const void *p)
+{
+        return (unsigned long)*(const int *)p;
+}
+
+int
+eq(const void *a, const void *b)
+{
+        return *(const int *)a == *(const int *)b;
+}
+
+int
+gen(void *seed, void **out)
+{
+        int     *s = seed;
+
+        if (s[0] >= s[1])
+                return 0;
+
+        ++calls;
+        *out = test_dup(&pool[s[0]++]);
+
+        return 1;
+}
+
+struct flist *
+build(const struct falloc *a, size_t from, size_t to)
+{
+        struct   flist *l;
+        size_t   i;
+
+        if (from == to || (l = flist_create(a)) == NULL)
+                return NULL;
+        flist_set_cleanup(l, test_cleanup);
+
+        for (i = from; i < to; ++i) {
+                CHECK(flist_append(l, test_dup(&pool[i]), FLIST_CLEANABLE)
+                    == l);
+        }
+
+        return l;
+}
+
+int
+holds(struct flist *l, size_t from, size_t to)
+{
+        struct   flist_iter *it;
+        size_t   i;
+        int     *p, v;
+
+        if (flist_length(l) != to - from)
+                return 0;
+
+        i = from;
+        FLIST_FOREACH(l, it) {
+                if (*(int *)it->data != (int)i)
+                        return 0;
+                ++i;
+        }
+
+        for (i = to; i-- > from; ) {
+                p = flist_val_at_i(l, (int)(i - from));
+                if (p == NULL || *p != (int)i)
+                        return 0;
+        }
+
+        for (v = (int)from - 1; v <= (int)to; ++v) {
+                if (flist_elem(l, test_cmp_int, &v)
+                    != (v >= (int)from && v < (int)to))
+                        return 0;
+        }
+
+        return 1;
+}
+
+void
+joined(void)
+{
+        static const size_t lens[][K] = {
+                { 0, 0, 0, 0, 0, 0 }, { 3, 0, 0, 0, 0, 0 },
+                { 0, 0, 0, 0, 0, 3 }, { 0, 4, 0, 5, 1, 0 },
+                { 1, 1, 1, 1, 1, 1 }, { 7, 0, 9, 0, 2, 4 }
+        };
+        struct   flist *ls[K], *l;
+        size_t   i, j, n;
+        int      s[2];
+
+        for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+                for (n = 0, j = 0; j < K; n += lens[i][j++])
+                        ls[j] = build(NULL, n, n + lens[i][j]);
+
+                errno = 0;
+                l = flist_concat_many(ls, K);
+                CHECK(holds(l, 0, n) && errno == 0);
+                for (j = 0; j < K; ++j)
+                        CHECK(ls[j] == NULL);
+
+                test_cleaned = 0;
+                flist_free(&l, 0);
+                CHECK(test_cleaned == n);
+        }
+
+        CHECK(flist_concat_many(ls, 0) == NULL);
+
+        /* elements of a lazy list in the middle are all there */
+        s[0]  = 2;
+        s[1]  = 5;
+        calls = 0;
+        ls[0] = build(NULL, 0, 2);
+        ls[1] = flist_unfoldr(gen, s, FLIST_CLEANABLE);
+        ls[2] = build(NULL, 5, 6);
+        flist_set_cleanup(ls[1], test_cleanup);
+        l = flist_concat_many(ls, 3);
+        CHECK(calls == 3 && holds(l, 0, 6));
+        flist_free(&l, 0);
+
+        /* a lazy list at the end is left to be forced later */
+        s[0]  = 2;
+        s[1]  = 5;
+        calls = 0;
+        ls[0] = build(NULL, 0, 2);
+        ls[1] = NULL;
+        ls[2] = flist_unfoldr(gen, s, FLIST_CLEANABLE);
+        flist_set_cleanup(ls[2], test_cleanup);
+        l = flist_concat_many(ls, 3);
+        CHECK(calls == 0 && holds(l, 0, 5) && calls == 3);
+        flist_free(&l, 0);
+
+        /* elements the list is not to clean up do not stand in the way */
+        ls[0] = build(NULL, 0, 3);
+        ls[1] = flist_append(NULL, &pool[3], FLIST_DONTCLEAN);
+        ls[2] = build(NULL, 4, 8);
+        l = flist_concat_many(ls, 3);
+        CHECK(holds(l, 0, 8));
+        test_cleaned = 0;
+        flist_free(&l, 0);
+        CHECK(test_cleaned == 7);
+}
+
+void
+indexed(void)
+{
+        struct   flist *ls[K], *l;
+
+        /* the index of the first list takes in the rest, others are dropped */
+        ls[0] = NULL;
+        ls[1] = build(NULL, 0, 5);
+        ls[2] = build(NULL, 5, 500);
+        ls[3] = NULL;
+        ls[4] = build(NULL, 500, POOL - 1);
+        ls[5] = build(NULL, POOL - 1, POOL);
+        CHECK(flist_set_hash(ls[1], hash, eq) == 0);
+        CHECK(flist_set_hash(ls[4], hash, eq) == 0);
+
+        l = flist_concat_many(ls, K);
+        CHECK(holds(l, 0, POOL));
+
+        /* and keeps up with what follows */
+        flist_drop(&l, 250, 0);
+        CHECK(holds(l, 250, POOL));
+        flist_free(&l, 0);
+}
+
+void
+failing(void)
+{
+        struct   flist *ls[4], *l, *m;
+        int      s[2];
+
+        /* the index of the first list cannot grow */
+        ls[0] = build(&test_brk_falloc, 0, 5);
+        ls[1] = NULL;
+        ls[2] = build(&test_brk_falloc, 5, 1000);
+        ls[3] = build(&test_brk_falloc, 1000, 1010);
+        CHECK(flist_set_hash(ls[0], hash, eq) == 0);
+
+        test_broke = 1;
+        errno = 0;
+        CHECK(flist_concat_many(ls, 4) == NULL && errno == ENOMEM);
+        test_broke = 0;
+        CHECK(holds(ls[0], 0, 5) && ls[1] == NULL);
+        CHECK(holds(ls[2], 5, 1000) && holds(ls[3], 1000, 1010));
+
+        l = flist_concat_many(ls, 4);
+        CHECK(holds(l, 0, 1010));
+        flist_free(&l, 0);
+
+        /* a lazy list in the middle cannot be forced */
+        falloc_set_default(&test_brk_falloc);
+        s[0]  = 3;
+        s[1]  = 8;
+        ls[0] = build(NULL, 0, 3);
+        ls[1] = flist_unfoldr(gen, s, FLIST_CLEANABLE);
+        ls[2] = build(NULL, 8, 10);
+        flist_set_cleanup(ls[1], test_cleanup);
+        falloc_set_default(NULL);
+
+        test_broke = 1;
+        errno = 0;
+        CHECK(flist_concat_many(ls, 3) == NULL && errno == ENOMEM);
+        test_broke = 0;
+        CHECK(holds(ls[0], 0, 3) && holds(ls[2], 8, 10));
+
+        l = flist_concat_many(ls, 3);
+        CHECK(holds(l, 0, 10));
+        CHECK(ls[0] == NULL && ls[1] == NULL && ls[2] == NULL);
+        flist_free(&l, 0);
+
+        /* lists with different allocators */
+        ls[0] = build(NULL, 0, 3);
+        ls[1] = build(&test_falloc, 3, 5);
+        ls[2] = NULL;
+        errno = 0;
+        CHECK(flist_concat_many(ls, 3) == NULL && errno == EINVAL);
+        CHECK(holds(ls[0], 0, 3) && holds(ls[1], 3, 5));
+
+        /* both have elements to clean up, with different handlers */
+        m = ls[1];
+        ls[1] = flist_append(NULL, test_dup(&pool[3]), FLIST_CLEANABLE);
+        ls[2] = build(NULL, 4, 5);
+        errno = 0;
+        CHECK(flist_concat_many(ls, 3) == NULL && errno == EINVAL);
+        CHECK(holds(ls[0], 0, 3) && holds(ls[1], 3, 4));
+        CHECK(holds(ls[2], 4, 5));
+
+        flist_set_cleanup(ls[1], test_cleanup);
+        l = flist_concat_many(ls, 3);
+        CHECK(holds(l, 0, 5));
+        test_cleaned = 0;
+        flist_free(&l, 0);
+        flist_free(&m, 0);
+        CHECK(test_cleaned == 7);
+}
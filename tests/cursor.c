@@ -0,0 +1,334 @@
+/*
+ * Cursors: they walk lists both ways and stop past either end, lazy lists
+ * are forced as they move, replaced elements are found through the hash
+ * index and removing the last element frees the list.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+
+#define N 50
+
+static size_t    calls;         /* elements generated so far */
+
+/**
+ * @fn static unsigned long hash(const void *p)
+ * @brief Hashing function of integers
+ */
+static unsigned long     hash(const void *);
+
+/**
+ * @fn static int eq(const void *a, const void *b)
+ * @brief Are integers pointed to by @p a and @p b equal?
+ */
+static int               eq(const void *, const void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding integers from @p seed to @a N - 1
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static struct flist *build(size_t len)
+ * @brief Returns list of integers 0 to @p len - 1 owned by the list
+ */
+static struct flist     *build(size_t);
+
+/**
+ * @fn static int holds(struct flist *l, int from, int step, size_t len)
+ * @brief Does @p l hold @p len integers from @p from, @p step apart, both
+ *  walking it and by position?
+ */
+static int               holds(struct flist *, int, int, size_t);
+
+/**
+ * @fn static void walk(void)
+ * @brief Cursors move both ways and stop past either end
+ */
+static void              walk(void);
+
+/**
+ * @fn static void set(void)
+ * @brief Replaced elements are cleaned up and found through the hash index
+ */
+static void              set(void);
+
+/**
+ * @fn static void removed(void)
+ * @brief Removed elements are cleaned up, removing the last frees the list
+ */
+static void              removed(void);
+
+/**
+ * @fn static void lazy(void)
+ * @brief Lazy lists are forced one element at a time as cursors move
+ */
+static void              lazy(void);
+
+int
+main(void)
+{
+        walk();
+        set();
+        removed();
+        lazy();
+
+        return test_done("cursor");
+}
+
+unsigned long
+hash(const void *p)
+{
+        return (unsigned long)*(const int *)p;
+}
+
+int
+eq(const void *a, const void *b)
+{
+        return *(const int *)a == *(const int *)b;
+}
+
+int
+gen(void *seed, void **out)
+{
+        if (*(int *)seed >= N)
+                return 0;
+
+        ++calls;
+        *out = test_dup(seed);
+        *(int *)seed += 1;
+
+        return *out != NULL;
+}
+
+struct flist *
+build(size_t len)
+{
+        struct   flist *l;
+        int      i;
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+        flist_set_cleanup(l, test_cleanup);
+        flist_set_index(l, 4);
+
+        for (i = 0; i < (int)len; ++i)
+                CHECK(flist_append(l, test_dup(&i), FLIST_CLEANABLE) == l);
+
+        return l;
+}
+
+int
+holds(struct flist *l, int from, int step, size_t len)
+{
+        struct   flist_iter *it;
+        size_t   i;
+        int     *p;
+
+        if (flist_length(l) != len)
+                return 0;
+
+        i = 0;
+        FLIST_FOREACH(l, it) {
+                if (*(int *)it->data != from + (int)i * step)
+                        return 0;
+                ++i;
+        }
+
+        for (i = len; i-- > 0; ) {
+                p = flist_val_at_i(l, (int)i);
+                if (p == NULL || *p != from + (int)i * step)
+                        return 0;
+        }
+
+        return 1;
+}
+
+void
+walk(void)
+{
+        struct   flist_cursor c;
+        struct   flist *l;
+        int      i;
+
+        if ((l = build(N)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+
+        CHECK(flist_cursor_begin(&c, &l));
+        for (i = 0; i < N - 1; ++i) {
+                CHECK(*(int *)flist_cursor_get(&c) == i);
+                CHECK(flist_cursor_next(&c));
+        }
+        CHECK(*(int *)flist_cursor_get(&c) == N - 1);
+
+        /* back from the last element to past the first */
+        for (i = N - 1; i > 0; --i) {
+                CHECK(flist_cursor_prev(&c));
+                CHECK(*(int *)flist_cursor_get(&c) == i - 1);
+        }
+        CHECK(!flist_cursor_prev(&c));
+        CHECK(flist_cursor_get(&c) == NULL);
+        CHECK(!flist_cursor_prev(&c) && !flist_cursor_next(&c));
+
+        /* forward past the last */
+        CHECK(flist_cursor_begin(&c, &l));
+        for (i = 1; i < N; ++i)
+                CHECK(flist_cursor_next(&c));
+        CHECK(!flist_cursor_next(&c));
+        CHECK(flist_cursor_get(&c) == NULL);
+        CHECK(!flist_cursor_next(&c) && !flist_cursor_prev(&c));
+
+        /* one element, both ends at once */
+        flist_take(&l, 1, 0);
+        CHECK(flist_cursor_begin(&c, &l));
+        CHECK(!flist_cursor_next(&c));
+        CHECK(flist_cursor_begin(&c, &l));
+        CHECK(!flist_cursor_prev(&c));
+
+        CHECK(holds(l, 0, 1, 1));
+        flist_free(&l, 0);
+
+        /* nothing to stand on */
+        CHECK(!flist_cursor_begin(&c, &l));
+        CHECK(flist_cursor_get(&c) == NULL);
+        CHECK(!flist_cursor_next(&c) && !flist_cursor_prev(&c));
+        CHECK(!flist_cursor_remove(&c, 0));
+        flist_cursor_set(&c, NULL, 0, 0);
+        CHECK(l == NULL);
+}
+
+void
+set(void)
+{
+        struct   flist_cursor c;
+        struct   flist *l;
+        int      i, x;
+
+        if ((l = build(N)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        CHECK(flist_set_hash(l, hash, eq) == 0);
+
+        /* every element i becomes 2 * i, the old ones are cleaned up */
+        test_cleaned = 0;
+        for (i = flist_cursor_begin(&c, &l); i; i = flist_cursor_next(&c)) {
+                x = 2 * *(int *)flist_cursor_get(&c);
+                flist_cursor_set(&c, test_dup(&x), FLIST_CLEANABLE, 0);
+        }
+        CHECK(test_cleaned == N);
+        CHECK(holds(l, 0, 2, N));
+
+        for (x = -1; x < 2 * N + 1; ++x)
+                CHECK(flist_elem(l, test_cmp_int, &x) == (x >= 0 && x % 2 == 0
+                    && x < 2 * N));
+
+        /* setting the element there is changes nothing */
+        test_cleaned = 0;
+        CHECK(flist_cursor_begin(&c, &l));
+        flist_cursor_set(&c, flist_cursor_get(&c), FLIST_CLEANABLE, 0);
+        CHECK(test_cleaned == 0);
+        x = 0;
+        CHECK(flist_elem(l, test_cmp_int, &x));
+
+        /* elements that are not the list's are left alone */
+        x = -7;
+        flist_cursor_set(&c, &x, FLIST_DONTCLEAN, 0);
+        CHECK(test_cleaned == 1 && flist_elem(l, test_cmp_int, &x));
+        x = 0;
+        CHECK(!flist_elem(l, test_cmp_int, &x));
+        flist_cursor_remove(&c, 0);
+        CHECK(test_cleaned == 1);
+
+        CHECK(holds(l, 2, 2, N - 1));
+        flist_free(&l, 0);
+}
+
+void
+removed(void)
+{
+        struct   flist_cursor c;
+        struct   flist *l;
+        int      on;
+
+        if ((l = build(N)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+
+        /* every even element */
+        test_cleaned = 0;
+        for (on = flist_cursor_begin(&c, &l); on; ) {
+                if (*(int *)flist_cursor_get(&c) % 2 == 0)
+                        on = flist_cursor_remove(&c, 0);
+                else
+                        on = flist_cursor_next(&c);
+        }
+        CHECK(test_cleaned == N / 2);
+        CHECK(holds(l, 1, 2, N / 2));
+
+        /* the last element, moving past the end */
+        CHECK(flist_cursor_begin(&c, &l));
+        while (flist_cursor_next(&c))
+                ;
+        CHECK(flist_cursor_prev(&c) == 0);
+        CHECK(flist_cursor_begin(&c, &l));
+        for (on = 1; on < N / 2; ++on)
+                CHECK(flist_cursor_next(&c));
+        CHECK(!flist_cursor_remove(&c, 0));
+        CHECK(holds(l, 1, 2, N / 2 - 1));
+
+        /* all of them, the list goes with the last one */
+        test_cleaned = 0;
+        for (on = flist_cursor_begin(&c, &l); on; )
+                on = flist_cursor_remove(&c, 0);
+        CHECK(test_cleaned == N / 2 - 1);
+        CHECK(l == NULL);
+
+        /* the only one */
+        if ((l = build(1)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        CHECK(flist_cursor_begin(&c, &l));
+        CHECK(!flist_cursor_remove(&c, 0));
+        CHECK(l == NULL && flist_cursor_get(&c) == NULL);
+}
+
+void
+lazy(void)
+{
+        struct   flist_cursor c;
+        struct   flist *l;
+        int      seed, i, on;
+
+        seed  = 0;
+        calls = 0;
+        l     = flist_unfoldr(gen, &seed, FLIST_CLEANABLE);
+        flist_set_cleanup(l, test_cleanup);
+
+        CHECK(flist_cursor_begin(&c, &l));
+        CHECK(calls == 1);
+        for (i = 1; i < 10; ++i) {
+                CHECK(flist_cursor_next(&c));
+                CHECK(calls == (size_t)i + 1);
+                CHECK(*(int *)flist_cursor_get(&c) == i);
+        }
+        CHECK(flist_cursor_prev(&c) && calls == 10);
+
+        /* removing the last one forced forces the next */
+        CHECK(flist_cursor_next(&c));
+        CHECK(flist_cursor_remove(&c, 0));
+        CHECK(calls == 11 && *(int *)flist_cursor_get(&c) == 10);
+
+        /* the list goes once nothing is left to force */
+        test_cleaned = 0;
+        for (on = flist_cursor_begin(&c, &l); on; )
+                on = flist_cursor_remove(&c, 0);
+        CHECK(calls == N && test_cleaned == N - 1);
+        CHECK(l == NULL);
+}
@@ -0,0 +1,168 @@
+/*
+ * Parallel queries: flist_find_par() returns the first match, as flist_find()
+ * does, even when later segments find theirs sooner, flist_find_any_par()
+ * returns some match, and flist_any_par(), flist_all_par() and
+ * flist_elem_par() answer as their serial counterparts.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+
+#define N 600
+
+static int       vals[N];
+static int       lo, hi;        /* @a hit() holds for values in [lo, hi) */
+static size_t    gen_next;      /* next element yielded by @a gen() */
+static size_t    gen_len;       /* @a gen() stops after these */
+
+/**
+ * @fn static int hit(void *p)
+ * @brief Is integer @p p in [@a lo, @a hi)?
+ *
+ * Takes longer for elements nearer the start of @a vals, so that segments
+ * near the end of the list tend to find their matches first.
+ */
+static int               hit(void *);
+
+/**
+ * @fn static int miss(void *p)
+ * @brief Logical negation of @a hit()
+ */
+static int               miss(void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding consecutive elements of @a vals
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static struct flist *build(size_t len, int lazy)
+ * @brief Returns list of first @p len elements of @a vals, lazy if @p lazy
+ *  is set
+ */
+static struct flist     *build(size_t, int);
+
+/**
+ * @fn static void run(size_t len, int lazy)
+ * @brief Compares parallel and serial queries about @p len elements for
+ *  ranges of matching values at the start, in the middle, at the end and
+ *  nowhere
+ */
+static void              run(size_t, int);
+
+int
+main(void)
+{
+        static const size_t lens[] = { 0, 1, 2, 3, 5, 8, 31, 100, N };
+        static const unsigned threads[] = { 2, 3, 4, 8 };
+        size_t   i, j;
+
+        /* every value twice, so that there is always a later match */
+        for (i = 0; i < N; ++i)
+                vals[i] = (int)(i % (N / 2));
+
+        for (j = 0; j < sizeof(threads) / sizeof(threads[0]); ++j) {
+                flist_set_threads(threads[j]);
+                CHECK(flist_get_threads() == threads[j]);
+
+                for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+                        run(lens[i], 0);
+                        run(lens[i], 1);
+                }
+        }
+
+        return test_done("find");
+}
+
+int
+hit(void *p)
+{
+        volatile size_t spin;
+        int      x;
+
+        x = *(int *)p;
+        for (spin = 0; spin < 4 * (size_t)(vals + N - (int *)p); ++spin)
+                ;
+
+        return x >= lo && x < hi;
+}
+
+int
+miss(void *p)
+{
+        return !hit(p);
+}
+
+int
+gen(void *seed, void **out)
+{
+        (void)seed;
+
+        if (gen_next >= gen_len)
+                return 0;
+
+        *out = &vals[gen_next++];
+
+        return 1;
+}
+
+struct flist *
+build(size_t len, int lazy)
+{
+        struct   flist *l;
+        size_t   i;
+
+        if (lazy) {
+                gen_next = 0;
+                gen_len  = len;
+                return flist_unfoldr(gen, NULL, FLIST_DONTCLEAN);
+        }
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+        for (i = 0; i < len; ++i)
+                CHECK(flist_append(l, &vals[i], FLIST_DONTCLEAN) == l);
+
+        return l;
+}
+
+void
+run(size_t len, int lazy)
+{
+        static const int ranges[][2] = {
+                { 0, 1 }, { 0, N }, { 7, 9 }, { N / 2 - 3, N / 2 },
+                { N / 2 - 1, N }, { 40, 200 }, { -5, 0 }, { N, N + 1 }
+        };
+        struct   flist *l;
+        size_t   r;
+        int     *ser, *par, x;
+
+        for (r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+                lo = ranges[r][0];
+                hi = ranges[r][1];
+
+                /* lazy lists are forced by both, each gets its own */
+                l   = build(len, lazy);
+                ser = flist_find(l, hit);
+                flist_free(&l, 0);
+                l   = build(len, lazy);
+                par = flist_find_par(l, hit);
+                CHECK(par == ser);
+
+                par = flist_find_any_par(l, hit);
+                CHECK((par == NULL) == (ser == NULL));
+                CHECK(par == NULL || (*par >= lo && *par < hi));
+
+                CHECK(flist_any_par(l, hit) == (ser != NULL));
+                CHECK(flist_all_par(l, miss) == (ser == NULL));
+                CHECK(flist_all_par(l, hit) == flist_all(l, hit));
+
+                x = lo;
+                CHECK(flist_elem_par(l, test_cmp_int, &x)
+                    == flist_elem(l, test_cmp_int, &x));
+
+                flist_free(&l, 0);
+        }
+}
@@ -0,0 +1,139 @@
+/*
+ * Node flags and links: inflags decide cleanup of elements removed by
+ * filters, take and free, whether nodes come from slabs or not, and links
+ * stay intact around them. Run with DEFS=-DFLIST_COMPACT as well, which packs
+ * the flags into the links.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+
+#define N 32    /* elements of each kind, even */
+
+static int       vals[3 * N];
+
+/**
+ * @fn static unsigned flags_of(int i)
+ * @brief Inflags of @p i th element, all three kinds in turn
+ */
+static unsigned          flags_of(int);
+
+/**
+ * @fn static int not_cleanable(void *p)
+ * @brief Predicate rejecting elements cleaned up even when not forced
+ */
+static int               not_cleanable(void *);
+
+/**
+ * @fn static int plain(void *p)
+ * @brief Predicate holding for elements appended as @a FLIST_DONTCLEAN
+ */
+static int               plain(void *);
+
+/**
+ * @fn static int linked(struct flist *l, size_t len)
+ * @brief Do links of @p l agree with each other and with its length?
+ */
+static int               linked(struct flist *, size_t);
+
+int
+main(void)
+{
+        struct   flist *l;
+        int     *p, i;
+
+        for (i = 0; i < 3 * N; ++i)
+                vals[i] = i;
+
+        /* first half of the nodes is allocated one by one, the rest carved */
+        l = flist_create(&test_falloc);
+        flist_set_cleanup(l, test_cleanup);
+        for (i = 0; i < 3 * N; ++i) {
+                if (i == 3 * N / 2)
+                        flist_set_arena(l, 8);
+
+                if (flags_of(i) == FLIST_DONTCLEAN)
+                        p = &vals[i];
+                else if ((p = malloc(sizeof(int))) != NULL)
+                        *p = i;
+
+                CHECK(flist_append(l, p, flags_of(i)) == l);
+        }
+        CHECK(linked(l, 3 * N));
+
+        /* cleanable elements go, protected ones stay */
+        flist_filter(&l, not_cleanable, 0);
+        CHECK(test_cleaned == N);
+        CHECK(linked(l, 2 * N));
+
+        /* protected and plain elements alternate, forcing cleans the former */
+        flist_take(&l, N, 1);
+        CHECK(test_cleaned == N + N / 2);
+        CHECK(linked(l, N));
+
+        flist_filter(&l, plain, 1);
+        CHECK(test_cleaned == 2 * N);
+        CHECK(linked(l, N / 2));
+
+        /* nothing is left to clean up, even when forced */
+        flist_free(&l, 1);
+        CHECK(test_cleaned == 2 * N);
+        CHECK(test_count.bytes == 0);
+        CHECK(test_count.allocs == test_count.frees);
+
+        return test_done("flags");
+}
+
+unsigned
+flags_of(int i)
+{
+        switch (i % 3) {
+        case 0:
+                return FLIST_CLEANABLE;
+        case 1:
+                return FLIST_CLEANABLE | FLIST_CLEANPROT;
+        default:
+                return FLIST_DONTCLEAN;
+        }
+}
+
+int
+not_cleanable(void *p)
+{
+        return flags_of(*(int *)p) != FLIST_CLEANABLE;
+}
+
+int
+plain(void *p)
+{
+        return flags_of(*(int *)p) == FLIST_DONTCLEAN;
+}
+
+int
+linked(struct flist *l, size_t len)
+{
+        struct   flist_iter *it, *prev;
+        size_t   n;
+        int      last;
+
+        n    = 0;
+        last = -1;
+        prev = NULL;
+        FLIST_FOREACH(l, it) {
+                if (FLIST_ITER_PREV(it) != prev || *(int *)it->data <= last)
+                        return 0;
+
+                last = *(int *)it->data;
+                prev = it;
+                ++n;
+        }
+
+        if (n != len || flist_iter_last(l) != prev)
+                return 0;
+
+        FLIST_FOREACH_REV(l, it)
+                --n;
+
+        return n == 0;
+}
@@ -0,0 +1,365 @@
+/*
+ * Numeric lists: sums, extremes, counts, filters and affine maps agree with
+ * plain loops over the same values, across chunk boundaries, lanes left over
+ * by vector loops and integer wraparound. Built once as is and once with
+ * -mavx2, so that both kinds of kernels are held to the same results.
+ */
+
+#include "test.h"
+
+#include "fnum.h"
+
+#ifdef __AVX2__
+# define NAME "fnum_avx2"
+#else
+# define NAME "fnum"
+#endif
+
+#define MAXLEN (2 * FNUM_CHUNK_BYTES / 4 + 9)   /* over two I32 chunks */
+
+static int64_t   ref[MAXLEN];   /* values of the list under test */
+static int64_t   tmp[MAXLEN];   /* expected values after an operation */
+static uint64_t  seed;
+
+/**
+ * @fn static uint64_t rnd(void)
+ * @brief Returns next pseudo-random number
+ */
+static uint64_t          rnd(void);
+
+/**
+ * @fn static struct fnum *build(enum fnum_type t, size_t len, int wrap)
+ * @brief Fills @a ref with @p len values of type @p t and returns list of them
+ *
+ * Integer values span their whole type if @p wrap is set, so that sums
+ * overflow. Floating-point values are small integers, which keeps every sum
+ * exact no matter the order of additions.
+ */
+static struct fnum      *build(enum fnum_type, size_t, int);
+
+/**
+ * @fn static union fnum_val mk(enum fnum_type t, int64_t x)
+ * @brief Returns @p x as a value of type @p t
+ */
+static union fnum_val    mk(enum fnum_type, int64_t);
+
+/**
+ * @fn static int64_t get(enum fnum_type t, union fnum_val v)
+ * @brief Returns value @p v of type @p t as an integer
+ */
+static int64_t           get(enum fnum_type, union fnum_val);
+
+/**
+ * @fn static int holds(int64_t x, enum fnum_cmp op, int64_t v)
+ * @brief Does "x op v" hold?
+ */
+static int               holds(int64_t, enum fnum_cmp, int64_t);
+
+/**
+ * @fn static int64_t affine(enum fnum_type t, int64_t x, int64_t a, int64_t
+ *  b, int mul)
+ * @brief Returns a * x + b (or x + b unless @p mul is set) computed as
+ *  @p t would
+ */
+static int64_t           affine(enum fnum_type, int64_t, int64_t, int64_t, int);
+
+/**
+ * @fn static int same(struct fnum *n, enum fnum_type t, size_t len)
+ * @brief Does @p n hold exactly the first @p len values of @a tmp?
+ */
+static int               same(struct fnum *, enum fnum_type, size_t);
+
+/**
+ * @fn static void run(enum fnum_type t, size_t len, int wrap)
+ * @brief Checks every kernel on @p len values of type @p t
+ */
+static void              run(enum fnum_type, size_t, int);
+
+/**
+ * @fn static void wraparound(void)
+ * @brief Integer sums wrap around instead of overflowing
+ */
+static void              wraparound(void);
+
+int
+main(void)
+{
+        static const size_t lens[] = {
+                0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33,
+                FNUM_CHUNK_BYTES / 8 - 1, FNUM_CHUNK_BYTES / 8,
+                FNUM_CHUNK_BYTES / 8 + 1, FNUM_CHUNK_BYTES / 4 - 1,
+                FNUM_CHUNK_BYTES / 4, FNUM_CHUNK_BYTES / 4 + 1, MAXLEN
+        };
+        size_t   i;
+        int      t;
+
+#ifdef __AVX2__
+        if (!__builtin_cpu_supports("avx2")) {
+                printf("%-10s skipped (no AVX2)\n", NAME);
+                return EXIT_SUCCESS;
+        }
+#endif
+
+        seed = 42;
+        for (t = FNUM_I32; t <= FNUM_F64; ++t) {
+                for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+                        run((enum fnum_type)t, lens[i], 0);
+                        if (t == FNUM_I32 || t == FNUM_I64)
+                                run((enum fnum_type)t, lens[i], 1);
+                }
+        }
+
+        wraparound();
+
+        return test_done(NAME);
+}
+
+uint64_t
+rnd(void)
+{
+        seed = seed * UINT64_C(6364136223846793005)
+            + UINT64_C(1442695040888963407);
+
+        return seed >> 11;
+}
+
+struct fnum *
+build(enum fnum_type t, size_t len, int wrap)
+{
+        struct   fnum *n;
+        size_t   i;
+
+        for (i = 0; i < len; ++i) {
+                if (!wrap)
+                        ref[i] = (int64_t)(rnd() % 201) - 100;
+                else if (t == FNUM_I32)
+                        ref[i] = (int32_t)(uint32_t)rnd();
+                else
+                        ref[i] = (int64_t)(rnd() << 11 ^ rnd());
+        }
+
+        if ((n = fnum_new(t)) == NULL)
+                return NULL;
+
+        /* a few values one at a time, so that arrays start unaligned */
+        for (i = 0; i < len && i < 3; ++i)
+                CHECK(fnum_append(n, mk(t, ref[i])) == 0);
+
+        for (; i < len; ++i) {
+                int32_t  i32;
+                int64_t  i64;
+                float    f32;
+                double   f64;
+
+                switch (t) {
+                case FNUM_I32:
+                        i32 = (int32_t)ref[i];
+                        CHECK(fnum_append_array(n, &i32, 1) == 0);
+                        break;
+                case FNUM_I64:
+                        i64 = ref[i];
+                        CHECK(fnum_append_array(n, &i64, 1) == 0);
+                        break;
+                case FNUM_F32:
+                        f32 = (float)ref[i];
+                        CHECK(fnum_append_array(n, &f32, 1) == 0);
+                        break;
+                case FNUM_F64:
+                        f64 = (double)ref[i];
+                        CHECK(fnum_append_array(n, &f64, 1) == 0);
+                        break;
+                }
+        }
+
+        return n;
+}
+
+union fnum_val
+mk(enum fnum_type t, int64_t x)
+{
+        switch (t) {
+        case FNUM_I32:
+                return fnum_i32((int32_t)x);
+        case FNUM_I64:
+                return fnum_i64(x);
+        case FNUM_F32:
+                return fnum_f32((float)x);
+        default:
+                return fnum_f64((double)x);
+        }
+}
+
+int64_t
+get(enum fnum_type t, union fnum_val v)
+{
+        switch (t) {
+        case FNUM_I32:
+                return v.i32;
+        case FNUM_I64:
+                return v.i64;
+        case FNUM_F32:
+                return (int64_t)v.f32;
+        default:
+                return (int64_t)v.f64;
+        }
+}
+
+int
+holds(int64_t x, enum fnum_cmp op, int64_t v)
+{
+        switch (op) {
+        case FNUM_LT:
+                return x < v;
+        case FNUM_LE:
+                return x <= v;
+        case FNUM_EQ:
+                return x == v;
+        case FNUM_NE:
+                return x != v;
+        case FNUM_GE:
+                return x >= v;
+        default:
+                return x > v;
+        }
+}
+
+int64_t
+affine(enum fnum_type t, int64_t x, int64_t a, int64_t b, int mul)
+{
+        uint64_t r;
+
+        r = mul ? (uint64_t)x * (uint64_t)a : (uint64_t)x;
+
+        /* wraparound of 32-bit values only depends on low bits */
+        if (t == FNUM_I32)
+                return (int32_t)(uint32_t)(r + (uint64_t)b);
+
+        return (int64_t)(r + (uint64_t)b);
+}
+
+int
+same(struct fnum *n, enum fnum_type t, size_t len)
+{
+        size_t   i;
+
+        if (fnum_length(n) != len)
+                return 0;
+
+        for (i = 0; i < len; ++i) {
+                if (get(t, fnum_at(n, i)) != tmp[i])
+                        return 0;
+        }
+
+        return 1;
+}
+
+void
+run(enum fnum_type t, size_t len, int wrap)
+{
+        struct   fnum *n;
+        union    fnum_val s;
+        uint64_t sum;
+        int64_t  lo, hi, v, a, b;
+        size_t   i, k;
+        int      op;
+
+        if ((n = build(t, len, wrap)) == NULL) {
+                CHECK(!"fnum_new() failed");
+                return;
+        }
+
+        CHECK(fnum_length(n) == len);
+
+        lo = hi = len > 0 ? ref[0] : 0;
+        for (sum = 0, i = 0; i < len; ++i) {
+                sum += (uint64_t)ref[i];
+                lo   = ref[i] < lo ? ref[i] : lo;
+                hi   = ref[i] > hi ? ref[i] : hi;
+        }
+
+        s = fnum_sum(n);
+        if (t == FNUM_I32 || t == FNUM_I64)
+                CHECK(s.i64 == (int64_t)sum);
+        else
+                CHECK(s.f64 == (double)(int64_t)sum);
+
+        CHECK(get(t, fnum_min(n)) == lo);
+        CHECK(get(t, fnum_max(n)) == hi);
+
+        /* something in the middle, present in the list if nonempty */
+        v = len > 0 ? ref[len / 2] : 0;
+        for (op = FNUM_LT; op <= FNUM_GT; ++op) {
+                for (k = 0, i = 0; i < len; ++i)
+                        k += holds(ref[i], (enum fnum_cmp)op, v);
+                CHECK(fnum_count(n, (enum fnum_cmp)op, mk(t, v)) == k);
+        }
+        CHECK(fnum_elem(n, mk(t, v)) == (len > 0));
+
+        /* integer maps wrap around, floats are kept small and exact */
+        a = wrap ? (int64_t)rnd() : 3;
+        b = wrap ? (int64_t)rnd() : -7;
+
+        for (i = 0; i < len; ++i)
+                tmp[i] = affine(t, ref[i], a, b, 1);
+        fnum_affine(n, mk(t, a), mk(t, b));
+        CHECK(same(n, t, len));
+        fnum_free(&n);
+
+        /* 64-bit integers only have a vector kernel for addition */
+        n = build(t, len, wrap);
+        for (i = 0; i < len; ++i)
+                tmp[i] = affine(t, ref[i], a, b, 0);
+        fnum_add(n, mk(t, b));
+        CHECK(same(n, t, len));
+        fnum_free(&n);
+
+        for (op = FNUM_LT; op <= FNUM_GT; ++op) {
+                n = build(t, len, wrap);
+                v = len > 0 ? ref[len / 3] : 0;
+                for (k = 0, i = 0; i < len; ++i) {
+                        if (holds(ref[i], (enum fnum_cmp)op, v))
+                                tmp[k++] = ref[i];
+                }
+                fnum_filter(n, (enum fnum_cmp)op, mk(t, v));
+                CHECK(same(n, t, k));
+                fnum_free(&n);
+        }
+}
+
+void
+wraparound(void)
+{
+        struct   fnum *n;
+        int64_t  big[9];
+        size_t   i;
+
+        if ((n = fnum_new(FNUM_I64)) == NULL) {
+                CHECK(!"fnum_new() failed");
+                return;
+        }
+
+        CHECK(fnum_append(n, fnum_i64(INT64_MAX)) == 0);
+        CHECK(fnum_append(n, fnum_i64(1)) == 0);
+        CHECK(fnum_sum(n).i64 == INT64_MIN);
+
+        /* vector lanes and the remainder overflow alike */
+        for (i = 0; i < 9; ++i)
+                big[i] = INT64_MAX;
+        CHECK(fnum_append_array(n, big, 9) == 0);
+        CHECK(fnum_sum(n).i64 == (int64_t)((uint64_t)INT64_MIN
+            + 9 * (uint64_t)INT64_MAX));
+
+        fnum_free(&n);
+
+        if ((n = fnum_new(FNUM_I32)) == NULL) {
+                CHECK(!"fnum_new() failed");
+                return;
+        }
+
+        /* 32-bit values are summed in 64 bits, nothing wraps */
+        for (i = 0; i < 17; ++i)
+                CHECK(fnum_append(n, fnum_i32(INT32_MAX)) == 0);
+        CHECK(fnum_sum(n).i64 == 17 * (int64_t)INT32_MAX);
+
+        fnum_free(&n);
+}
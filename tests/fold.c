@@ -0,0 +1,244 @@
+/*
+ * Folds: flist_fold_assoc() gives what flist_foldl() does for an associative
+ * operation that does not commute, whatever the number of threads, and the
+ * same result every time for a fixed number of them otherwise.
+ * flist_foldr_mut() visits elements from the right and flist_scanl() keeps
+ * the seed and every state after it.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+
+#define N 1000
+
+/**
+ * @brief 2x2 matrix of integers modulo 2^32
+ */
+struct mat {
+        unsigned long    a, b, c, d;
+};
+
+static int               vals[N];
+static const struct mat  ident = { 1, 0, 0, 1 };
+static struct mat        scan[N + 2];   /* states of flist_scanl() */
+
+/**
+ * @fn static void *mul(void *x, void *y)
+ * @brief Returns newly allocated product of matrices @p x and @p y
+ */
+static void             *mul(void *, void *);
+
+/**
+ * @fn static void *step(void *acc, void *p)
+ * @brief Folding function, multiplies @p acc by matrix made of integer @p p
+ */
+static void             *step(void *, void *);
+
+/**
+ * @fn static void rstep(void *p, void *acc)
+ * @brief Folding function, multiplies matrix made of integer @p p by @p acc
+ *  in place
+ */
+static void              rstep(void *, void *);
+
+/**
+ * @fn static void lstep(void *acc, void *p)
+ * @brief Folding function, multiplies @p acc by matrix made of integer @p p
+ *  in place
+ */
+static void              lstep(void *, void *);
+
+/**
+ * @fn static void *mix(void *acc, void *p)
+ * @brief Folding function that is not associative
+ */
+static void             *mix(void *, void *);
+
+/**
+ * @fn static void *mix2(void *x, void *y)
+ * @brief Combining function for @a mix()
+ */
+static void             *mix2(void *, void *);
+
+/**
+ * @fn static int eq(const struct mat *x, const struct mat *y)
+ * @brief Are matrices @p x and @p y equal?
+ */
+static int               eq(const struct mat *, const struct mat *);
+
+/**
+ * @fn static void run(size_t len)
+ * @brief Folds first @p len elements of @a vals both ways
+ */
+static void              run(size_t);
+
+int
+main(void)
+{
+        static const size_t lens[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 100, N };
+        static const unsigned threads[] = { 2, 3, 4, 8 };
+        size_t   i, j;
+
+        for (i = 0; i < N; ++i)
+                vals[i] = (int)(i * 7919 % 1009);
+
+        for (j = 0; j < sizeof(threads) / sizeof(threads[0]); ++j) {
+                flist_set_threads(threads[j]);
+                CHECK(flist_get_threads() == threads[j]);
+
+                for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+                        run(lens[i]);
+        }
+
+        return test_done("fold");
+}
+
+void *
+mul(void *x, void *y)
+{
+        struct   mat *m, *n, *ret;
+
+        m = x;
+        n = y;
+        if ((ret = malloc(sizeof(struct mat))) == NULL)
+                return NULL;
+
+        ret->a = (m->a * n->a + m->b * n->c) & 0xffffffffUL;
+        ret->b = (m->a * n->b + m->b * n->d) & 0xffffffffUL;
+        ret->c = (m->c * n->a + m->d * n->c) & 0xffffffffUL;
+        ret->d = (m->c * n->b + m->d * n->d) & 0xffffffffUL;
+
+        return ret;
+}
+
+void *
+step(void *acc, void *p)
+{
+        struct   mat m;
+
+        m.a = (unsigned long)*(int *)p;
+        m.b = 1;
+        m.c = 1;
+        m.d = 0;
+
+        return mul(acc, &m);
+}
+
+void
+rstep(void *p, void *acc)
+{
+        struct   mat m, *ret;
+
+        m.a = (unsigned long)*(int *)p;
+        m.b = 1;
+        m.c = 1;
+        m.d = 0;
+
+        if ((ret = mul(&m, acc)) != NULL) {
+                *(struct mat *)acc = *ret;
+                free(ret);
+        }
+}
+
+void
+lstep(void *acc, void *p)
+{
+        struct   mat *ret;
+
+        if ((ret = step(acc, p)) != NULL) {
+                *(struct mat *)acc = *ret;
+                free(ret);
+        }
+}
+
+void *
+mix(void *acc, void *p)
+{
+        struct   mat *ret;
+
+        if ((ret = malloc(sizeof(struct mat))) == NULL)
+                return NULL;
+
+        *ret   = *(struct mat *)acc;
+        ret->a = (ret->a * 3 + (unsigned long)*(int *)p + 1) & 0xffffffffUL;
+
+        return ret;
+}
+
+void *
+mix2(void *x, void *y)
+{
+        struct   mat *ret;
+
+        if ((ret = malloc(sizeof(struct mat))) == NULL)
+                return NULL;
+
+        *ret   = *(struct mat *)x;
+        ret->a = (ret->a * 5 + ((struct mat *)y)->a) & 0xffffffffUL;
+
+        return ret;
+}
+
+int
+eq(const struct mat *x, const struct mat *y)
+{
+        return x->a == y->a && x->b == y->b && x->c == y->c && x->d == y->d;
+}
+
+void
+run(size_t len)
+{
+        struct   flist *l;
+        static const struct mat mark = { 7, 7, 7, 7 };
+        struct   mat *ser, *par, *again, acc, cur;
+        size_t   i;
+
+        if ((l = flist_create(NULL)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+
+        for (i = 0; i < len; ++i)
+                CHECK(flist_append(l, &vals[i], FLIST_DONTCLEAN) == l);
+
+        ser = flist_foldl(l, (void *)&ident, step);
+        par = flist_fold_assoc(l, (void *)&ident, step, mul);
+        CHECK(ser != NULL && par != NULL && eq(ser, par));
+
+        /* from the right, prepending factors gives the same product */
+        acc = ident;
+        flist_foldr_mut(l, &acc, rstep);
+        CHECK(ser != NULL && eq(&acc, ser));
+
+        /* seed first, then the state after each element, nothing more */
+        acc = ident;
+        scan[len + 1] = mark;
+        CHECK(flist_scanl(l, &acc, lstep, scan, sizeof(struct mat))
+            == len + 1);
+        CHECK(eq(&scan[0], &ident) && eq(&scan[len + 1], &mark));
+        CHECK(ser != NULL && eq(&acc, ser));
+        for (cur = ident, i = 0; i < len; ++i) {
+                lstep(&cur, &vals[i]);
+                CHECK(eq(&scan[i + 1], &cur));
+        }
+
+        if (len == 0) {
+                CHECK(ser == &ident && par == &ident);
+        } else {
+                free(ser);
+                free(par);
+        }
+
+        /* shape of the tree depends on the number of threads alone */
+        par   = flist_fold_assoc(l, (void *)&ident, mix, mix2);
+        again = flist_fold_assoc(l, (void *)&ident, mix, mix2);
+        CHECK(par != NULL && again != NULL && eq(par, again));
+
+        if (len != 0) {
+                free(par);
+                free(again);
+        }
+
+        flist_free(&l, 0);
+}
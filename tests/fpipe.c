@@ -0,0 +1,338 @@
+/*
+ * Pipelines: chains of stages give what the same flist subroutines applied
+ * one after another do, take stages stop forcing lazy sources, values made
+ * by map stages are cleaned up when filtered out or folded, and pipelines
+ * that lost a stage fail.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+
+#include "fpipe.h"
+
+#define N 100
+
+static size_t    calls;         /* elements generated so far */
+
+/**
+ * @fn static void *inc(void *p)
+ * @brief Returns newly allocated successor of integer @p p
+ */
+static void             *inc(void *);
+
+/**
+ * @fn static void *twice(void *p)
+ * @brief Returns newly allocated double of integer @p p
+ */
+static void             *twice(void *);
+
+/**
+ * @fn static int no3(void *p)
+ * @brief Is integer @p p not a multiple of three?
+ */
+static int               no3(void *);
+
+/**
+ * @fn static void *sum(void *acc, void *p)
+ * @brief Returns newly allocated sum of integers @p acc and @p p
+ */
+static void             *sum(void *, void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding consecutive integers from @p seed
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static int same(struct flist *a, struct flist *b)
+ * @brief Do @p a and @p b hold equal integers?
+ */
+static int               same(struct flist *, struct flist *);
+
+/**
+ * @fn static struct flist *build(void)
+ * @brief Returns list of integers 0 to @a N - 1 owned by the list
+ */
+static struct flist     *build(void);
+
+/**
+ * @fn static void chain(int skip, int keep)
+ * @brief A map, filter, drop, take and map chain dropping @p skip and taking
+ *  @p keep elements agrees with the same flist subroutines
+ */
+static void              chain(int, int);
+
+/**
+ * @fn static void early(void)
+ * @brief Take stages stop forcing a lazy source
+ */
+static void              early(void);
+
+/**
+ * @fn static void cleaned(void)
+ * @brief Mapped values filtered out or folded are cleaned up
+ */
+static void              cleaned(void);
+
+/**
+ * @fn static void lost(void)
+ * @brief Pipelines that lost a stage fail with ENOMEM
+ */
+static void              lost(void);
+
+int
+main(void)
+{
+        static const int counts[][2] = {
+                { 0, 0 }, { 0, 1 }, { 5, 20 }, { 0, N }, { N, 5 },
+                { 3, 2 * N }, { -1, -1 }
+        };
+        size_t   i;
+
+        for (i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+                chain(counts[i][0], counts[i][1]);
+
+        early();
+        cleaned();
+        lost();
+
+        return test_done("fpipe");
+}
+
+void *
+inc(void *p)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) != NULL)
+                *ret = *(int *)p + 1;
+
+        return ret;
+}
+
+void *
+twice(void *p)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) != NULL)
+                *ret = 2 * *(int *)p;
+
+        return ret;
+}
+
+int
+no3(void *p)
+{
+        return *(int *)p % 3 != 0;
+}
+
+void *
+sum(void *acc, void *p)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) != NULL)
+                *ret = *(int *)acc + *(int *)p;
+
+        return ret;
+}
+
+int
+gen(void *seed, void **out)
+{
+        ++calls;
+        *out = inc(seed);
+        *(int *)seed += 1;
+
+        return *out != NULL;
+}
+
+int
+same(struct flist *a, struct flist *b)
+{
+        struct   flist_iter *ia, *ib;
+
+        if (flist_length(a) != flist_length(b))
+                return 0;
+
+        for (ia = flist_iter_first(a), ib = flist_iter_first(b);
+            ia != NULL && ib != NULL; ia = ia->next, ib = ib->next) {
+                if (*(int *)ia->data != *(int *)ib->data)
+                        return 0;
+        }
+
+        return ia == NULL && ib == NULL;
+}
+
+struct flist *
+build(void)
+{
+        struct   flist *l;
+        int      i;
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+        flist_set_cleanup(l, test_cleanup);
+
+        for (i = 0; i < N; ++i)
+                CHECK(flist_append(l, test_dup(&i), FLIST_CLEANABLE) == l);
+
+        return l;
+}
+
+void
+chain(int skip, int keep)
+{
+        struct   flist *src, *ref, *out;
+        struct   fpipe *p;
+
+        if ((src = build()) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+
+        ref = flist_copy(src, test_dup);
+        flist_map(ref, inc, 1);
+        flist_filter(&ref, no3, 1);
+        flist_drop(&ref, skip, 1);
+        flist_take(&ref, keep, 1);
+        if (ref != NULL)
+                flist_map(ref, twice, 1);
+
+        p = fpipe_new(src);
+        fpipe_take(fpipe_drop(fpipe_filter(fpipe_map(p, inc), no3), skip),
+            keep);
+        fpipe_map(p, twice);
+
+        out = fpipe_collect(p);
+        CHECK(same(out, ref));
+        flist_free(&out, 0);
+
+        /* pipelines can be run again */
+        out = fpipe_collect(p);
+        CHECK(same(out, ref));
+        flist_free(&out, 0);
+
+        /* unmapped elements are shared with the source */
+        fpipe_free(&p);
+        CHECK(p == NULL);
+        p   = fpipe_new(src);
+        out = fpipe_collect(fpipe_drop(p, skip));
+        flist_drop(&src, skip, 0);
+        CHECK(same(out, src));
+        flist_free(&out, 0);
+        fpipe_free(&p);
+
+        flist_free(&ref, 0);
+        flist_free(&src, 0);
+}
+
+void
+early(void)
+{
+        struct   flist *src, *out;
+        struct   fpipe *p;
+        int      seed;
+
+        seed  = 0;
+        calls = 0;
+        src   = flist_unfoldr(gen, &seed, FLIST_CLEANABLE);
+        p     = fpipe_take(fpipe_filter(fpipe_new(src), test_odd), 5);
+
+        /* 1, 3, 5, 7 and 9 are among the first nine elements generated */
+        out = fpipe_collect(p);
+        CHECK(flist_length(out) == 5 && calls == 9);
+        CHECK(*(int *)flist_val_at_i(out, 4) == 9);
+        flist_free(&out, 0);
+
+        fpipe_free(&p);
+        flist_take(&src, 0, 0);
+        CHECK(src == NULL);
+}
+
+void
+cleaned(void)
+{
+        struct   flist *src, *out;
+        struct   fpipe *p;
+        int      zero, *res;
+
+        if ((src = build()) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+
+        /* of 1 to N, multiples of three are made and thrown away */
+        p = fpipe_filter(fpipe_map(fpipe_new(src), inc), no3);
+        fpipe_set_cleanup(p, test_cleanup);
+
+        test_cleaned = 0;
+        out = fpipe_collect(p);
+        CHECK(test_cleaned == N / 3);
+        CHECK(flist_length(out) == N - N / 3);
+
+        /* the rest belongs to the result */
+        test_cleaned = 0;
+        flist_free(&out, 0);
+        CHECK(test_cleaned == N - N / 3);
+
+        /* values thrown away, values folded and all sums but one are freed */
+        zero = 0;
+        test_cleaned = 0;
+        res = fpipe_foldl(p, &zero, sum);
+        CHECK(res != NULL && *res == N * (N + 1) / 2 - 3 * (N / 3)
+            * (N / 3 + 1) / 2);
+        CHECK(test_cleaned == N / 3 + 2 * (N - N / 3) - 1);
+        free(res);
+
+        /* nothing made it through, starting element is not freed */
+        test_cleaned = 0;
+        fpipe_take(p, 0);
+        CHECK(fpipe_foldl(p, &zero, sum) == &zero);
+        CHECK(fpipe_collect(p) == NULL);
+        CHECK(test_cleaned == 0);
+
+        fpipe_free(&p);
+        flist_free(&src, 0);
+}
+
+void
+lost(void)
+{
+        struct   flist *src;
+        struct   fpipe *p;
+        int      zero, i;
+
+        if ((src = flist_create(&test_brk_falloc)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        for (i = 0; i < N; ++i)
+                CHECK(flist_append(src, test_dup(&i), FLIST_CLEANABLE) == src);
+
+        p = fpipe_new(src);
+        CHECK(p != NULL);
+
+        test_broke = 1;
+        CHECK(fpipe_map(p, inc) == p);
+        test_broke = 0;
+        fpipe_filter(p, no3);
+
+        zero  = 0;
+        errno = 0;
+        CHECK(fpipe_collect(p) == NULL && errno == ENOMEM);
+        errno = 0;
+        CHECK(fpipe_foldl(p, &zero, sum) == NULL && errno == ENOMEM);
+
+        /* stages added after the loss do not bring the pipeline back */
+        errno = 0;
+        CHECK(fpipe_collect(fpipe_take(p, 3)) == NULL && errno == ENOMEM);
+
+        fpipe_free(&p);
+        flist_free(&src, 0);
+
+        CHECK(fpipe_collect(NULL) == NULL);
+}
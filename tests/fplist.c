@@ -0,0 +1,230 @@
+/*
+ * Persistent lists: versions share nodes, elements are cleaned up exactly
+ * once, when the last version holding the node that owns them is freed.
+ */
+
+#include "test.h"
+
+#include "fplist.h"
+
+#define N 16
+
+/**
+ * @fn static int *num(int x)
+ * @brief Returns newly allocated integer @p x
+ */
+static int              *num(int);
+
+/**
+ * @fn static void *dbl_odd(void *p)
+ * @brief Returns new integer twice @p p for test_odd elements, @p p itself
+ *  otherwise
+ */
+static void             *dbl_odd(void *);
+
+/**
+ * @fn static void *sum(void *acc, void *p)
+ * @brief Returns new integer, sum of @p acc and @p p
+ */
+static void             *sum(void *, void *);
+
+/**
+ * @fn static struct fplist *build(void)
+ * @brief Builds list of N owned integers 0, 1, ...
+ */
+static struct fplist    *build(void);
+
+/**
+ * @fn static void sharing(void)
+ * @brief Derived versions share nodes and leave their sources intact
+ */
+static void              sharing(void);
+
+/**
+ * @fn static void derived(void)
+ * @brief Results of map and filter own only what they allocated
+ */
+static void              derived(void);
+
+/**
+ * @fn static void convert(void)
+ * @brief Conversions to and from flist keep elements and their order
+ */
+static void              convert(void);
+
+int
+main(void)
+{
+        sharing();
+        derived();
+        convert();
+
+        return test_done("fplist");
+}
+
+int *
+num(int x)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        *ret = x;
+
+        return ret;
+}
+
+void *
+dbl_odd(void *p)
+{
+        return test_odd(p) ? num(2 * *(int *)p) : p;
+}
+
+void *
+sum(void *acc, void *p)
+{
+        return num(*(int *)acc + *(int *)p);
+}
+
+struct fplist *
+build(void)
+{
+        struct   fplist_builder *b;
+        struct   fplist *ret;
+        int      i;
+
+        b = fplist_builder_new();
+        for (i = 0; i < N; ++i)
+                fplist_builder_append(b, num(i), FLIST_CLEANABLE);
+
+        ret = fplist_builder_finish(b);
+        fplist_set_cleanup(ret, test_cleanup);
+
+        return ret;
+}
+
+void
+sharing(void)
+{
+        struct   fplist *base, *pre, *tl, *tk, *dr, *dup;
+        int      zero, *acc;
+
+        base = build();
+        pre  = fplist_prepend(base, num(-1), FLIST_CLEANABLE);
+        tl   = fplist_tail(base);
+        tk   = fplist_take(base, 3);
+        dr   = fplist_drop(base, 5);
+        dup  = fplist_dup(dr);
+
+        CHECK(fplist_length(base) == N);
+        CHECK(*(int *)fplist_val_head(base) == 0);
+        CHECK(fplist_length(pre) == N + 1);
+        CHECK(*(int *)fplist_val_head(pre) == -1);
+        CHECK(*(int *)fplist_val_at_i(pre, 1) == 0);
+        CHECK(fplist_val_at_i(pre, 0) != fplist_val_head(base));
+        CHECK(fplist_val_at_i(pre, 1) == fplist_val_head(base));
+        CHECK(fplist_length(tl) == N - 1);
+        CHECK(*(int *)fplist_val_head(tl) == 1);
+        CHECK(fplist_length(tk) == 3);
+        CHECK(fplist_val_at_i(tk, 3) == NULL);
+        CHECK(fplist_length(dr) == N - 5);
+        CHECK(*(int *)fplist_val_head(dr) == 5);
+        CHECK(fplist_val_at_i(dup, 0) == fplist_val_head(dr));
+
+        zero = 0;
+        acc  = fplist_foldl(tk, &zero, sum);
+        CHECK(*acc == 0 + 1 + 2);
+        free(acc);
+
+        /* intermediate results of the fold went through the handler */
+        test_cleaned = 0;
+
+        /* nodes of base are all still used by other versions */
+        fplist_free(&base, 0);
+        CHECK(base == NULL && test_cleaned == 0);
+
+        fplist_free(&pre, 0);
+        CHECK(test_cleaned == 1);
+
+        /* the take keeps the whole tail alive, head goes with it */
+        fplist_free(&tk, 0);
+        CHECK(test_cleaned == 2);
+
+        fplist_free(&tl, 0);
+        CHECK(test_cleaned == 6);
+
+        fplist_free(&dr, 0);
+        CHECK(test_cleaned == 6);
+        CHECK(fplist_length(dup) == N - 5);
+
+        fplist_free(&dup, 0);
+        CHECK(test_cleaned == N + 1);
+}
+
+void
+derived(void)
+{
+        struct   fplist *base, *m, *f;
+        size_t   i;
+
+        test_cleaned = 0;
+
+        base = build();
+        m    = fplist_map(base, dbl_odd);
+        f    = fplist_filter(base, test_odd);
+
+        CHECK(fplist_length(m) == N);
+        for (i = 0; i < N; ++i)
+                CHECK(*(int *)fplist_val_at_i(m, i)
+                    == (int)(i % 2 ? 2 * i : i));
+        CHECK(fplist_val_at_i(m, 0) == fplist_val_at_i(base, 0));
+
+        CHECK(fplist_length(f) == N / 2);
+        for (i = 0; i < N / 2; ++i)
+                CHECK(fplist_val_at_i(f, i) == fplist_val_at_i(base,
+                    2 * i + 1));
+
+        /* only elements computed by map belong to it */
+        fplist_free(&m, 0);
+        CHECK(test_cleaned == N / 2);
+
+        /* test_odd elements are still used by the filtered version */
+        fplist_free(&base, 0);
+        CHECK(test_cleaned == N / 2 + N / 2);
+        CHECK(*(int *)fplist_val_at_i(f, N / 2 - 1) == N - 1);
+
+        fplist_free(&f, 0);
+        CHECK(test_cleaned == 2 * N - N / 2);
+        CHECK(fplist_filter(NULL, test_odd) == NULL);
+        CHECK(fplist_map(NULL, dbl_odd) == NULL);
+}
+
+void
+convert(void)
+{
+        struct   flist *l, *back;
+        struct   fplist *p;
+        int      vals[N];
+        size_t   i;
+
+        for (l = NULL, i = 0; i < N; ++i) {
+                vals[i] = (int)i;
+                l = flist_append(l, &vals[i], FLIST_DONTCLEAN);
+        }
+
+        p    = fplist_from_flist(l);
+        back = fplist_to_flist(p);
+
+        CHECK(fplist_length(p) == N && flist_length(back) == N);
+        for (i = 0; i < N; ++i) {
+                CHECK(fplist_val_at_i(p, i) == &vals[i]);
+                CHECK(flist_val_at_i(back, (int)i) == &vals[i]);
+        }
+
+        flist_free(&back, 0);
+        fplist_free(&p, 0);
+        flist_free(&l, 0);
+}
@@ -0,0 +1,165 @@
+/*
+ * Tuples: construction in caller buffers, custom allocators and reuse of
+ * pairs and triples kept by pools.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+
+#include "ftuple.h"
+
+#define PER_SLAB 4
+
+/**
+ * @fn static void init(void)
+ * @brief Tuples built in caller buffers hold their elements and own nothing
+ */
+static void              init(void);
+
+/**
+ * @fn static void with(void)
+ * @brief Tuples are allocated and freed through the allocator given
+ */
+static void              with(void);
+
+/**
+ * @fn static void pool(void)
+ * @brief Pools hand freed pairs and triples out again
+ */
+static void              pool(void);
+
+int
+main(void)
+{
+        init();
+        with();
+        pool();
+
+        CHECK(test_count.bytes == 0);
+        CHECK(test_count.allocs == test_count.frees);
+
+        return test_done("ftuple");
+}
+
+void
+init(void)
+{
+        struct   ftuple *t;
+        void    *buf[FTUPLE_BUFLEN(3)], *elems[3];
+        int      a, b, c;
+
+        CHECK(FTUPLE_BUFLEN(2) * sizeof(void *) >= ftuple_size(2));
+        CHECK(ftuple_size(3) - ftuple_size(2) == sizeof(void *));
+
+        elems[0] = &a;
+        elems[1] = &b;
+        elems[2] = &c;
+
+        t = ftuple_init(buf, sizeof(buf), 3, elems);
+        CHECK(t != NULL && ftuple_dim(t) == 3);
+        CHECK(ftuple_fst(t) == &a && ftuple_snd(t) == &b);
+        CHECK(ftuple_nth(t, 2) == &c && ftuple_nth(t, 3) == NULL);
+
+        ftuple_free(&t);
+        CHECK(t == NULL);
+
+        t = ftuple_init(buf, sizeof(buf), 2, NULL);
+        CHECK(t != NULL && ftuple_fst(t) == NULL && ftuple_snd(t) == NULL);
+        ftuple_free(&t);
+
+        errno = 0;
+        CHECK(ftuple_init(buf, ftuple_size(3) - 1, 3, elems) == NULL);
+        CHECK(errno == EINVAL);
+
+        errno = 0;
+        CHECK(ftuple_init(buf, sizeof(buf), 1, elems) == NULL);
+        CHECK(errno == EINVAL);
+
+        CHECK(test_count.allocs == 0);
+}
+
+void
+with(void)
+{
+        struct   ftuple *t;
+        void    *elems[4];
+        int      a;
+
+        t = ftuple_create_with(&test_falloc, 2, &a, NULL);
+        CHECK(t != NULL && test_count.allocs == 1);
+        CHECK(test_count.bytes == (long)ftuple_size(2));
+        CHECK(ftuple_fst(t) == &a && ftuple_snd(t) == NULL);
+        ftuple_free(&t);
+        CHECK(test_count.bytes == 0);
+
+        /* the default allocator is used unless one is given */
+        falloc_set_default(&test_falloc);
+
+        elems[0] = elems[1] = elems[2] = elems[3] = &a;
+        t = ftuple_create_from_array(4, elems);
+        CHECK(t != NULL && test_count.allocs == 2);
+        CHECK(ftuple_nth(t, 3) == &a);
+        ftuple_free(&t);
+
+        falloc_set_default(NULL);
+        CHECK(falloc_get_default() == &falloc_malloc);
+}
+
+void
+pool(void)
+{
+        struct   ftuple_pool *p;
+        struct   ftuple *t[PER_SLAB], *big;
+        const    struct falloc *a;
+        void    *addr[PER_SLAB];
+        size_t   allocs, frees, i, j, found;
+
+        falloc_set_default(&test_falloc);
+        p = ftuple_pool_create(PER_SLAB);
+        falloc_set_default(NULL);
+        if (p == NULL) {
+                CHECK(p != NULL);
+                return;
+        }
+
+        a      = ftuple_pool_falloc(p);
+        allocs = test_count.allocs;
+
+        for (i = 0; i < PER_SLAB; ++i) {
+                t[i]    = ftuple_create_with(a, 2, &t[i], NULL);
+                addr[i] = t[i];
+        }
+        CHECK(test_count.allocs == allocs + 1);
+        CHECK(ftuple_fst(t[PER_SLAB - 1]) == &t[PER_SLAB - 1]);
+
+        for (i = 0; i < PER_SLAB; ++i)
+                ftuple_free(&t[i]);
+
+        /* the same blocks come back, no slab is added */
+        for (found = 0, i = 0; i < PER_SLAB; ++i) {
+                t[i] = ftuple_create_with(a, 2, NULL, NULL);
+                for (j = 0; j < PER_SLAB; ++j)
+                        found += addr[j] == (void *)t[i];
+        }
+        CHECK(found == PER_SLAB);
+        CHECK(test_count.allocs == allocs + 1);
+
+        /* triples have a separate free list, larger tuples bypass the pool */
+        big = ftuple_create_with(a, 3, NULL, NULL, &big);
+        CHECK(big != NULL && ftuple_nth(big, 2) == &big);
+        CHECK(test_count.allocs == allocs + 2);
+        ftuple_free(&big);
+
+        frees = test_count.frees;
+        big   = ftuple_create_with(a, 4, NULL, NULL, NULL, NULL);
+        CHECK(test_count.allocs == allocs + 3);
+        ftuple_free(&big);
+        CHECK(test_count.frees == frees + 1);
+
+        for (i = 0; i < PER_SLAB; ++i)
+                ftuple_free(&t[i]);
+
+        ftuple_pool_destroy(&p);
+        CHECK(p == NULL);
+}
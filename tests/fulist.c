@@ -0,0 +1,101 @@
+/*
+ * Unrolled lists: contents survive operations crossing node boundaries and
+ * all memory goes through the allocator the list was created with.
+ */
+
+#include "test.h"
+
+#include "fulist.h"
+
+#define N (4 * FULIST_CHUNK + 3)
+
+static int       vals[N];
+
+/**
+ * @fn static int even(void *p)
+ * @brief Is integer @p p even?
+ */
+static int               even(void *);
+
+/**
+ * @fn static int ordered(struct fulist *l, int from, int step, size_t n)
+ * @brief Does @p l hold @p n elements of @a vals starting at @p from, every
+ *  @p step th one?
+ */
+static int               ordered(struct fulist *, int, int, size_t);
+
+/**
+ * @fn static void with(void)
+ * @brief Lists are allocated and freed through the allocator given
+ */
+static void              with(void);
+
+int
+main(void)
+{
+        int      i;
+
+        for (i = 0; i < N; ++i)
+                vals[i] = i;
+
+        with();
+
+        CHECK(test_count.bytes == 0);
+        CHECK(test_count.allocs == test_count.frees);
+
+        return test_done("fulist");
+}
+
+int
+even(void *p)
+{
+        return *(int *)p % 2 == 0;
+}
+
+int
+ordered(struct fulist *l, int from, int step, size_t n)
+{
+        size_t   i;
+
+        if (fulist_length(l) != n)
+                return 0;
+
+        for (i = 0; i < n; ++i) {
+                if (fulist_val_at_i(l, (int)i) != &vals[from + (int)i * step])
+                        return 0;
+        }
+
+        return 1;
+}
+
+void
+with(void)
+{
+        struct   fulist *l;
+        int      i;
+
+        l = fulist_create(&test_falloc);
+        CHECK(l != NULL && fulist_length(l) == 0);
+        CHECK(test_count.allocs == 1);
+
+        /* middle of the values appended, the rest prepended around them */
+        for (i = N / 2; i < N; ++i)
+                CHECK(fulist_append(l, &vals[i], FLIST_DONTCLEAN) == l);
+        for (i = N / 2 - 1; i >= 0; --i)
+                CHECK(fulist_prepend(l, &vals[i], FLIST_DONTCLEAN) == l);
+        CHECK(ordered(l, 0, 1, N));
+        CHECK(test_count.allocs > 1);
+
+        fulist_drop(&l, FULIST_CHUNK + 1, 0);
+        CHECK(ordered(l, FULIST_CHUNK + 1, 1, N - FULIST_CHUNK - 1));
+
+        fulist_take(&l, 2 * FULIST_CHUNK, 0);
+        CHECK(ordered(l, FULIST_CHUNK + 1, 1, 2 * FULIST_CHUNK));
+
+        /* FULIST_CHUNK + 1 is even, so is every other element after it */
+        fulist_filter(&l, even, 0);
+        CHECK(ordered(l, FULIST_CHUNK + 1, 2, FULIST_CHUNK));
+
+        fulist_free(&l, 0);
+        CHECK(l == NULL);
+}
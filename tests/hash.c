@@ -0,0 +1,428 @@
+/*
+ * Hash index: flist_elem() answers as a walk over the list would while the
+ * list is taken from, dropped from, filtered and added to, and hash-based
+ * nub, group_by, intersect and union agree with quadratic loops over arrays.
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+#include "flist.h"
+
+#define POOL  6000
+#define M     97                /* distinct values */
+#define STEPS 300
+
+static int       pool[POOL];    /* element i of the pool is i % M */
+static int      *ref[POOL];     /* expected contents of the list */
+static int      *tmp[POOL];
+static size_t    len;           /* length of @a ref */
+static size_t    next;          /* first unused element of @a pool */
+static int       modulus;       /* @a keep() drops multiples of it */
+
+/**
+ * @fn static unsigned long hash(const void *p)
+ * @brief Hashing function of integers
+ */
+static unsigned long     hash(const void *);
+
+/**
+ * @fn static int eq(const void *a, const void *b)
+ * @brief Are integers pointed to by @p a and @p b equal?
+ */
+static int               eq(const void *, const void *);
+
+/**
+ * @fn static int keep(void *p)
+ * @brief Is integer @p p not a multiple of @a modulus?
+ */
+static int               keep(void *);
+
+/**
+ * @fn static int in(int **arr, size_t n, int v)
+ * @brief Does any of @p n integers pointed to from @p arr equal @p v?
+ */
+static int               in(int **, size_t, int);
+
+/**
+ * @fn static int holds(struct flist *l, int **arr, size_t n)
+ * @brief Does @p l hold exactly the @p n elements of @p arr, in order?
+ */
+static int               holds(struct flist *, int **, size_t);
+
+/**
+ * @fn static struct flist *build(size_t n, size_t from)
+ * @brief Returns list of @p n consecutive elements of @a pool from @p from
+ *  and stores them in @a ref
+ */
+static struct flist     *build(size_t, size_t);
+
+/**
+ * @fn static void check(struct flist *l)
+ * @brief Asks @p l about every value and a few absent ones
+ */
+static void              check(struct flist *);
+
+/**
+ * @fn static struct flist *mutate(struct flist *l)
+ * @brief Applies random operation to @p l and @a ref, returns the list
+ *
+ * The list is replaced by a new indexed one if it was freed.
+ */
+static struct flist     *mutate(struct flist *);
+
+/**
+ * @fn static void index_kept(void)
+ * @brief The index answers correctly through @a STEPS operations
+ */
+static void              index_kept(void);
+
+/**
+ * @fn static void nub(void)
+ * @brief @a flist_nub() keeps first occurrences in order
+ */
+static void              nub(void);
+
+/**
+ * @fn static void group_by(void)
+ * @brief @a flist_group_by() gathers equal elements in order
+ */
+static void              group_by(void);
+
+/**
+ * @fn static void sets(void)
+ * @brief @a flist_intersect() and @a flist_union() agree with loops
+ */
+static void              sets(void);
+
+int
+main(void)
+{
+        size_t   i;
+
+        for (i = 0; i < POOL; ++i)
+                pool[i] = (int)(i % M);
+
+        flist_set_threads(4);
+        test_seed = 3;
+
+        index_kept();
+        nub();
+        group_by();
+        sets();
+
+        return test_done("hash");
+}
+
+unsigned long
+hash(const void *p)
+{
+        return (unsigned long)*(const int *)p;
+}
+
+int
+eq(const void *a, const void *b)
+{
+        return *(const int *)a == *(const int *)b;
+}
+
+int
+keep(void *p)
+{
+        return *(int *)p % modulus != 0;
+}
+
+int
+in(int **arr, size_t n, int v)
+{
+        size_t   i;
+
+        for (i = 0; i < n; ++i) {
+                if (*arr[i] == v)
+                        return 1;
+        }
+
+        return 0;
+}
+
+int
+holds(struct flist *l, int **arr, size_t n)
+{
+        struct   flist_iter *it;
+        size_t   i;
+
+        if (flist_length(l) != n)
+                return 0;
+
+        i = 0;
+        FLIST_FOREACH(l, it) {
+                if (i >= n || it->data != arr[i])
+                        return 0;
+                ++i;
+        }
+
+        return i == n;
+}
+
+struct flist *
+build(size_t n, size_t from)
+{
+        struct   flist *l;
+        size_t   i;
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+
+        for (i = 0; i < n; ++i) {
+                ref[i] = &pool[(from + i) % POOL];
+                CHECK(flist_append(l, ref[i], FLIST_DONTCLEAN) == l);
+        }
+        len = n;
+
+        return l;
+}
+
+void
+check(struct flist *l)
+{
+        int      v;
+
+        CHECK(holds(l, ref, len));
+
+        for (v = -2; v < M + 2; ++v) {
+                CHECK(flist_elem(l, test_cmp_int, &v) == in(ref, len, v));
+                CHECK(flist_elem_par(l, test_cmp_int, &v) == in(ref, len, v));
+        }
+}
+
+struct flist *
+mutate(struct flist *l)
+{
+        struct   flist *src;
+        size_t   i, j, k;
+
+        switch (test_rnd(7)) {
+        case 0:
+                for (k = test_rnd(30); k > 0 && next < POOL; --k, ++next) {
+                        CHECK(flist_append(l, &pool[next], 0) == l);
+                        ref[len++] = &pool[next];
+                }
+                break;
+        case 1:
+                for (k = test_rnd(30); k > 0 && next < POOL; --k, ++next) {
+                        CHECK(flist_prepend(l, &pool[next], 0) == l);
+                        memmove(ref + 1, ref, len * sizeof(int *));
+                        ref[0] = &pool[next];
+                        ++len;
+                }
+                break;
+        case 2:
+                modulus = 2 + (int)test_rnd(6);
+                if (test_rnd(2))
+                        flist_filter(&l, keep, 0);
+                else
+                        flist_filter_par(&l, keep, 0);
+                for (i = 0, j = 0; i < len; ++i) {
+                        if (*ref[i] % modulus != 0)
+                                ref[j++] = ref[i];
+                }
+                len = j;
+                break;
+        case 3:
+                k = len - test_rnd(len / 3 + 1);
+                flist_take(&l, (int)k, 0);
+                len = k;
+                break;
+        case 4:
+                k = test_rnd(len / 3 + 1);
+                flist_drop(&l, (int)k, 0);
+                memmove(ref, ref + k, (len - k) * sizeof(int *));
+                len -= k;
+                break;
+        case 5:
+                flist_tail(&l, 0);
+                if (len > 0) {
+                        memmove(ref, ref + 1, (len - 1) * sizeof(int *));
+                        --len;
+                }
+                break;
+        default:
+                /* elements moved in from a list without an index */
+                src = NULL;
+                for (k = 1 + test_rnd(20); k > 0 && next < POOL; --k, ++next) {
+                        src = flist_append(src, &pool[next], 0);
+                        CHECK(src != NULL);
+                        ref[len++] = &pool[next];
+                }
+                if (src != NULL)
+                        CHECK(flist_concat(l, &src) == l);
+                break;
+        }
+
+        if (l == NULL) {
+                CHECK(len == 0);
+                if ((l = flist_create(NULL)) != NULL)
+                        CHECK(flist_set_hash(l, hash, eq) == 0);
+        }
+
+        return l;
+}
+
+void
+index_kept(void)
+{
+        struct   flist *l;
+        size_t   s;
+
+        next = 0;
+        if ((l = build(0, 0)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        CHECK(flist_set_hash(l, hash, eq) == 0);
+
+        for (s = 0; s < STEPS && l != NULL; ++s) {
+                l = mutate(l);
+                check(l);
+        }
+
+        /* without the index answers stay the same */
+        if (l != NULL)
+                CHECK(flist_set_hash(l, NULL, NULL) == 0);
+        check(l);
+
+        flist_free(&l, 0);
+}
+
+void
+nub(void)
+{
+        struct   flist *l;
+        size_t   i, k, n;
+        int      indexed;
+
+        for (indexed = 0; indexed < 2; ++indexed) {
+                if ((l = build(5 * M + 3, 11)) == NULL) {
+                        CHECK(!"flist_create() failed");
+                        return;
+                }
+                if (indexed)
+                        CHECK(flist_set_hash(l, hash, eq) == 0);
+
+                for (i = 0, n = 0; i < len; ++i) {
+                        if (!in(tmp, n, *ref[i]))
+                                tmp[n++] = ref[i];
+                }
+
+                flist_nub(&l, hash, eq, 0);
+                CHECK(holds(l, tmp, n));
+
+                /* the index of the result only holds what is left */
+                for (k = 0; indexed && k < n; ++k)
+                        CHECK(flist_elem(l, test_cmp_int, tmp[k]) == 1);
+
+                flist_free(&l, 0);
+        }
+}
+
+void
+group_by(void)
+{
+        struct   flist *l, *g;
+        struct   flist_iter *it;
+        size_t   i, k, n;
+
+        if ((l = build(3 * M + 40, 5)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+
+        g = flist_group_by(l, hash, eq);
+
+        /* first occurrences, in order, tell the order of groups */
+        for (i = 0, n = 0; i < len; ++i) {
+                if (!in(tmp, n, *ref[i]))
+                        tmp[n++] = ref[i];
+        }
+        CHECK(flist_length(g) == n);
+
+        k = 0;
+        FLIST_FOREACH(g, it) {
+                struct   flist_iter *e;
+                size_t   j;
+
+                j = 0;
+                FLIST_FOREACH((struct flist *)it->data, e) {
+                        while (j < len && *ref[j] != *tmp[k])
+                                ++j;
+                        CHECK(j < len && e->data == ref[j]);
+                        ++j;
+                }
+                /* nothing equal left after the last member */
+                while (j < len && *ref[j] != *tmp[k])
+                        ++j;
+                CHECK(j == len);
+                ++k;
+        }
+        CHECK(k == n);
+
+        flist_free(&g, 0);
+        CHECK(holds(l, ref, len));
+        flist_free(&l, 0);
+}
+
+void
+sets(void)
+{
+        struct   flist *l1, *l2, *r;
+        int     *r1[POOL], *r2[POOL];
+        size_t   n1, n2, i, n;
+
+        /* values 0 to M / 2 + 9 twice, values from M / 2 on once */
+        if ((l1 = build(M / 2 + 10, 0)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        for (i = 0; i < M / 2 + 10; ++i) {
+                ref[len] = ref[i];
+                CHECK(flist_append(l1, ref[len++], 0) == l1);
+        }
+        memcpy(r1, ref, len * sizeof(int *));
+        n1 = len;
+
+        if ((l2 = build(M / 2 + 20, M / 2)) == NULL) {
+                CHECK(!"flist_create() failed");
+                flist_free(&l1, 0);
+                return;
+        }
+        for (i = 0; i < 5; ++i) {
+                ref[len] = ref[i];
+                CHECK(flist_append(l2, ref[len++], 0) == l2);
+        }
+        memcpy(r2, ref, len * sizeof(int *));
+        n2 = len;
+
+        for (i = 0, n = 0; i < n1; ++i) {
+                if (in(r2, n2, *r1[i]))
+                        tmp[n++] = r1[i];
+        }
+        r = flist_intersect(l1, l2, hash, eq);
+        CHECK(holds(r, tmp, n));
+        flist_free(&r, 0);
+
+        memcpy(tmp, r1, n1 * sizeof(int *));
+        for (i = 0, n = n1; i < n2; ++i) {
+                if (!in(tmp, n, *r2[i]))
+                        tmp[n++] = r2[i];
+        }
+        r = flist_union(l1, l2, hash, eq);
+        CHECK(holds(r, tmp, n));
+        flist_free(&r, 0);
+
+        CHECK(holds(l1, r1, n1));
+        CHECK(holds(l2, r2, n2));
+
+        flist_free(&l1, 0);
+        flist_free(&l2, 0);
+}
@@ -0,0 +1,231 @@
+/*
+ * Positional index: flist_val_at_i() returns what a walk over the list would,
+ * in any order of access, with and without an index, as nodes are added,
+ * removed and moved around.
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+#include "flist.h"
+
+#define POOL  20000
+#define STEPS 400
+
+static int       pool[POOL];    /* element i of the pool is i */
+static int       ref[POOL];     /* expected contents of the list */
+static size_t    len;           /* length of @a ref */
+static size_t    next;          /* first unused element of @a pool */
+static int       modulus;       /* @a keep() drops multiples of it */
+
+/**
+ * @fn static int keep(void *p)
+ * @brief Is integer @p p not a multiple of @a modulus?
+ */
+static int               keep(void *);
+
+/**
+ * @fn static int cmp_ref(const void *a, const void *b)
+ * @brief Compares integers @p a and @p b point to, for qsort()
+ */
+static int               cmp_ref(const void *, const void *);
+
+/**
+ * @fn static void check(struct flist *l)
+ * @brief Compares @p l with @a ref, walking it and by position in several
+ *  orders
+ */
+static void              check(struct flist *);
+
+/**
+ * @fn static struct flist *mutate(struct flist *l, size_t n)
+ * @brief Applies random operation to @p l and @a ref, returns the list
+ *
+ * The list is replaced by a new one with index of @p n if it was freed.
+ */
+static struct flist     *mutate(struct flist *, size_t);
+
+/**
+ * @fn static void run(size_t n)
+ * @brief Checks a list indexed every @p n nodes through @a STEPS operations
+ */
+static void              run(size_t);
+
+int
+main(void)
+{
+        static const size_t ns[] = { 0, 1, 2, 7, 64 };
+        size_t   i;
+
+        for (i = 0; i < POOL; ++i)
+                pool[i] = (int)i;
+
+        flist_set_threads(4);
+
+        test_seed = 1;
+        for (i = 0; i < sizeof(ns) / sizeof(ns[0]); ++i)
+                run(ns[i]);
+
+        return test_done("index");
+}
+
+int
+keep(void *p)
+{
+        return *(int *)p % modulus != 0;
+}
+
+int
+cmp_ref(const void *a, const void *b)
+{
+        return -test_cmp_int(a, b);
+}
+
+void
+check(struct flist *l)
+{
+        struct   flist_iter *it;
+        size_t   i, k;
+        int     *p;
+
+        CHECK(flist_length(l) == len);
+
+        i = 0;
+        FLIST_FOREACH(l, it) {
+                if (i < len)
+                        CHECK(*(int *)it->data == ref[i]);
+                ++i;
+        }
+        CHECK(i == len);
+
+        for (i = 0; i < len; ++i) {
+                p = flist_val_at_i(l, (int)i);
+                CHECK(p != NULL && *p == ref[i]);
+        }
+        for (i = len; i-- > 0; ) {
+                p = flist_val_at_i(l, (int)i);
+                CHECK(p != NULL && *p == ref[i]);
+        }
+        for (k = 0; k < 64 && len > 0; ++k) {
+                i = test_rnd(len);
+                p = flist_val_at_i(l, (int)i);
+                CHECK(p != NULL && *p == ref[i]);
+        }
+
+        CHECK(flist_val_at_i(l, (int)len) == NULL);
+}
+
+struct flist *
+mutate(struct flist *l, size_t n)
+{
+        struct   flist *src;
+        size_t   i, j, k;
+        int      x;
+
+        switch (test_rnd(9)) {
+        case 0:
+                for (k = test_rnd(40); k > 0 && next < POOL; --k, ++next) {
+                        CHECK(flist_append(l, &pool[next], 0) == l);
+                        ref[len++] = pool[next];
+                }
+                break;
+        case 1:
+                for (k = test_rnd(40); k > 0 && next < POOL; --k, ++next) {
+                        CHECK(flist_prepend(l, &pool[next], 0) == l);
+                        memmove(ref + 1, ref, len * sizeof(int));
+                        ref[0] = pool[next];
+                        ++len;
+                }
+                break;
+        case 2:
+                modulus = 2 + (int)test_rnd(6);
+                if (test_rnd(2))
+                        flist_filter(&l, keep, 0);
+                else
+                        flist_filter_par(&l, keep, 0);
+                for (i = 0, j = 0; i < len; ++i) {
+                        if (ref[i] % modulus != 0)
+                                ref[j++] = ref[i];
+                }
+                len = j;
+                break;
+        case 3:
+                flist_reverse(l);
+                for (i = 0; i < len / 2; ++i) {
+                        x = ref[i];
+                        ref[i] = ref[len - 1 - i];
+                        ref[len - 1 - i] = x;
+                }
+                break;
+        case 4:
+                k = len - test_rnd(len / 4 + 1);
+                flist_take(&l, (int)k, 0);
+                len = k;
+                break;
+        case 5:
+                k = test_rnd(len / 4 + 1);
+                flist_drop(&l, (int)k, 0);
+                memmove(ref, ref + k, (len - k) * sizeof(int));
+                len -= k;
+                break;
+        case 6:
+                flist_sort(l, test_cmp_int);
+                qsort(ref, len, sizeof(int), test_cmp_int);
+                break;
+        case 7:
+                /* nodes moved in from another list, somewhere in the middle */
+                src = NULL;
+                for (k = 1 + test_rnd(20); k > 0 && next < POOL; --k, ++next) {
+                        src = flist_append(src, &pool[next], 0);
+                        CHECK(src != NULL);
+                }
+                if (src == NULL)
+                        break;
+                i = test_rnd(len + 1);
+                k = flist_length(src);
+                memmove(ref + i + k, ref + i, (len - i) * sizeof(int));
+                for (j = 0; j < k; ++j)
+                        ref[i + j] = pool[next - k + j];
+                len += k;
+                CHECK(flist_splice_at(l, i, &src) == l);
+                break;
+        default:
+                /* the index is set anew on a list in use */
+                flist_sort(l, cmp_ref);
+                qsort(ref, len, sizeof(int), cmp_ref);
+                flist_set_index(l, n == 0 ? 0 : 1 + test_rnd(2 * n));
+                break;
+        }
+
+        if (l == NULL) {
+                CHECK(len == 0);
+                if ((l = flist_create(NULL)) != NULL)
+                        flist_set_index(l, n);
+        }
+
+        return l;
+}
+
+void
+run(size_t n)
+{
+        struct   flist *l;
+        size_t   s;
+
+        len  = 0;
+        next = 0;
+
+        if ((l = flist_create(NULL)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        flist_set_index(l, n);
+
+        for (s = 0; s < STEPS && l != NULL; ++s) {
+                l = mutate(l, n);
+                check(l);
+        }
+
+        flist_free(&l, 0);
+}
@@ -0,0 +1,373 @@
+/*
+ * Lazy lists: flist_take(), flist_drop() and flist_tail() force only what
+ * they need and handle empty lists, counts of zero and counts as large as
+ * they get, flist_cycle() and flist_repeat_lazy() build elements as they are
+ * forced, predicates answer no when forcing fails.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+#include <limits.h>
+
+#include "flist.h"
+
+#define N 10
+
+static int       vals[4 * N];
+static size_t    calls;         /* elements generated so far */
+static size_t    limit;         /* generator stops after these, 0 never */
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding consecutive elements of @a vals
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static void *succ(void *p)
+ * @brief Returns newly allocated successor of integer @p p
+ */
+static void             *succ(void *);
+
+/**
+ * @fn static void *copy(void *p)
+ * @brief Copy constructor counting its calls in @a calls
+ */
+static void             *copy(void *);
+
+/**
+ * @fn static int never(void *p)
+ * @brief Predicate no element satisfies
+ */
+static int               never(void *);
+
+/**
+ * @fn static int always(void *p)
+ * @brief Predicate every element satisfies
+ */
+static int               always(void *);
+
+/**
+ * @fn static struct flist *counted(size_t lim)
+ * @brief Returns lazy list of @p lim elements (infinite for 0), resetting
+ *  @a calls
+ */
+static struct flist     *counted(size_t);
+
+/**
+ * @fn static void empty(void)
+ * @brief Empty lists stay empty
+ */
+static void              empty(void);
+
+/**
+ * @fn static void infinite(void)
+ * @brief Infinite lists are forced only as far as needed
+ */
+static void              infinite(void);
+
+/**
+ * @fn static void finite(void)
+ * @brief Counts past the end of finite lazy lists
+ */
+static void              finite(void);
+
+/**
+ * @fn static void owned(void)
+ * @brief Elements allocated by the generator are cleaned up
+ */
+static void              owned(void);
+
+/**
+ * @fn static void cycles(void)
+ * @brief Cycled and repeated elements are made one at a time
+ */
+static void              cycles(void);
+
+/**
+ * @fn static void failing(void)
+ * @brief Predicates answer no with errno set when forcing fails
+ */
+static void              failing(void);
+
+int
+main(void)
+{
+        size_t   i;
+
+        for (i = 0; i < 4 * N; ++i)
+                vals[i] = (int)i;
+
+        empty();
+        infinite();
+        finite();
+        owned();
+        cycles();
+        failing();
+
+        return test_done("lazy");
+}
+
+int
+gen(void *seed, void **out)
+{
+        size_t  *next;
+
+        next = seed;
+        if (limit != 0 && *next >= limit)
+                return 0;
+
+        ++calls;
+        *out = &vals[(*next)++ % (4 * N)];
+
+        return 1;
+}
+
+void *
+succ(void *p)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) != NULL)
+                *ret = *(int *)p + 1;
+
+        return ret;
+}
+
+void *
+copy(void *p)
+{
+        ++calls;
+
+        return test_dup(p);
+}
+
+int
+never(void *p)
+{
+        (void)p;
+
+        return 0;
+}
+
+int
+always(void *p)
+{
+        (void)p;
+
+        return 1;
+}
+
+struct flist *
+counted(size_t lim)
+{
+        static size_t next;
+
+        next  = 0;
+        calls = 0;
+        limit = lim;
+
+        return flist_unfoldr(gen, &next, FLIST_DONTCLEAN);
+}
+
+void
+empty(void)
+{
+        struct   flist *l;
+
+        l = NULL;
+        flist_take(&l, 3, 0);
+        CHECK(l == NULL);
+        flist_take(&l, 0, 0);
+        CHECK(l == NULL);
+        flist_drop(&l, 3, 0);
+        CHECK(l == NULL);
+        flist_drop(&l, 0, 0);
+        CHECK(l == NULL);
+        flist_tail(&l, 0);
+        CHECK(l == NULL);
+        flist_head(l, 0);
+        CHECK(flist_length(l) == 0);
+}
+
+void
+infinite(void)
+{
+        struct   flist *l;
+
+        l = counted(0);
+
+        flist_drop(&l, 0, 0);
+        CHECK(l != NULL && calls == 0);
+        flist_drop(&l, -1, 0);
+        CHECK(l != NULL && calls == 0);
+
+        flist_drop(&l, 5, 0);
+        CHECK(l != NULL && calls <= 6);
+        CHECK(*(int *)flist_val_head(l) == 5);
+
+        flist_tail(&l, 0);
+        CHECK(l != NULL && calls <= 7);
+        CHECK(*(int *)flist_val_head(l) == 6);
+
+        /* taking makes the list finite */
+        flist_take(&l, 3, 0);
+        CHECK(flist_length(l) == 3 && calls <= 9);
+        CHECK(*(int *)flist_val_at_i(l, 2) == 8);
+
+        flist_tail(&l, 0);
+        flist_tail(&l, 0);
+        flist_tail(&l, 0);
+        CHECK(l == NULL);
+
+        l = counted(0);
+        flist_take(&l, 0, 0);
+        CHECK(l == NULL && calls == 0);
+
+        l = counted(0);
+        flist_head(l, 0);
+        CHECK(flist_length(l) == 1 && calls == 1);
+        flist_free(&l, 0);
+}
+
+void
+finite(void)
+{
+        struct   flist *l;
+
+        l = counted(N);
+        flist_take(&l, 2 * N, 0);
+        CHECK(flist_length(l) == N && calls == N);
+        flist_free(&l, 0);
+
+        l = counted(N);
+        flist_drop(&l, N - 1, 0);
+        CHECK(flist_length(l) == 1);
+        CHECK(*(int *)flist_val_head(l) == N - 1);
+        flist_free(&l, 0);
+
+        l = counted(N);
+        flist_drop(&l, N, 0);
+        CHECK(l == NULL);
+
+        l = counted(N);
+        flist_drop(&l, 2 * N, 0);
+        CHECK(l == NULL && calls == N);
+
+        /* counting one past the last element dropped must not overflow */
+        l = counted(N);
+        flist_drop(&l, INT_MAX, 0);
+        CHECK(l == NULL && calls == N);
+
+        l = counted(N);
+        flist_take(&l, INT_MAX, 0);
+        CHECK(flist_length(l) == N && calls == N);
+        flist_drop(&l, INT_MAX, 0);
+        CHECK(l == NULL);
+}
+
+void
+owned(void)
+{
+        struct   flist *l;
+        int      zero;
+
+        zero = 0;
+
+        l = flist_iterate(&zero, FLIST_DONTCLEAN, succ);
+        flist_take(&l, N, 0);
+        CHECK(flist_length(l) == N);
+        CHECK(*(int *)flist_val_at_i(l, N - 1) == N - 1);
+        flist_free(&l, 0);
+
+        l = flist_iterate(&zero, FLIST_DONTCLEAN, succ);
+        flist_drop(&l, N, 0);
+        CHECK(*(int *)flist_val_head(l) == N);
+        flist_tail(&l, 0);
+        CHECK(*(int *)flist_val_head(l) == N + 1);
+        flist_take(&l, 0, 0);
+        CHECK(l == NULL);
+}
+
+void
+cycles(void)
+{
+        struct   flist *src, *l;
+        size_t   i;
+        int      ok;
+
+        CHECK(flist_cycle(NULL) == NULL);
+        CHECK(flist_repeat_lazy(NULL, NULL) == NULL);
+
+        /* a lazy source is forced once, entirely */
+        src = counted(3);
+        l   = flist_cycle(src);
+        CHECK(l != NULL && calls == 3);
+
+        flist_take(&l, 3 * N + 1, 0);
+        CHECK(flist_length(l) == 3 * N + 1);
+        for (ok = 1, i = 0; i < 3 * N + 1; ++i)
+                ok &= flist_val_at_i(l, (int)i) == &vals[i % 3];
+        CHECK(ok);
+        flist_free(&l, 0);
+
+        l = flist_cycle(src);
+        flist_drop(&l, 4, 0);
+        CHECK(flist_val_head(l) == &vals[1]);
+        flist_free(&l, 0);
+
+        /* shallow copies leave the source as it was, even when forced */
+        CHECK(flist_length(src) == 3 && flist_val_head(src) == &vals[0]);
+        flist_free(&src, 0);
+
+        calls = 0;
+        l = flist_repeat_lazy(&vals[7], copy);
+        CHECK(l != NULL && calls == 0);
+        flist_drop(&l, 2, 0);
+        CHECK(calls <= 3 && *(int *)flist_val_head(l) == 7);
+        CHECK(flist_val_head(l) != &vals[7]);
+        flist_take(&l, N, 0);
+        CHECK(flist_length(l) == N && calls == N + 2);
+        flist_free(&l, 0);
+
+        l = flist_repeat_lazy(&vals[7], NULL);
+        flist_take(&l, N, 0);
+        CHECK(flist_length(l) == N && flist_val_at_i(l, N - 1) == &vals[7]);
+        flist_free(&l, 0);
+}
+
+void
+failing(void)
+{
+        struct   flist *l;
+        int      x;
+
+        x = -1;
+
+        falloc_set_default(&test_brk_falloc);
+        l = counted(N);
+        falloc_set_default(NULL);
+        flist_drop(&l, 1, 0);   /* make sure the list is there */
+
+        test_broke = 1;
+
+        errno = 0;
+        CHECK(flist_any(l, never) == 0 && errno == ENOMEM);
+        errno = 0;
+        CHECK(flist_all(l, always) == 0 && errno == ENOMEM);
+        errno = 0;
+        CHECK(flist_elem(l, test_cmp_int, &x) == 0 && errno == ENOMEM);
+        errno = 0;
+        CHECK(flist_any_par(l, never) == 0 && errno == ENOMEM);
+        errno = 0;
+        CHECK(flist_all_par(l, always) == 0 && errno == ENOMEM);
+        errno = 0;
+        CHECK(flist_elem_par(l, test_cmp_int, &x) == 0 && errno == ENOMEM);
+
+        /* forcing goes on once memory is back */
+        test_broke = 0;
+        CHECK(flist_all(l, always) == 1);
+        CHECK(flist_length(l) == N - 1);
+        flist_free(&l, 0);
+}
@@ -0,0 +1,217 @@
+/*
+ * Parallel subroutines: flist_map_par(), flist_filter_par() and
+ * flist_copy_par() leave lists exactly as their serial counterparts do, for
+ * lengths below, at and above the number of threads.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+
+#define N 1000
+
+/**
+ * @fn static void *twice(void *p)
+ * @brief Returns newly allocated double of integer @p p
+ */
+static void             *twice(void *);
+
+/**
+ * @fn static struct flist *build(size_t len)
+ * @brief Returns list of integers 0 to @p len - 1 owned by the list
+ */
+static struct flist     *build(size_t);
+
+/**
+ * @fn static int ordered(struct flist *l, size_t len)
+ * @brief Does @p l hold integers 0 to @p len - 1?
+ */
+static int               ordered(struct flist *, size_t);
+
+/**
+ * @fn static int same(struct flist *a, struct flist *b)
+ * @brief Do @p a and @p b hold equal integers, walked both ways?
+ */
+static int               same(struct flist *, struct flist *);
+
+/**
+ * @fn static void map(size_t len)
+ * @brief @a flist_map_par() agrees with @a flist_map()
+ */
+static void              map(size_t);
+
+/**
+ * @fn static void filter(size_t len)
+ * @brief @a flist_filter_par() agrees with @a flist_filter()
+ */
+static void              filter(size_t);
+
+/**
+ * @fn static void copy(size_t len)
+ * @brief @a flist_copy_par() agrees with @a flist_copy()
+ */
+static void              copy(size_t);
+
+int
+main(void)
+{
+        static const size_t lens[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 100, N };
+        static const unsigned threads[] = { 2, 3, 4, 8 };
+        size_t   i, j;
+
+        for (j = 0; j < sizeof(threads) / sizeof(threads[0]); ++j) {
+                flist_set_threads(threads[j]);
+                CHECK(flist_get_threads() == threads[j]);
+
+                for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+                        map(lens[i]);
+                        filter(lens[i]);
+                        copy(lens[i]);
+                }
+        }
+
+        return test_done("par");
+}
+
+void *
+twice(void *p)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) != NULL)
+                *ret = 2 * *(int *)p;
+
+        return ret;
+}
+
+struct flist *
+build(size_t len)
+{
+        struct   flist *l;
+        size_t   i;
+        int      x;
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+        flist_set_cleanup(l, test_cleanup);
+
+        for (i = 0; i < len; ++i) {
+                x = (int)i;
+                CHECK(flist_append(l, test_dup(&x), FLIST_CLEANABLE) == l);
+        }
+
+        return l;
+}
+
+int
+ordered(struct flist *l, size_t len)
+{
+        struct   flist_iter *it;
+        size_t   i;
+
+        i = 0;
+        FLIST_FOREACH(l, it) {
+                if (*(int *)it->data != (int)i++)
+                        return 0;
+        }
+
+        return i == len;
+}
+
+int
+same(struct flist *a, struct flist *b)
+{
+        struct   flist_iter *ia, *ib;
+
+        if (flist_length(a) != flist_length(b))
+                return 0;
+
+        for (ia = flist_iter_first(a), ib = flist_iter_first(b);
+            ia != NULL && ib != NULL; ia = ia->next, ib = ib->next) {
+                if (*(int *)ia->data != *(int *)ib->data)
+                        return 0;
+        }
+        if (ia != NULL || ib != NULL)
+                return 0;
+
+        for (ia = flist_iter_last(a), ib = flist_iter_last(b);
+            ia != NULL && ib != NULL;
+            ia = FLIST_ITER_PREV(ia), ib = FLIST_ITER_PREV(ib)) {
+                if (*(int *)ia->data != *(int *)ib->data)
+                        return 0;
+        }
+
+        return ia == NULL && ib == NULL;
+}
+
+void
+map(size_t len)
+{
+        struct   flist *ser, *par;
+        size_t   cleaned;
+
+        ser = build(len);
+        par = build(len);
+
+        test_cleaned = 0;
+        flist_map(ser, twice, 1);
+        cleaned = test_cleaned;
+
+        test_cleaned = 0;
+        flist_map_par(par, twice, 1);
+        CHECK(test_cleaned == cleaned);
+        CHECK(same(ser, par));
+        CHECK(len == 0 || *(int *)flist_val_at_i(par, (int)len - 1)
+            == 2 * ((int)len - 1));
+
+        flist_free(&ser, 0);
+        flist_free(&par, 0);
+}
+
+void
+filter(size_t len)
+{
+        struct   flist *ser, *par;
+        size_t   cleaned;
+
+        ser = build(len);
+        par = build(len);
+
+        test_cleaned = 0;
+        flist_filter(&ser, test_odd, 1);
+        cleaned = test_cleaned;
+
+        test_cleaned = 0;
+        flist_filter_par(&par, test_odd, 1);
+        CHECK(test_cleaned == cleaned);
+        CHECK(same(ser, par));
+
+        flist_free(&ser, 0);
+        flist_free(&par, 0);
+}
+
+void
+copy(size_t len)
+{
+        struct   flist *l, *ser, *par;
+
+        l = build(len);
+
+        ser = flist_copy(l, test_dup);
+        par = flist_copy_par(l, test_dup);
+        CHECK(same(ser, l));
+        CHECK(same(par, l));
+        flist_free(&ser, 0);
+        flist_free(&par, 0);
+
+        /* shallow copies leave shared elements alone unless forced */
+        ser = flist_copy(l, NULL);
+        par = flist_copy_par(l, NULL);
+        CHECK(same(ser, l));
+        CHECK(same(par, l));
+        flist_free(&ser, 0);
+        flist_free(&par, 0);
+        CHECK(ordered(l, len));
+
+        flist_free(&l, 0);
+}
@@ -0,0 +1,162 @@
+/*
+ * Round trips through flist_serialize() and flist_mmap_open(), including
+ * elements larger than the staging buffer whose encodings need padding.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "flist.h"
+
+#define NSMALL 20000    /* enough to fill the staging buffer a few times */
+
+/**
+ * @fn static size_t enc_str(const void *x, void *buf, size_t size)
+ * @brief Encodes a string along with its terminator
+ */
+static size_t            enc_str(const void *, void *, size_t);
+
+/**
+ * @fn static char *big(size_t len, char c)
+ * @brief Returns a string of @p len copies of @p c
+ */
+static char             *big(size_t, char);
+
+/**
+ * @fn static void round_trip(struct flist *l, const char *path)
+ * @brief Checks that @p l survives a round trip through file @p path
+ */
+static void              round_trip(struct flist *, const char *);
+
+/**
+ * @fn static void corrupt(const char *path)
+ * @brief Checks that a damaged file is rejected
+ */
+static void              corrupt(const char *);
+
+int
+main(void)
+{
+        struct   flist *l;
+        char     path[] = "/tmp/funcc_test_XXXXXX";
+        char     buf[NSMALL][8];
+        size_t   i;
+        int      fd;
+
+        if ((fd = mkstemp(path)) == -1) {
+                perror("mkstemp");
+                return EXIT_FAILURE;
+        }
+        close(fd);
+
+        /* encodings of 70001 and 9 bytes are not multiples of 8 */
+        l = flist_append(NULL, big(70000, 'a'), FLIST_CLEANABLE);
+        l = flist_append(l, "12345678", FLIST_DONTCLEAN);
+        l = flist_append(l, NULL, FLIST_DONTCLEAN);
+        l = flist_append(l, big(65531, 'b'), FLIST_CLEANABLE);
+        for (i = 0; i < NSMALL; ++i) {
+                sprintf(buf[i], "%lu", (unsigned long)i);
+                l = flist_append(l, buf[i], FLIST_DONTCLEAN);
+        }
+        l = flist_append(l, big(140003, 'c'), FLIST_CLEANABLE);
+        l = flist_append(l, "", FLIST_DONTCLEAN);
+
+        round_trip(l, path);
+        flist_free(&l, 0);
+
+        round_trip(NULL, path);
+
+        l = flist_append(NULL, big(100001, 'd'), FLIST_CLEANABLE);
+        round_trip(l, path);
+        flist_free(&l, 0);
+
+        corrupt(path);
+
+        unlink(path);
+
+        return test_done("serialize");
+}
+
+size_t
+enc_str(const void *x, void *buf, size_t size)
+{
+        size_t   len;
+
+        len = strlen(x) + 1;
+        if (len <= size)
+                memcpy(buf, x, len);
+
+        return len;
+}
+
+char *
+big(size_t len, char c)
+{
+        char    *ret;
+
+        if ((ret = malloc(len + 1)) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+
+        memset(ret, c, len);
+        ret[len] = '\0';
+
+        return ret;
+}
+
+void
+round_trip(struct flist *l, const char *path)
+{
+        struct   flist *m;
+        struct   flist_iter *a, *b;
+        size_t   i;
+
+        CHECK(flist_serialize(l, path, enc_str) == 0);
+        if ((m = flist_mmap_open(path)) == NULL) {
+                CHECK(m != NULL || l == NULL);
+                return;
+        }
+
+        CHECK(flist_length(m) == flist_length(l));
+
+        for (i = 0, a = flist_iter_first(l), b = flist_iter_first(m);
+            a != NULL && b != NULL;
+            ++i, a = flist_iter_next(l, a), b = flist_iter_next(m, b)) {
+                if (a->data == NULL || *(char *)a->data == '\0')
+                        CHECK(b->data == NULL
+                            || strcmp(b->data, a->data) == 0);
+                else
+                        CHECK(b->data != NULL
+                            && strcmp(b->data, a->data) == 0);
+
+                CHECK((size_t)b->data % 8 == 0);
+        }
+        CHECK(a == NULL && b == NULL);
+
+        flist_free(&m, 0);
+}
+
+void
+corrupt(const char *path)
+{
+        FILE    *f;
+        int      c;
+
+        if ((f = fopen(path, "r+b")) == NULL) {
+                perror("fopen");
+                return;
+        }
+
+        fseek(f, -1, SEEK_END);
+        c = fgetc(f);
+        fseek(f, -1, SEEK_END);
+        fputc(c ^ 0x01, f);
+        fclose(f);
+
+        errno = 0;
+        CHECK(flist_mmap_open(path) == NULL && errno == EINVAL);
+}
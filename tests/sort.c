@@ -0,0 +1,247 @@
+/*
+ * Sorting: flist_sort() and flist_sort_by_key() order elements as a stable
+ * sort of an array does, ties, negative keys and extreme keys included, and
+ * flist_sort_by_key() leaves the list alone if it runs out of memory.
+ */
+
+#include "test.h"
+
+#include <limits.h>
+#include <string.h>
+
+#include "flist.h"
+
+#define N 2000
+
+/**
+ * @brief Element sorted by @a key, @a seq being its original position
+ */
+struct rec {
+        long     key;
+        size_t   seq;
+};
+
+static struct rec        recs[N];
+static struct rec        ref[N];        /* expected order */
+static size_t            keyed;         /* calls to key() so far */
+
+/**
+ * @fn static int cmp_rec(const void *a, const void *b)
+ * @brief Compares keys of records @p a and @p b
+ */
+static int               cmp_rec(const void *, const void *);
+
+/**
+ * @fn static int cmp_ref(const void *a, const void *b)
+ * @brief Compares keys, then positions of records @p a and @p b, for qsort()
+ */
+static int               cmp_ref(const void *, const void *);
+
+/**
+ * @fn static long key(const void *p)
+ * @brief Returns key of record @p p, counting calls in @a keyed
+ */
+static long              key(const void *);
+
+/**
+ * @fn static struct flist *build(size_t len, int kind)
+ * @brief Fills @a recs with @p len records whose keys are chosen as @p kind
+ *  says, sorts them into @a ref and returns list of them
+ */
+static struct flist     *build(size_t, int);
+
+/**
+ * @fn static int sorted(struct flist *l, size_t len)
+ * @brief Does @p l hold the @p len records of @a ref, in order, both ways?
+ */
+static int               sorted(struct flist *, size_t);
+
+/**
+ * @fn static void run(size_t len, int kind)
+ * @brief Sorts lists of @p len records of keys chosen as @p kind says
+ */
+static void              run(size_t, int);
+
+/**
+ * @fn static void failing(void)
+ * @brief Radix sort leaves the list unsorted when memory runs out
+ */
+static void              failing(void);
+
+int
+main(void)
+{
+        static const size_t lens[] = { 0, 1, 2, 3, 15, 16, 17, 255, 256, 257,
+            1000, N };
+        size_t   i;
+        int      kind;
+
+        test_seed = 7;
+        for (kind = 0; kind < 5; ++kind) {
+                for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+                        run(lens[i], kind);
+        }
+
+        failing();
+
+        return test_done("sort");
+}
+
+int
+cmp_rec(const void *a, const void *b)
+{
+        const struct rec *x = a, *y = b;
+
+        return (x->key > y->key) - (x->key < y->key);
+}
+
+int
+cmp_ref(const void *a, const void *b)
+{
+        const struct rec *x = a, *y = b;
+        int      c;
+
+        if ((c = cmp_rec(a, b)) != 0)
+                return c;
+
+        return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+long
+key(const void *p)
+{
+        ++keyed;
+
+        return ((const struct rec *)p)->key;
+}
+
+struct flist *
+build(size_t len, int kind)
+{
+        static const long extreme[] = { LONG_MIN, LONG_MIN + 1, -256, -255,
+            -1, 0, 1, 255, 256, LONG_MAX - 1, LONG_MAX };
+        struct   flist *l;
+        size_t   i;
+
+        for (i = 0; i < len; ++i) {
+                switch (kind) {
+                case 0:         /* many ties */
+                        recs[i].key = (long)test_rnd(8);
+                        break;
+                case 1:         /* negative and positive, few ties */
+                        recs[i].key = (long)test_rnd(1 << 20) - (1L << 19);
+                        break;
+                case 2:         /* every byte of the key matters */
+                        recs[i].key = (long)(test_rnd(1 << 16) << 16
+                            ^ test_rnd(1 << 16));
+                        if (test_rnd(2))
+                                recs[i].key = -recs[i].key;
+                        recs[i].key *= 65537L;
+                        break;
+                case 3:
+                        recs[i].key = extreme[test_rnd(sizeof(extreme)
+                            / sizeof(extreme[0]))];
+                        break;
+                default:        /* already sorted, descending */
+                        recs[i].key = (long)(len - i) / 3;
+                        break;
+                }
+                recs[i].seq = i;
+        }
+
+        memcpy(ref, recs, len * sizeof(struct rec));
+        qsort(ref, len, sizeof(struct rec), cmp_ref);
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+        for (i = 0; i < len; ++i)
+                CHECK(flist_append(l, &recs[i], FLIST_DONTCLEAN) == l);
+
+        return l;
+}
+
+int
+sorted(struct flist *l, size_t len)
+{
+        struct   flist_iter *it;
+        struct   rec *r;
+        size_t   i;
+
+        if (flist_length(l) != len)
+                return 0;
+
+        i = 0;
+        FLIST_FOREACH(l, it) {
+                r = it->data;
+                if (i >= len || r->seq != ref[i].seq)
+                        return 0;
+                ++i;
+        }
+
+        FLIST_FOREACH_REV(l, it) {
+                r = it->data;
+                if (i == 0 || r->seq != ref[--i].seq)
+                        return 0;
+        }
+
+        return i == 0;
+}
+
+void
+run(size_t len, int kind)
+{
+        struct   flist *l;
+
+        if ((l = build(len, kind)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        flist_sort(l, cmp_rec);
+        CHECK(sorted(l, len));
+        flist_free(&l, 0);
+
+        if ((l = build(len, kind)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        keyed = 0;
+        CHECK(flist_sort_by_key(l, key) == 0);
+        CHECK(keyed == len || (len < 2 && keyed == 0));
+        CHECK(sorted(l, len));
+
+        /* sorting sorted lists changes nothing, either way */
+        CHECK(flist_sort_by_key(l, key) == 0);
+        CHECK(sorted(l, len));
+        flist_sort(l, cmp_rec);
+        CHECK(sorted(l, len));
+        flist_free(&l, 0);
+}
+
+void
+failing(void)
+{
+        struct   flist *l;
+        size_t   i;
+
+        if ((l = flist_create(&test_brk_falloc)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        for (i = 0; i < 100; ++i) {
+                recs[i].key = (long)(100 - i);
+                recs[i].seq = i;
+                ref[i]      = recs[i];
+                CHECK(flist_append(l, &recs[i], FLIST_DONTCLEAN) == l);
+        }
+
+        test_broke = 1;
+        CHECK(flist_sort_by_key(l, key) == -1);
+        test_broke = 0;
+        CHECK(sorted(l, 100));
+
+        CHECK(flist_sort_by_key(l, key) == 0);
+        qsort(ref, 100, sizeof(struct rec), cmp_ref);
+        CHECK(sorted(l, 100));
+
+        flist_free(&l, 0);
+}
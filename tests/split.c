@@ -0,0 +1,286 @@
+/*
+ * Splitting: flist_span(), flist_break() and flist_split_at() cut lists in
+ * two at the right place, both halves answer positional and hash index
+ * queries about what they hold, and lazy lists are forced only as far as
+ * the cut.
+ */
+
+#include "test.h"
+
+#include "flist.h"
+#include "ftuple.h"
+
+#define N 300
+
+static int       pool[N];       /* element i of the pool is i */
+static int       bound;         /* @a below() holds for values under it */
+static size_t    calls;         /* elements generated so far */
+
+/**
+ * @fn static unsigned long hash(const void *p)
+ * @brief Hashing function of integers
+ */
+static unsigned long     hash(const void *);
+
+/**
+ * @fn static int eq(const void *a, const void *b)
+ * @brief Are integers pointed to by @p a and @p b equal?
+ */
+static int               eq(const void *, const void *);
+
+/**
+ * @fn static int below(void *p)
+ * @brief Is integer @p p less than @a bound?
+ */
+static int               below(void *);
+
+/**
+ * @fn static int above(void *p)
+ * @brief Logical negation of @a below()
+ */
+static int               above(void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding elements of @a pool from @p seed on
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static struct flist *build(size_t len)
+ * @brief Returns list of first @p len elements of @a pool, indexed both ways
+ */
+static struct flist     *build(size_t);
+
+/**
+ * @fn static void holds(struct flist *l, size_t from, size_t to)
+ * @brief Checks that @p l holds elements of @a pool from @p from to @p to,
+ *  walking it, by position and through its hash index
+ */
+static void              holds(struct flist *, size_t, size_t);
+
+/**
+ * @fn static void halves(struct ftuple *t, size_t len, size_t n)
+ * @brief Checks that @p t holds the first @p n of @p len elements of @a pool
+ *  and the rest, frees both lists and @p t
+ */
+static void              halves(struct ftuple *, size_t, size_t);
+
+/**
+ * @fn static void run(size_t len)
+ * @brief Splits lists of @p len elements at every interesting place
+ */
+static void              run(size_t);
+
+/**
+ * @fn static void lazy(void)
+ * @brief Lazy lists are forced up to the cut, the rest stays lazy
+ */
+static void              lazy(void);
+
+int
+main(void)
+{
+        static const size_t lens[] = { 0, 1, 2, 3, 10, 64, N };
+        size_t   i;
+
+        for (i = 0; i < N; ++i)
+                pool[i] = (int)i;
+
+        for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+                run(lens[i]);
+
+        lazy();
+
+        return test_done("split");
+}
+
+unsigned long
+hash(const void *p)
+{
+        return (unsigned long)*(const int *)p;
+}
+
+int
+eq(const void *a, const void *b)
+{
+        return *(const int *)a == *(const int *)b;
+}
+
+int
+below(void *p)
+{
+        return *(int *)p < bound;
+}
+
+int
+above(void *p)
+{
+        return !below(p);
+}
+
+int
+gen(void *seed, void **out)
+{
+        if (*(int *)seed >= N)
+                return 0;
+
+        ++calls;
+        *out = &pool[(*(int *)seed)++];
+
+        return 1;
+}
+
+struct flist *
+build(size_t len)
+{
+        struct   flist *l;
+        size_t   i;
+
+        if ((l = flist_create(NULL)) == NULL)
+                return NULL;
+        flist_set_index(l, 3);
+        CHECK(flist_set_hash(l, hash, eq) == 0);
+
+        for (i = 0; i < len; ++i)
+                CHECK(flist_append(l, &pool[i], FLIST_DONTCLEAN) == l);
+
+        return l;
+}
+
+void
+holds(struct flist *l, size_t from, size_t to)
+{
+        struct   flist_iter *it;
+        size_t   i;
+        int      v;
+
+        CHECK((l == NULL) == (from == to));
+        CHECK(flist_length(l) == to - from);
+
+        i = from;
+        FLIST_FOREACH(l, it) {
+                CHECK(i < to && it->data == &pool[i]);
+                ++i;
+        }
+        CHECK(i == to);
+
+        for (i = to; i-- > from; )
+                CHECK(flist_val_at_i(l, (int)(i - from)) == &pool[i]);
+        CHECK(flist_val_at_i(l, (int)(to - from)) == NULL);
+
+        for (v = -1; v <= N; ++v) {
+                CHECK(flist_elem(l, test_cmp_int, &v)
+                    == (v >= (int)from && v < (int)to));
+        }
+}
+
+void
+halves(struct ftuple *t, size_t len, size_t n)
+{
+        struct   flist *a, *b;
+
+        if (t == NULL) {
+                CHECK(!"split failed");
+                return;
+        }
+        CHECK(ftuple_dim(t) == 2);
+
+        a = ftuple_fst(t);
+        b = ftuple_snd(t);
+        holds(a, 0, n);
+        holds(b, n, len);
+
+        flist_free(&a, 0);
+        flist_free(&b, 0);
+        ftuple_free(&t);
+}
+
+void
+run(size_t len)
+{
+        size_t   cuts[6], i, n;
+        struct   flist *l;
+
+        cuts[0] = 0;
+        cuts[1] = 1;
+        cuts[2] = len / 2;
+        cuts[3] = len > 0 ? len - 1 : 0;
+        cuts[4] = len;
+        cuts[5] = len + 5;
+
+        for (i = 0; i < sizeof(cuts) / sizeof(cuts[0]); ++i) {
+                n = cuts[i] < len ? cuts[i] : len;
+
+                l = build(len);
+                halves(flist_split_at(&l, cuts[i]), len, n);
+                CHECK(l == NULL);
+
+                /* none match when bound is 0, all of them past len */
+                bound = (int)cuts[i];
+                l = build(len);
+                halves(flist_span(&l, below), len, n);
+                CHECK(l == NULL);
+
+                l = build(len);
+                halves(flist_break(&l, above), len, n);
+                CHECK(l == NULL);
+        }
+
+        /* the prefix ends at the first miss, later matches stay behind */
+        if (len > 2) {
+                struct   ftuple *t;
+                struct   flist *a, *b;
+
+                bound = (int)len / 2;
+                l = build(len);
+                CHECK(flist_append(l, &pool[0], FLIST_DONTCLEAN) == l);
+                if ((t = flist_span(&l, below)) == NULL) {
+                        CHECK(!"flist_span() failed");
+                        return;
+                }
+                a = ftuple_fst(t);
+                b = ftuple_snd(t);
+                holds(a, 0, len / 2);
+                CHECK(flist_length(b) == len - len / 2 + 1);
+                CHECK(flist_val_at_i(b, (int)(len - len / 2)) == &pool[0]);
+
+                flist_free(&a, 0);
+                flist_free(&b, 0);
+                ftuple_free(&t);
+        }
+}
+
+void
+lazy(void)
+{
+        struct   ftuple *t;
+        struct   flist *l, *a, *b;
+        int      seed;
+
+        seed  = 0;
+        calls = 0;
+        l     = flist_unfoldr(gen, &seed, FLIST_DONTCLEAN);
+        t     = flist_split_at(&l, 10);
+        CHECK(t != NULL && calls == 10);
+        a = ftuple_fst(t);
+        b = ftuple_snd(t);
+        ftuple_free(&t);
+
+        /* the first element not below bound is forced, it is in b */
+        bound = 15;
+        t = flist_span(&b, below);
+        CHECK(t != NULL && calls == 16);
+        l = ftuple_fst(t);
+        b = ftuple_snd(t);
+        CHECK(flist_concat(a, &l) == a);
+        ftuple_free(&t);
+
+        /* the rest is still there to be forced */
+        CHECK(flist_length(a) == 15 && calls == 16);
+        CHECK(flist_length(b) == N - 15 && calls == N);
+        CHECK(*(int *)flist_val_at_i(b, 0) == 15);
+
+        flist_free(&a, 0);
+        flist_free(&b, 0);
+}
@@ -0,0 +1,170 @@
+/*
+ * Instrumentation, built with FUNCC_STATS whatever DEFS say: a workload that
+ * frees everything it makes, on this thread and on workers, leaves as many
+ * node and tuple releases as allocations and no bytes held, and
+ * flist_stats_reset() zeroes every counter.
+ */
+
+#include "test.h"
+
+#include <string.h>
+
+#include "flist.h"
+#include "fstats.h"
+#include "ftuple.h"
+
+#define N     500
+#define PAIRS (N / 2)           /* made by flist_zip() in @a workload() */
+
+static int       vals[N];       /* element i is i */
+
+/**
+ * @fn static void *inc(void *p)
+ * @brief Returns newly allocated successor of integer @p p
+ */
+static void             *inc(void *);
+
+/**
+ * @fn static int zeroed(const struct flist_stats *s)
+ * @brief Are all counters and histograms of @p s zero?
+ */
+static int               zeroed(const struct flist_stats *);
+
+/**
+ * @fn static unsigned long calls(const struct flist_stats *s,
+ *  enum flist_stats_op op)
+ * @brief Returns number of calls of @p op recorded in the histogram of @p s
+ */
+static unsigned long     calls(const struct flist_stats *,
+    enum flist_stats_op);
+
+/**
+ * @fn static void workload(void)
+ * @brief Builds, transforms and frees lists and tuples
+ */
+static void              workload(void);
+
+int
+main(void)
+{
+        struct   flist_stats s;
+        size_t   cleaned;
+        int      i;
+
+        for (i = 0; i < N; ++i)
+                vals[i] = i;
+
+        flist_set_threads(4);
+
+        flist_stats_reset();
+        flist_stats_get(&s);
+        CHECK(s.enabled && zeroed(&s));
+
+        test_cleaned = 0;
+        workload();
+        cleaned = test_cleaned;
+
+        flist_stats_get(&s);
+        CHECK(s.enabled);
+        CHECK(s.node_allocs > 0 && s.node_allocs == s.node_frees);
+        CHECK(s.tuple_allocs > 0 && s.tuple_allocs == s.tuple_frees);
+        CHECK(s.bytes_held == 0);
+        CHECK(s.traversed > 0 && s.callbacks >= 2 * N);
+        CHECK(s.cleanups == cleaned + PAIRS);
+        CHECK(calls(&s, FLIST_OP_APPEND) >= N);
+        CHECK(calls(&s, FLIST_OP_TUPLE_CREATE) == s.tuple_allocs);
+        CHECK(calls(&s, FLIST_OP_FREE) > 0);
+
+        flist_stats_reset();
+        flist_stats_get(&s);
+        CHECK(s.enabled && zeroed(&s));
+
+        /* counting starts over */
+        workload();
+        flist_stats_get(&s);
+        CHECK(s.node_allocs > 0 && s.node_allocs == s.node_frees);
+        CHECK(s.bytes_held == 0 && s.cleanups == cleaned + PAIRS);
+
+        return test_done("stats");
+}
+
+void *
+inc(void *p)
+{
+        int      x;
+
+        x = *(int *)p + 1;
+
+        return test_dup(&x);
+}
+
+int
+zeroed(const struct flist_stats *s)
+{
+        static const struct flist_stats zero;
+        struct   flist_stats tmp;
+
+        tmp = *s;
+        tmp.enabled = 0;
+
+        return memcmp(&tmp, &zero, sizeof(struct flist_stats)) == 0;
+}
+
+unsigned long
+calls(const struct flist_stats *s, enum flist_stats_op op)
+{
+        unsigned long ret;
+        size_t   i;
+
+        for (ret = 0, i = 0; i < FLIST_STATS_BUCKETS; ++i)
+                ret += s->latency[op][i];
+
+        return ret;
+}
+
+void
+workload(void)
+{
+        struct   flist *l, *c, *z;
+        struct   ftuple *t;
+        void    *arr[N];
+        int      i;
+
+        l = NULL;
+        for (i = 0; i < N; ++i)
+                l = flist_append(l, test_dup(&vals[i]), FLIST_CLEANABLE);
+        flist_set_cleanup(l, test_cleanup);
+
+        /* nodes made and freed by workers count as well */
+        c = flist_copy_par(l, test_dup);
+        flist_set_cleanup(c, test_cleanup);
+        flist_map_par(c, inc, 0);
+        flist_filter_par(&c, test_odd, 0);
+        flist_sort(c, test_cmp_int);
+
+        /* pairs go with the list, through its own cleanup handler */
+        z = flist_zip(l, c);
+        CHECK(flist_length(z) == PAIRS);
+        flist_take(&z, N / 4, 0);
+        flist_free(&z, 0);
+
+        t = flist_split_at(&c, 10);
+        c = ftuple_fst(t);
+        z = ftuple_snd(t);
+        ftuple_free(&t);
+        CHECK(flist_concat(c, &z) == c);
+
+        flist_drop(&l, N / 2, 0);
+        flist_free(&c, 0);
+        flist_free(&l, 0);
+
+        /* nodes carved from one block */
+        for (i = 0; i < N; ++i)
+                arr[i] = &vals[i];
+        l = flist_from_array(NULL, arr, N, FLIST_DONTCLEAN);
+        flist_tail(&l, 0);
+        flist_free(&l, 0);
+
+        t = ftuple_create(3, &vals[0], &vals[1], &vals[2]);
+        ftuple_free(&t);
+}
@@ -0,0 +1,265 @@
+/*
+ * Lists read by flist_from_fd(): elements split across reads, the last
+ * element lacking its separator, fixed-size records, folds running in
+ * constant memory and read errors reported by flist_stream_error().
+ */
+
+#include "test.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "falloc.h"
+#include "flist.h"
+
+#define NLINES  200000  /* 2.2 MB of input, dozens of reads */
+#define LINELEN 11      /* "line%06lu\n" */
+
+/**
+ * @brief Accumulator of @a fold_line()
+ */
+struct fold_acc {
+        size_t       n;                 /**< @brief Lines seen */
+        size_t       bad;               /**< @brief Lines not as written */
+        long         peak;              /**< @brief Most bytes held */
+};
+
+/**
+ * @fn static int open_input(char *path, const char *dat, size_t len)
+ * @brief Writes @p len bytes of @p dat to a new file and opens it for reading
+ *
+ * @p path is a template for mkstemp(), the file is unlinked right away.
+ */
+static int               open_input(char *, const char *, size_t);
+
+/**
+ * @fn static int slice_eq(const struct flist_slice *sl, const char *s)
+ * @brief Does @p sl hold exactly the bytes of @p s?
+ */
+static int               slice_eq(const struct flist_slice *, const char *);
+
+/**
+ * @fn static int slice_is(const struct flist_slice *sl, const char *s)
+ * @brief Does @p sl hold exactly @p s, terminated?
+ */
+static int               slice_is(const struct flist_slice *, const char *);
+
+/**
+ * @fn static void fold_line(void *acc, void *x)
+ * @brief Checks that line @p x is the next one written by @a test_lines()
+ */
+static void              fold_line(void *, void *);
+
+/**
+ * @fn static void test_lines(void)
+ * @brief Reads many lines, some of them split across reads, twice
+ *
+ * First by forcing the list, then by folding it, which has to run in constant
+ * memory.
+ */
+static void              test_lines(void);
+
+/**
+ * @fn static void test_tail(void)
+ * @brief Reads input whose last element lacks the separator
+ */
+static void              test_tail(void);
+
+/**
+ * @fn static void test_fixed(void)
+ * @brief Reads fixed-size records, the last one short
+ */
+static void              test_fixed(void);
+
+/**
+ * @fn static void test_error(void)
+ * @brief Reads from a descriptor that fails to read
+ */
+static void              test_error(void);
+
+int
+main(void)
+{
+        test_lines();
+        test_tail();
+        test_fixed();
+        test_error();
+
+        return test_done("stream");
+}
+
+int
+open_input(char *path, const char *dat, size_t len)
+{
+        int      fd;
+
+        if ((fd = mkstemp(path)) == -1) {
+                perror("mkstemp");
+                exit(EXIT_FAILURE);
+        }
+        unlink(path);
+
+        if (write(fd, dat, len) != (ssize_t)len
+            || lseek(fd, 0, SEEK_SET) != 0) {
+                perror("write");
+                exit(EXIT_FAILURE);
+        }
+
+        return fd;
+}
+
+int
+slice_eq(const struct flist_slice *sl, const char *s)
+{
+        return sl->len == strlen(s) && memcmp(sl->data, s, sl->len) == 0;
+}
+
+int
+slice_is(const struct flist_slice *sl, const char *s)
+{
+        return slice_eq(sl, s) && sl->data[sl->len] == '\0';
+}
+
+void
+fold_line(void *acc, void *x)
+{
+        struct   fold_acc *a;
+        char     buf[LINELEN];
+
+        a = acc;
+        sprintf(buf, "line%06lu", (unsigned long)a->n++);
+        if (!slice_is(x, buf))
+                ++a->bad;
+
+        if (test_count.bytes > a->peak)
+                a->peak = test_count.bytes;
+}
+
+void
+test_lines(void)
+{
+        struct   flist *l;
+        struct   flist_iter *it;
+        struct   fold_acc acc;
+        char     path[] = "/tmp/funcc_test_XXXXXX";
+        char    *dat, buf[LINELEN];
+        size_t   i, bad;
+        int      fd;
+
+        if ((dat = malloc(NLINES * LINELEN + 1)) == NULL) {
+                perror("malloc");
+                exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < NLINES; ++i)
+                sprintf(dat + i * LINELEN, "line%06lu\n", (unsigned long)i);
+
+        /* 65536 is not a multiple of 11, so lines straddle every read */
+        fd = open_input(path, dat, NLINES * LINELEN);
+        l  = flist_from_fd(fd, flist_split_delim, "\n");
+
+        i = bad = 0;
+        FLIST_FOREACH(l, it) {
+                sprintf(buf, "line%06lu", (unsigned long)i++);
+                if (!slice_is(it->data, buf))
+                        ++bad;
+        }
+        CHECK(i == NLINES);
+        CHECK(bad == 0);
+        CHECK(flist_length(l) == NLINES);
+        CHECK(flist_stream_error(l) == 0);
+
+        flist_free(&l, 0);
+
+        /* nodes of all the lines would take up megabytes */
+        CHECK(lseek(fd, 0, SEEK_SET) == 0);
+        falloc_set_default(&test_falloc);
+
+        l = flist_from_fd(fd, flist_split_delim, "\n");
+        memset(&acc, 0x00, sizeof(struct fold_acc));
+        flist_foldl_mut(l, &acc, fold_line);
+        CHECK(acc.n == NLINES);
+        CHECK(acc.bad == 0);
+        CHECK(acc.peak < 1L << 20);
+        CHECK(flist_length(l) < NLINES / 10);
+
+        flist_free(&l, 0);
+        CHECK(test_count.bytes == 0);
+        falloc_set_default(NULL);
+
+        close(fd);
+        free(dat);
+}
+
+void
+test_tail(void)
+{
+        struct   flist *l;
+        char     path[] = "/tmp/funcc_test_XXXXXX";
+        int      fd;
+
+        fd = open_input(path, "a\n\nbb\nccc", 9);
+        l  = flist_from_fd(fd, flist_split_delim, "\n");
+
+        CHECK(slice_is(flist_val_at_i(l, 0), "a"));
+        CHECK(slice_is(flist_val_at_i(l, 1), ""));
+        CHECK(slice_is(flist_val_at_i(l, 2), "bb"));
+        CHECK(slice_is(flist_val_at_i(l, 3), "ccc"));
+        CHECK(flist_val_at_i(l, 4) == NULL);
+        CHECK(flist_length(l) == 4);
+
+        flist_free(&l, 0);
+        close(fd);
+}
+
+void
+test_fixed(void)
+{
+        struct   flist *l;
+        char     path[] = "/tmp/funcc_test_XXXXXX";
+        size_t   size;
+        int      fd;
+
+        size = 4;
+        fd   = open_input(path, "0123456789", 10);
+        l    = flist_from_fd(fd, flist_split_fixed, &size);
+
+        /* records are only terminated at the end of input */
+        CHECK(slice_eq(flist_val_at_i(l, 0), "0123"));
+        CHECK(slice_eq(flist_val_at_i(l, 1), "4567"));
+        CHECK(slice_is(flist_val_at_i(l, 2), "89"));
+        CHECK(flist_val_at_i(l, 3) == NULL);
+
+        flist_free(&l, 0);
+        close(fd);
+}
+
+void
+test_error(void)
+{
+        struct   flist *l, *t;
+        int      fd;
+
+        /* reading a directory fails with EISDIR */
+        if ((fd = open("/", O_RDONLY)) == -1) {
+                perror("open");
+                exit(EXIT_FAILURE);
+        }
+
+        l = flist_from_fd(fd, flist_split_delim, "\n");
+        CHECK(flist_stream_error(l) == 0);
+        CHECK(flist_val_at_i(l, 0) == NULL);
+        CHECK(flist_stream_error(l) == EISDIR);
+
+        /* the error goes along with the input */
+        t = flist_append(NULL, "x", FLIST_DONTCLEAN);
+        flist_set_arena(t, 0);
+        CHECK(flist_concat(t, &l) == t);
+        CHECK(flist_stream_error(t) == EISDIR);
+
+        flist_free(&t, 0);
+        close(fd);
+
+        CHECK(flist_stream_error(NULL) == 0);
+}
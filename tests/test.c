@@ -0,0 +1,130 @@
+#include "test.h"
+
+int              test_failed;
+size_t           test_cleaned;
+struct test_count test_count;
+int              test_broke;
+unsigned long    test_seed = 1;
+
+/**
+ * @fn static void *count_alloc(void *ctx, size_t size)
+ * @brief Allocation function of @a test_falloc
+ */
+static void     *count_alloc(void *, size_t);
+
+/**
+ * @fn static void count_free(void *ctx, void *ptr, size_t size)
+ * @brief Release function of @a test_falloc
+ */
+static void      count_free(void *, void *, size_t);
+
+/**
+ * @fn static void *brk_alloc(void *ctx, size_t size)
+ * @brief Allocation function of @a test_brk_falloc
+ */
+static void     *brk_alloc(void *, size_t);
+
+/**
+ * @fn static void brk_free(void *ctx, void *ptr, size_t size)
+ * @brief Release function of @a test_brk_falloc
+ */
+static void      brk_free(void *, void *, size_t);
+
+const struct falloc test_falloc = { count_alloc, count_free, &test_count };
+const struct falloc test_brk_falloc = { brk_alloc, brk_free, NULL };
+
+int
+test_done(const char *name)
+{
+        if (test_failed == 0) {
+                printf("%-10s ok\n", name);
+                return EXIT_SUCCESS;
+        }
+
+        printf("%-10s FAILED (%d checks)\n", name, test_failed);
+        return EXIT_FAILURE;
+}
+
+void
+test_cleanup(void *p)
+{
+        ++test_cleaned;
+        free(p);
+}
+
+void *
+count_alloc(void *ctx, size_t size)
+{
+        struct   test_count *c;
+        void    *ret;
+
+        c = ctx;
+        if ((ret = malloc(size)) != NULL) {
+                ++c->allocs;
+                c->bytes += (long)size;
+        }
+
+        return ret;
+}
+
+void
+count_free(void *ctx, void *ptr, size_t size)
+{
+        struct   test_count *c;
+
+        if (ptr == NULL)
+                return;
+
+        c = ctx;
+        ++c->frees;
+        c->bytes -= (long)size;
+        free(ptr);
+}
+
+void *
+brk_alloc(void *ctx, size_t size)
+{
+        (void)ctx;
+
+        return test_broke ? NULL : malloc(size);
+}
+
+void
+brk_free(void *ctx, void *ptr, size_t size)
+{
+        (void)ctx;
+        (void)size;
+
+        free(ptr);
+}
+
+size_t
+test_rnd(size_t n)
+{
+        test_seed = test_seed * 1103515245UL + 12345UL;
+
+        return n == 0 ? 0 : (size_t)((test_seed >> 8) & 0xffffffUL) % n;
+}
+
+int
+test_cmp_int(const void *a, const void *b)
+{
+        return *(const int *)a - *(const int *)b;
+}
+
+int
+test_odd(void *p)
+{
+        return *(int *)p % 2 != 0;
+}
+
+void *
+test_dup(void *p)
+{
+        int     *ret;
+
+        if ((ret = malloc(sizeof(int))) != NULL)
+                *ret = *(int *)p;
+
+        return ret;
+}
@@ -0,0 +1,112 @@
+/*
+ * Helpers shared by libfuncc tests.
+ */
+
+#ifndef TEST_H_INCLUDED
+#define TEST_H_INCLUDED
+
+#ifndef _POSIX_C_SOURCE
+# define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "falloc.h"
+
+/**
+ * @brief Checks condition @p X, reporting it and counting a failure if false
+ *
+ * Tests go on after a failed check, so that a single run reports all of them.
+ *
+ * @param[in] X Condition expected to hold
+ */
+#define CHECK(X) do {                                               \
+        if (!(X)) {                                                 \
+                fprintf(stderr, "[%s:%d] check failed: %s\n",       \
+                    __FILE__, __LINE__, #X);                        \
+                ++test_failed;                                      \
+        }                                                           \
+} while (0)
+
+/**
+ * @brief Allocations made through @a test_falloc
+ */
+struct test_count {
+        size_t       allocs;            /**< @brief Successful allocations */
+        size_t       frees;             /**< @brief Releases */
+        long         bytes;             /**< @brief Bytes held */
+};
+
+/**
+ * @brief Number of failed checks so far
+ */
+extern int                       test_failed;
+
+/**
+ * @brief Counters of @a test_falloc
+ */
+extern struct test_count         test_count;
+
+/**
+ * @brief Allocator wrapping malloc() that keeps @a test_count up to date
+ */
+extern const struct falloc       test_falloc;
+
+/**
+ * @fn int test_done(const char *name)
+ * @brief Reports outcome of test @p name and returns its exit status
+ */
+int      test_done(const char *);
+
+/**
+ * @fn void test_cleanup(void *p)
+ * @brief Cleanup handler counting its calls in @a test_cleaned, then freeing
+ */
+void     test_cleanup(void *);
+
+/**
+ * @brief Number of calls to @a test_cleanup() so far
+ */
+extern size_t                    test_cleaned;
+
+/**
+ * @brief Allocations through @a test_brk_falloc fail while this is set
+ */
+extern int                       test_broke;
+
+/**
+ * @brief Allocator wrapping malloc() that fails while @a test_broke is set
+ */
+extern const struct falloc       test_brk_falloc;
+
+/**
+ * @brief State of @a test_rnd(), tests set it to get sequences of their own
+ */
+extern unsigned long             test_seed;
+
+/**
+ * @fn size_t test_rnd(size_t n)
+ * @brief Returns next pseudo-random number below @p n, zero if @p n is zero
+ */
+size_t   test_rnd(size_t);
+
+/**
+ * @fn int test_cmp_int(const void *a, const void *b)
+ * @brief Compares integers pointed to by @p a and @p b
+ */
+int      test_cmp_int(const void *, const void *);
+
+/**
+ * @fn int test_odd(void *p)
+ * @brief Is integer @p p odd?
+ */
+int      test_odd(void *);
+
+/**
+ * @fn void *test_dup(void *p)
+ * @brief Returns newly allocated copy of integer @p p
+ */
+void    *test_dup(void *);
+
+#endif /* TEST_H_INCLUDED */
@@ -0,0 +1,320 @@
+/*
+ * Zipping: flist_zip(), flist_zip3() and flist_zip_with() are as long as the
+ * shortest list, own the tuples they build but not what is inside them, and
+ * force lazy lists no further than needed. flist_unzip() takes the number of
+ * lists from the first tuple, whatever the dimension of the others.
+ */
+
+#include "test.h"
+
+#include <errno.h>
+
+#include "flist.h"
+#include "ftuple.h"
+
+#define N 40
+
+static int       pool[N + 2];   /* element i of the pool is i */
+static size_t    calls;         /* elements generated so far */
+
+/**
+ * @fn static void *diff(void *a, void *b)
+ * @brief Returns newly allocated difference of integers @p a and @p b
+ */
+static void             *diff(void *, void *);
+
+/**
+ * @fn static int gen(void *seed, void **out)
+ * @brief Unfolding function yielding elements of @a pool from @p seed on
+ */
+static int               gen(void *, void **);
+
+/**
+ * @fn static struct flist *build(size_t len, size_t from)
+ * @brief Returns list of @p len copies of elements of @a pool from @p from,
+ *  owned by the list and allocated with @a test_falloc
+ */
+static struct flist     *build(size_t, size_t);
+
+/**
+ * @fn static void run(size_t n1, size_t n2, size_t n3)
+ * @brief Zips lists of @p n1, @p n2 and @p n3 elements every way
+ */
+static void              run(size_t, size_t, size_t);
+
+/**
+ * @fn static void lazy(void)
+ * @brief Lazy lists are forced as far as the zipped list is
+ */
+static void              lazy(void);
+
+/**
+ * @fn static void unzip(void)
+ * @brief Tuples of differing dimension unzip into as many lists as the
+ *  first one has elements
+ */
+static void              unzip(void);
+
+int
+main(void)
+{
+        static const size_t lens[][3] = {
+                { 0, 0, 0 }, { 0, 3, 3 }, { 3, 0, 3 }, { 3, 3, 0 },
+                { 1, 1, 1 }, { 5, 5, 5 }, { 5, 9, 7 }, { 9, 5, 7 },
+                { 7, 9, 5 }, { N, 1, N }
+        };
+        size_t   i;
+
+        for (i = 0; i < N + 2; ++i)
+                pool[i] = (int)i;
+
+        for (i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+                run(lens[i][0], lens[i][1], lens[i][2]);
+
+        lazy();
+        unzip();
+
+        return test_done("zip");
+}
+
+void *
+diff(void *a, void *b)
+{
+        int      x;
+
+        x = *(int *)a - *(int *)b;
+
+        return test_dup(&x);
+}
+
+int
+gen(void *seed, void **out)
+{
+        if (*(int *)seed >= N)
+                return 0;
+
+        ++calls;
+        *out = &pool[(*(int *)seed)++];
+
+        return 1;
+}
+
+struct flist *
+build(size_t len, size_t from)
+{
+        struct   flist *l;
+        size_t   i;
+
+        if (len == 0 || (l = flist_create(&test_falloc)) == NULL)
+                return NULL;
+        flist_set_cleanup(l, test_cleanup);
+
+        for (i = 0; i < len; ++i) {
+                CHECK(flist_append(l, test_dup(&pool[from + i]),
+                    FLIST_CLEANABLE) == l);
+        }
+
+        return l;
+}
+
+void
+run(size_t n1, size_t n2, size_t n3)
+{
+        struct   flist *l1, *l2, *l3, *z, *parts[3];
+        struct   flist_iter *it;
+        struct   ftuple *t;
+        size_t   n, i, k;
+        long     bytes;
+
+        l1 = build(n1, 0);
+        l2 = build(n2, 1);
+        l3 = build(n3, 2);
+        bytes = test_count.bytes;
+
+        /* pairs and triples go with the list, their elements stay */
+        test_cleaned = 0;
+        n = n1 < n2 ? n1 : n2;
+        z = flist_zip(l1, l2);
+        CHECK(flist_length(z) == n && (z == NULL) == (n == 0));
+        i = 0;
+        FLIST_FOREACH(z, it) {
+                CHECK(ftuple_dim(it->data) == 2);
+                CHECK(*(int *)ftuple_fst(it->data) == (int)i);
+                CHECK(*(int *)ftuple_snd(it->data) == (int)i + 1);
+                ++i;
+        }
+
+        /* the pairs unzip back into what was zipped */
+        if ((t = flist_unzip(z)) == NULL) {
+                CHECK(!"flist_unzip() failed");
+        } else {
+                CHECK(ftuple_dim(t) == 2);
+                for (k = 0; k < 2; ++k) {
+                        parts[k] = ftuple_nth(t, k);
+                        CHECK(flist_length(parts[k]) == n);
+                        for (i = 0; i < n; ++i) {
+                                CHECK(flist_val_at_i(parts[k], (int)i)
+                                    == flist_val_at_i(k == 0 ? l1 : l2,
+                                    (int)i));
+                        }
+                        flist_free(&parts[k], 0);
+                }
+                ftuple_free(&t);
+        }
+
+        flist_free(&z, 0);
+        CHECK(test_cleaned == 0 && test_count.bytes == bytes);
+
+        n = n < n3 ? n : n3;
+        z = flist_zip3(l1, l2, l3);
+        CHECK(flist_length(z) == n && (z == NULL) == (n == 0));
+        i = 0;
+        FLIST_FOREACH(z, it) {
+                CHECK(ftuple_dim(it->data) == 3);
+                for (k = 0; k < 3; ++k)
+                        CHECK(*(int *)ftuple_nth(it->data, k) == (int)(i + k));
+                ++i;
+        }
+
+        /* removed triples are freed as well */
+        flist_take(&z, (int)n / 2, 0);
+        CHECK(flist_length(z) == n / 2);
+        flist_free(&z, 0);
+        CHECK(test_cleaned == 0 && test_count.bytes == bytes);
+
+        /* results of f belong to the list if the flags say so */
+        n = n1 < n2 ? n1 : n2;
+        z = flist_zip_with(l1, l2, diff, FLIST_CLEANABLE);
+        flist_set_cleanup(z, test_cleanup);
+        CHECK(flist_length(z) == n);
+        FLIST_FOREACH(z, it)
+                CHECK(*(int *)it->data == -1);
+        flist_free(&z, 0);
+        CHECK(test_cleaned == n && test_count.bytes == bytes);
+
+        /* a NULL list zips with nothing */
+        errno = 0;
+        CHECK(flist_zip(NULL, l2) == NULL && flist_zip(l1, NULL) == NULL);
+        CHECK(flist_zip3(l1, l2, NULL) == NULL);
+        CHECK(flist_zip3(NULL, l2, l3) == NULL);
+        CHECK(flist_zip_with(NULL, l2, diff, FLIST_CLEANABLE) == NULL);
+        CHECK(errno == 0);
+
+        test_cleaned = 0;
+        flist_free(&l1, 0);
+        flist_free(&l2, 0);
+        flist_free(&l3, 0);
+        CHECK(test_cleaned == n1 + n2 + n3);
+        CHECK(test_count.allocs == test_count.frees && test_count.bytes == 0);
+}
+
+void
+lazy(void)
+{
+        struct   flist *l1, *l2, *l3, *z;
+        int      s1, s2, i;
+
+        s1    = 0;
+        s2    = 0;
+        calls = 0;
+        l1    = flist_unfoldr(gen, &s1, FLIST_DONTCLEAN);
+        l2    = flist_unfoldr(gen, &s2, FLIST_DONTCLEAN);
+
+        /* both lazy, so is the result */
+        z = flist_zip(l1, l2);
+        CHECK(z != NULL && calls == 0);
+        CHECK(*(int *)ftuple_snd(flist_val_at_i(z, 4)) == 4);
+        CHECK(calls == 10);
+        flist_free(&z, 0);
+
+        /* one of them is not, it tells how far the other is forced */
+        if ((l3 = flist_create(NULL)) == NULL) {
+                CHECK(!"flist_create() failed");
+                return;
+        }
+        for (i = 0; i < 7; ++i)
+                CHECK(flist_append(l3, &pool[N - 1 - i], 0) == l3);
+
+        z = flist_zip3(l1, l3, l2);
+        CHECK(flist_length(z) == 7 && calls == 14);
+        CHECK(*(int *)ftuple_nth(flist_val_at_i(z, 6), 0) == 6);
+        CHECK(*(int *)ftuple_nth(flist_val_at_i(z, 6), 1) == N - 7);
+        flist_free(&z, 0);
+
+        flist_free(&l1, 0);
+        flist_free(&l2, 0);
+        flist_free(&l3, 0);
+}
+
+void
+unzip(void)
+{
+        struct   ftuple *ts[4], *t;
+        struct   flist *l, *parts[3];
+        size_t   i, k;
+
+        ts[0] = ftuple_create(3, &pool[0], &pool[1], &pool[2]);
+        ts[1] = ftuple_create(2, &pool[3], &pool[4]);
+        ts[2] = ftuple_create(3, &pool[5], &pool[6], &pool[7]);
+        ts[3] = ftuple_create(2, &pool[8], &pool[9]);
+
+        /* a triple first, so three lists, NULL where pairs have nothing */
+        l = NULL;
+        for (i = 0; i < 3; ++i)
+                l = flist_append(l, ts[i], FLIST_DONTCLEAN);
+        if ((t = flist_unzip(l)) == NULL) {
+                CHECK(!"flist_unzip() failed");
+        } else {
+                CHECK(ftuple_dim(t) == 3);
+                for (k = 0; k < 3; ++k) {
+                        parts[k] = ftuple_nth(t, k);
+                        CHECK(flist_length(parts[k]) == 3);
+                        CHECK(flist_val_at_i(parts[k], 0) == &pool[k]);
+                        CHECK(flist_val_at_i(parts[k], 2) == &pool[5 + k]);
+                }
+                CHECK(flist_val_at_i(parts[0], 1) == &pool[3]);
+                CHECK(flist_val_at_i(parts[1], 1) == &pool[4]);
+                CHECK(flist_val_at_i(parts[2], 1) == NULL);
+                for (k = 0; k < 3; ++k)
+                        flist_free(&parts[k], 0);
+                ftuple_free(&t);
+        }
+        CHECK(flist_length(l) == 3);
+        flist_free(&l, 0);
+
+        /* a pair first, so two lists, third elements are left out */
+        l = NULL;
+        for (i = 1; i < 3; ++i)
+                l = flist_append(l, ts[i], FLIST_DONTCLEAN);
+        if ((t = flist_unzip(l)) == NULL) {
+                CHECK(!"flist_unzip() failed");
+        } else {
+                CHECK(ftuple_dim(t) == 2);
+                parts[0] = ftuple_fst(t);
+                parts[1] = ftuple_snd(t);
+                CHECK(flist_val_at_i(parts[0], 1) == &pool[5]);
+                CHECK(flist_val_at_i(parts[1], 1) == &pool[6]);
+                CHECK(flist_length(parts[1]) == 2);
+                flist_free(&parts[0], 0);
+                flist_free(&parts[1], 0);
+                ftuple_free(&t);
+        }
+        flist_free(&l, 0);
+
+        /* nothing to unzip */
+        if ((t = flist_unzip(NULL)) != NULL) {
+                CHECK(ftuple_dim(t) == 2);
+                CHECK(ftuple_fst(t) == NULL && ftuple_snd(t) == NULL);
+                ftuple_free(&t);
+        }
+
+        /* no tuple first */
+        l = flist_append(NULL, NULL, FLIST_DONTCLEAN);
+        l = flist_append(l, ts[3], FLIST_DONTCLEAN);
+        errno = 0;
+        CHECK(flist_unzip(l) == NULL && errno == EINVAL);
+        flist_free(&l, 0);
+
+        for (i = 0; i < 4; ++i)
+                ftuple_free(&ts[i]);
+}